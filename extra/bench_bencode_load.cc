@@ -0,0 +1,258 @@
+// Times loading torrent files the way download_add does, reading into
+// an Object tree and hashing the re-encoded info dictionary, against
+// indexing the buffer with a reused BencodeIndex and hashing the info
+// dictionary as found in the buffer.
+//
+// Then times the two download_add overloads themselves, which also
+// build the file list and the Object kept by the download. Removing the
+// downloads is not timed.
+//
+// Usage: bench_bencode_load [file.torrent ...]
+//
+// Without arguments a corpus of synthetic multi-file torrents is used.
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "thread_main.h"
+#include "torrent/bencode_view.h"
+#include "torrent/download.h"
+#include "torrent/download_info.h"
+#include "torrent/exceptions.h"
+#include "torrent/object.h"
+#include "torrent/object_stream.h"
+#include "torrent/torrent.h"
+#include "utils/sha1.h"
+
+static constexpr unsigned int synthetic_count = 2000;
+static constexpr unsigned int synthetic_files = 40;
+static constexpr unsigned int rounds          = 5;
+
+static std::string
+bencode_string(const std::string& str) {
+  return std::to_string(str.size()) + ":" + str;
+}
+
+static std::string
+synthetic_torrent(unsigned int index) {
+  std::string files;
+
+  for (unsigned int i = 0; i < synthetic_files; i++)
+    files += "d6:lengthi" + std::to_string((i + 1) * 1048576 + index) + "e4:pathl" +
+      bencode_string("directory_" + std::to_string(i % 4)) + bencode_string("file_" + std::to_string(i) + ".dat") + "ee";
+
+  std::string info =
+    "d5:filesl" + files + "e" +
+    "4:name" + bencode_string("torrent_" + std::to_string(index)) +
+    "12:piece lengthi262144e" +
+    "6:pieces" + bencode_string(std::string(20 * 4 * synthetic_files, static_cast<char>(index))) +
+    "e";
+
+  return "d8:announce" + bencode_string("http://tracker.example.com:6969/announce") +
+    "13:creation datei1700000000e" +
+    "4:info" + info + "e";
+}
+
+static std::vector<std::string>
+load_corpus(int argc, char** argv) {
+  std::vector<std::string> corpus;
+
+  for (int i = 1; i < argc; i++) {
+    std::ifstream file(argv[i], std::ios::binary);
+    std::stringstream data;
+
+    data << file.rdbuf();
+
+    if (file.fail())
+      std::cerr << "could not read: " << argv[i] << std::endl;
+    else
+      corpus.push_back(data.str());
+  }
+
+  if (argc <= 1)
+    for (unsigned int i = 0; i < synthetic_count; i++)
+      corpus.push_back(synthetic_torrent(i));
+
+  return corpus;
+}
+
+static std::string
+sha1_buffer(const char* data, unsigned int length) {
+  char buffer[20];
+
+  torrent::Sha1 sha;
+  sha.init();
+  sha.update(data, length);
+  sha.final_c(buffer);
+
+  return std::string(buffer, 20);
+}
+
+// Touches the keys DownloadConstructor reads, so both methods do
+// comparable work beyond parsing.
+template <typename Bencode>
+static uint64_t
+walk_info(const Bencode& info) {
+  uint64_t check = info.get_key_string("name").size() + info.get_key_value("piece length");
+
+  if (info.has_key_value("length"))
+    return check + info.get_key_value("length");
+
+  for (const auto& file : info.get_key_list("files")) {
+    check += file.get_key_value("length");
+
+    for (const auto& element : file.get_key_list("path"))
+      check += element.as_string().size();
+  }
+
+  return check;
+}
+
+static uint64_t
+load_object(const std::string& data, std::string& info_hash) {
+  torrent::Object object;
+  torrent::object_read_bencode_c(data.data(), data.data() + data.size(), &object);
+
+  const auto& info = object.get_key("info");
+  info_hash = torrent::object_sha1(&info);
+
+  return walk_info(info);
+}
+
+static uint64_t
+load_view(torrent::BencodeIndex& index, const std::string& data, std::string& info_hash) {
+  index.parse(data.data(), data.data() + data.size());
+
+  auto info = index.root().get_key("info");
+  auto raw = info.as_raw_bencode();
+  info_hash = sha1_buffer(raw.data(), raw.size());
+
+  return walk_info(info);
+}
+
+static torrent::Download
+add_object(const std::string& data) {
+  auto object = std::make_unique<torrent::Object>();
+  torrent::object_read_bencode_c(data.data(), data.data() + data.size(), object.get());
+
+  auto download = torrent::download_add(object.get(), 0);
+
+  object.release();
+  return download;
+}
+
+static torrent::Download
+add_view(torrent::BencodeIndex& index, const std::string& data) {
+  index.parse(data.data(), data.data() + data.size());
+
+  return torrent::download_add(index.root(), 0);
+}
+
+// Adds every torrent in the corpus, keeping the info hash of each, and
+// returns the time spent adding.
+template <typename Add>
+static std::chrono::steady_clock::duration
+add_downloads(const std::vector<std::string>& corpus, std::vector<std::string>& hashes, Add add) {
+  std::vector<torrent::Download> downloads;
+  downloads.reserve(corpus.size());
+
+  auto started = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < corpus.size(); i++) {
+    try {
+      downloads.push_back(add(corpus[i]));
+      hashes[i] = downloads.back().info()->hash().str();
+    } catch (const torrent::base_error&) {
+      hashes[i].clear();
+    }
+  }
+
+  auto elapsed = std::chrono::steady_clock::now() - started;
+
+  for (auto& download : downloads)
+    torrent::download_remove(download);
+
+  return elapsed;
+}
+
+int
+main(int argc, char** argv) {
+  auto corpus = load_corpus(argc, argv);
+  uint64_t bytes = 0;
+
+  for (auto& data : corpus)
+    bytes += data.size();
+
+  std::cout << "corpus: " << corpus.size() << " torrents, " << bytes / 1024 << " KiB" << std::endl;
+
+  std::vector<std::string> object_hashes(corpus.size());
+  std::vector<std::string> view_hashes(corpus.size());
+  torrent::BencodeIndex    index;
+
+  for (unsigned int round = 0; round < rounds; round++) {
+    uint64_t object_check = 0;
+    uint64_t view_check = 0;
+    unsigned int failed = 0;
+
+    auto started = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < corpus.size(); i++) {
+      try {
+        object_check += load_object(corpus[i], object_hashes[i]);
+      } catch (const torrent::base_error&) {
+        failed++;
+      }
+    }
+
+    auto object_elapsed = std::chrono::steady_clock::now() - started;
+    started = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < corpus.size(); i++) {
+      try {
+        view_check += load_view(index, corpus[i], view_hashes[i]);
+      } catch (const torrent::base_error&) {
+      }
+    }
+
+    auto view_elapsed = std::chrono::steady_clock::now() - started;
+
+    if (object_check != view_check || object_hashes != view_hashes)
+      std::cout << "results differ" << std::endl;
+
+    auto per_torrent = [&](auto elapsed) {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / corpus.size();
+    };
+
+    std::cout << "round " << round << ": object " << per_torrent(object_elapsed) << " ns/torrent"
+              << ", view " << per_torrent(view_elapsed) << " ns/torrent"
+              << (failed != 0 ? ", invalid: " + std::to_string(failed) : std::string()) << std::endl;
+  }
+
+  torrent::initialize_main_thread();
+  torrent::initialize();
+
+  for (unsigned int round = 0; round < rounds; round++) {
+    auto object_elapsed = add_downloads(corpus, object_hashes, add_object);
+    auto view_elapsed   = add_downloads(corpus, view_hashes, [&index](const std::string& data) { return add_view(index, data); });
+
+    if (object_hashes != view_hashes)
+      std::cout << "download_add results differ" << std::endl;
+
+    auto per_torrent = [&](auto elapsed) {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / corpus.size();
+    };
+
+    std::cout << "round " << round << ": download_add object " << per_torrent(object_elapsed) << " ns/torrent"
+              << ", view " << per_torrent(view_elapsed) << " ns/torrent" << std::endl;
+  }
+
+  torrent::cleanup();
+  delete torrent::ThreadMain::thread_main();
+
+  return 0;
+}
@@ -0,0 +1,73 @@
+// Times the bitfield kernels of each supported engine on 1M bit
+// fields, as used by Bitfield::update, peer interest checks and the
+// linear chunk search.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "utils/bitfield_ops.h"
+
+static constexpr uint32_t bit_count = 1 << 20;
+static constexpr unsigned int iterations = 2000;
+
+template <typename Func>
+static void
+time_op(const torrent::bitfield_ops* ops, const char* name, Func func) {
+  auto started = std::chrono::steady_clock::now();
+  uint64_t result = 0;
+
+  for (unsigned int i = 0; i < iterations; i++)
+    result += func(i);
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started);
+
+  std::cout << ops->name << " " << name << ": " << elapsed.count() / iterations << " ns/op (" << result << ")" << std::endl;
+}
+
+int
+main() {
+  std::vector<uint8_t> a(bit_count / 8);
+  std::vector<uint8_t> b(bit_count / 8);
+  std::vector<uint8_t> sparse(bit_count / 8);
+
+  for (auto& byte : a)
+    byte = std::rand();
+
+  for (auto& byte : b)
+    byte = std::rand();
+
+  // A nearly complete download, where the search walks long runs of
+  // chunks we already have.
+  for (unsigned int i = 0; i < 64; i++)
+    sparse[std::rand() % sparse.size()] = 0x10;
+
+  const torrent::bitfield_ops::engine_type engines[] = {
+    torrent::bitfield_ops::ENGINE_SCALAR,
+    torrent::bitfield_ops::ENGINE_POPCNT,
+    torrent::bitfield_ops::ENGINE_AVX2,
+  };
+
+  for (auto engine : engines) {
+    if (!torrent::bitfield_ops::is_engine_supported(engine))
+      continue;
+
+    auto ops = torrent::bitfield_ops::get(engine);
+
+    time_op(ops, "popcount", [&](unsigned int) { return ops->popcount(a.data(), a.size()); });
+    time_op(ops, "count_and", [&](unsigned int) { return ops->count_and(a.data(), b.data(), a.size()); });
+    time_op(ops, "any_andnot", [&](unsigned int) { return ops->any_andnot(sparse.data(), a.data(), a.size()); });
+
+    time_op(ops, "find_next_and sparse walk", [&](unsigned int) {
+        uint32_t found = 0;
+
+        for (uint32_t i = 0; (i = ops->find_next_and(sparse.data(), a.data(), i, bit_count)) != bit_count; i++)
+          found++;
+
+        return found;
+      });
+  }
+
+  return 0;
+}
@@ -0,0 +1,90 @@
+// Times DownloadManager lookups of plain and obfuscated info hashes,
+// as done by HandshakeManager for each incoming connection, against
+// the linear scan used previously.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "download/download_wrapper.h"
+#include "torrent/download_info.h"
+#include "torrent/download/download_manager.h"
+
+static constexpr unsigned int download_count = 100000;
+static constexpr unsigned int lookup_count = 1000000;
+static constexpr unsigned int linear_lookup_count = 1000;
+
+static void
+random_hash(char* hash) {
+  for (int i = 0; i < 20; i++)
+    hash[i] = std::rand();
+}
+
+template <typename Func>
+static void
+time_lookups(const char* name, unsigned int n, Func func) {
+  auto started = std::chrono::steady_clock::now();
+  unsigned int found = 0;
+
+  for (unsigned int i = 0; i < n; i++)
+    found += func(i) != nullptr;
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started);
+
+  std::cout << name << ": " << elapsed.count() / n << " ns/lookup (" << found << "/" << n << " found)" << std::endl;
+}
+
+int
+main() {
+  torrent::DownloadManager download_manager;
+  std::vector<torrent::HashString> hashes;
+  std::vector<torrent::HashString> obfuscated_hashes;
+
+  for (unsigned int i = 0; i < download_count; i++) {
+    auto download = new torrent::DownloadWrapper;
+
+    random_hash(download->info()->mutable_hash().data());
+    random_hash(download->info()->mutable_hash_obfuscated().data());
+
+    hashes.push_back(download->info()->hash());
+    obfuscated_hashes.push_back(download->info()->hash_obfuscated());
+
+    download_manager.insert(download);
+  }
+
+  std::cout << "downloads: " << download_manager.size() << std::endl;
+
+  // Half of the lookups are for unknown hashes.
+  std::vector<torrent::HashString> lookups;
+
+  for (unsigned int i = 0; i < 4096; i++) {
+    if (i % 2) {
+      lookups.push_back(hashes[std::rand() % hashes.size()]);
+    } else {
+      lookups.emplace_back();
+      random_hash(lookups.back().data());
+    }
+  }
+
+  time_lookups("find_main", lookup_count, [&](unsigned int i) {
+      return download_manager.find_main(lookups[i % lookups.size()].c_str());
+    });
+
+  time_lookups("find_main_obfuscated", lookup_count, [&](unsigned int i) {
+      return download_manager.find_main_obfuscated(obfuscated_hashes[i % obfuscated_hashes.size()].c_str());
+    });
+
+  time_lookups("linear_scan", linear_lookup_count, [&](unsigned int i) -> torrent::DownloadWrapper* {
+      auto& hash = lookups[i % lookups.size()];
+
+      for (auto download : download_manager)
+        if (download->info()->hash() == hash)
+          return download;
+
+      return nullptr;
+    });
+
+  download_manager.clear();
+  return 0;
+}
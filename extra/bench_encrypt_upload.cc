@@ -0,0 +1,68 @@
+// Times the upload path for encrypted connections, copying piece data
+// out of a chunk into the 16 KB encrypt buffer and encrypting it, in
+// separate passes as done previously and fused into a single RC4 pass
+// as done by PeerConnectionBase::up_chunk_encrypt. Plaintext copying
+// is included for reference.
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "utils/rc4.h"
+
+static constexpr size_t source_size = 64 << 20;
+static constexpr size_t buffer_size = 16 << 10;
+static constexpr unsigned int passes = 8;
+
+template <typename Func>
+static void
+time_upload(const char* name, const std::vector<char>& source, Func func) {
+  char buffer[buffer_size];
+  unsigned int check = 0;
+
+  auto started = std::chrono::steady_clock::now();
+
+  for (unsigned int i = 0; i < passes; i++) {
+    for (size_t offset = 0; offset < source.size(); offset += buffer_size) {
+      func(source.data() + offset, buffer);
+
+      // Keeps the copy from being optimized away.
+      check += static_cast<unsigned char>(buffer[(offset / buffer_size) % buffer_size]);
+    }
+  }
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started);
+  double bytes = static_cast<double>(source.size()) * passes;
+
+  std::cout << name << ": " << elapsed.count() / (bytes / buffer_size) << " ns/16KB "
+            << bytes / elapsed.count() * 1e9 / (1 << 20) << " MB/s (" << check << ")" << std::endl;
+}
+
+int
+main() {
+  std::vector<char> source(source_size);
+
+  for (auto& c : source)
+    c = std::rand();
+
+  const unsigned char key[20] = { 1, 2, 3, 4, 5 };
+  torrent::RC4 rc4_separate(key, sizeof(key));
+  torrent::RC4 rc4_fused(key, sizeof(key));
+
+  time_upload("plaintext copy", source, [](const char* data, char* buffer) {
+      std::memcpy(buffer, data, buffer_size);
+    });
+
+  time_upload("copy then encrypt", source, [&](const char* data, char* buffer) {
+      std::memcpy(buffer, data, buffer_size);
+      rc4_separate.crypt(buffer, buffer_size);
+    });
+
+  time_upload("fused encrypt", source, [&](const char* data, char* buffer) {
+      rc4_fused.crypt(data, buffer, buffer_size);
+    });
+
+  return 0;
+}
@@ -0,0 +1,99 @@
+// Times rescheduling and erasing entries in utils::Scheduler with
+// 100k entries scheduled, as with many peer connections, trackers and
+// downloads each holding timers, against the previous vector that was
+// searched and rebuilt with make_heap on every change.
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "torrent/utils/scheduler.h"
+
+using torrent::utils::SchedulerEntry;
+
+static constexpr unsigned int entry_count = 100000;
+static constexpr unsigned int churn_count = 1000000;
+static constexpr unsigned int rebuild_churn_count = 1000;
+
+static constexpr std::chrono::microseconds base_time = 365 * 24h;
+
+template <typename Func>
+static void
+time_churn(const char* name, unsigned int n, Func func) {
+  auto started = std::chrono::steady_clock::now();
+
+  for (unsigned int i = 0; i < n; i++)
+    func(i);
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started);
+
+  std::cout << name << ": " << elapsed.count() / n << " ns/op" << std::endl;
+}
+
+int
+main() {
+  std::mt19937 rng(1);
+  std::vector<std::unique_ptr<SchedulerEntry>> entries(entry_count);
+  std::vector<std::chrono::microseconds> times(churn_count);
+
+  torrent::utils::ExternalScheduler scheduler;
+
+  for (auto& t : times)
+    t = base_time + std::chrono::milliseconds(1 + rng() % 600000);
+
+  for (unsigned int i = 0; i < entry_count; i++) {
+    entries[i] = std::make_unique<SchedulerEntry>();
+    entries[i]->slot() = [] {};
+
+    scheduler.wait_until(entries[i].get(), times[i]);
+  }
+
+  std::cout << "entries: " << scheduler.size() << std::endl;
+
+  time_churn("update_wait_until", churn_count, [&](unsigned int i) {
+      scheduler.update_wait_until(entries[(i * 7919) % entry_count].get(), times[i]);
+    });
+
+  time_churn("erase and wait_until", churn_count, [&](unsigned int i) {
+      auto entry = entries[(i * 7919) % entry_count].get();
+
+      scheduler.erase(entry);
+      scheduler.wait_until(entry, times[i]);
+    });
+
+  // Expiring entries and scheduling them again, like repeating
+  // timers.
+  time_churn("perform and reschedule", churn_count / 10, [&](unsigned int i) {
+      auto entry = scheduler.front();
+      auto time = entry->time();
+
+      scheduler.external_perform(time);
+      scheduler.wait_until(entry, time + std::chrono::milliseconds(1 + times[i].count() % 600000));
+    });
+
+  // The previous implementation, a linear search and make_heap for
+  // each erase.
+  std::vector<SchedulerEntry*> heap(scheduler.begin(), scheduler.end());
+
+  auto compare = [](const SchedulerEntry* a, const SchedulerEntry* b) {
+    return a->time() > b->time();
+  };
+
+  time_churn("previous erase and push", rebuild_churn_count, [&](unsigned int i) {
+      auto entry = entries[(i * 7919) % entry_count].get();
+
+      heap.erase(std::find(heap.begin(), heap.end(), entry));
+      std::make_heap(heap.begin(), heap.end(), compare);
+
+      heap.push_back(entry);
+      std::push_heap(heap.begin(), heap.end(), compare);
+    });
+
+  for (auto& entry : entries)
+    scheduler.erase(entry.get());
+
+  return 0;
+}
@@ -0,0 +1,57 @@
+// Times each supported SHA-1 batch engine hashing 64 MB of random
+// data split into pieces of 16 KB, 256 KB and 4 MB.
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "utils/sha1_batch.h"
+
+using segment_type = torrent::Sha1Batch::segment_type;
+using segment_list = torrent::Sha1Batch::segment_list;
+
+static constexpr size_t total_size = 64 << 20;
+
+int
+main() {
+  const torrent::Sha1Batch::engine_type engines[] = {
+    torrent::Sha1Batch::ENGINE_OPENSSL,
+    torrent::Sha1Batch::ENGINE_SIMD_X4,
+    torrent::Sha1Batch::ENGINE_SIMD_X8,
+    torrent::Sha1Batch::ENGINE_SIMD_X16,
+  };
+
+  std::mt19937 rng(total_size);
+  std::vector<char> data(total_size);
+
+  for (auto& c : data)
+    c = rng();
+
+  for (uint32_t piece_size : { 16u << 10, 256u << 10, 4u << 20 }) {
+    for (auto engine : engines) {
+      if (!torrent::Sha1Batch::is_engine_supported(engine))
+        continue;
+
+      torrent::Sha1Batch batch(engine);
+
+      for (size_t offset = 0; offset < total_size; offset += piece_size)
+        batch.push_back(segment_list{segment_type(data.data() + offset, piece_size)});
+
+      std::vector<char> digests(batch.size() * 20);
+
+      auto started = std::chrono::steady_clock::now();
+      batch.perform(digests.data());
+      auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+      std::cout << "piece:" << std::setw(8) << piece_size
+                << " engine:" << std::setw(9) << torrent::Sha1Batch::engine_name(engine)
+                << " lanes:" << std::setw(3) << batch.lanes()
+                << " MB/s:" << std::fixed << std::setprecision(0) << (total_size >> 20) / elapsed
+                << std::endl;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,87 @@
+// Times reading a 64 MB file in 256 KB chunks, in sequential and
+// random order, through the mmap and pread storage backends.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <unistd.h>
+#include <vector>
+
+#include "data/storage_backend.h"
+#include "torrent/chunk_manager.h"
+
+static constexpr uint64_t file_size   = 64 << 20;
+static constexpr uint32_t piece_size  = 256 << 10;
+static constexpr uint32_t piece_count = file_size / piece_size;
+
+int
+main() {
+  char path[] = "/tmp/libtorrent_bench_storage_XXXXXX";
+  int fd = mkstemp(path);
+
+  if (fd == -1) {
+    std::cerr << "could not create temporary file" << std::endl;
+    return 1;
+  }
+
+  ::unlink(path);
+
+  std::mt19937 rng(file_size);
+  std::vector<char> data(file_size);
+
+  for (auto& c : data)
+    c = rng();
+
+  if (pwrite(fd, data.data(), data.size(), 0) != static_cast<ssize_t>(data.size())) {
+    std::cerr << "could not write temporary file" << std::endl;
+    return 1;
+  }
+
+  std::vector<uint32_t> sequential(piece_count);
+  std::iota(sequential.begin(), sequential.end(), 0);
+
+  std::vector<uint32_t> random = sequential;
+  std::shuffle(random.begin(), random.end(), std::mt19937(piece_count));
+
+  const uint32_t backends[] = {
+    torrent::ChunkManager::storage_backend_mmap,
+    torrent::ChunkManager::storage_backend_pread,
+  };
+
+  for (auto type : backends) {
+    auto backend = torrent::StorageBackend::from_type(type);
+
+    for (auto order : { &sequential, &random }) {
+      uint64_t checksum = 0;
+      auto started = std::chrono::steady_clock::now();
+
+      for (auto index : *order) {
+        auto mc = backend->create_chunk(fd, static_cast<uint64_t>(index) * piece_size, piece_size, torrent::MemoryChunk::prot_read);
+
+        if (!mc.is_valid()) {
+          std::cerr << "could not create chunk " << index << std::endl;
+          return 1;
+        }
+
+        for (const char* itr = mc.begin(); itr < mc.end(); itr += 64)
+          checksum += *itr;
+
+        backend->release_chunk(mc);
+      }
+
+      auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+      std::cout << "backend:" << std::setw(6) << (type == torrent::ChunkManager::storage_backend_mmap ? "mmap" : "pread")
+                << " access:" << std::setw(11) << (order == &sequential ? "sequential" : "random")
+                << " MB/s:" << std::fixed << std::setprecision(0) << (file_size >> 20) / elapsed
+                << " (" << checksum << ")" << std::endl;
+    }
+  }
+
+  ::close(fd);
+  return 0;
+}
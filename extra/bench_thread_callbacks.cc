@@ -0,0 +1,126 @@
+// Times producer threads queueing callbacks to a single consumer
+// through utils::CallbackQueue, against the previous multimap keyed
+// on the target that took a mutex for every push and for every
+// callback processed.
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "torrent/utils/callback_queue.h"
+
+using torrent::utils::CallbackQueue;
+
+static constexpr unsigned int push_count = 1000000;
+
+class multimap_queue {
+public:
+  void push(const void* target, std::function<void ()>&& fn) {
+    auto lock = std::scoped_lock(m_lock);
+    m_callbacks.emplace(target, std::move(fn));
+  }
+
+  bool process() {
+    bool processed = false;
+
+    while (true) {
+      std::function<void ()> callback;
+
+      {
+        auto lock = std::scoped_lock(m_lock);
+
+        if (m_callbacks.empty())
+          break;
+
+        callback = m_callbacks.extract(m_callbacks.begin()).mapped();
+        m_processing_lock.lock();
+      }
+
+      callback();
+      m_processing_lock.unlock();
+      processed = true;
+    }
+
+    return processed;
+  }
+
+private:
+  std::mutex                                         m_lock;
+  std::multimap<const void*, std::function<void ()>> m_callbacks;
+  std::mutex                                         m_processing_lock;
+};
+
+class lock_free_queue {
+public:
+  void push(const void* target, std::function<void ()>&& fn) {
+    m_queue.push(target, std::move(fn));
+  }
+
+  bool process() {
+    return m_queue.process([this](CallbackQueue::node_type& node) {
+        auto lock = std::scoped_lock(m_processing_lock);
+
+        if (!node.is_cancelled())
+          node.call();
+      });
+  }
+
+private:
+  CallbackQueue m_queue;
+  std::mutex    m_processing_lock;
+};
+
+template <typename Queue>
+static void
+time_producers(const char* name, unsigned int producer_count) {
+  Queue queue;
+  std::atomic<bool> done{false};
+  uint64_t check = 0;
+
+  auto started = std::chrono::steady_clock::now();
+
+  std::thread consumer([&] {
+      while (!done)
+        queue.process();
+
+      queue.process();
+    });
+
+  std::vector<std::thread> producers;
+
+  for (unsigned int p = 0; p < producer_count; p++)
+    producers.emplace_back([&, p] {
+        int target;
+
+        for (unsigned int i = p; i < push_count; i += producer_count)
+          queue.push(&target, [&check, i] { check += i; });
+      });
+
+  for (auto& producer : producers)
+    producer.join();
+
+  done = true;
+  consumer.join();
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started);
+
+  if (check != uint64_t{push_count} * (push_count - 1) / 2)
+    std::cout << name << ": missing callbacks" << std::endl;
+
+  std::cout << name << " producers:" << producer_count << ": " << elapsed.count() / push_count << " ns/op" << std::endl;
+}
+
+int
+main() {
+  for (unsigned int producer_count : {1, 2, 4, 8}) {
+    time_producers<multimap_queue>("multimap", producer_count);
+    time_producers<lock_free_queue>("callback_queue", producer_count);
+  }
+
+  return 0;
+}
@@ -0,0 +1,4 @@
+# Requires a configured tree, BUILD is the build directory.
+BUILD=${BUILD:-..}
+
+g++ -std=c++17 -Wall -O2 -g -I.. -I../src -I$BUILD -o bench_encrypt_upload bench_encrypt_upload.cc -lcrypto
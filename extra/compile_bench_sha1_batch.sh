@@ -0,0 +1,5 @@
+# Requires a configured and built tree, BUILD is the build directory.
+BUILD=${BUILD:-..}
+LIBS="$BUILD/src/.libs/manager.o $BUILD/src/.libs/thread_main.o -Wl,--start-group $BUILD/src/.libs/libtorrent_other.a $BUILD/src/torrent/.libs/libtorrent_torrent.a -Wl,--end-group"
+
+g++ -std=c++17 -Wall -O2 -g -I.. -I../src -I$BUILD -o bench_sha1_batch bench_sha1_batch.cc $LIBS -lcurl -lz -lcrypto -lpthread
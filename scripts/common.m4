@@ -142,6 +142,65 @@ AC_DEFUN([TORRENT_CHECK_POSIX_FADVISE], [
   ])
 ])
 
+AC_DEFUN([TORRENT_CHECK_IO_URING], [
+  AC_ARG_ENABLE(io-uring,
+    AS_HELP_STRING([--disable-io-uring],
+      [disable the io_uring disk engine [[default=enable]]]),
+    [], [enable_io_uring=yes])
+
+  AC_MSG_CHECKING(for io_uring)
+
+  if test "$enable_io_uring" = "yes"; then
+    AC_COMPILE_IFELSE([AC_LANG_SOURCE([
+        #include <linux/io_uring.h>
+        #include <sys/syscall.h>
+        #include <unistd.h>
+        int f() { struct io_uring_params p = {}; return syscall(__NR_io_uring_setup, 8, &p) + IORING_OP_FSYNC + IORING_FSYNC_DATASYNC; }
+      ])],
+      [
+        AC_MSG_RESULT(yes)
+        AC_DEFINE(USE_IO_URING, 1, Use io_uring for the disk engine.)
+      ], [
+        AC_MSG_RESULT(no)
+    ])
+  else
+    AC_MSG_RESULT(disabled)
+  fi
+])
+
+AC_DEFUN([TORRENT_CHECK_SENDFILE], [
+  AC_MSG_CHECKING(for Linux compatible sendfile)
+
+  AC_COMPILE_IFELSE([AC_LANG_SOURCE([
+      #include <sys/sendfile.h>
+      ssize_t f() { off_t offset = 0; return sendfile(1, 0, &offset, 1); }
+      ])],
+    [
+      AC_MSG_RESULT(yes)
+      AC_DEFINE(USE_SENDFILE, 1, Use sendfile for uploading piece data.)
+    ], [
+      AC_MSG_RESULT(no)
+  ])
+])
+
+AC_DEFUN([TORRENT_CHECK_MMSG], [
+  AC_MSG_CHECKING(for recvmmsg and sendmmsg)
+
+  AC_COMPILE_IFELSE([AC_LANG_SOURCE([
+      #ifndef _GNU_SOURCE
+      #define _GNU_SOURCE
+      #endif
+      #include <sys/socket.h>
+      int f(struct mmsghdr* m) { return recvmmsg(0, m, 1, 0, 0) + sendmmsg(0, m, 1, 0); }
+      ])],
+    [
+      AC_MSG_RESULT(yes)
+      AC_DEFINE(USE_MMSG, 1, Use recvmmsg and sendmmsg for batched datagram I/O.)
+    ], [
+      AC_MSG_RESULT(no)
+  ])
+])
+
 AC_DEFUN([TORRENT_CHECK_POPCOUNT], [
   AC_MSG_CHECKING(for __builtin_popcount)
 
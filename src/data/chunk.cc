@@ -42,6 +42,7 @@
 #include <cstring>
 #include <functional>
 
+#include "protocol/encryption_info.h"
 #include "torrent/exceptions.h"
 
 #include "chunk.h"
@@ -173,7 +174,18 @@ Chunk::sync(int flags) {
   bool success = true;
 
   for (auto& c : *this)
-    if (!c.chunk().sync(0, c.chunk().size(), flags))
+    if (!c.sync(flags))
+      success = false;
+
+  return success;
+}
+
+bool
+Chunk::sync_buffers(int flags) {
+  bool success = true;
+
+  for (auto& c : *this)
+    if (c.mapped() == ChunkPart::MAPPED_BUFFER && !c.sync(flags))
       success = false;
 
   return success;
@@ -232,6 +244,29 @@ Chunk::to_buffer(void* buffer, uint32_t position, uint32_t length) {
   return true;
 }
 
+// Encrypting while copying means the chunk is only read once, instead
+// of copied out and then encrypted in place.
+bool
+Chunk::to_buffer_encrypted(void* buffer, uint32_t position, uint32_t length, EncryptionInfo* encryption) {
+  if (position + length > m_chunkSize)
+    throw internal_error("Chunk::to_buffer_encrypted(...) position + length > m_chunkSize.");
+
+  if (length == 0)
+    return true;
+
+  Chunk::data_type data;
+  ChunkIterator itr(this, position, position + length);
+
+  do {
+    data = itr.data();
+    encryption->encrypt(data.first, buffer, data.second);
+
+    buffer = static_cast<char*>(buffer) + data.second;
+  } while (itr.next());
+
+  return true;
+}
+
 // Consider using uint32_t returning first mismatch or length if
 // matching.
 bool
@@ -10,6 +10,8 @@
 
 namespace torrent {
 
+class EncryptionInfo;
+
 class Chunk : private std::vector<ChunkPart> {
 public:
   using base_type = std::vector<ChunkPart>;
@@ -64,9 +66,14 @@ public:
 
   bool                sync(int flags);
 
+  // Only writes back parts backed by heap buffers, mapped parts are
+  // left to the kernel.
+  bool                sync_buffers(int flags);
+
   void                preload(uint32_t position, uint32_t length, bool useAdvise);
 
   bool                to_buffer(void* buffer, uint32_t position, uint32_t length);
+  bool                to_buffer_encrypted(void* buffer, uint32_t position, uint32_t length, EncryptionInfo* encryption);
   bool                from_buffer(const void* buffer, uint32_t position, uint32_t length);
   bool                compare_buffer(const void* buffer, uint32_t position, uint32_t length);
 
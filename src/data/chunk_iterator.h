@@ -51,6 +51,7 @@ public:
   Chunk::data_type    data();
 
   MemoryChunk*        memory_chunk() { return &m_iterator->chunk(); }
+  const ChunkPart*    chunk_part() const { return &*m_iterator; }
 
   uint32_t            memory_chunk_first() const { return m_first - m_iterator->position(); }
   uint32_t            memory_chunk_last() const { return m_last - m_iterator->position(); }
@@ -1,15 +1,18 @@
 #include "config.h"
 
+#include <cstring>
 #include <rak/error_number.h>
 
 #include "torrent/exceptions.h"
 #include "torrent/chunk_manager.h"
 #include "torrent/data/download_data.h"
+#include "torrent/data/file.h"
 #include "torrent/utils/log.h"
 #include "utils/instrumentation.h"
 
 #include "chunk_list.h"
 #include "chunk.h"
+#include "thread_disk.h"
 
 #define LT_LOG_THIS(log_level, log_fmt, ...)                              \
   lt_log_print_data(LOG_STORAGE_##log_level, m_data, "chunk_list", log_fmt, __VA_ARGS__);
@@ -56,12 +59,29 @@ void
 ChunkList::clear() {
   LT_LOG_THIS(INFO, "Clearing.", 0);
 
+  // The fdatasyncs already handed to thread_disk are waited for, so
+  // the chunks still referenced by them can be released.
+  if (thread_disk() != nullptr && thread_disk()->disk_io() != nullptr)
+    thread_disk()->disk_io()->wait(this);
+
+  for (auto& batch : m_sync_batches)
+    m_queue.insert(m_queue.end(), batch.nodes.begin(), batch.nodes.end());
+
+  m_sync_batches.clear();
+  m_sync_pending_size = 0;
+
   // Don't do any sync'ing as whomever decided to shut down really
   // doesn't care, so just de-reference all chunks in queue.
+  //
+  // Chunks backed by heap buffers would lose their data though, so
+  // those get written back without waiting for the disk.
   for (auto chunk : m_queue) {
     if (chunk->references() != 1 || chunk->writable() != 1)
       throw internal_error("ChunkList::clear() called but a node in the queue is still referenced.");
 
+    if (!chunk->chunk()->sync_buffers(MemoryChunk::sync_async))
+      LT_LOG_THIS(ERROR, "Could not write back chunk: index:%" PRIu32 " errmsg:%s.", chunk->index(), rak::error_number::current().c_str());
+
     chunk->dec_rw();
     clear_chunk(chunk, release_default);
   }
@@ -284,6 +304,11 @@ ChunkList::sync_chunks(sync_flags flags) {
 
   uint32_t failed = 0;
 
+  bool use_disk_thread = m_manager->sync_on_disk_thread() && thread_disk() != nullptr && thread_disk()->disk_io() != nullptr;
+  Queue disk_thread_nodes;
+  std::vector<ChunkPart*> disk_thread_parts;
+  std::vector<File*> disk_thread_files;
+
   for (auto itr = split, last = m_queue.end(); itr != last; ++itr) {
 
     // We can easily skip pieces by swap_iter, so there should be no
@@ -297,6 +322,22 @@ ChunkList::sync_chunks(sync_flags flags) {
 
     std::pair<int,bool> options = sync_options(*itr, flags);
 
+    // Only start the writeback of mapped parts here and leave writing
+    // buffers and waiting for the disk to thread_disk. The node keeps
+    // its reference until the files are synced.
+    if (use_disk_thread && options.first == MemoryChunk::sync_sync) {
+      if (!prepare_disk_thread_sync(*itr, disk_thread_parts, disk_thread_files)) {
+        std::iter_swap(itr, split++);
+
+        failed++;
+        continue;
+      }
+
+      (*itr)->set_sync_triggered(true);
+      disk_thread_nodes.push_back(*itr);
+      continue;
+    }
+
     if (!sync_chunk(*itr, options)) {
       std::iter_swap(itr, split++);
 
@@ -317,6 +358,9 @@ ChunkList::sync_chunks(sync_flags flags) {
 
   m_queue.erase(split, m_queue.end());
 
+  if (!disk_thread_nodes.empty())
+    sync_on_disk_thread(disk_thread_nodes, disk_thread_parts, disk_thread_files);
+
   // The caller must either make sure that it is safe to close the
   // download or set the sync_ignore_error flag.
   if (failed && !(flags & sync_ignore_error))
@@ -325,6 +369,136 @@ ChunkList::sync_chunks(sync_flags flags) {
   return failed;
 }
 
+// Parts added before a failure are dropped, as the node stays in the
+// queue rather than joining the batch that would keep them alive.
+bool
+ChunkList::prepare_disk_thread_sync(ChunkListNode* node, std::vector<ChunkPart*>& parts, std::vector<File*>& files) {
+  auto parts_size = parts.size();
+  auto files_size = files.size();
+
+  for (auto& part : *node->chunk()) {
+    bool success;
+
+    if (part.mapped() == ChunkPart::MAPPED_BUFFER) {
+      // The file might have been closed by FileManager since the part
+      // was read.
+      success = part.file()->prepare(false, MemoryChunk::prot_read | MemoryChunk::prot_write, 0);
+
+      if (success)
+        parts.push_back(&part);
+
+    } else {
+      success = part.sync(MemoryChunk::sync_async);
+    }
+
+    if (!success) {
+      parts.resize(parts_size);
+      files.resize(files_size);
+      return false;
+    }
+
+    if (part.file() != nullptr && !part.file()->is_padding())
+      files.push_back(part.file());
+  }
+
+  return true;
+}
+
+// The buffers are written first, and the files synced once all of the
+// writes have completed.
+void
+ChunkList::sync_on_disk_thread(Queue& nodes, std::vector<ChunkPart*>& parts, std::vector<File*>& files) {
+  std::sort(files.begin(), files.end());
+  files.erase(std::unique(files.begin(), files.end()), files.end());
+
+  LT_LOG_THIS(DEBUG, "Sync on disk thread: chunks:%zu buffers:%zu files:%zu.", nodes.size(), parts.size(), files.size());
+
+  auto batch = m_sync_batches.emplace(m_sync_batches.end());
+  batch->nodes.swap(nodes);
+  batch->files.swap(files);
+  m_sync_pending_size += batch->nodes.size();
+
+  for (auto part : parts) {
+    batch->remaining++;
+
+    auto fd = part->file()->file_descriptor();
+
+    thread_disk()->disk_io()->write(this, fd, part->file_offset(), part->chunk().begin(), part->size(), [this, batch](int result) {
+        if (result < 0)
+          batch->failed = true;
+
+        if (--batch->remaining == 0)
+          sync_batch_files(batch);
+
+        if (result < 0)
+          m_slot_storage_error("Could not write chunk: " + std::string(std::strerror(-result)));
+      });
+  }
+
+  if (batch->remaining == 0)
+    sync_batch_files(batch);
+}
+
+// Files closed since the chunk was synced are skipped, closing them
+// already handed the data over to the kernel.
+void
+ChunkList::sync_batch_files(SyncBatchList::iterator batch) {
+  if (batch->failed) {
+    sync_batch_done(batch);
+    return;
+  }
+
+  for (auto file : batch->files) {
+    if (!file->is_open())
+      continue;
+
+    batch->remaining++;
+
+    // The storage error slot may close the download, which clears the
+    // batches, so it is called last.
+    thread_disk()->disk_io()->fdatasync(this, file->file_descriptor(), [this, batch](int result) {
+        if (result < 0)
+          batch->failed = true;
+
+        if (--batch->remaining == 0)
+          sync_batch_done(batch);
+
+        if (result < 0)
+          m_slot_storage_error("Could not sync file: " + std::string(std::strerror(-result)));
+      });
+  }
+
+  if (batch->remaining == 0)
+    sync_batch_done(batch);
+}
+
+// Chunks modified while waiting, or whose files failed to sync, go
+// back in the queue unless a writer still holds them, in which case
+// releasing that handle queues them.
+void
+ChunkList::sync_batch_done(SyncBatchList::iterator batch) {
+  LT_LOG_THIS(DEBUG, "Sync batch done: chunks:%zu failed:%i.", batch->nodes.size(), (int)batch->failed);
+
+  for (auto node : batch->nodes) {
+    if (batch->failed || !node->sync_triggered()) {
+      if (node->writable() == 1)
+        m_queue.push_back(node);
+      else
+        node->dec_rw();
+
+      continue;
+    }
+
+    node->dec_rw();
+
+    if (node->references() == 0)
+      clear_chunk(node, release_default);
+  }
+
+  m_sync_pending_size -= batch->nodes.size();
+  m_sync_batches.erase(batch);
+}
+
 std::pair<int, bool>
 ChunkList::sync_options(ChunkListNode* node, sync_flags flags) {
   if ((flags & sync_force)) {
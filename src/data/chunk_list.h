@@ -2,6 +2,7 @@
 #define LIBTORRENT_DATA_CHUNK_LIST_H
 
 #include <functional>
+#include <list>
 #include <string>
 #include <vector>
 
@@ -76,7 +77,7 @@ public:
   void                change_flags(int flags, bool state) { if (state) set_flags(flags); else unset_flags(flags); }
 
   uint32_t            chunk_size() const                  { return m_chunk_size; }
-  size_type           queue_size() const                  { return m_queue.size(); }
+  size_type           queue_size() const                  { return m_queue.size() + m_sync_pending_size; }
 
   download_data*      data()                              { return m_data; }
 
@@ -115,7 +116,23 @@ private:
   inline bool         is_queued(ChunkListNode* node);
 
   inline void         clear_chunk(ChunkListNode* node, release_flags flags);
+  // Chunks waiting for thread_disk to write back their buffers and
+  // then fdatasync their files, they keep their writable reference
+  // until all of the files are synced.
+  struct sync_batch_type {
+    Queue               nodes;
+    std::vector<File*>  files;
+    unsigned int        remaining{0};
+    bool                failed{false};
+  };
+
+  using SyncBatchList = std::list<sync_batch_type>;
+
   inline bool         sync_chunk(ChunkListNode* node, std::pair<int,bool> options);
+  bool                prepare_disk_thread_sync(ChunkListNode* node, std::vector<ChunkPart*>& parts, std::vector<File*>& files);
+  void                sync_on_disk_thread(Queue& nodes, std::vector<ChunkPart*>& parts, std::vector<File*>& files);
+  void                sync_batch_files(SyncBatchList::iterator batch);
+  void                sync_batch_done(SyncBatchList::iterator batch);
 
   Queue::iterator     partition_optimize(Queue::iterator first, Queue::iterator last, int weight, int maxDistance, bool dontSkip);
 
@@ -127,6 +144,8 @@ private:
   download_data*      m_data{};
   ChunkManager*       m_manager{};
   Queue               m_queue;
+  SyncBatchList       m_sync_batches;
+  size_type           m_sync_pending_size{0};
 
   int                 m_flags{0};
   uint32_t            m_chunk_size{0};
@@ -2,8 +2,12 @@
 
 #include <algorithm>
 
+#include "manager.h"
 #include "torrent/exceptions.h"
+#include "torrent/data/file.h"
+#include "torrent/data/file_manager.h"
 #include "chunk_part.h"
+#include "storage_backend.h"
 
 namespace torrent {
 
@@ -14,12 +18,49 @@ ChunkPart::clear() {
     m_chunk.unmap();
     break;
 
+  case MAPPED_BUFFER:
+    StorageBackend::from_mapped(m_mapped)->release_chunk(m_chunk);
+    break;
+
   default:
   case MAPPED_STATIC:
-    throw internal_error("ChunkPart::clear() only MAPPED_MMAP supported.");
+    throw internal_error("ChunkPart::clear() only MAPPED_MMAP and MAPPED_BUFFER supported.");
   }
 
   m_chunk.clear();
+
+  if (m_file != nullptr) {
+    manager->file_manager()->unpin(m_file);
+    m_file = nullptr;
+  }
+}
+
+void
+ChunkPart::set_file(File* f, uint64_t f_offset) {
+  if (m_file != nullptr)
+    manager->file_manager()->unpin(m_file);
+
+  m_file = f;
+  m_file_offset = f_offset;
+
+  if (m_file != nullptr)
+    manager->file_manager()->pin(m_file);
+}
+
+bool
+ChunkPart::sync(int flags) {
+  if (m_mapped != MAPPED_BUFFER)
+    return m_chunk.sync(0, m_chunk.size(), flags);
+
+  if (m_file == nullptr)
+    throw internal_error("ChunkPart::sync(...) buffer part has no file.");
+
+  // The file might have been closed by FileManager since the part was
+  // read.
+  if (!m_file->prepare(false, MemoryChunk::prot_read | MemoryChunk::prot_write, 0))
+    return false;
+
+  return StorageBackend::from_mapped(m_mapped)->write_chunk(m_file->file_descriptor(), m_file_offset, m_chunk, flags);
 }
 
 bool
@@ -33,6 +74,9 @@ ChunkPart::is_incore(uint32_t pos, uint32_t length) {
   if (length > size() || pos + length > size())
     throw internal_error("ChunkPart::is_incore(...) got invalid length.");
 
+  if (m_mapped == MAPPED_BUFFER)
+    return true;
+
   return m_chunk.is_incore(pos, length);
 }
 
@@ -46,6 +90,9 @@ ChunkPart::incore_length(uint32_t pos, uint32_t length) {
   if (pos >= size())
     throw internal_error("ChunkPart::incore_length(...) got invalid position");
 
+  if (m_mapped == MAPPED_BUFFER)
+    return length;
+
   const uint32_t touched = m_chunk.pages_touched(pos, length);
   auto buf = std::make_unique<char[]>(touched);
   auto begin = buf.get();
@@ -13,7 +13,8 @@ class ChunkPart {
 public:
   enum mapped_type {
     MAPPED_MMAP,
-    MAPPED_STATIC
+    MAPPED_STATIC,
+    MAPPED_BUFFER
   };
 
   ChunkPart(mapped_type mapped, const MemoryChunk& c, uint32_t pos) :
@@ -26,6 +27,10 @@ public:
 
   void                clear();
 
+  // Uses msync for mapped parts and pwrite for buffer parts, so the
+  // file must be set on the latter.
+  bool                sync(int flags);
+
   mapped_type         mapped() const                        { return m_mapped; }
 
   MemoryChunk&        chunk()                               { return m_chunk; }
@@ -39,7 +44,8 @@ public:
   File*               file() const                          { return m_file; }
   uint64_t            file_offset() const                   { return m_file_offset; }
 
-  void                set_file(File* f, uint64_t f_offset)  { m_file = f; m_file_offset = f_offset; }
+  // Pins the file in FileManager until the part is cleared.
+  void                set_file(File* f, uint64_t f_offset);
 
   bool                is_incore(uint32_t pos, uint32_t length = ~uint32_t());
   uint32_t            incore_length(uint32_t pos, uint32_t length = ~uint32_t());
@@ -0,0 +1,606 @@
+#include "config.h"
+
+#include "data/disk_io.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <pthread.h>
+#include <thread>
+#include <unistd.h>
+
+#ifdef USE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+#include "torrent/event.h"
+#include "torrent/exceptions.h"
+#include "torrent/utils/log.h"
+#include "torrent/utils/thread.h"
+
+#define LT_LOG(log_fmt, ...)                                            \
+  lt_log_print(LOG_STORAGE_NOTICE, "disk_io: " log_fmt, __VA_ARGS__);
+
+namespace torrent {
+
+class DiskIoThreadPool : public DiskIo {
+public:
+  DiskIoThreadPool(utils::Thread* owner, unsigned int pool_size);
+  ~DiskIoThreadPool() override;
+
+  const char*         name() const override { return "thread_pool"; }
+
+  // The workers pick up requests on their own.
+  void                perform() override {}
+
+protected:
+  void                notify() override { m_worker_cv.notify_one(); }
+
+private:
+  void                worker_loop();
+
+  std::vector<std::thread> m_workers;
+  std::condition_variable  m_worker_cv;
+  bool                     m_stopping{false};
+};
+
+#ifdef USE_IO_URING
+
+class DiskIoUring : public DiskIo, public Event {
+public:
+  static constexpr unsigned int ring_entries = 128;
+
+  DiskIoUring(utils::Thread* owner) : DiskIo(owner) {}
+  ~DiskIoUring() override;
+
+  bool                setup();
+
+  const char*         name() const override      { return "io_uring"; }
+  const char*         type_name() const override { return "disk_io_uring"; }
+
+  void                perform() override;
+  Event*              poll_event() override      { return this; }
+
+  void                event_read() override      { perform(); }
+  void                event_write() override;
+  void                event_error() override;
+
+private:
+  void                release_ring();
+
+  void                submit();
+  void                reap();
+
+  io_uring_params     m_params{};
+
+  void*               m_sq_ring{MAP_FAILED};
+  size_t              m_sq_ring_size{0};
+  void*               m_cq_ring{MAP_FAILED};
+  size_t              m_cq_ring_size{0};
+  io_uring_sqe*       m_sqes{static_cast<io_uring_sqe*>(MAP_FAILED)};
+
+  unsigned*           m_sq_head;
+  unsigned*           m_sq_tail;
+  unsigned*           m_sq_mask;
+  unsigned*           m_sq_array;
+  unsigned*           m_cq_head;
+  unsigned*           m_cq_tail;
+  unsigned*           m_cq_mask;
+  io_uring_cqe*       m_cqes;
+
+  // Writes point the ring at the iovec, so it lives with the
+  // request until completion.
+  struct in_flight_type {
+    request_ptr       request;
+    iovec             iov;
+  };
+
+  std::map<uint64_t, in_flight_type> m_in_flight;
+};
+
+#endif
+
+namespace {
+
+int
+perform_fdatasync(int fd) {
+  while (true) {
+#if defined(_POSIX_SYNCHRONIZED_IO) && _POSIX_SYNCHRONIZED_IO > 0
+    int result = ::fdatasync(fd);
+#else
+    int result = ::fsync(fd);
+#endif
+
+    if (result == 0)
+      return 0;
+
+    if (errno != EINTR)
+      return -errno;
+  }
+}
+
+int
+perform_write(int fd, uint64_t offset, const char* buffer, uint32_t length) {
+  uint32_t done = 0;
+
+  while (done != length) {
+    ssize_t result = ::pwrite(fd, buffer + done, length - done, offset + done);
+
+    if (result == -1 && errno == EINTR)
+      continue;
+
+    if (result == -1)
+      return -errno;
+
+    if (result == 0)
+      return -EIO;
+
+    done += result;
+  }
+
+  return 0;
+}
+
+} // namespace
+
+std::unique_ptr<DiskIo>
+DiskIo::create(utils::Thread* owner, unsigned int pool_size) {
+#ifdef USE_IO_URING
+  auto ring = std::make_unique<DiskIoUring>(owner);
+
+  if (ring->setup()) {
+    LT_LOG("using io_uring", 0);
+    return ring;
+  }
+
+  LT_LOG("io_uring unavailable, falling back to thread pool : %s", std::strerror(errno));
+#endif
+
+  return create_thread_pool(owner, pool_size);
+}
+
+std::unique_ptr<DiskIo>
+DiskIo::create_thread_pool(utils::Thread* owner, unsigned int pool_size) {
+  if (pool_size == 0)
+    throw internal_error("DiskIo::create_thread_pool(...) pool_size == 0.");
+
+  LT_LOG("using thread pool : size:%u", pool_size);
+
+  return std::make_unique<DiskIoThreadPool>(owner, pool_size);
+}
+
+DiskIo::~DiskIo() {
+  assert(m_running.empty() && "DiskIo::~DiskIo() requests still running.");
+
+  for (auto& request : m_pending)
+    ::close(request->fd);
+}
+
+void
+DiskIo::write(void* requester, int fd, uint64_t offset, const char* buffer, uint32_t length, slot_done&& slot) {
+  auto request = std::make_unique<request_type>();
+  request->operation = OPERATION_WRITE;
+  request->offset = offset;
+  request->buffer = buffer;
+  request->length = length;
+  request->requester = requester;
+
+  add_request(std::move(request), fd, std::move(slot));
+}
+
+void
+DiskIo::fdatasync(void* requester, int fd, slot_done&& slot) {
+  auto request = std::make_unique<request_type>();
+  request->operation = OPERATION_FDATASYNC;
+  request->offset = 0;
+  request->buffer = nullptr;
+  request->length = 0;
+  request->requester = requester;
+
+  add_request(std::move(request), fd, std::move(slot));
+}
+
+void
+DiskIo::add_request(request_ptr request, int fd, slot_done&& slot) {
+  auto thread = utils::Thread::self();
+
+  if (thread == nullptr)
+    throw internal_error("DiskIo request made from a thread without a Thread object.");
+
+  if (request->requester == nullptr)
+    throw internal_error("DiskIo request made with a null requester.");
+
+  int dup_fd = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+
+  if (dup_fd == -1) {
+    thread->callback(request->requester, [slot = std::move(slot), result = -errno]() { slot(result); });
+    return;
+  }
+
+  request->fd = dup_fd;
+  request->thread = thread;
+  request->slot = std::move(slot);
+
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_pending.push_back(std::move(request));
+  }
+
+  notify();
+
+  if (m_owner != nullptr)
+    m_owner->interrupt();
+}
+
+void
+DiskIo::cancel(void* requester) {
+  {
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    auto last = std::stable_partition(m_pending.begin(), m_pending.end(), [requester](auto& request) {
+        return request->requester != requester;
+      });
+
+    std::for_each(last, m_pending.end(), [](auto& request) { ::close(request->fd); });
+    m_pending.erase(last, m_pending.end());
+
+    auto is_requester = [requester](auto request) { return request->requester == requester; };
+
+    for (auto request : m_running)
+      if (is_requester(request))
+        request->canceled = true;
+
+    m_finished.wait(lock, [&] { return std::none_of(m_running.begin(), m_running.end(), is_requester); });
+  }
+
+  if (utils::Thread::self() != nullptr)
+    utils::Thread::self()->cancel_callback_and_wait(requester);
+}
+
+void
+DiskIo::wait(void* requester) {
+  {
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    m_finished.wait(lock, [&] {
+        return
+          std::none_of(m_pending.begin(), m_pending.end(), [requester](auto& request) { return request->requester == requester; }) &&
+          std::none_of(m_running.begin(), m_running.end(), [requester](auto request) { return request->requester == requester; });
+      });
+  }
+
+  if (utils::Thread::self() != nullptr)
+    utils::Thread::self()->cancel_callback_and_wait(requester);
+}
+
+unsigned int
+DiskIo::pending() const {
+  std::lock_guard<std::mutex> guard(m_lock);
+  return m_pending.size() + m_running.size();
+}
+
+DiskIo::request_ptr
+DiskIo::pop_pending() {
+  std::lock_guard<std::mutex> guard(m_lock);
+
+  if (m_pending.empty())
+    return nullptr;
+
+  auto request = std::move(m_pending.front());
+  m_pending.pop_front();
+  m_running.push_back(request.get());
+
+  return request;
+}
+
+bool
+DiskIo::has_pending_locked() const {
+  return !m_pending.empty();
+}
+
+void
+DiskIo::push_pending_front(request_ptr request) {
+  std::lock_guard<std::mutex> guard(m_lock);
+
+  m_running.erase(std::find(m_running.begin(), m_running.end(), request.get()));
+
+  if (request->canceled) {
+    ::close(request->fd);
+    m_finished.notify_all();
+    return;
+  }
+
+  m_pending.push_front(std::move(request));
+}
+
+// The callback is added while holding the lock so that 'cancel' can
+// never miss it.
+void
+DiskIo::finish(request_ptr request, int result) {
+  ::close(request->fd);
+
+  std::lock_guard<std::mutex> guard(m_lock);
+
+  m_running.erase(std::find(m_running.begin(), m_running.end(), request.get()));
+
+  if (!request->canceled)
+    request->thread->callback(request->requester, [slot = std::move(request->slot), result]() { slot(result); });
+
+  m_finished.notify_all();
+}
+
+DiskIoThreadPool::DiskIoThreadPool(utils::Thread* owner, unsigned int pool_size) :
+  DiskIo(owner) {
+
+  for (unsigned int i = 0; i < pool_size; i++)
+    m_workers.emplace_back(&DiskIoThreadPool::worker_loop, this);
+}
+
+DiskIoThreadPool::~DiskIoThreadPool() {
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_stopping = true;
+  }
+
+  m_worker_cv.notify_all();
+
+  for (auto& worker : m_workers)
+    worker.join();
+}
+
+void
+DiskIoThreadPool::worker_loop() {
+#if defined(HAS_PTHREAD_SETNAME_NP_DARWIN)
+  pthread_setname_np("rtorrent dio");
+#elif defined(HAS_PTHREAD_SETNAME_NP_GENERIC)
+  pthread_setname_np(pthread_self(), "rtorrent dio");
+#endif
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(m_lock);
+      m_worker_cv.wait(lock, [this] { return m_stopping || has_pending_locked(); });
+
+      if (m_stopping)
+        return;
+    }
+
+    auto request = pop_pending();
+
+    if (request == nullptr)
+      continue;
+
+    int result;
+
+    if (request->operation == OPERATION_WRITE)
+      result = perform_write(request->fd, request->offset, request->buffer, request->length);
+    else
+      result = perform_fdatasync(request->fd);
+
+    finish(std::move(request), result);
+  }
+}
+
+#ifdef USE_IO_URING
+
+DiskIoUring::~DiskIoUring() {
+  // Wait for all submitted requests to complete, so their file
+  // descriptors are closed and 'finish' gets called for each.
+  while (!m_in_flight.empty()) {
+    if (::syscall(__NR_io_uring_enter, m_fileDesc, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) == -1 && errno != EINTR)
+      break;
+
+    reap();
+  }
+
+  release_ring();
+}
+
+bool
+DiskIoUring::setup() {
+  int fd = ::syscall(__NR_io_uring_setup, ring_entries, &m_params);
+
+  if (fd == -1)
+    return false;
+
+  m_fileDesc = fd;
+
+  m_sq_ring_size = m_params.sq_off.array + m_params.sq_entries * sizeof(unsigned);
+  m_cq_ring_size = m_params.cq_off.cqes + m_params.cq_entries * sizeof(io_uring_cqe);
+
+  if (m_params.features & IORING_FEAT_SINGLE_MMAP)
+    m_sq_ring_size = m_cq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+
+  m_sq_ring = ::mmap(nullptr, m_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+
+  if (m_sq_ring == MAP_FAILED) {
+    release_ring();
+    return false;
+  }
+
+  if (m_params.features & IORING_FEAT_SINGLE_MMAP) {
+    m_cq_ring = m_sq_ring;
+  } else {
+    m_cq_ring = ::mmap(nullptr, m_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+
+    if (m_cq_ring == MAP_FAILED) {
+      release_ring();
+      return false;
+    }
+  }
+
+  m_sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, m_params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE,
+                                             MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+
+  if (m_sqes == MAP_FAILED) {
+    release_ring();
+    return false;
+  }
+
+  auto sq_ring = static_cast<char*>(m_sq_ring);
+  auto cq_ring = static_cast<char*>(m_cq_ring);
+
+  m_sq_head  = reinterpret_cast<unsigned*>(sq_ring + m_params.sq_off.head);
+  m_sq_tail  = reinterpret_cast<unsigned*>(sq_ring + m_params.sq_off.tail);
+  m_sq_mask  = reinterpret_cast<unsigned*>(sq_ring + m_params.sq_off.ring_mask);
+  m_sq_array = reinterpret_cast<unsigned*>(sq_ring + m_params.sq_off.array);
+  m_cq_head  = reinterpret_cast<unsigned*>(cq_ring + m_params.cq_off.head);
+  m_cq_tail  = reinterpret_cast<unsigned*>(cq_ring + m_params.cq_off.tail);
+  m_cq_mask  = reinterpret_cast<unsigned*>(cq_ring + m_params.cq_off.ring_mask);
+  m_cqes     = reinterpret_cast<io_uring_cqe*>(cq_ring + m_params.cq_off.cqes);
+
+  return true;
+}
+
+void
+DiskIoUring::release_ring() {
+  int saved_errno = errno;
+
+  if (m_sqes != MAP_FAILED)
+    ::munmap(m_sqes, m_params.sq_entries * sizeof(io_uring_sqe));
+
+  if (m_cq_ring != MAP_FAILED && m_cq_ring != m_sq_ring)
+    ::munmap(m_cq_ring, m_cq_ring_size);
+
+  if (m_sq_ring != MAP_FAILED)
+    ::munmap(m_sq_ring, m_sq_ring_size);
+
+  m_sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+  m_cq_ring = m_sq_ring = MAP_FAILED;
+
+  if (m_fileDesc != -1)
+    ::close(m_fileDesc);
+
+  m_fileDesc = -1;
+  errno = saved_errno;
+}
+
+void
+DiskIoUring::perform() {
+  reap();
+  submit();
+}
+
+void
+DiskIoUring::submit() {
+  unsigned int tail = *m_sq_tail;
+  unsigned int head = __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+
+  // Keep the number of requests in flight below the completion queue
+  // size so that completions are never dropped.
+  while (m_in_flight.size() < m_params.cq_entries && tail - head < m_params.sq_entries) {
+    auto request = pop_pending();
+
+    if (request == nullptr)
+      break;
+
+    auto key = reinterpret_cast<uint64_t>(request.get());
+    auto& in_flight = m_in_flight[key];
+
+    unsigned int index = tail & *m_sq_mask;
+    io_uring_sqe* sqe = &m_sqes[index];
+
+    std::memset(sqe, 0, sizeof(io_uring_sqe));
+    sqe->fd = request->fd;
+    sqe->user_data = key;
+
+    switch (request->operation) {
+    case OPERATION_WRITE:
+      in_flight.iov.iov_base = const_cast<char*>(request->buffer + request->done);
+      in_flight.iov.iov_len = request->length - request->done;
+
+      sqe->opcode = IORING_OP_WRITEV;
+      sqe->off = request->offset + request->done;
+      sqe->addr = reinterpret_cast<uint64_t>(&in_flight.iov);
+      sqe->len = 1;
+      break;
+
+    case OPERATION_FDATASYNC:
+      sqe->opcode = IORING_OP_FSYNC;
+      sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+      break;
+    }
+
+    in_flight.request = std::move(request);
+    m_sq_array[index] = index;
+    tail++;
+  }
+
+  __atomic_store_n(m_sq_tail, tail, __ATOMIC_RELEASE);
+
+  unsigned int to_submit = tail - __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+
+  if (to_submit == 0)
+    return;
+
+  // Entries that were not consumed stay in the ring and get submitted
+  // on the next call.
+  if (::syscall(__NR_io_uring_enter, m_fileDesc, to_submit, 0, 0, nullptr, 0) == -1 &&
+      errno != EINTR && errno != EAGAIN && errno != EBUSY)
+    throw internal_error("DiskIoUring::submit() io_uring_enter failed: " + std::string(std::strerror(errno)));
+}
+
+void
+DiskIoUring::reap() {
+  unsigned int head = *m_cq_head;
+  unsigned int tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+
+  while (head != tail) {
+    io_uring_cqe* cqe = &m_cqes[head & *m_cq_mask];
+    uint64_t key = cqe->user_data;
+    int result = cqe->res;
+
+    __atomic_store_n(m_cq_head, ++head, __ATOMIC_RELEASE);
+
+    auto itr = m_in_flight.find(key);
+
+    if (itr == m_in_flight.end())
+      throw internal_error("DiskIoUring::reap() got completion for unknown request.");
+
+    auto request = std::move(itr->second.request);
+    m_in_flight.erase(itr);
+
+    if (result == -EINTR || result == -EAGAIN) {
+      push_pending_front(std::move(request));
+      continue;
+    }
+
+    if (result < 0 || request->operation == OPERATION_FDATASYNC) {
+      finish(std::move(request), std::min(result, 0));
+      continue;
+    }
+
+    if (result == 0) {
+      finish(std::move(request), -EIO);
+      continue;
+    }
+
+    // Short writes are resubmitted for the remainder.
+    request->done += result;
+
+    if (request->done < request->length)
+      push_pending_front(std::move(request));
+    else
+      finish(std::move(request), 0);
+  }
+}
+
+void
+DiskIoUring::event_write() {
+  throw internal_error("DiskIoUring::event_write() called, but not expected.");
+}
+
+void
+DiskIoUring::event_error() {
+  throw internal_error("DiskIoUring::event_error() called, but not expected.");
+}
+
+#endif // USE_IO_URING
+
+} // namespace torrent
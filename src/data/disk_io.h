@@ -0,0 +1,111 @@
+#ifndef LIBTORRENT_DATA_DISK_IO_H
+#define LIBTORRENT_DATA_DISK_IO_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "torrent/common.h"
+
+namespace torrent {
+
+// Asynchronous positional writes and fdatasync, performed on behalf
+// of other threads.
+//
+// The engine is owned by thread_disk. Uses io_uring when the kernel
+// supports it, otherwise a pool of threads doing blocking pwrite and
+// fdatasync.
+//
+// Completion slots are called through 'Thread::callback' on the
+// thread that made the request, with zero or a negative errno. Writes
+// only complete once all of the data is written. File descriptors are
+// duplicated, so the caller may close them while the request is
+// pending.
+
+class DiskIo {
+public:
+  using slot_done = std::function<void (int)>;
+
+  enum operation_type {
+    OPERATION_WRITE,
+    OPERATION_FDATASYNC
+  };
+
+  static constexpr unsigned int default_pool_size = 4;
+
+  // Returns the io_uring engine when available, else the thread pool.
+  static std::unique_ptr<DiskIo> create(utils::Thread* owner, unsigned int pool_size = default_pool_size);
+  static std::unique_ptr<DiskIo> create_thread_pool(utils::Thread* owner, unsigned int pool_size = default_pool_size);
+
+  virtual ~DiskIo();
+
+  virtual const char* name() const = 0;
+
+  // May be called from any thread with a valid Thread::self(). The
+  // buffer must remain valid until the slot is called or 'cancel' or
+  // 'wait' returns.
+  void                write(void* requester, int fd, uint64_t offset, const char* buffer, uint32_t length, slot_done&& slot);
+  void                fdatasync(void* requester, int fd, slot_done&& slot);
+
+  // Must be called from the requesting thread, and none of the
+  // requester's slots are called after these return. 'cancel' drops
+  // requests not yet started and waits for the rest, while 'wait'
+  // waits for all of them to complete.
+  void                cancel(void* requester);
+  void                wait(void* requester);
+
+  unsigned int        pending() const;
+
+  // Called by the owning thread from 'call_events', and when the
+  // event returned by 'poll_event' becomes readable.
+  virtual void        perform() = 0;
+  virtual Event*      poll_event() { return nullptr; }
+
+protected:
+  struct request_type {
+    operation_type  operation;
+    int             fd;
+    uint64_t        offset;
+    const char*     buffer;
+    uint32_t        length;
+    uint32_t        done{0};
+
+    void*           requester;
+    utils::Thread*  thread;
+    slot_done       slot;
+    bool            canceled{false};
+  };
+
+  using request_ptr = std::unique_ptr<request_type>;
+
+  DiskIo(utils::Thread* owner) : m_owner(owner) {}
+
+  // The engine takes ownership of requests with 'pop_pending' and
+  // must hand them back with 'finish'.
+  request_ptr         pop_pending();
+  bool                has_pending_locked() const;
+  void                push_pending_front(request_ptr request);
+
+  void                finish(request_ptr request, int result);
+
+  // Notified whenever a new request is added.
+  virtual void        notify() {}
+
+  mutable std::mutex      m_lock;
+  std::condition_variable m_finished;
+
+private:
+  void                add_request(request_ptr request, int fd, slot_done&& slot);
+
+  utils::Thread*            m_owner;
+
+  std::deque<request_ptr>   m_pending;
+  std::vector<request_type*> m_running;
+};
+
+} // namespace torrent
+
+#endif
@@ -2,14 +2,19 @@
 
 #include "hash_check_queue.h"
 
+#include <pthread.h>
+
 #include "data/hash_chunk.h"
 #include "torrent/hash_string.h"
 #include "utils/instrumentation.h"
 
 namespace torrent {
 
-HashCheckQueue::HashCheckQueue()  = default;
-HashCheckQueue::~HashCheckQueue() = default;
+HashCheckQueue::HashCheckQueue() = default;
+
+HashCheckQueue::~HashCheckQueue() {
+  stop_workers();
+}
 
 // Always poke thread_disk after calling this.
 void
@@ -28,6 +33,8 @@ HashCheckQueue::push_back(HashChunk* hash_chunk) {
   int64_t size = hash_chunk->chunk()->chunk()->chunk_size();
   instrumentation_update(INSTRUMENTATION_MEMORY_HASHING_CHUNK_COUNT, 1);
   instrumentation_update(INSTRUMENTATION_MEMORY_HASHING_CHUNK_USAGE, size);
+
+  m_worker_cv.notify_one();
 }
 
 // erase...
@@ -70,7 +77,46 @@ void
 HashCheckQueue::perform() {
   auto lock = std::unique_lock(m_lock);
 
+  // The workers own the queue while they are running.
+  if (!m_workers.empty())
+    return;
+
   while (!empty()) {
+    auto hash_chunks = pop_front_locked();
+
+    lock.unlock();
+    perform_chunks(hash_chunks, nullptr);
+    lock.lock();
+  }
+}
+
+void
+HashCheckQueue::set_worker_count(unsigned int count) {
+  if (count > max_workers)
+    throw input_error("HashCheckQueue::set_worker_count(...) count is larger than max_workers.");
+
+  if (count == m_workers.size())
+    return;
+
+  stop_workers();
+  start_workers(count);
+}
+
+void
+HashCheckQueue::set_sha1_engine(Sha1Batch::engine_type engine) {
+  if (!Sha1Batch::is_engine_supported(engine))
+    throw input_error("HashCheckQueue::set_sha1_engine(...) engine not supported by this cpu.");
+
+  m_sha1_engine = engine;
+}
+
+HashCheckQueue::chunk_list
+HashCheckQueue::pop_front_locked() {
+  chunk_list hash_chunks;
+
+  unsigned int lanes = Sha1Batch::engine_lanes(m_sha1_engine);
+
+  while (!empty() && hash_chunks.size() != lanes) {
     HashChunk* hash_chunk = base_type::front();
     base_type::pop_front();
 
@@ -81,15 +127,114 @@ HashCheckQueue::perform() {
     instrumentation_update(INSTRUMENTATION_MEMORY_HASHING_CHUNK_COUNT, -1);
     instrumentation_update(INSTRUMENTATION_MEMORY_HASHING_CHUNK_USAGE, -size);
 
-    lock.unlock();
+    hash_chunks.push_back(hash_chunk);
+  }
 
-    if (!hash_chunk->perform(~uint32_t(), true))
-      throw internal_error("HashCheckQueue::perform(): !hash_chunk->perform(~uint32_t(), true).");
+  return hash_chunks;
+}
 
-    HashString hash;
-    hash_chunk->hash_c(hash.data());
+void
+HashCheckQueue::perform_chunks(const chunk_list& hash_chunks, worker_type* worker) {
+  Sha1Batch batch(m_sha1_engine);
+  int64_t   total_size = 0;
 
-    m_slot_chunk_done(hash_chunk, hash);
+  for (auto hash_chunk : hash_chunks) {
+    Sha1Batch::segment_list segments;
+
+    for (auto& part : *hash_chunk->chunk()->chunk())
+      segments.emplace_back(part.chunk().begin(), part.size());
+
+    batch.push_back(std::move(segments));
+    total_size += hash_chunk->chunk()->chunk()->chunk_size();
+  }
+
+  char digests[Sha1Batch::max_lanes * HashString::size_data];
+  batch.perform(digests);
+
+  if (worker != nullptr) {
+    worker->chunks += hash_chunks.size();
+    worker->bytes += total_size;
+
+    instrumentation_update(INSTRUMENTATION_HASHING_WORKER_CHUNKS, hash_chunks.size());
+    instrumentation_update(INSTRUMENTATION_HASHING_WORKER_BYTES, total_size);
+  } else {
+    instrumentation_update(INSTRUMENTATION_HASHING_DISK_CHUNKS, hash_chunks.size());
+    instrumentation_update(INSTRUMENTATION_HASHING_DISK_BYTES, total_size);
+  }
+
+  for (size_t i = 0; i < hash_chunks.size(); i++)
+    m_slot_chunk_done(hash_chunks[i], *HashString::cast_from(digests + i * HashString::size_data));
+}
+
+void
+HashCheckQueue::start_workers(unsigned int count) {
+  auto lock = std::scoped_lock(m_lock);
+
+  m_workers_stopping = false;
+
+  for (unsigned int i = 0; i < count; i++) {
+    auto worker = std::make_unique<worker_type>();
+    worker->thread = std::thread(&HashCheckQueue::worker_loop, this, worker.get());
+
+    m_workers.push_back(std::move(worker));
+  }
+
+  instrumentation_update(INSTRUMENTATION_HASHING_WORKERS, count);
+}
+
+// Chunks still in the queue are left for the next call to 'perform()'
+// or the next set of workers, 'slot_pending' is called to make sure
+// the owning thread picks them up.
+void
+HashCheckQueue::stop_workers() {
+  {
+    auto lock = std::scoped_lock(m_lock);
+
+    if (m_workers.empty())
+      return;
+
+    m_workers_stopping = true;
+  }
+
+  m_worker_cv.notify_all();
+
+  for (auto& worker : m_workers)
+    worker->thread.join();
+
+  instrumentation_update(INSTRUMENTATION_HASHING_WORKERS, -static_cast<int64_t>(m_workers.size()));
+
+  bool pending;
+
+  {
+    auto lock = std::scoped_lock(m_lock);
+    m_workers.clear();
+    pending = !empty();
+  }
+
+  if (pending && m_slot_pending)
+    m_slot_pending();
+}
+
+void
+HashCheckQueue::worker_loop(worker_type* worker) {
+#if defined(HAS_PTHREAD_SETNAME_NP_DARWIN)
+  pthread_setname_np("rtorrent hash");
+#elif defined(HAS_PTHREAD_SETNAME_NP_GENERIC)
+  pthread_setname_np(pthread_self(), "rtorrent hash");
+#endif
+
+  auto lock = std::unique_lock(m_lock);
+
+  while (true) {
+    m_worker_cv.wait(lock, [this] { return m_workers_stopping || !empty(); });
+
+    if (m_workers_stopping)
+      break;
+
+    auto hash_chunks = pop_front_locked();
+
+    lock.unlock();
+    perform_chunks(hash_chunks, worker);
     lock.lock();
   }
 }
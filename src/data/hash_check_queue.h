@@ -1,9 +1,16 @@
 #ifndef LIBTORRENT_DATA_HASH_CHECK_QUEUE_H
 #define LIBTORRENT_DATA_HASH_CHECK_QUEUE_H
 
+#include <atomic>
+#include <condition_variable>
 #include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <vector>
+
+#include "utils/sha1_batch.h"
 
 // TODO: Create separate directory for thread_disk's hash checking code.
 
@@ -12,10 +19,19 @@ namespace torrent {
 class HashString;
 class HashChunk;
 
+// When no workers are started the queue is drained by calling
+// 'perform()', usually from thread_disk. With workers started each
+// worker pulls chunks from the shared queue and 'perform()' does
+// nothing, leaving thread_disk free to handle its other events.
+//
+// Chunks are taken from the queue in groups of up to the number of
+// lanes of the SHA-1 batch engine and hashed together.
+
 class HashCheckQueue : private std::deque<HashChunk*> {
 public:
   using base_type         = std::deque<HashChunk*>;
   using slot_chunk_handle = std::function<void(HashChunk*, const HashString&)>;
+  using slot_void         = std::function<void()>;
 
   using base_type::iterator;
 
@@ -27,6 +43,8 @@ public:
   using base_type::front;
   using base_type::back;
 
+  static constexpr unsigned int max_workers = 64;
+
   HashCheckQueue();
   ~HashCheckQueue();
 
@@ -39,9 +57,47 @@ public:
 
   slot_chunk_handle&  slot_chunk_done() { return m_slot_chunk_done; }
 
+  // Called when stopping the workers leaves chunks in the queue, so
+  // the owning thread wakes up and drains them with 'perform()'.
+  slot_void&          slot_pending()    { return m_slot_pending; }
+
+  // Not thread-safe, only call these from the main thread and never
+  // from within 'slot_chunk_done'.
+  unsigned int        worker_count() const { return m_workers.size(); }
+  void                set_worker_count(unsigned int count);
+
+  uint64_t            worker_chunks(unsigned int index) const { return m_workers.at(index)->chunks.load(); }
+  uint64_t            worker_bytes(unsigned int index) const  { return m_workers.at(index)->bytes.load(); }
+
+  Sha1Batch::engine_type sha1_engine() const                   { return m_sha1_engine; }
+  void                set_sha1_engine(Sha1Batch::engine_type engine);
+
 private:
-  std::mutex          m_lock;
-  slot_chunk_handle   m_slot_chunk_done;
+  struct worker_type {
+    std::thread           thread;
+    std::atomic<uint64_t> chunks{0};
+    std::atomic<uint64_t> bytes{0};
+  };
+
+  using worker_list = std::vector<std::unique_ptr<worker_type>>;
+  using chunk_list  = std::vector<HashChunk*>;
+
+  chunk_list          pop_front_locked();
+  void                perform_chunks(const chunk_list& hash_chunks, worker_type* worker);
+
+  void                start_workers(unsigned int count);
+  void                stop_workers();
+  void                worker_loop(worker_type* worker);
+
+  std::mutex              m_lock;
+  std::condition_variable m_worker_cv;
+  slot_chunk_handle       m_slot_chunk_done;
+  slot_void               m_slot_pending;
+
+  worker_list             m_workers;
+  bool                    m_workers_stopping{false};
+
+  std::atomic<Sha1Batch::engine_type> m_sha1_engine{Sha1Batch::default_engine()};
 };
 
 } // namespace torrent
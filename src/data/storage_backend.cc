@@ -0,0 +1,213 @@
+#include "config.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "data/socket_file.h"
+#include "data/storage_backend.h"
+#include "torrent/chunk_manager.h"
+#include "torrent/exceptions.h"
+
+namespace torrent {
+
+StorageBackend*
+StorageBackend::from_type(uint32_t type) {
+  switch (type) {
+  case ChunkManager::storage_backend_mmap:
+    return from_mapped(ChunkPart::MAPPED_MMAP);
+  case ChunkManager::storage_backend_pread:
+    return from_mapped(ChunkPart::MAPPED_BUFFER);
+  default:
+    throw internal_error("StorageBackend::from_type(...) invalid backend type.");
+  }
+}
+
+StorageBackend*
+StorageBackend::from_mapped(ChunkPart::mapped_type mapped) {
+  static StorageBackendMmap  backend_mmap;
+  static StorageBackendPread backend_pread;
+
+  switch (mapped) {
+  case ChunkPart::MAPPED_MMAP:
+    return &backend_mmap;
+  case ChunkPart::MAPPED_BUFFER:
+    return &backend_pread;
+  default:
+    throw internal_error("StorageBackend::from_mapped(...) mapped type has no backend.");
+  }
+}
+
+MemoryChunk
+StorageBackendMmap::create_chunk(int fd, uint64_t offset, uint32_t length, int prot) {
+  return SocketFile(fd).create_chunk(offset, length, prot, MemoryChunk::map_shared);
+}
+
+void
+StorageBackendMmap::release_chunk(MemoryChunk& mc) {
+  mc.unmap();
+}
+
+bool
+StorageBackendMmap::write_chunk([[maybe_unused]] int fd, [[maybe_unused]] uint64_t offset, MemoryChunk& mc, int flags) {
+  return mc.sync(0, mc.size(), flags);
+}
+
+StorageBackendPread::~StorageBackendPread() {
+  trim_pool_locked(0);
+}
+
+uint32_t
+StorageBackendPread::buffer_size_class(uint32_t length) {
+  uint32_t size_class = MemoryChunk::page_size();
+
+  while (size_class < length && size_class < (uint32_t{1} << 31))
+    size_class <<= 1;
+
+  if (size_class < length)
+    throw internal_error("StorageBackendPread::buffer_size_class(...) length too large.");
+
+  return size_class;
+}
+
+char*
+StorageBackendPread::allocate_buffer(uint32_t size_class) {
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    auto itr = m_pool.find(size_class);
+
+    if (itr != m_pool.end() && !itr->second.empty()) {
+      char* buffer = itr->second.back();
+      itr->second.pop_back();
+      m_pooled_bytes -= size_class;
+      return buffer;
+    }
+  }
+
+  void* buffer = nullptr;
+
+  if (posix_memalign(&buffer, MemoryChunk::page_size(), size_class) != 0) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+
+  return static_cast<char*>(buffer);
+}
+
+MemoryChunk
+StorageBackendPread::create_chunk(int fd, uint64_t offset, uint32_t length, int prot) {
+  if (fd == SocketFile::invalid_fd)
+    throw internal_error("StorageBackendPread::create_chunk(...) called on a closed file.");
+
+  SocketFile file(fd);
+
+  if (length == 0 || offset > file.size() || offset + length > file.size())
+    return MemoryChunk();
+
+  char* buffer = allocate_buffer(buffer_size_class(length));
+
+  if (buffer == nullptr)
+    return MemoryChunk();
+
+  // MemoryChunk takes ownership of the buffer in 'release_chunk', so
+  // construct it before any early return to get it back on failure.
+  MemoryChunk mc(buffer, buffer, buffer + length, prot, 0);
+
+  for (uint32_t done = 0; done != length; ) {
+    ssize_t result = ::pread(fd, buffer + done, length - done, offset + done);
+
+    if (result == -1 && errno == EINTR)
+      continue;
+
+    if (result <= 0) {
+      int saved_errno = result == 0 ? EIO : errno;
+
+      release_chunk(mc);
+      errno = saved_errno;
+      return MemoryChunk();
+    }
+
+    done += result;
+  }
+
+  return mc;
+}
+
+void
+StorageBackendPread::release_chunk(MemoryChunk& mc) {
+  if (!mc.is_valid())
+    throw internal_error("StorageBackendPread::release_chunk(...) called on an invalid object.");
+
+  uint32_t size_class = buffer_size_class(mc.size());
+
+  std::lock_guard<std::mutex> guard(m_lock);
+
+  if (m_pooled_bytes + size_class > m_max_pooled) {
+    std::free(mc.ptr());
+    return;
+  }
+
+  m_pool[size_class].push_back(mc.ptr());
+  m_pooled_bytes += size_class;
+}
+
+// There's no dirty tracking, so the whole buffer is written back each
+// time.
+bool
+StorageBackendPread::write_chunk(int fd, uint64_t offset, MemoryChunk& mc, int flags) {
+  if (!mc.is_valid())
+    throw internal_error("StorageBackendPread::write_chunk(...) called on an invalid object.");
+
+  for (uint32_t done = 0, length = mc.size(); done != length; ) {
+    ssize_t result = ::pwrite(fd, mc.begin() + done, length - done, offset + done);
+
+    if (result == -1 && errno == EINTR)
+      continue;
+
+    if (result <= 0) {
+      if (result == 0)
+        errno = EIO;
+
+      return false;
+    }
+
+    done += result;
+  }
+
+  if (!(flags & MemoryChunk::sync_sync))
+    return true;
+
+#if defined(_POSIX_SYNCHRONIZED_IO) && _POSIX_SYNCHRONIZED_IO > 0
+  return ::fdatasync(fd) == 0;
+#else
+  return ::fsync(fd) == 0;
+#endif
+}
+
+uint64_t
+StorageBackendPread::pooled_bytes() const {
+  std::lock_guard<std::mutex> guard(m_lock);
+  return m_pooled_bytes;
+}
+
+void
+StorageBackendPread::set_max_pooled(uint64_t bytes) {
+  std::lock_guard<std::mutex> guard(m_lock);
+
+  m_max_pooled = bytes;
+  trim_pool_locked(bytes);
+}
+
+void
+StorageBackendPread::trim_pool_locked(uint64_t target) {
+  for (auto itr = m_pool.rbegin(); itr != m_pool.rend() && m_pooled_bytes > target; ++itr) {
+    while (!itr->second.empty() && m_pooled_bytes > target) {
+      std::free(itr->second.back());
+      itr->second.pop_back();
+      m_pooled_bytes -= itr->first;
+    }
+  }
+}
+
+} // namespace torrent
@@ -0,0 +1,88 @@
+#ifndef LIBTORRENT_DATA_STORAGE_BACKEND_H
+#define LIBTORRENT_DATA_STORAGE_BACKEND_H
+
+#include <cinttypes>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "chunk_part.h"
+#include "memory_chunk.h"
+
+namespace torrent {
+
+// Provides the memory backing the file parts of a Chunk.
+//
+// The mmap backend maps the file directly, while the pread backend
+// copies the data into page-aligned heap buffers and writes them back
+// with pwrite when the chunk is synced or released. The latter avoids
+// large numbers of mappings, TLB shootdowns on munmap and SIGBUS when
+// the disk is full, at the cost of an extra copy.
+//
+// Chunk parts remember which backend created them through their
+// mapped type, so the backend may be changed while chunks are held.
+
+class StorageBackend {
+public:
+  virtual ~StorageBackend() = default;
+
+  // Takes the ChunkManager::storage_backend_* value.
+  static StorageBackend*  from_type(uint32_t type);
+  static StorageBackend*  from_mapped(ChunkPart::mapped_type mapped);
+
+  virtual ChunkPart::mapped_type mapped() const = 0;
+
+  // Returns an invalid MemoryChunk on failure, use errno for the
+  // reason.
+  virtual MemoryChunk     create_chunk(int fd, uint64_t offset, uint32_t length, int prot) = 0;
+  virtual void            release_chunk(MemoryChunk& mc) = 0;
+
+  // Flags are MemoryChunk::sync_*.
+  virtual bool            write_chunk(int fd, uint64_t offset, MemoryChunk& mc, int flags) = 0;
+};
+
+class StorageBackendMmap : public StorageBackend {
+public:
+  ChunkPart::mapped_type mapped() const override { return ChunkPart::MAPPED_MMAP; }
+
+  MemoryChunk     create_chunk(int fd, uint64_t offset, uint32_t length, int prot) override;
+  void            release_chunk(MemoryChunk& mc) override;
+
+  bool            write_chunk(int fd, uint64_t offset, MemoryChunk& mc, int flags) override;
+};
+
+class StorageBackendPread : public StorageBackend {
+public:
+  // Released buffers are kept for reuse up to this many bytes.
+  static constexpr uint64_t default_max_pooled = 64 << 20;
+
+  ~StorageBackendPread() override;
+
+  ChunkPart::mapped_type mapped() const override { return ChunkPart::MAPPED_BUFFER; }
+
+  MemoryChunk     create_chunk(int fd, uint64_t offset, uint32_t length, int prot) override;
+  void            release_chunk(MemoryChunk& mc) override;
+
+  bool            write_chunk(int fd, uint64_t offset, MemoryChunk& mc, int flags) override;
+
+  uint64_t        pooled_bytes() const;
+  uint64_t        max_pooled() const                 { return m_max_pooled; }
+  void            set_max_pooled(uint64_t bytes);
+
+  // Buffers are handed out in power-of-two size classes of at least
+  // one page.
+  static uint32_t buffer_size_class(uint32_t length);
+
+private:
+  char*           allocate_buffer(uint32_t size_class);
+  void            trim_pool_locked(uint64_t target);
+
+  mutable std::mutex                       m_lock;
+  std::map<uint32_t, std::vector<char*>>   m_pool;
+  uint64_t                                 m_pooled_bytes{0};
+  uint64_t                                 m_max_pooled{default_max_pooled};
+};
+
+} // namespace torrent
+
+#endif
@@ -7,6 +7,7 @@
 #include "thread_main.h"
 #include "data/hash_queue.h"
 #include "torrent/exceptions.h"
+#include "torrent/poll.h"
 #include "torrent/net/resolver.h"
 #include "utils/instrumentation.h"
 
@@ -38,12 +39,29 @@ ThreadDisk::init_thread() {
   m_hash_check_queue.slot_chunk_done() = [](auto hc, const auto& hv) {
       ThreadMain::thread_main()->hash_queue()->chunk_done(hc, hv);
     };
+  m_hash_check_queue.slot_pending() = [this] { interrupt(); };
+
+  m_disk_io = DiskIo::create(this);
+
+  if (auto event = m_disk_io->poll_event()) {
+    m_poll->open(event);
+    m_poll->insert_read(event);
+  }
 }
 
 void
 ThreadDisk::cleanup_thread() {
   m_thread_disk = nullptr;
 
+  // The hash workers are stopped by 'torrent::cleanup()' from the main
+  // thread before this thread is stopped.
+  assert(m_hash_check_queue.worker_count() == 0 && "ThreadDisk::cleanup_thread(): hash workers still running.");
+
+  if (auto event = m_disk_io->poll_event())
+    m_poll->remove_and_close(event);
+
+  m_disk_io.reset();
+
   assert(m_hash_check_queue.empty() && "ThreadDisk::cleanup_thread(): m_hash_check_queue not empty.");
 }
 
@@ -61,6 +79,7 @@ ThreadDisk::call_events() {
   }
 
   m_hash_check_queue.perform();
+  m_disk_io->perform();
   process_callbacks();
 }
 
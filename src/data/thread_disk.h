@@ -1,6 +1,9 @@
 #ifndef LIBTORRENT_DATA_THREAD_DISK_H
 #define LIBTORRENT_DATA_THREAD_DISK_H
 
+#include <memory>
+
+#include "data/disk_io.h"
 #include "data/hash_check_queue.h"
 #include "torrent/common.h"
 #include "torrent/utils/thread.h"
@@ -18,6 +21,9 @@ public:
 
   HashCheckQueue* hash_check_queue() { return &m_hash_check_queue; }
 
+  // Only valid between init_thread and cleanup_thread.
+  DiskIo*         disk_io()          { return m_disk_io.get(); }
+
   void            init_thread() override;
   void            cleanup_thread() override;
 
@@ -30,6 +36,7 @@ private:
   static ThreadDisk* m_thread_disk;
 
   HashCheckQueue  m_hash_check_queue;
+  std::unique_ptr<DiskIo> m_disk_io;
 };
 
 inline ThreadDisk* thread_disk() {
@@ -665,186 +665,240 @@ DhtServer::clear_transactions() {
   m_transactions.clear();
 }
 
+// Drains the socket a batch of datagrams at a time.
 void
 DhtServer::event_read() {
   uint32_t total = 0;
 
   while (true) {
-    Object request;
-    rak::socket_address sa;
-    int type = '?';
-    DhtMessage message;
-    const HashString* nodeId = NULL;
+    int count = read_datagrams(m_read_batch);
 
-    try {
-      char buffer[2048];
-      int32_t read = read_datagram(buffer, sizeof(buffer), &sa);
+    if (count <= 0)
+      break;
 
-      if (read < 0)
-        break;
+    for (int i = 0; i != count; i++) {
+      rak::socket_address sa = *rak::socket_address::cast_from(m_read_batch.address(i));
 
-      // We can currently only process mapped-IPv4 addresses, not real IPv6.
-      // Translate them to an af_inet socket_address.
-      if (sa.family() == rak::socket_address::af_inet6)
-        sa = sa.sa_inet6()->normalize_address();
+      total += process_datagram(m_read_batch.data(i), m_read_batch.length(i), &sa);
+    }
 
-      if (sa.family() != rak::socket_address::af_inet)
-        continue;
+    if (static_cast<unsigned int>(count) != m_read_batch.capacity())
+      break;
+  }
 
-      total += read;
+  m_downloadThrottle->node_used_unthrottled(total);
+  m_downloadNode.rate()->insert(total);
 
-      // If it's not a valid bencode dictionary at all, it's probably not a DHT
-      // packet at all, so we don't throw an error to prevent bounce loops.
-      try {
-        static_map_read_bencode(buffer, buffer + read, message);
-      } catch (const bencode_error&) {
-        continue;
-      }
+  start_write();
+}
 
-      if (!message[key_t].is_raw_string())
-        throw dht_error(dht_error_protocol, "No transaction ID");
+// Returns the number of bytes accounted to the download throttle.
+uint32_t
+DhtServer::process_datagram(const char* buffer, uint32_t length, rak::socket_address* sa) {
+  int type = '?';
+  DhtMessage message;
+  const HashString* nodeId = NULL;
 
-      // Restrict the length of Transaction IDs. We echo them in our replies.
-      if(message[key_t].as_raw_string().size() > 20) {
-		  throw dht_error(dht_error_protocol, "Transaction ID length too long");
-      }
+  // We can currently only process mapped-IPv4 addresses, not real IPv6.
+  // Translate them to an af_inet socket_address.
+  if (sa->family() == rak::socket_address::af_inet6)
+    *sa = sa->sa_inet6()->normalize_address();
 
-      if (!message[key_y].is_raw_string())
-        throw dht_error(dht_error_protocol, "No message type");
+  if (sa->family() != rak::socket_address::af_inet)
+    return 0;
 
-      if (message[key_y].as_raw_string().size() != 1)
-        throw dht_error(dht_error_bad_method, "Unsupported message type");
+  try {
+    // If it's not a valid bencode dictionary at all, it's probably not a DHT
+    // packet at all, so we don't throw an error to prevent bounce loops.
+    try {
+      static_map_read_bencode(buffer, buffer + length, message);
+    } catch (const bencode_error&) {
+      return length;
+    }
 
-      type = message[key_y].as_raw_string().data()[0];
+    if (!message[key_t].is_raw_string())
+      throw dht_error(dht_error_protocol, "No transaction ID");
 
-      // Queries and replies have node ID in different dictionaries.
-      if (type == 'r' || type == 'q') {
-        if (!message[type == 'q' ? key_a_id : key_r_id].is_raw_string())
-          throw dht_error(dht_error_protocol, "Invalid `id' value");
+    // Restrict the length of Transaction IDs. We echo them in our replies.
+    if(message[key_t].as_raw_string().size() > 20) {
+      throw dht_error(dht_error_protocol, "Transaction ID length too long");
+    }
 
-        raw_string nodeIdStr = message[type == 'q' ? key_a_id : key_r_id].as_raw_string();
+    if (!message[key_y].is_raw_string())
+      throw dht_error(dht_error_protocol, "No message type");
 
-        if (nodeIdStr.size() < HashString::size_data)
-          throw dht_error(dht_error_protocol, "`id' value too short");
+    if (message[key_y].as_raw_string().size() != 1)
+      throw dht_error(dht_error_bad_method, "Unsupported message type");
 
-        nodeId = HashString::cast_from(nodeIdStr.data());
-      }
+    type = message[key_y].as_raw_string().data()[0];
 
-      // Sanity check the returned transaction ID.
-      if ((type == 'r' || type == 'e') && 
-          (!message[key_t].is_raw_string() || message[key_t].as_raw_string().size() != 1))
-        throw dht_error(dht_error_protocol, "Invalid transaction ID type/length.");
+    // Queries and replies have node ID in different dictionaries.
+    if (type == 'r' || type == 'q') {
+      if (!message[type == 'q' ? key_a_id : key_r_id].is_raw_string())
+        throw dht_error(dht_error_protocol, "Invalid `id' value");
 
-      // Stupid broken implementations.
-      if (nodeId != NULL && *nodeId == m_router->id())
-        throw dht_error(dht_error_protocol, "Send your own ID, not mine");
+      raw_string nodeIdStr = message[type == 'q' ? key_a_id : key_r_id].as_raw_string();
 
-      switch (type) {
-        case 'q':
-          process_query(*nodeId, &sa, message);
-          break;
+      if (nodeIdStr.size() < HashString::size_data)
+        throw dht_error(dht_error_protocol, "`id' value too short");
 
-        case 'r':
-          process_response(*nodeId, &sa, message);
-          break;
+      nodeId = HashString::cast_from(nodeIdStr.data());
+    }
 
-        case 'e':
-          process_error(&sa, message);
-          break;
+    // Sanity check the returned transaction ID.
+    if ((type == 'r' || type == 'e') && 
+        (!message[key_t].is_raw_string() || message[key_t].as_raw_string().size() != 1))
+      throw dht_error(dht_error_protocol, "Invalid transaction ID type/length.");
 
-        default:
-          throw dht_error(dht_error_bad_method, "Unknown message type.");
-      }
+    // Stupid broken implementations.
+    if (nodeId != NULL && *nodeId == m_router->id())
+      throw dht_error(dht_error_protocol, "Send your own ID, not mine");
 
-    // If node was querying us, reply with error packet, otherwise mark the node as "query failed",
-    // so that if it repeatedly sends malformed replies we will drop it instead of propagating it
-    // to other nodes.
-    } catch (const bencode_error& e) {
-      if ((type == 'r' || type == 'e') && nodeId != NULL) {
-        m_router->node_inactive(*nodeId, &sa);
-      } else {
-        snprintf(message.data_end, message.data + torrent::DhtMessage::data_size - message.data_end - 1, "Malformed packet: %s", e.what());
-        message.data[torrent::DhtMessage::data_size - 1] = '\0';
-        create_error(message, &sa, dht_error_protocol, message.data_end);
-      }
+    switch (type) {
+      case 'q':
+        process_query(*nodeId, sa, message);
+        break;
+
+      case 'r':
+        process_response(*nodeId, sa, message);
+        break;
 
-    } catch (const dht_error& e) {
-      if ((type == 'r' || type == 'e') && nodeId != NULL)
-        m_router->node_inactive(*nodeId, &sa);
-      else
-        create_error(message, &sa, e.code(), e.what());
+      case 'e':
+        process_error(sa, message);
+        break;
 
-    } catch (const network_error&) {
+      default:
+        throw dht_error(dht_error_bad_method, "Unknown message type.");
     }
-  }
 
-  m_downloadThrottle->node_used_unthrottled(total);
-  m_downloadNode.rate()->insert(total);
+  // If node was querying us, reply with error packet, otherwise mark the node as "query failed",
+  // so that if it repeatedly sends malformed replies we will drop it instead of propagating it
+  // to other nodes.
+  } catch (const bencode_error& e) {
+    if ((type == 'r' || type == 'e') && nodeId != NULL) {
+      m_router->node_inactive(*nodeId, sa);
+    } else {
+      snprintf(message.data_end, message.data + torrent::DhtMessage::data_size - message.data_end - 1, "Malformed packet: %s", e.what());
+      message.data[torrent::DhtMessage::data_size - 1] = '\0';
+      create_error(message, sa, dht_error_protocol, message.data_end);
+    }
 
-  start_write();
+  } catch (const dht_error& e) {
+    if ((type == 'r' || type == 'e') && nodeId != NULL)
+      m_router->node_inactive(*nodeId, sa);
+    else
+      create_error(message, sa, e.code(), e.what());
+
+  } catch (const network_error&) {
+  }
+
+  return length;
 }
 
+// Packets are gathered into batches and sent with a single system
+// call, as long as the whole batch fits within the quota.
 bool
 DhtServer::process_queue(packet_queue& queue, uint32_t* quota) {
   uint32_t used = 0;
+  DhtTransactionPacket* packets[batch_size];
 
   while (!queue.empty()) {
-    DhtTransactionPacket* packet = queue.front();
-    DhtTransaction::key_type transactionKey = 0;
-    if(packet->has_transaction())
-      transactionKey = packet->transaction()->key(packet->id());
-
-    // Make sure its transaction hasn't timed out yet, if it has/had one
-    // and don't bother sending non-transaction packets (replies) after 
-    // more than 15 seconds in the queue.
-    if (packet->has_failed() || packet->age() > 15) {
-      delete packet;
+    uint32_t batch_length = 0;
+    bool     out_of_quota = false;
+
+    m_write_batch.clear();
+
+    while (!queue.empty() && !m_write_batch.full()) {
+      DhtTransactionPacket* packet = queue.front();
+
+      // Make sure its transaction hasn't timed out yet, if it has/had one
+      // and don't bother sending non-transaction packets (replies) after 
+      // more than 15 seconds in the queue.
+      if (packet->has_failed() || packet->age() > 15) {
+        delete packet;
+        queue.pop_front();
+        continue;
+      }
+
+      if (batch_length + packet->length() > *quota) {
+        out_of_quota = true;
+        break;
+      }
+
       queue.pop_front();
-      continue;
+
+      packets[m_write_batch.size()] = packet;
+      m_write_batch.push_back(packet->c_str(), packet->length(), packet->address()->c_sockaddr());
+      batch_length += packet->length();
     }
 
-    if (packet->length() > *quota) {
+    if (!m_write_batch.empty()) {
+      uint32_t written = flush_write_batch(packets);
+
+      used += written;
+      *quota -= written;
+    }
+
+    if (out_of_quota) {
       m_uploadThrottle->node_used(&m_uploadNode, used);
       return false;
     }
+  }
 
-    queue.pop_front();
-
-    try {
-      int written = write_datagram(packet->c_str(), packet->length(), packet->address());
+  m_uploadThrottle->node_used(&m_uploadNode, used);
+  return true;
+}
 
-      if (written == -1)
-        throw network_error();
+// Sends all packets in the write batch and releases them, returning
+// the number of bytes written.
+uint32_t
+DhtServer::flush_write_batch(DhtTransactionPacket** packets) {
+  uint32_t written = 0;
+  unsigned int index = 0;
 
-      used += written;
-      *quota -= written;
+  while (index != m_write_batch.size()) {
+    int count = write_datagrams(m_write_batch, index);
 
-      if (static_cast<unsigned int>(written) != packet->length())
-        throw network_error();
+    // Couldn't write packet, maybe something wrong with node address
+    // or routing, so mark node as bad and continue with the next.
+    if (count <= 0) {
+      finish_packet(packets[index++], true);
+      continue;
+    }
 
-    } catch (const network_error&) {
-      // Couldn't write packet, maybe something wrong with node address or routing, so mark node as bad.
-      if (packet->has_transaction()) {
-        auto itr = m_transactions.find(transactionKey);
-        if (itr == m_transactions.end())
-          throw internal_error("DhtServer::process_queue could not find transaction.");
+    for (int i = 0; i != count; i++, index++) {
+      written += m_write_batch.length(index);
 
-        failed_transaction(itr, false);
-      }
+      finish_packet(packets[index], m_write_batch.length(index) != packets[index]->length());
     }
+  }
 
-    if (packet->has_transaction()) {
-      // here transaction can be already deleted by failed_transaction.
-      auto itr = m_transactions.find(transactionKey);
-      if (itr != m_transactions.end())
-        packet->transaction()->set_packet(NULL);
-    }
+  return written;
+}
 
-    delete packet;
+void
+DhtServer::finish_packet(DhtTransactionPacket* packet, bool failed) {
+  DhtTransaction::key_type transactionKey = 0;
+
+  if (packet->has_transaction())
+    transactionKey = packet->transaction()->key(packet->id());
+
+  if (failed && packet->has_transaction()) {
+    auto itr = m_transactions.find(transactionKey);
+    if (itr == m_transactions.end())
+      throw internal_error("DhtServer::finish_packet could not find transaction.");
+
+    failed_transaction(itr, false);
   }
 
-  m_uploadThrottle->node_used(&m_uploadNode, used);
-  return true;
+  if (packet->has_transaction()) {
+    // here transaction can be already deleted by failed_transaction.
+    auto itr = m_transactions.find(transactionKey);
+    if (itr != m_transactions.end())
+      packet->transaction()->set_packet(NULL);
+  }
+
+  delete packet;
 }
 
 void
@@ -101,6 +101,10 @@ private:
     "announce_peer",
   };
 
+  // Datagrams received or sent per system call.
+  static constexpr unsigned int batch_size          = 32;
+  static constexpr uint32_t     read_buffer_size    = 2048;
+
   // Priorities for the outgoing packets.
   static constexpr int packet_prio_high  = 2;  // For important queries we send (announces).
   static constexpr int packet_prio_low   = 1;  // For (relatively) unimportant queries we send.
@@ -108,6 +112,8 @@ private:
 
   void                start_write();
 
+  uint32_t            process_datagram(const char* buffer, uint32_t length, rak::socket_address* sa);
+
   void                process_query(const HashString& id, const rak::socket_address* sa, const DhtMessage& req);
   void                process_response(const HashString& id, const rak::socket_address* sa, const DhtMessage& req);
   void                process_error(const rak::socket_address* sa, const DhtMessage& error);
@@ -135,6 +141,8 @@ private:
   void                clear_transactions();
 
   bool                process_queue(packet_queue& queue, uint32_t* quota);
+  uint32_t            flush_write_batch(DhtTransactionPacket** packets);
+  void                finish_packet(DhtTransactionPacket* packet, bool failed);
   void                receive_timeout();
 
   DhtRouter*          m_router{};
@@ -142,6 +150,9 @@ private:
   packet_queue        m_lowQueue;
   transaction_map     m_transactions;
 
+  DatagramBatch       m_read_batch{batch_size, read_buffer_size};
+  DatagramBatch       m_write_batch{batch_size, 0};
+
   utils::SchedulerEntry m_task_timeout;
 
   ThrottleNode        m_uploadNode{60};
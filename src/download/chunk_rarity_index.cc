@@ -0,0 +1,78 @@
+#include "config.h"
+
+#include "download/chunk_rarity_index.h"
+
+#include <algorithm>
+
+#include "torrent/exceptions.h"
+
+namespace torrent {
+
+void
+ChunkRarityIndex::initialize(size_type chunks) {
+  if (!m_prev.empty())
+    throw internal_error("ChunkRarityIndex::initialize(...) called on an initialized object.");
+
+  m_next.assign(chunks, invalid_index);
+  m_prev.assign(chunks, unlinked_index);
+  m_heads.clear();
+  m_size = 0;
+}
+
+void
+ChunkRarityIndex::clear() {
+  m_next = std::vector<size_type>();
+  m_prev = std::vector<size_type>();
+  m_heads = std::vector<size_type>();
+  m_size = 0;
+}
+
+void
+ChunkRarityIndex::link(size_type index, size_type count) {
+  if (index >= m_prev.size() || is_linked(index))
+    throw internal_error("ChunkRarityIndex::link(...) invalid or already linked index.");
+
+  if (count >= m_heads.size())
+    m_heads.resize(count + 1, invalid_index);
+
+  m_next[index] = m_heads[count];
+  m_prev[index] = invalid_index;
+
+  if (m_heads[count] != invalid_index)
+    m_prev[m_heads[count]] = index;
+
+  m_heads[count] = index;
+  m_size++;
+}
+
+void
+ChunkRarityIndex::unlink(size_type index, size_type count) {
+  if (index >= m_prev.size() || !is_linked(index) || count >= m_heads.size())
+    throw internal_error("ChunkRarityIndex::unlink(...) invalid or unlinked index.");
+
+  if (m_prev[index] == invalid_index) {
+    if (m_heads[count] != index)
+      throw internal_error("ChunkRarityIndex::unlink(...) index not in bucket.");
+
+    m_heads[count] = m_next[index];
+  } else {
+    m_next[m_prev[index]] = m_next[index];
+  }
+
+  if (m_next[index] != invalid_index)
+    m_prev[m_next[index]] = m_prev[index];
+
+  m_next[index] = invalid_index;
+  m_prev[index] = unlinked_index;
+  m_size--;
+}
+
+void
+ChunkRarityIndex::unlink_all() {
+  std::fill(m_next.begin(), m_next.end(), invalid_index);
+  std::fill(m_prev.begin(), m_prev.end(), unlinked_index);
+  std::fill(m_heads.begin(), m_heads.end(), invalid_index);
+  m_size = 0;
+}
+
+} // namespace torrent
@@ -0,0 +1,77 @@
+#ifndef LIBTORRENT_DOWNLOAD_CHUNK_RARITY_INDEX_H
+#define LIBTORRENT_DOWNLOAD_CHUNK_RARITY_INDEX_H
+
+#include <cinttypes>
+#include <vector>
+
+namespace torrent {
+
+// Chunks linked into one bucket per availability count, so the
+// rarest chunks can be visited without scanning every index.
+//
+// ChunkSelector links the chunks it still wants and ChunkStatistics
+// moves linked chunks between buckets as their counts change, both in
+// constant time. Buckets are doubly linked lists threaded through
+// per-chunk arrays.
+
+class ChunkRarityIndex {
+public:
+  using size_type = uint32_t;
+
+  static constexpr size_type invalid_index = ~size_type{0};
+
+  ChunkRarityIndex() = default;
+  ChunkRarityIndex(const ChunkRarityIndex&) = delete;
+  ChunkRarityIndex& operator=(const ChunkRarityIndex&) = delete;
+
+  size_type           size() const                      { return m_size; }
+
+  bool                is_linked(size_type index) const  { return m_prev[index] != unlinked_index; }
+
+  void                initialize(size_type chunks);
+  void                clear();
+
+  void                link(size_type index, size_type count);
+  void                unlink(size_type index, size_type count);
+  void                unlink_all();
+
+  // Does nothing if the index is not linked.
+  void                move(size_type index, size_type from, size_type to);
+
+  // Calls 'func(index, count)' on linked chunks from the lowest count
+  // upward until it returns false. Chunks with the same count are
+  // visited in no particular order.
+  template <typename Func>
+  void                for_each_rarest(Func func) const;
+
+private:
+  static constexpr size_type unlinked_index = invalid_index - 1;
+
+  size_type           m_size{};
+
+  std::vector<size_type> m_next;
+  std::vector<size_type> m_prev;
+  std::vector<size_type> m_heads;
+};
+
+inline void
+ChunkRarityIndex::move(size_type index, size_type from, size_type to) {
+  if (!is_linked(index))
+    return;
+
+  unlink(index, from);
+  link(index, to);
+}
+
+template <typename Func>
+inline void
+ChunkRarityIndex::for_each_rarest(Func func) const {
+  for (size_type count = 0; count < m_heads.size(); count++)
+    for (size_type index = m_heads[count]; index != invalid_index; index = m_next[index])
+      if (!func(index, count))
+        return;
+}
+
+} // namespace torrent
+
+#endif
@@ -41,6 +41,7 @@
 
 #include "protocol/peer_chunks.h"
 #include "torrent/exceptions.h"
+#include "utils/bitfield_ops.h"
 
 #include "chunk_selector.h"
 #include "chunk_statistics.h"
@@ -67,6 +68,9 @@ ChunkSelector::initialize(ChunkStatistics* cs) {
 
 void
 ChunkSelector::cleanup() {
+  if (m_statistics != NULL)
+    m_statistics->index_unlink_all();
+
   m_data->mutable_untouched_bitfield()->clear();
   m_statistics = NULL;
 }
@@ -80,6 +84,16 @@ ChunkSelector::update_priorities() {
 
   m_sharedQueue.clear();
 
+  m_statistics->index_unlink_all();
+
+  for (auto& range : *m_data->high_priority())
+    for (uint32_t index = range.first; index < range.second; index++)
+      index_link_if_wanted(index);
+
+  for (auto& range : *m_data->normal_priority())
+    for (uint32_t index = range.first; index < range.second; index++)
+      index_link_if_wanted(index);
+
   if (m_position == invalid_chunk)
     m_position = random() % size();
 
@@ -139,8 +153,9 @@ ChunkSelector::find(PeerChunks* pc, [[maybe_unused]] bool highPriority) {
     // Urgh...
     queue->clear();
 
-    (search_linear(pc->bitfield(), queue, m_data->normal_priority(), m_position, size()) &&
-     search_linear(pc->bitfield(), queue, m_data->normal_priority(), 0, m_position));
+    if (!search_rarest(pc->bitfield(), queue))
+      (search_linear(pc->bitfield(), queue, m_data->normal_priority(), m_position, size()) &&
+       search_linear(pc->bitfield(), queue, m_data->normal_priority(), 0, m_position));
 
     if (!queue->prepare_pop())
       return invalid_chunk;
@@ -169,6 +184,9 @@ ChunkSelector::using_index(uint32_t index) {
 
   m_data->mutable_untouched_bitfield()->unset(index);
 
+  if (m_statistics->rarity_index()->is_linked(index))
+    m_statistics->index_unlink(index);
+
   // We always know 'm_position' points to a wanted chunk. If it
   // changes, we need to move m_position to the next one.
   if (index == m_position)
@@ -184,6 +202,7 @@ ChunkSelector::not_using_index(uint32_t index) {
     throw internal_error("ChunkSelector::deselect_index(...) index already unset.");
 
   m_data->mutable_untouched_bitfield()->set(index);
+  index_link_if_wanted(index);
 
   // This will make sure that if we enable new chunks, it will start
   // downloading them event when 'index == invalid_chunk'.
@@ -208,7 +227,7 @@ ChunkSelector::received_have_chunk(PeerChunks* pc, uint32_t index) {
     return false;
 
   if (pc->download_cache()->is_enabled())
-    pc->download_cache()->insert(m_statistics->rarity(index), index);
+    pc->download_cache()->insert(std::min<uint32_t>(m_statistics->rarity(index), 255), index);
 
   return true;
 }
@@ -235,40 +254,59 @@ ChunkSelector::search_linear_range(const Bitfield* bf, rak::partial_queue* pq, u
   if (first >= last || last > size())
     throw internal_error("ChunkSelector::search_linear_range(...) received an invalid range.");
 
-  Bitfield::const_iterator local  = m_data->untouched_bitfield()->begin() + first / 8;
-  Bitfield::const_iterator source = bf->begin() + first / 8;
-
-  // Unset any bits before 'first'.
-  Bitfield::value_type wanted = (*source & *local) & Bitfield::mask_from(first % 8);
+  const Bitfield* untouched = m_data->untouched_bitfield();
 
-  while (m_data->untouched_bitfield()->position(local + 1) < last) {
-    if (wanted && !search_linear_byte(pq, m_data->untouched_bitfield()->position(local), wanted))
+  while ((first = bitfield_find_next_and(bf->begin(), untouched->begin(), first, last)) != last) {
+    if (!pq->insert(std::min<uint32_t>(m_statistics->rarity(first), 255), first) && pq->is_full())
       return false;
 
-    wanted = (*++source & *++local);
+    first++;
   }
-  
-  // Unset any bits from 'last'.
-  wanted &= Bitfield::mask_before(last - m_data->untouched_bitfield()->position(local));
 
-  if (wanted)
-    return search_linear_byte(pq, m_data->untouched_bitfield()->position(local), wanted);
-  else
+  return true;
+}
+
+// Searches the wanted chunks from the rarest up, stopping once the
+// queue is full or no more rarities fit. Only used when the peer has a
+// large enough part of the torrent that few chunks are skipped, and
+// gives up after 'size() / 32' chunks so it never costs much more than
+// a linear search.
+//
+// Returns false if the linear search should be used instead.
+bool
+ChunkSelector::search_rarest(const Bitfield* bf, rak::partial_queue* pq) {
+  if (bf->size_set() < static_cast<uint64_t>(size()) * rarity_index_min_fraction / 256)
+    return false;
+
+  uint32_t remaining = size() / 32 + 64;
+  bool     completed = true;
+
+  m_statistics->rarity_index()->for_each_rarest([&](uint32_t index, uint32_t count) {
+      if (remaining-- == 0)
+        return (completed = false);
+
+      if (!bf->get(index))
+        return true;
+
+      return pq->insert(std::min<uint32_t>(count, 255), index);
+    });
+
+  if (completed || pq->prepare_pop())
     return true;
+
+  pq->clear();
+  return false;
 }
 
-// Take pointer to partial_queue
-inline bool
-ChunkSelector::search_linear_byte(rak::partial_queue* pq, uint32_t index, Bitfield::value_type wanted) {
-  for (int i = 0; i < 8; ++i) {
-    if (!(wanted & Bitfield::mask_at(i)))
-      continue;
+void
+ChunkSelector::index_link_if_wanted(uint32_t index) {
+  if (!m_data->untouched_bitfield()->get(index) || m_statistics->rarity_index()->is_linked(index))
+    return;
 
-    if (!pq->insert(m_statistics->rarity(index + i), index + i) && pq->is_full())
-      return false;
-  }
+  if (!m_data->high_priority()->has(index) && !m_data->normal_priority()->has(index))
+    return;
 
-  return true;
+  m_statistics->index_link(index);
 }
 
 void
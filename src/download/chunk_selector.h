@@ -53,6 +53,10 @@ namespace torrent {
 //
 // When updating Content::bitfield, make sure you update this bitfield
 // and unmark any chunks in Delegator.
+//
+// Wanted chunks are also kept in ChunkStatistics' rarity index, which
+// is searched rarest first for peers having most of the torrent
+// instead of scanning their bitfield.
 
 class ChunkStatistics;
 class PeerChunks;
@@ -61,6 +65,10 @@ class ChunkSelector {
 public:
   static constexpr auto invalid_chunk = ~uint32_t{0};
 
+  // Peers with at least this fraction of the chunks, in 1/256ths, are
+  // searched through the rarity index.
+  static constexpr uint32_t rarity_index_min_fraction = 64;
+
   ChunkSelector(download_data* data) : m_data(data) {}
 
   bool                empty() const                 { return size() == 0; }
@@ -103,7 +111,10 @@ public:
 private:
   bool                search_linear(const Bitfield* bf, rak::partial_queue* pq, const download_data::priority_ranges* ranges, uint32_t first, uint32_t last);
   inline bool         search_linear_range(const Bitfield* bf, rak::partial_queue* pq, uint32_t first, uint32_t last);
-  inline bool         search_linear_byte(rak::partial_queue* pq, uint32_t index, Bitfield::value_type wanted);
+
+  bool                search_rarest(const Bitfield* bf, rak::partial_queue* pq);
+
+  void                index_link_if_wanted(uint32_t index);
 
 //   inline uint32_t     search_rarest(const Bitfield* bf, priority_ranges* ranges, uint32_t first, uint32_t last);
 //   inline uint32_t     search_rarest_range(const Bitfield* bf, uint32_t first, uint32_t last);
@@ -113,7 +124,7 @@ private:
 
   download_data*      m_data;
 
-  ChunkStatistics*    m_statistics;
+  ChunkStatistics*    m_statistics{};
   
   rak::partial_queue  m_sharedQueue;
 
@@ -51,12 +51,34 @@ ChunkStatistics::should_add(PeerChunks* pc) const {
   return m_accounted < max_accounted;
 }
 
+inline void
+ChunkStatistics::increment(size_type n) {
+  auto& count = base_type::operator[](n);
+
+  m_rarity_index.move(n, count, count + 1);
+  count++;
+
+  m_saturated[n] = std::min<value_type>(count, 255);
+}
+
+inline void
+ChunkStatistics::decrement(size_type n) {
+  auto& count = base_type::operator[](n);
+
+  m_rarity_index.move(n, count, count - 1);
+  count--;
+
+  m_saturated[n] = std::min<value_type>(count, 255);
+}
+
 void
 ChunkStatistics::initialize(size_type s) {
   if (!empty())
     throw internal_error("ChunkStatistics::initialize(...) called on an initialized object.");
 
   base_type::resize(s);
+  m_rarity_index.initialize(s);
+  m_saturated.resize(s);
 }
 
 void
@@ -65,6 +87,8 @@ ChunkStatistics::clear() {
     throw internal_error("ChunkStatistics::clear() m_complete != 0.");
 
   base_type::clear();
+  m_rarity_index.clear();
+  m_saturated = std::vector<uint8_t>();
 }
 
 void
@@ -82,11 +106,10 @@ ChunkStatistics::received_connect(PeerChunks* pc) {
     pc->set_using_counter(true);
     m_accounted++;
 
-    auto itr = base_type::begin();
-
     // Use a bitfield iterator instead.
-    for (Bitfield::size_type index = 0; index < pc->bitfield()->size_bits(); ++index, ++itr)
-      *itr += pc->bitfield()->get(index);
+    for (Bitfield::size_type index = 0; index < pc->bitfield()->size_bits(); ++index)
+      if (pc->bitfield()->get(index))
+        increment(index);
   }
 }
 
@@ -110,11 +133,10 @@ ChunkStatistics::received_disconnect(PeerChunks* pc) {
 
     m_accounted--;
 
-    auto itr = base_type::begin();
-
     // Use a bitfield iterator instead.
-    for (Bitfield::size_type index = 0; index < pc->bitfield()->size_bits(); ++index, ++itr)
-      *itr -= pc->bitfield()->get(index);
+    for (Bitfield::size_type index = 0; index < pc->bitfield()->size_bits(); ++index)
+      if (pc->bitfield()->get(index))
+        decrement(index);
   }
 }
 
@@ -137,7 +159,7 @@ ChunkStatistics::received_have_chunk(PeerChunks* pc, uint32_t index, uint32_t le
   
   if (pc->using_counter()) {
 
-    base_type::operator[](index)++;
+    increment(index);
 
     // The below code should not cause useless work to be done in case
     // of immediate disconnect.
@@ -148,7 +170,8 @@ ChunkStatistics::received_have_chunk(PeerChunks* pc, uint32_t index, uint32_t le
       m_complete++;
       m_accounted--;
 
-      std::transform(base_type::begin(), base_type::end(), base_type::begin(), [] (auto c) { return c - 1; });
+      for (size_type n = 0; n < size(); n++)
+        decrement(n);
     }
 
   } else {
@@ -40,13 +40,18 @@
 #include <cinttypes>
 #include <vector>
 
+#include "download/chunk_rarity_index.h"
+
 namespace torrent {
 
 class PeerChunks;
 
-class ChunkStatistics : public std::vector<uint8_t> {
+// Counts are 16 bit, limiting the number of accounted peers to
+// 'max_accounted'.
+
+class ChunkStatistics : public std::vector<uint16_t> {
 public:
-  using base_type = std::vector<uint8_t>;
+  using base_type = std::vector<uint16_t>;
   using size_type = uint32_t;
 
   using value_type       = base_type::value_type;
@@ -59,7 +64,7 @@ public:
   using base_type::empty;
   using base_type::size;
 
-  static constexpr size_type max_accounted = 255;
+  static constexpr size_type max_accounted = (1 << 16) - 1;
 
   ChunkStatistics() = default;
   ~ChunkStatistics() = default;
@@ -102,8 +107,25 @@ public:
 
   const_reference     operator [] (size_type n) const { return base_type::operator[](n); }
 
+  // Chunks are linked into the index by ChunkSelector while wanted.
+  const ChunkRarityIndex* rarity_index() const        { return &m_rarity_index; }
+
+  void                index_link(size_type n)         { m_rarity_index.link(n, rarity(n)); }
+  void                index_unlink(size_type n)       { m_rarity_index.unlink(n, rarity(n)); }
+  void                index_unlink_all()              { m_rarity_index.unlink_all(); }
+
+  // The counts saturated to 8 bits, kept up to date by increment and
+  // decrement. Valid until the statistics are cleared.
+  const uint8_t*      saturated_counts() const        { return m_saturated.data(); }
+
 private:
   inline bool         should_add(PeerChunks* pc) const;
+
+  inline void         increment(size_type n);
+  inline void         decrement(size_type n);
+
+  ChunkRarityIndex    m_rarity_index;
+  std::vector<uint8_t> m_saturated;
   size_type           m_complete{};
   size_type           m_accounted{};
 };
@@ -19,39 +19,83 @@
 
 namespace torrent {
 
+static const std::string& download_constructor_string(const std::string& str) { return str; }
+static std::string        download_constructor_string(std::string_view str)   { return std::string(str); }
+
+template <typename Entry>
 static bool
-download_constructor_is_single_path(Object::map_type::const_reference v) {
+download_constructor_is_single_path(const Entry& v) {
   return v.first.rfind("name.", 0) == 0 && v.second.is_string();
 }
 
+template <typename Entry>
 static bool
-download_constructor_is_multi_path(Object::map_type::const_reference v) {
+download_constructor_is_multi_path(const Entry& v) {
   return v.first.rfind("path.", 0) == 0 && v.second.is_list();
 }
 
+template <typename Bencode>
+static bool
+download_constructor_has_tracker_groups(const Bencode& b) {
+  if (!b.has_key_list("announce-list"))
+    return false;
+
+  // Some torrent makers create empty/invalid 'announce-list'
+  // entries while still having valid 'announce'.
+  const auto& announce_list = b.get_key_list("announce-list");
+
+  return !announce_list.empty() &&
+    std::any_of(announce_list.begin(), announce_list.end(), [](const auto& group) { return group.is_list(); });
+}
+
 void
 DownloadConstructor::initialize(Object& b) {
   if (!b.has_key_map("info") && b.has_key_string("magnet-uri"))
     parse_magnet_uri(b, b.get_key_string("magnet-uri"));
 
+  parse_root(b);
+}
+
+// Magnet URIs are not handled as they add keys to the torrent, callers
+// need to read those into an Object.
+void
+DownloadConstructor::initialize(const BencodeView& b) {
+  parse_root(b);
+}
+
+void
+DownloadConstructor::parse_tracker(const Object& b) {
+  parse_announce(b);
+}
+
+void
+DownloadConstructor::parse_tracker(const BencodeView& b) {
+  parse_announce(b);
+}
+
+template <typename Bencode>
+void
+DownloadConstructor::parse_root(const Bencode& b) {
   if (b.has_key_string("encoding"))
-    m_defaultEncoding = b.get_key_string("encoding");
+    m_defaultEncoding = download_constructor_string(b.get_key_string("encoding"));
 
   if (b.has_key_value("creation date"))
     m_download->info()->set_creation_date(b.get_key_value("creation date"));
 
-  if (b.get_key("info").has_key_value("private") &&
-      b.get_key("info").get_key_value("private") == 1)
+  const auto& info = b.get_key("info");
+
+  if (info.has_key_value("private") && info.get_key_value("private") == 1)
     m_download->info()->set_private();
 
-  parse_name(b.get_key("info"));
-  parse_info(b.get_key("info"));
+  parse_name(info);
+  parse_info(info);
 }
 
 // Currently using a hack of the path thingie to extract the correct
 // torrent name.
+template <typename Bencode>
 void
-DownloadConstructor::parse_name(const Object& b) {
+DownloadConstructor::parse_name(const Bencode& b) {
   if (is_invalid_path_element(b.get_key("name")))
     throw input_error("Bad torrent file, \"name\" is an invalid path name.");
 
@@ -59,13 +103,13 @@ DownloadConstructor::parse_name(const Object& b) {
 
   pathList.emplace_back();
   pathList.back().set_encoding(m_defaultEncoding);
-  pathList.back().push_back(b.get_key_string("name"));
+  pathList.back().push_back(download_constructor_string(b.get_key_string("name")));
 
   for (const auto& map : b.as_map()) {
     if (download_constructor_is_single_path(map)) {
       pathList.emplace_back();
-      pathList.back().set_encoding(map.first.substr(sizeof("name.") - 1));
-      pathList.back().push_back(map.second.as_string());
+      pathList.back().set_encoding(download_constructor_string(map.first.substr(sizeof("name.") - 1)));
+      pathList.back().push_back(download_constructor_string(map.second.as_string()));
     }
   }
 
@@ -80,8 +124,9 @@ DownloadConstructor::parse_name(const Object& b) {
   m_download->info()->set_name(name.front());
 }
 
+template <typename Bencode>
 void
-DownloadConstructor::parse_info(const Object& b) {
+DownloadConstructor::parse_info(const Bencode& b) {
   FileList* fileList = m_download->main()->file_list();
 
   if (!fileList->empty())
@@ -125,23 +170,17 @@ DownloadConstructor::parse_info(const Object& b) {
 
   // Set chunksize before adding files to make sure the index range is
   // correct.
-  m_download->set_complete_hash(b.get_key_string("pieces"));
+  m_download->set_complete_hash(download_constructor_string(b.get_key_string("pieces")));
 
   if (m_download->complete_hash().size() / 20 < fileList->size_chunks())
     throw bencode_error("Torrent size and 'info:pieces' length does not match.");
 }
 
+template <typename Bencode>
 void
-DownloadConstructor::parse_tracker(const Object& b) {
-  const Object::list_type* announce_list = NULL;
-
-  if (b.has_key_list("announce-list") &&
-
-      // Some torrent makers create empty/invalid 'announce-list'
-      // entries while still having valid 'announce'.
-      !(announce_list = &b.get_key_list("announce-list"))->empty() &&
-      std::any_of(announce_list->begin(), announce_list->end(), std::mem_fn(&Object::is_list))) {
-    for (const auto& group : *announce_list) {
+DownloadConstructor::parse_announce(const Bencode& b) {
+  if (download_constructor_has_tracker_groups(b)) {
+    for (const auto& group : b.get_key_list("announce-list")) {
       add_tracker_group(group);
     }
   } else if (b.has_key("announce")) {
@@ -163,8 +202,9 @@ DownloadConstructor::parse_tracker(const Object& b) {
   m_download->main()->tracker_list()->randomize_group_entries();
 }
 
+template <typename Bencode>
 void
-DownloadConstructor::add_tracker_group(const Object& b) {
+DownloadConstructor::add_tracker_group(const Bencode& b) {
   if (!b.is_list())
     throw bencode_error("Tracker group list not a list");
 
@@ -175,16 +215,18 @@ DownloadConstructor::add_tracker_group(const Object& b) {
   }
 }
 
+template <typename Bencode>
 void
-DownloadConstructor::add_tracker_single(const Object& b, int group) {
+DownloadConstructor::add_tracker_single(const Bencode& b, int group) {
   if (!b.is_string())
     throw bencode_error("Tracker entry not a string");
 
-  m_download->main()->tracker_list()->insert_url(group, rak::trim_classic(b.as_string()));
+  m_download->main()->tracker_list()->insert_url(group, rak::trim_classic(download_constructor_string(b.as_string())));
 }
 
+template <typename Bencode>
 void
-DownloadConstructor::add_dht_node(const Object& b) {
+DownloadConstructor::add_dht_node(const Bencode& b) {
   if (!b.is_list() || b.as_list().size() < 2)
     return;
 
@@ -193,7 +235,7 @@ DownloadConstructor::add_dht_node(const Object& b) {
   if (!el->is_string())
     return;
 
-  const std::string& host = el->as_string();
+  const auto& host = download_constructor_string(el->as_string());
 
   if (!(++el)->is_value())
     return;
@@ -201,8 +243,9 @@ DownloadConstructor::add_dht_node(const Object& b) {
   manager->dht_controller()->add_node(host, el->as_value());
 }
 
+template <typename Bencode>
 bool
-DownloadConstructor::is_valid_path_element(const Object& b) {
+DownloadConstructor::is_valid_path_element(const Bencode& b) {
   return
     b.is_string() &&
     b.as_string() != "." &&
@@ -211,8 +254,9 @@ DownloadConstructor::is_valid_path_element(const Object& b) {
     std::find(b.as_string().begin(), b.as_string().end(), '\0') == b.as_string().end();
 }
 
+template <typename Bencode>
 void
-DownloadConstructor::parse_single_file(const Object& b, uint32_t chunkSize) {
+DownloadConstructor::parse_single_file(const Bencode& b, uint32_t chunkSize) {
   if (is_invalid_path_element(b.get_key("name")))
     throw input_error("Bad torrent file, \"name\" is an invalid path name.");
 
@@ -224,15 +268,15 @@ DownloadConstructor::parse_single_file(const Object& b, uint32_t chunkSize) {
 
   pathList.emplace_back();
   pathList.back().set_encoding(m_defaultEncoding);
-  pathList.back().push_back(b.get_key_string("name"));
+  pathList.back().push_back(download_constructor_string(b.get_key_string("name")));
 
   for (const auto& map : b.as_map()) {
     if (!download_constructor_is_single_path(map))
       continue;
 
     pathList.emplace_back();
-    pathList.back().set_encoding(map.first.substr(sizeof("name.") - 1));
-    pathList.back().push_back(map.second.as_string());
+    pathList.back().set_encoding(download_constructor_string(map.first.substr(sizeof("name.") - 1)));
+    pathList.back().push_back(download_constructor_string(map.second.as_string()));
   }
 
   if (pathList.empty())
@@ -242,9 +286,10 @@ DownloadConstructor::parse_single_file(const Object& b, uint32_t chunkSize) {
   fileList->update_paths(fileList->begin(), fileList->end());
 }
 
+template <typename Bencode>
 void
-DownloadConstructor::parse_multi_files(const Object& b, uint32_t chunk_size) {
-  const Object::list_type& object_list = b.as_list();
+DownloadConstructor::parse_multi_files(const Bencode& b, uint32_t chunk_size) {
+  const auto& object_list = b.as_list();
 
   // Multi file torrent
   if (object_list.empty())
@@ -262,7 +307,7 @@ DownloadConstructor::parse_multi_files(const Object& b, uint32_t chunk_size) {
 
     for (const auto& path : object.as_map())
       if (download_constructor_is_multi_path(path))
-        path_list.push_back(create_path(path.second.as_list(), path.first.substr(sizeof("path.") - 1)));
+        path_list.push_back(create_path(path.second.as_list(), download_constructor_string(path.first.substr(sizeof("path.") - 1))));
 
     if (path_list.empty())
       throw input_error("Bad torrent file, an entry has no valid filename.");
@@ -292,19 +337,22 @@ DownloadConstructor::parse_multi_files(const Object& b, uint32_t chunk_size) {
   file_list->update_paths(file_list->begin(), file_list->end());
 }
 
+template <typename List>
 inline Path
-DownloadConstructor::create_path(const Object::list_type& plist, const std::string& enc) {
+DownloadConstructor::create_path(const List& plist, const std::string& enc) {
   // Make sure we are given a proper file path.
   if (plist.empty())
     throw input_error("Bad torrent file, \"path\" has zero entries.");
 
-  if (std::any_of(plist.begin(), plist.end(), &DownloadConstructor::is_invalid_path_element))
+  if (std::any_of(plist.begin(), plist.end(), [](const auto& element) { return is_invalid_path_element(element); }))
     throw input_error("Bad torrent file, \"path\" has zero entries or a zero length entry.");
 
   Path p;
   p.set_encoding(enc);
 
-  std::transform(plist.begin(), plist.end(), std::back_inserter(p), std::mem_fn(&Object::as_string_c));
+  std::transform(plist.begin(), plist.end(), std::back_inserter(p), [](const auto& element) {
+      return download_constructor_string(element.as_string());
+    });
 
   return p;
 }
@@ -3,6 +3,7 @@
 
 #include <list>
 
+#include "torrent/bencode_view.h"
 #include "torrent/object.h"
 
 namespace torrent {
@@ -16,28 +17,35 @@ using EncodingList = std::list<std::string>;
 class DownloadConstructor {
 public:
   void                initialize(Object& b);
+  void                initialize(const BencodeView& b);
 
   void                parse_tracker(const Object& b);
+  void                parse_tracker(const BencodeView& b);
 
   void                set_download(DownloadWrapper* d)         { m_download = d; }
   void                set_encoding_list(const EncodingList* e) { m_encodingList = e; }
 
 private:
-  void                parse_name(const Object& b);
-  void                parse_info(const Object& b);
+  // Parsing is shared between Object and BencodeView through their
+  // common read accessors.
+  template <typename Bencode> void parse_root(const Bencode& b);
+  template <typename Bencode> void parse_announce(const Bencode& b);
+
+  template <typename Bencode> void parse_name(const Bencode& b);
+  template <typename Bencode> void parse_info(const Bencode& b);
   static void         parse_magnet_uri(Object& b, const std::string& uri);
 
-  void                add_tracker_group(const Object& b);
-  void                add_tracker_single(const Object& b, int group);
-  static void         add_dht_node(const Object& b);
+  template <typename Bencode> void add_tracker_group(const Bencode& b);
+  template <typename Bencode> void add_tracker_single(const Bencode& b, int group);
+  template <typename Bencode> static void add_dht_node(const Bencode& b);
 
-  static bool         is_valid_path_element(const Object& b);
-  static bool         is_invalid_path_element(const Object& b) { return !is_valid_path_element(b); }
+  template <typename Bencode> static bool is_valid_path_element(const Bencode& b);
+  template <typename Bencode> static bool is_invalid_path_element(const Bencode& b) { return !is_valid_path_element(b); }
 
-  void                parse_single_file(const Object& b, uint32_t chunkSize);
-  void                parse_multi_files(const Object& b, uint32_t chunkSize);
+  template <typename Bencode> void parse_single_file(const Bencode& b, uint32_t chunkSize);
+  template <typename Bencode> void parse_multi_files(const Bencode& b, uint32_t chunkSize);
 
-  static Path         create_path(const Object::list_type& plist, const std::string& enc);
+  template <typename List> static Path create_path(const List& plist, const std::string& enc);
   inline Path         choose_path(std::list<Path>* pathList);
 
   DownloadWrapper*    m_download{};
@@ -86,9 +86,6 @@ DownloadMain::~DownloadMain() {
   delete m_chunkList;
   delete m_chunkSelector;
   delete m_info;
-
-  m_ut_pex_delta.clear();
-  m_ut_pex_initial.clear();
 }
 
 void
@@ -332,9 +329,40 @@ DownloadMain::receive_tracker_request() {
   m_tracker_controller.start_requesting();
 }
 
-static bool
-SocketAddressCompact_less(const SocketAddressCompact& a, const SocketAddressCompact& b) {
-  return (a.addr < b.addr) || ((a.addr == b.addr) && (a.port < b.port));
+// Peers are advertised with their listen port, and IPv4-mapped
+// addresses as IPv4.
+template <typename Func>
+static void
+ut_pex_address(PeerInfo* peer_info, Func func) {
+  auto sa = rak::socket_address::cast_from(peer_info->socket_address());
+
+  if (peer_info->listen_port() == 0)
+    return;
+
+  if (sa->family() == rak::socket_address::af_inet) {
+    func(SocketAddressCompact(sa->sa_inet()->address_n(), htons(peer_info->listen_port())));
+    return;
+  }
+
+  if (sa->family() != rak::socket_address::af_inet6)
+    return;
+
+  auto normalized = sa->sa_inet6()->normalize_address();
+
+  if (normalized.family() == rak::socket_address::af_inet)
+    func(SocketAddressCompact(normalized.sa_inet()->address_n(), htons(peer_info->listen_port())));
+  else
+    func(SocketAddressCompact6(normalized.sa_inet6()->address(), htons(peer_info->listen_port())));
+}
+
+void
+DownloadMain::ut_pex_insert(PeerInfo* peer_info) {
+  ut_pex_address(peer_info, [this](const auto& sa) { m_ut_pex.insert(sa); });
+}
+
+void
+DownloadMain::ut_pex_erase(PeerInfo* peer_info) {
+  ut_pex_address(peer_info, [this](const auto& sa) { m_ut_pex.erase(sa); });
 }
 
 void
@@ -362,16 +390,8 @@ DownloadMain::do_peer_exchange() {
     m_info->unset_flags(DownloadInfo::flag_pex_active);
   }
 
-  // Return if we don't really want to do anything?
-
-  ProtocolExtension::PEXList current;
-
   for (auto& connection : *m_connectionList) {
     auto pcb = connection->m_ptr();
-    auto sa  = rak::socket_address::cast_from(pcb->peer_info()->socket_address());
-
-    if (pcb->peer_info()->listen_port() != 0 && sa->family() == rak::socket_address::af_inet)
-      current.emplace_back(sa->sa_inet()->address_n(), htons(pcb->peer_info()->listen_port()));
 
     if (!pcb->extensions()->is_remote_supported(ProtocolExtension::UT_PEX))
       continue;
@@ -391,63 +411,12 @@ DownloadMain::do_peer_exchange() {
       continue;
     }
 
-    // Still using the old buffer? Make a copy in this rare case.
-    DataBuffer* message = pcb->extension_message();
-
-    if (!message->empty() && (message->data() == m_ut_pex_initial.data() || message->data() == m_ut_pex_delta.data())) {
-      auto buffer = new char[message->length()];
-      memcpy(buffer, message->data(), message->length());
-      message->set(buffer, buffer + message->length(), true);
-    }
-
     pcb->do_peer_exchange();
   }
 
-  std::sort(current.begin(), current.end(), SocketAddressCompact_less);
-
-  ProtocolExtension::PEXList added;
-  added.reserve(current.size());
-  std::set_difference(current.begin(), current.end(), m_ut_pex_list.begin(), m_ut_pex_list.end(), std::back_inserter(added), SocketAddressCompact_less);
-
-  ProtocolExtension::PEXList removed;
-  removed.reserve(m_ut_pex_list.size());
-  std::set_difference(m_ut_pex_list.begin(), m_ut_pex_list.end(), current.begin(), current.end(), std::back_inserter(removed), SocketAddressCompact_less);
-
-  if (current.size() > torrent::DownloadInfo::max_size_pex_list()) {
-    // This test is only correct as long as we have a constant max
-    // size.
-    if (added.size() < current.size() - torrent::DownloadInfo::max_size_pex_list())
-      throw internal_error("DownloadMain::do_peer_exchange() added.size() < current.size() - m_info->max_size_pex_list().");
-
-    // Randomize this:
-    added.erase(added.end() - (current.size() - torrent::DownloadInfo::max_size_pex_list()), added.end());
-
-    // Create the new m_ut_pex_list by removing any 'removed'
-    // addresses from the original list and then adding the new
-    // addresses.
-    m_ut_pex_list.erase(
-      std::set_difference(
-        m_ut_pex_list.begin(), m_ut_pex_list.end(), removed.begin(), removed.end(), m_ut_pex_list.begin(), SocketAddressCompact_less),
-      m_ut_pex_list.end());
-    m_ut_pex_list.insert(m_ut_pex_list.end(), added.begin(), added.end());
-
-    std::sort(m_ut_pex_list.begin(), m_ut_pex_list.end(), SocketAddressCompact_less);
-
-  } else {
-    m_ut_pex_list.swap(current);
-  }
-
-  current.clear();
-  m_ut_pex_delta.clear();
-
-  // If no peers were added or removed, the initial message is still correct and
-  // the delta message stays emptied. Otherwise generate the appropriate messages.
-  if (!added.empty() || !m_ut_pex_list.empty()) {
-    m_ut_pex_delta = ProtocolExtension::generate_ut_pex_message(added, removed);
-
-    m_ut_pex_initial.clear();
-    m_ut_pex_initial = ProtocolExtension::generate_ut_pex_message(m_ut_pex_list, current);
-  }
+  // Messages still queued on connections hold a reference to the
+  // previous buffers, so they can be replaced here.
+  m_ut_pex.update();
 }
 
 void
@@ -8,6 +8,7 @@
 #include "download/delegator.h"
 #include "net/address_list.h"
 #include "net/data_buffer.h"
+#include "protocol/ut_pex_list.h"
 #include "torrent/data/file_list.h"
 #include "torrent/download/group_entry.h"
 #include "torrent/peer/peer_list.h"
@@ -27,11 +28,11 @@ class HandshakeManager;
 class DownloadInfo;
 class ThrottleList;
 class InitialSeeding;
+class PeerInfo;
 
 class DownloadMain {
 public:
   using have_queue_type = std::deque<std::pair<std::chrono::microseconds, uint32_t>>;
-  using pex_list        = std::vector<SocketAddressCompact>;
 
   DownloadMain();
   ~DownloadMain();
@@ -84,10 +85,15 @@ public:
   group_entry*        up_group_entry()                           { return &m_up_group_entry; }
   group_entry*        down_group_entry()                         { return &m_down_group_entry; }
 
-  DataBuffer          get_ut_pex(bool initial)                   { return (initial ? m_ut_pex_initial : m_ut_pex_delta).clone(); }
+  DataBuffer          get_ut_pex(bool initial)                   { return initial ? m_ut_pex.initial_message() : m_ut_pex.delta_message(); }
 
   bool                want_pex_msg();
 
+  // Called by ConnectionList as peers connect and disconnect, and when
+  // a connected peer's listen port changes.
+  void                ut_pex_insert(PeerInfo* peer_info);
+  void                ut_pex_erase(PeerInfo* peer_info);
+
   void                set_metadata_size(size_t s);
 
   // Carefull with these.
@@ -126,6 +132,10 @@ public:
 
   auto&               delay_disconnect_peers()    { return m_delay_disconnect_peers; }
 
+  // The thread whose poll owns the sockets of this download's peer connections.
+  utils::Thread*      peer_thread() const                    { return m_peer_thread; }
+  void                set_peer_thread(utils::Thread* thread) { m_peer_thread = thread; }
+
 private:
   void                setup_start();
   void                setup_stop();
@@ -136,6 +146,7 @@ private:
   TrackerList*                      m_tracker_list;
 
   class choke_group*  m_choke_group{};
+  utils::Thread*      m_peer_thread{};
 
   group_entry         m_up_group_entry;
   group_entry         m_down_group_entry;
@@ -152,9 +163,7 @@ private:
   FileList            m_fileList;
   PeerList            m_peerList;
 
-  DataBuffer          m_ut_pex_delta;
-  DataBuffer          m_ut_pex_initial;
-  pex_list            m_ut_pex_list;
+  UtPexList           m_ut_pex;
 
   ThrottleList*       m_upload_throttle{};
   ThrottleList*       m_download_throttle{};
@@ -8,6 +8,7 @@
 #include "download/chunk_selector.h"
 #include "protocol/handshake_manager.h"
 #include "protocol/peer_connection_base.h"
+#include "thread_main.h"
 #include "torrent/data/file.h"
 #include "torrent/data/file_list.h"
 #include "torrent/data/file_manager.h"
@@ -79,6 +80,10 @@ DownloadWrapper::initialize(const std::string& hash, const std::string& id, uint
 
   m_main->tracker_list()->set_key(tracker_key);
 
+  // Peer connections of every download are owned by the main thread's poll for now. Dedicated
+  // peer I/O threads would be picked here, e.g. by sharding on the info hash.
+  m_main->set_peer_thread(ThreadMain::thread_main());
+
   m_main->slot_hash_check_add([this](torrent::ChunkHandle handle) { return check_chunk_hash(handle, false); });
 
   // Info hash must be calculate from here on.
@@ -47,6 +47,7 @@ struct DataBuffer {
   DataBuffer() = default;
   DataBuffer(char* data, char* end)   : m_data(data), m_end(end) {}
 
+  // Clones of a shared buffer keep the data alive until cleared.
   DataBuffer          clone() const        { DataBuffer d = *this; d.m_owned = false; return d; }
   DataBuffer          release()            { DataBuffer d = *this; set(NULL, NULL, false); return d; }
 
@@ -54,12 +55,18 @@ struct DataBuffer {
   char*               end() const          { return m_end; }
 
   bool                owned() const        { return m_owned; }
+  bool                shared() const       { return m_shared != nullptr; }
   bool                empty() const        { return m_data == NULL; }
   size_t              length() const       { return m_end - m_data; }
 
   void                clear();
   void                set(char* data, char* end, bool owned);
 
+  // Hands the data of an owned buffer over to a reference count
+  // shared by all its clones, so it may be queued on several
+  // connections without copying.
+  void                set_shared();
+
 private:
   char*               m_data{};
   char*               m_end{};
@@ -67,6 +74,8 @@ private:
   // Used to indicate if buffer held by PCB is its own and needs to be
   // deleted after transmission (false if shared with other connections).
   bool                m_owned{true};
+
+  std::shared_ptr<char[]> m_shared;
 };
 
 inline void
@@ -76,6 +85,7 @@ DataBuffer::clear() {
 
   m_data = m_end = NULL;
   m_owned = false;
+  m_shared.reset();
 }
 
 inline void
@@ -83,6 +93,15 @@ DataBuffer::set(char* data, char* end, bool owned) {
   m_data = data;
   m_end = end;
   m_owned = owned;
+  m_shared.reset();
+}
+
+inline void
+DataBuffer::set_shared() {
+  if (!empty() && m_owned)
+    m_shared.reset(m_data);
+
+  m_owned = false;
 }
 
 } // namespace torrent
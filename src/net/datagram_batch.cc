@@ -0,0 +1,78 @@
+#include "config.h"
+
+#include "datagram_batch.h"
+
+#include <cstring>
+
+#include "torrent/exceptions.h"
+#include "torrent/net/socket_address.h"
+
+namespace torrent {
+
+DatagramBatch::DatagramBatch(unsigned int capacity, uint32_t buffer_size) :
+  m_buffer_size(buffer_size),
+  m_messages(capacity),
+  m_vectors(capacity),
+  m_addresses(capacity) {
+
+  if (capacity == 0)
+    throw internal_error("DatagramBatch::DatagramBatch(...) capacity is zero.");
+
+  if (buffer_size != 0)
+    m_buffers = std::make_unique<char[]>(static_cast<size_t>(capacity) * buffer_size);
+
+  std::memset(m_messages.data(), 0, sizeof(message_type) * capacity);
+
+  for (unsigned int i = 0; i < capacity; i++) {
+    m_messages[i].msg_hdr.msg_iov = &m_vectors[i];
+    m_messages[i].msg_hdr.msg_iovlen = 1;
+  }
+}
+
+void
+DatagramBatch::push_back(const void* data, uint32_t length, const sockaddr* sa) {
+  if (full())
+    throw internal_error("DatagramBatch::push_back(...) batch is full.");
+
+  if (length == 0)
+    throw internal_error("DatagramBatch::push_back(...) length is zero.");
+
+  message_type& message = m_messages[m_size];
+
+  m_vectors[m_size].iov_base = const_cast<void*>(data);
+  m_vectors[m_size].iov_len = length;
+
+  if (sa != nullptr) {
+    std::memcpy(&m_addresses[m_size], sa, sa_length(sa));
+    message.msg_hdr.msg_name = &m_addresses[m_size];
+    message.msg_hdr.msg_namelen = sa_length(sa);
+  } else {
+    message.msg_hdr.msg_name = nullptr;
+    message.msg_hdr.msg_namelen = 0;
+  }
+
+  message.msg_hdr.msg_flags = 0;
+  message.msg_len = 0;
+
+  m_size++;
+}
+
+void
+DatagramBatch::prepare_read() {
+  if (m_buffers == nullptr)
+    throw internal_error("DatagramBatch::prepare_read() batch has no receive buffers.");
+
+  for (unsigned int i = 0; i < capacity(); i++) {
+    m_vectors[i].iov_base = m_buffers.get() + static_cast<size_t>(i) * m_buffer_size;
+    m_vectors[i].iov_len = m_buffer_size;
+
+    m_messages[i].msg_hdr.msg_name = &m_addresses[i];
+    m_messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+    m_messages[i].msg_hdr.msg_flags = 0;
+    m_messages[i].msg_len = 0;
+  }
+
+  m_size = 0;
+}
+
+} // namespace torrent
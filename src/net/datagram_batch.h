@@ -0,0 +1,76 @@
+#ifndef LIBTORRENT_NET_DATAGRAM_BATCH_H
+#define LIBTORRENT_NET_DATAGRAM_BATCH_H
+
+#include <cinttypes>
+#include <memory>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+namespace torrent {
+
+// A fixed set of datagram slots used for receiving or sending several
+// datagrams with one system call, see SocketDatagram::read_datagrams
+// and write_datagrams.
+//
+// Receive buffers are allocated once by the constructor and reused,
+// while queued sends reference the caller's data which must remain
+// valid until the batch is written or cleared.
+
+class DatagramBatch {
+public:
+#ifdef USE_MMSG
+  using message_type = mmsghdr;
+#else
+  struct message_type {
+    msghdr        msg_hdr;
+    unsigned int  msg_len;
+  };
+#endif
+
+  // A 'buffer_size' of zero allocates no receive buffers, for batches
+  // only used for sending.
+  DatagramBatch(unsigned int capacity, uint32_t buffer_size);
+
+  unsigned int        capacity() const                  { return m_messages.size(); }
+  unsigned int        size() const                      { return m_size; }
+  uint32_t            buffer_size() const               { return m_buffer_size; }
+
+  bool                empty() const                     { return m_size == 0; }
+  bool                full() const                      { return m_size == m_messages.size(); }
+
+  void                clear()                           { m_size = 0; }
+
+  // Queues a datagram for sending. A null 'sa' uses the socket's
+  // connected address.
+  void                push_back(const void* data, uint32_t length, const sockaddr* sa);
+
+  // Data and length of a received datagram, or the number of bytes
+  // written for a sent one.
+  char*               data(unsigned int index)          { return static_cast<char*>(m_vectors[index].iov_base); }
+  uint32_t            length(unsigned int index) const  { return m_messages[index].msg_len; }
+
+  sockaddr*           address(unsigned int index)       { return reinterpret_cast<sockaddr*>(&m_addresses[index]); }
+
+  // Used by SocketDatagram.
+  message_type*       messages()                        { return m_messages.data(); }
+
+  void                prepare_read();
+  void                set_size(unsigned int size)       { m_size = size; }
+
+private:
+  DatagramBatch(const DatagramBatch&) = delete;
+  DatagramBatch& operator=(const DatagramBatch&) = delete;
+
+  uint32_t                      m_buffer_size;
+  unsigned int                  m_size{0};
+
+  std::unique_ptr<char[]>       m_buffers;
+  std::vector<message_type>     m_messages;
+  std::vector<iovec>            m_vectors;
+  std::vector<sockaddr_storage> m_addresses;
+};
+
+} // namespace torrent
+
+#endif
@@ -2,6 +2,7 @@
 
 #include "socket_datagram.h"
 
+#include <cstring>
 #include <sys/socket.h>
 
 #include "rak/socket_address.h"
@@ -71,4 +72,72 @@ SocketDatagram::write_datagram_sa(const void* buffer, unsigned int length, socka
   return r;
 }
 
+int
+SocketDatagram::read_datagrams(DatagramBatch& batch) {
+  batch.prepare_read();
+
+#ifdef USE_MMSG
+  int r = ::recvmmsg(m_fileDesc, batch.messages(), batch.capacity(), 0, NULL);
+#else
+  int r = 0;
+
+  for (; static_cast<unsigned int>(r) != batch.capacity(); r++) {
+    int length = ::recvmsg(m_fileDesc, &batch.messages()[r].msg_hdr, 0);
+
+    if (length < 0)
+      break;
+
+    batch.messages()[r].msg_len = length;
+  }
+
+  if (r == 0)
+    r = -1;
+#endif
+
+  if (r > 0)
+    batch.set_size(r);
+
+  return r;
+}
+
+int
+SocketDatagram::write_datagrams(DatagramBatch& batch, unsigned int first) {
+  if (first >= batch.size())
+    throw internal_error("Tried to send an empty datagram batch");
+
+  DatagramBatch::message_type* messages = batch.messages() + first;
+  unsigned int count = batch.size() - first;
+
+  if (m_ipv6_socket) {
+    for (unsigned int i = 0; i != count; i++) {
+      auto sa = static_cast<sockaddr*>(messages[i].msg_hdr.msg_name);
+
+      if (sa == NULL || sa->sa_family != AF_INET)
+        continue;
+
+      rak::socket_address_inet6 sa_mapped = rak::socket_address::cast_from(sa)->sa_inet()->to_mapped_address();
+
+      std::memcpy(sa, sa_mapped.c_sockaddr(), sizeof(rak::socket_address_inet6));
+      messages[i].msg_hdr.msg_namelen = sizeof(rak::socket_address_inet6);
+    }
+  }
+
+#ifdef USE_MMSG
+  return ::sendmmsg(m_fileDesc, messages, count, 0);
+#else
+  unsigned int i = 0;
+
+  for (; i != count; i++) {
+    int length = ::sendmsg(m_fileDesc, &messages[i].msg_hdr, 0);
+
+    if (length < 0)
+      break;
+
+    messages[i].msg_len = length;
+  }
+
+  return i != 0 ? i : -1;
+#endif
+}
+
 } // namespace torrent
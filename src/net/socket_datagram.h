@@ -1,6 +1,7 @@
 #ifndef LIBTORRENT_NET_SOCKET_DGRAM_H
 #define LIBTORRENT_NET_SOCKET_DGRAM_H
 
+#include "datagram_batch.h"
 #include "socket_base.h"
 
 namespace torrent {
@@ -14,6 +15,13 @@ public:
   int                 write_datagram(const void* buffer, unsigned int length, rak::socket_address* sa = NULL);
 
   int                 write_datagram_sa(const void* buffer, unsigned int length, sockaddr* sa);
+
+  // Receives up to 'batch.capacity()' datagrams, or sends the queued
+  // datagrams starting at 'first', using recvmmsg/sendmmsg when
+  // available. Returns the number of datagrams transferred, or -1
+  // with errno set if none were.
+  int                 read_datagrams(DatagramBatch& batch);
+  int                 write_datagrams(DatagramBatch& batch, unsigned int first = 0);
 };
 
 } // namespace torrent
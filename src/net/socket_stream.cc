@@ -4,6 +4,10 @@
 
 #include <rak/error_number.h>
 
+#ifdef USE_SENDFILE
+#include <sys/sendfile.h>
+#endif
+
 namespace torrent {
 
 uint32_t
@@ -48,4 +52,83 @@ SocketStream::write_stream_throws(const void* buf, uint32_t length) {
   return r;
 }
 
+uint32_t
+SocketStream::read_vector_throws(const iovec* vectors, int count) {
+  int r = read_vector(vectors, count);
+
+  if (r == 0)
+    throw close_connection();
+
+  if (r < 0) {
+    if (rak::error_number::current().is_blocked_momentary())
+      return 0;
+    else if (rak::error_number::current().is_closed())
+      throw close_connection();
+    else if (rak::error_number::current().is_blocked_prolonged())
+      throw blocked_connection();
+    else
+      throw connection_error(rak::error_number::current().value());
+  }
+
+  return r;
+}
+
+uint32_t
+SocketStream::write_vector_throws(const iovec* vectors, int count) {
+  int r = write_vector(vectors, count);
+
+  if (r == 0)
+    throw close_connection();
+
+  if (r < 0) {
+    if (rak::error_number::current().is_blocked_momentary())
+      return 0;
+    else if (rak::error_number::current().is_closed())
+      throw close_connection();
+    else if (rak::error_number::current().is_blocked_prolonged())
+      throw blocked_connection();
+    else
+      throw connection_error(rak::error_number::current().value());
+  }
+
+  return r;
+}
+
+int
+SocketStream::sendfile_stream([[maybe_unused]] int fd, [[maybe_unused]] uint64_t offset, uint32_t length) {
+  if (length == 0)
+    throw internal_error("Tried to sendfile with length 0.");
+
+#ifdef USE_SENDFILE
+  off_t file_offset = offset;
+
+  return ::sendfile(m_fileDesc, fd, &file_offset, length);
+#else
+  throw internal_error("SocketStream::sendfile_stream(...) called but sendfile is not supported.");
+#endif
+}
+
+// The file being shorter than expected is reported as a storage
+// error rather than as a closed connection.
+uint32_t
+SocketStream::sendfile_stream_throws(int fd, uint64_t offset, uint32_t length) {
+  int r = sendfile_stream(fd, offset, length);
+
+  if (r == 0)
+    throw storage_error("File chunk read error: sendfile reached end of file");
+
+  if (r < 0) {
+    if (rak::error_number::current().is_blocked_momentary())
+      return 0;
+    else if (rak::error_number::current().is_closed())
+      throw close_connection();
+    else if (rak::error_number::current().is_blocked_prolonged())
+      throw blocked_connection();
+    else
+      throw connection_error(rak::error_number::current().value());
+  }
+
+  return r;
+}
+
 } // namespace torrent
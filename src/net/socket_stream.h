@@ -39,6 +39,7 @@
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 
 #include "torrent/exceptions.h"
 #include "socket_base.h"
@@ -56,6 +57,20 @@ public:
   uint32_t            read_stream_throws(void* buf, uint32_t length);
   uint32_t            write_stream_throws(const void* buf, uint32_t length);
 
+  // Scatter/gather variants, transferring to or from 'count' buffers
+  // with a single system call. Error handling is the same as for
+  // the *_stream_throws functions.
+  int                 read_vector(const iovec* vectors, int count);
+  int                 write_vector(const iovec* vectors, int count);
+
+  uint32_t            read_vector_throws(const iovec* vectors, int count);
+  uint32_t            write_vector_throws(const iovec* vectors, int count);
+
+  // Sends directly from 'fd' without copying the data to user-space.
+  // Only available if USE_SENDFILE is defined.
+  int                 sendfile_stream(int fd, uint64_t offset, uint32_t length);
+  uint32_t            sendfile_stream_throws(int fd, uint64_t offset, uint32_t length);
+
   // Handles all the error catching etc. Returns true if the buffer is
   // finished reading/writing.
   bool                read_buffer(void* buf, uint32_t length, uint32_t& pos);
@@ -94,6 +109,22 @@ SocketStream::write_stream(const void* buf, uint32_t length) {
   return ::send(m_fileDesc, buf, length, 0);
 }
 
+inline int
+SocketStream::read_vector(const iovec* vectors, int count) {
+  if (count <= 0)
+    throw internal_error("Tried to read to vector count 0.");
+
+  return ::readv(m_fileDesc, vectors, count);
+}
+
+inline int
+SocketStream::write_vector(const iovec* vectors, int count) {
+  if (count <= 0)
+    throw internal_error("Tried to write from vector count 0.");
+
+  return ::writev(m_fileDesc, vectors, count);
+}
+
 } // namespace torrent
 
 #endif
@@ -17,7 +17,6 @@ namespace torrent {
 
 ThrottleInternal::ThrottleInternal(int flags) :
     m_flags(flags),
-    m_next_slave(m_slave_list.end()),
     m_time_last_tick(torrent::this_thread::cached_time()) {
 
   if (is_root())
@@ -28,15 +27,17 @@ ThrottleInternal::~ThrottleInternal() {
   if (is_root())
     torrent::this_thread::scheduler()->erase(&m_task_tick);
 
-  for (const auto& t : m_slave_list)
+  for (const auto& t : m_slave_list) {
+    delete t->m_throttleList;
     delete t;
+  }
 }
 
 void
 ThrottleInternal::enable() {
   m_throttleList->enable();
   for (auto t : m_slave_list)
-    t->m_throttleList->enable();
+    t->enable();
 
   if (is_root()) {
     // We need to start the ticks, and make sure we set timeLastTick
@@ -50,7 +51,7 @@ ThrottleInternal::enable() {
 void
 ThrottleInternal::disable() {
   for (auto t : m_slave_list)
-    t->m_throttleList->disable();
+    t->disable();
   m_throttleList->disable();
 
   if (is_root())
@@ -68,7 +69,6 @@ ThrottleInternal::create_slave() {
     slave->enable();
 
   m_slave_list.push_back(slave);
-  m_next_slave = m_slave_list.end();
 
   return slave;
 }
@@ -89,33 +89,96 @@ ThrottleInternal::receive_tick() {
   m_time_last_tick = torrent::this_thread::cached_time();
 }
 
+uint32_t
+ThrottleInternal::quota_need(uint32_t quota, uint32_t fraction) const {
+  return std::min<uint64_t>(quota, static_cast<uint64_t>(fraction) * m_maxRate >> fraction_bits);
+}
+
+uint32_t
+ThrottleInternal::quota_guaranteed(uint32_t quota, uint32_t fraction) const {
+  return std::min<uint64_t>(quota_need(quota, fraction), static_cast<uint64_t>(fraction) * m_minRate >> fraction_bits);
+}
+
+uint32_t
+ThrottleInternal::quota_demand(uint32_t need, uint32_t offered, int32_t used, uint32_t headroom) {
+  if (used >= static_cast<int32_t>(offered))
+    return need;
+
+  return std::min<uint64_t>(need, static_cast<uint64_t>(std::max(used, 0)) + headroom);
+}
+
+// Each tick the slaves and our own list are given max-min fair
+// shares of the quota, after the slaves' guaranteed quota has been
+// set aside. Those that used less than offered last tick are expected
+// to need little more, and what they don't take is split between the
+// rest. Ties in share size are broken by rotating the starting slave
+// every tick.
 int32_t
 ThrottleInternal::receive_quota(uint32_t quota, uint32_t fraction) {
   m_unused_quota += quota;
 
-  while (m_next_slave != m_slave_list.end()) {
-    // TODO: Add logging and see if the use of 'quota' below is causing the quota to be
-    // over-allocated to the next slave, instead of a smoother distribution.
-    //
-    // E.g. we might want to spread it over the next few slaves, especially if we have a very large
-    // number.
+  uint32_t count = m_slave_list.size();
+  uint32_t available = m_unused_quota;
 
-    uint32_t need = std::min<uint32_t>(quota, static_cast<uint64_t>(fraction) * (*m_next_slave)->max_rate() >> fraction_bits);
+  auto& shares = m_shares;
+  shares.clear();
 
-    if (need > m_unused_quota)
-      break;
+  for (uint32_t i = 0; i < count; i++) {
+    ThrottleInternal* slave = m_slave_list[(m_next_slave + i) % count];
 
-    m_unused_quota -= (*m_next_slave)->receive_quota(need, fraction);
-    m_throttleList->add_rate((*m_next_slave)->throttle_list()->rate_added());
+    uint32_t demand = quota_demand(slave->quota_need(quota, fraction), slave->m_offered, slave->m_used,
+                                   slave->throttle_list()->max_chunk_size());
+    uint32_t offer  = std::min({slave->quota_guaranteed(quota, fraction), demand, available});
 
-    ++m_next_slave;
+    available -= offer;
+    shares.push_back(share_type{slave, demand, offer});
   }
 
-  uint32_t need = std::min<uint32_t>(quota, static_cast<uint64_t>(fraction) * m_maxRate >> fraction_bits);
+  shares.push_back(share_type{nullptr,
+                              quota_demand(quota_need(quota, fraction), m_list_offered, m_list_used, m_throttleList->max_chunk_size()),
+                              0});
+
+  if (count != 0)
+    m_next_slave = (m_next_slave + 1) % count;
+
+  // Fill the smallest demands first, so each gets at most an equal
+  // share of what is left and the largest ones split the remainder.
+  // Equal demands keep their rotated order, as 'shares' is contiguous.
+  auto& order = m_order;
+  order.clear();
+
+  for (auto& share : shares)
+    order.push_back(&share);
+
+  std::sort(order.begin(), order.end(), [](share_type* a, share_type* b) {
+      uint32_t a_left = a->demand - a->offer;
+      uint32_t b_left = b->demand - b->offer;
+
+      return a_left < b_left || (a_left == b_left && a < b);
+    });
+
+  uint32_t left = order.size();
+
+  for (auto share : order) {
+    uint32_t extra = std::min(share->demand - share->offer, available / left--);
+
+    share->offer += extra;
+    available -= extra;
+  }
+
+  for (auto& share : shares) {
+    if (share.slave == nullptr) {
+      m_list_offered = share.offer;
+      m_list_used = m_throttleList->update_quota(share.offer);
+      m_unused_quota -= m_list_used;
+      continue;
+    }
+
+    share.slave->m_offered = share.offer;
+    share.slave->m_used = share.slave->receive_quota(share.offer, fraction);
 
-  if (m_next_slave == m_slave_list.end() && need <= m_unused_quota) {
-    m_unused_quota -= m_throttleList->update_quota(need);
-    m_next_slave = m_slave_list.begin();
+    m_unused_quota -= share.slave->m_used;
+    m_throttleList->add_rate(share.slave->throttle_list()->rate_added());
   }
 
   // Return how much quota we used, but keep as much as one allocation's worth until the next tick
@@ -31,18 +31,46 @@ private:
 
   using SlaveList = std::vector<ThrottleInternal*>;
 
+  struct share_type {
+    ThrottleInternal* slave;
+    uint32_t          demand;
+    uint32_t          offer;
+  };
+
   void                receive_tick();
 
   // Distribute quota, return amount of quota used. May be negative
   // if it had more unused quota than is now allowed.
   int32_t             receive_quota(uint32_t quota, uint32_t fraction);
 
+  // The most quota this throttle takes out of the parent's 'quota'
+  // over an interval of 'fraction', and the part of it that is
+  // guaranteed by the minimum rate.
+  uint32_t            quota_need(uint32_t quota, uint32_t fraction) const;
+  uint32_t            quota_guaranteed(uint32_t quota, uint32_t fraction) const;
+
+  // Limits 'need' to a bit more than was used last tick if less than
+  // what was offered was used.
+  static uint32_t     quota_demand(uint32_t need, uint32_t offered, int32_t used, uint32_t headroom);
+
   int                 m_flags;
   SlaveList           m_slave_list;
-  SlaveList::iterator m_next_slave;
+  uint32_t            m_next_slave{0};
 
   uint32_t            m_unused_quota{0};
 
+  // Offered and used quota of the last tick, kept by the parent for
+  // slaves and by the throttle for its own list.
+  uint32_t            m_offered{0};
+  int32_t             m_used{0};
+  uint32_t            m_list_offered{0};
+  int32_t             m_list_used{0};
+
+  // Scratch space for receive_quota, kept to avoid allocating every
+  // tick.
+  std::vector<share_type>  m_shares;
+  std::vector<share_type*> m_order;
+
   std::chrono::microseconds m_time_last_tick;
   utils::SchedulerEntry     m_task_tick;
 };
@@ -9,14 +9,16 @@
 
 namespace torrent {
 
+// Nodes keep track of which side of 'm_splitActive' they are on, so
+// the checks done on every node_quota call don't search the list.
 bool
 ThrottleList::is_active(const ThrottleNode* node) const {
-  return std::find(begin(), const_iterator(m_splitActive), node) != m_splitActive;
+  return is_throttled(node) && !node->is_inactive();
 }
 
 bool
 ThrottleList::is_inactive(const ThrottleNode* node) const {
-  return std::find(const_iterator(m_splitActive), end(), node) != end();
+  return is_throttled(node) && node->is_inactive();
 }
 
 bool
@@ -62,7 +64,11 @@ ThrottleList::disable() {
   m_unusedUnthrottledQuota = 0;
 
   std::for_each(begin(), end(), std::mem_fn(&ThrottleNode::clear_quota));
-  std::for_each(m_splitActive, end(), std::mem_fn(&ThrottleNode::activate));
+
+  std::for_each(m_splitActive, end(), [](ThrottleNode* node) {
+      node->set_inactive(false);
+      node->activate();
+    });
 
   m_splitActive = end();
 }
@@ -89,6 +95,7 @@ ThrottleList::update_quota(uint32_t quota) {
     if ((*m_splitActive)->quota() < m_minChunkSize)
       break;
 
+    (*m_splitActive)->set_inactive(false);
     (*m_splitActive)->activate();
     m_splitActive++;
   }
@@ -172,6 +179,7 @@ ThrottleList::node_deactivate(ThrottleNode* node) {
                          "ThrottleList::node_deactivate(...) could not find node.");
 
   base_type::splice(end(), *this, node->list_iterator());
+  node->set_inactive(true);
 
   if (m_splitActive == end())
     m_splitActive = node->list_iterator();
@@ -220,6 +228,7 @@ ThrottleList::erase(ThrottleNode* node) {
     base_type::erase(node->list_iterator());
 
   node->clear_quota();
+  node->set_inactive(false);
   node->set_list_iterator(end());
   m_size--;
 }
@@ -46,6 +46,7 @@ public:
 
   uint32_t            outstanding_quota() const      { return m_outstandingQuota; }
   uint32_t            unallocated_quota() const      { return m_unallocatedQuota; }
+  uint32_t            unthrottled_quota() const      { return m_unusedUnthrottledQuota; }
 
   uint32_t            min_chunk_size() const         { return m_minChunkSize; }
   void                set_min_chunk_size(uint32_t v) { m_minChunkSize = v; }
@@ -28,6 +28,11 @@ public:
   void                clear_quota()                   { m_quota = 0; }
   void                set_quota(uint32_t q)           { m_quota = q; }
 
+  // Inactive nodes wait in ThrottleList for enough quota to be
+  // activated.
+  bool                is_inactive() const             { return m_inactive; }
+  void                set_inactive(bool v)            { m_inactive = v; }
+
   iterator            list_iterator()                 { return m_listIterator; }
   const_iterator      list_iterator() const           { return m_listIterator; }
   void                set_list_iterator(iterator itr) { m_listIterator = itr; }
@@ -41,6 +46,7 @@ private:
   ThrottleNode& operator=(const ThrottleNode&) = delete;
 
   uint32_t            m_quota;
+  bool                m_inactive{false};
   iterator            m_listIterator;
 
   Rate                m_rate;
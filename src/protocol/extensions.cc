@@ -50,6 +50,7 @@
 #include "torrent/object_stream.h"
 #include "torrent/peer/connection_list.h"
 #include "torrent/peer/peer_info.h"
+#include "utils/buffer_pool.h"
 
 #include "extensions.h"
 
@@ -69,6 +70,7 @@ const ExtHandshakeMessage::key_list_type ExtHandshakeMessage::keys = {
 template <>
 const ExtPEXMessage::key_list_type ExtPEXMessage::keys = {
   { key_pex_added,    "added*S" },
+  { key_pex_added6,   "added6*S" },
 };
 
 // DEBUG: Add type info.
@@ -98,6 +100,8 @@ ProtocolExtension::cleanup() {
   for (int t = HANDSHAKE + 1; t < FIRST_INVALID; t++)
     if (is_local_enabled(t))
       unset_local_enabled(t);
+
+  read_release();
 }
 
 void
@@ -188,27 +192,47 @@ ProtocolExtension::generate_toggle_message(MessageType t, bool on) {
 }
 
 DataBuffer
-ProtocolExtension::generate_ut_pex_message(const PEXList& added, const PEXList& removed) {
-  if (added.empty() && removed.empty())
+ProtocolExtension::generate_ut_pex_message(const PEXList& added, const PEXList& removed,
+                                           const PEXList6& added6, const PEXList6& removed6) {
+  if (added.empty() && removed.empty() && added6.empty() && removed6.empty())
     return DataBuffer();
 
-  int added_len   = added.size() * 6;
-  int removed_len = removed.size() * 6;
+  int added_len    = added.size() * 6;
+  int removed_len  = removed.size() * 6;
+  int added6_len   = added6.size() * 18;
+  int removed6_len = removed6.size() * 18;
+  int max_len      = 80 + added_len + removed_len + added6_len + removed6_len;
+
+  // Manually create bencoded map { "added" => added, "added6" => added6,
+  // "dropped" => dropped, "dropped6" => dropped6 }, leaving out the
+  // IPv6 keys when both are empty.
+  bool has_inet6 = !added6.empty() || !removed6.empty();
 
-  // Manually create bencoded map { "added" => added, "dropped" => dropped }
-  auto buffer = new char[32 + added_len + removed_len];
+  auto buffer = new char[max_len];
   auto end = buffer;
 
   end += sprintf(end, "d5:added%d:", added_len);
-  memcpy(end, added.begin()->c_str(), added_len);
+  memcpy(end, added.data(), added_len);
   end += added_len;
 
+  if (has_inet6) {
+    end += sprintf(end, "6:added6%d:", added6_len);
+    memcpy(end, added6.data(), added6_len);
+    end += added6_len;
+  }
+
   end += sprintf(end, "7:dropped%d:", removed_len);
-  memcpy(end, removed.begin()->c_str(), removed_len);
+  memcpy(end, removed.data(), removed_len);
   end += removed_len;
 
+  if (has_inet6) {
+    end += sprintf(end, "8:dropped6%d:", removed6_len);
+    memcpy(end, removed6.data(), removed6_len);
+    end += removed6_len;
+  }
+
   *end++ = 'e';
-  if (end - buffer > 32 + added_len + removed_len)
+  if (end - buffer > max_len)
     throw internal_error("ProtocolExtension::ut_pex_message wrote beyond buffer.");
 
   return DataBuffer(buffer, end);
@@ -233,7 +257,8 @@ ProtocolExtension::read_start(int type, uint32_t length, bool skip) {
 
   // Allocate the buffer even for SKIP_EXTENSION, just to make things
   // simpler.
-  m_readPos = m_read = new char[length];
+  m_readSize = length;
+  m_readPos = m_read = BufferPool::thread_pool()->allocate(length);
 }
 
 bool
@@ -256,8 +281,7 @@ ProtocolExtension::read_done() {
 //     throw internal_error("ProtocolExtension::read_done '" + std::string(m_read, std::distance(m_read, m_readPos)) + "'");
   }
 
-  delete [] m_read;
-  m_read = NULL;
+  read_release();
 
   m_readType = FIRST_INVALID;
   m_flags |= flag_received_ext;
@@ -265,6 +289,17 @@ ProtocolExtension::read_done() {
   return result;
 }
 
+void
+ProtocolExtension::read_release() {
+  if (m_read == nullptr)
+    return;
+
+  BufferPool::thread_pool()->release(m_read, m_readSize);
+
+  m_read = nullptr;
+  m_readSize = 0;
+}
+
 // Called whenever peer enables or disables an extension.
 void
 ProtocolExtension::peer_toggle_remote(int type, bool active) {
@@ -307,8 +342,19 @@ ProtocolExtension::parse_handshake() {
   if (message[key_p].is_value()) {
     uint16_t port = message[key_p].as_value();
 
-    if (port > 0)
+    // Connected peers are advertised through ut_pex with their listen
+    // port, which might only become known here.
+    if (port > 0 && port != m_peerInfo->listen_port()) {
+      bool connected = m_peerInfo->connection() != nullptr;
+
+      if (connected)
+        m_download->ut_pex_erase(m_peerInfo);
+
       m_peerInfo->set_listen_port(port);
+
+      if (connected)
+        m_download->ut_pex_insert(m_peerInfo);
+    }
   }
 
   if (message[key_reqq].is_value())
@@ -331,17 +377,17 @@ ProtocolExtension::parse_ut_pex() {
   static_map_read_bencode(m_read, m_readPos, message);
 
   // TODO: Check if pex is enabled?
-  if (!message[key_pex_added].is_raw_string())
-    return true;
+  AddressList l;
 
-  raw_string peers = message[key_pex_added].as_raw_string();
+  if (message[key_pex_added].is_raw_string())
+    l.parse_address_compact(message[key_pex_added].as_raw_string());
 
-  if (peers.empty())
+  if (message[key_pex_added6].is_raw_string())
+    l.parse_address_compact_ipv6(message[key_pex_added6].as_raw_string());
+
+  if (l.empty())
     return true;
 
-  // TODO: Sort the list before adding it.
-  AddressList l;
-  l.parse_address_compact(peers);
   l.sort();
   l.erase(std::unique(l.begin(), l.end()), l.end());
  
@@ -25,7 +25,8 @@ public:
     SKIP_EXTENSION,
   };
 
-  using PEXList = std::vector<SocketAddressCompact>;
+  using PEXList  = std::vector<SocketAddressCompact>;
+  using PEXList6 = std::vector<SocketAddressCompact6>;
 
   static constexpr int    flag_default           = 1<<0;
   static constexpr int    flag_initial_handshake = 1<<1;
@@ -45,7 +46,7 @@ public:
   static constexpr size_t metadata_piece_size  = 1 << metadata_piece_shift;
 
   ProtocolExtension();
-  ~ProtocolExtension() { delete [] m_read; }
+  ~ProtocolExtension() { read_release(); }
   ProtocolExtension(const ProtocolExtension&) = default;
   ProtocolExtension& operator=(const ProtocolExtension&) = default;
 
@@ -60,7 +61,8 @@ public:
 
   DataBuffer          generate_handshake_message();
   static DataBuffer   generate_toggle_message(MessageType t, bool on);
-  static DataBuffer   generate_ut_pex_message(const PEXList& added, const PEXList& removed);
+  static DataBuffer   generate_ut_pex_message(const PEXList& added, const PEXList& removed,
+                                              const PEXList6& added6 = PEXList6(), const PEXList6& removed6 = PEXList6());
 
   // Return peer's extension ID for the given extension type, or 0 if
   // disabled by peer.
@@ -117,6 +119,9 @@ private:
   void                peer_toggle_remote(int type, bool active);
   void                send_metadata_piece(size_t piece);
 
+  // Returns the read buffer to the thread's BufferPool.
+  void                read_release();
+
   // Map of IDs peer uses for each extension message type, excluding
   // HANDSHAKE.
   uint8_t             m_idMap[extension_count];
@@ -132,6 +137,7 @@ private:
 
   uint8_t             m_readType{FIRST_INVALID};
   uint32_t            m_readLeft;
+  uint32_t            m_readSize{};
   char*               m_read{};
   char*               m_readPos;
 
@@ -152,6 +158,7 @@ enum ext_handshake_keys {
 
 enum ext_pex_keys {
   key_pex_added,
+  key_pex_added6,
   key_pex_LAST
 };
 
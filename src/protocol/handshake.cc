@@ -78,6 +78,7 @@ void
 Handshake::initialize_incoming(const sockaddr* sa) {
   m_incoming = true;
   m_address = sa_copy(sa);
+  m_started_time = this_thread::cached_time();
 
   if (m_encryption.options() & (ConnectionManager::encryption_allow_incoming | ConnectionManager::encryption_require))
     m_state = READ_ENC_KEY;
@@ -101,6 +102,7 @@ Handshake::initialize_outgoing(const sockaddr* sa, DownloadMain* d, PeerInfo* pe
 
   m_incoming = false;
   m_address = sa_copy(sa);
+  m_started_time = this_thread::cached_time();
 
   std::make_pair(m_uploadThrottle, m_downloadThrottle) = m_download->throttles(m_address.get());
 
@@ -247,10 +249,25 @@ Handshake::read_encryption_key() {
   if (m_incoming)
     prepare_key_plus_pad();
 
-  if(!m_encryption.key()->compute_secret(m_readBuffer.position(), 96))
-    throw handshake_error(ConnectionManager::handshake_failed, e_handshake_invalid_encryption);
+  // The secret is computed by the key pool's worker, stop reading
+  // until it is done.
+  m_encryption.compute_secret(m_readBuffer.position(), [this] { receive_encryption_secret(); });
   m_readBuffer.consume(96);
 
+  this_thread::poll()->remove_read(this);
+
+  m_state = READ_ENC_SECRET;
+  return true;
+}
+
+bool
+Handshake::read_encryption_secret() {
+  if (m_encryption.is_computing_secret())
+    return false;
+
+  if (!m_encryption.key()->has_secret())
+    throw handshake_error(ConnectionManager::handshake_failed, e_handshake_invalid_encryption);
+
   // Determine the synchronisation string.
   if (m_incoming)
     m_encryption.hash_req1_to_sync();
@@ -265,6 +282,17 @@ Handshake::read_encryption_key() {
   return true;
 }
 
+// Called through the thread's callbacks when the key pool is done,
+// the handshake is destroyed before then if it fails or times out.
+void
+Handshake::receive_encryption_secret() {
+  if (m_state != READ_ENC_SECRET)
+    throw internal_error("Handshake::receive_encryption_secret() called in invalid state.");
+
+  this_thread::poll()->insert_read(this);
+  event_read();
+}
+
 // Handshake::read_encryption_sync()
 // *E 96, [96, enc_pad_read_size>
 bool
@@ -666,9 +694,14 @@ restart:
       if (!read_encryption_key())
         break;
 
-      if (m_state != READ_ENC_SYNC)
+      if (m_state != READ_ENC_SECRET)
         goto restart;
 
+      [[fallthrough]];
+    case READ_ENC_SECRET:
+      if (!read_encryption_secret())
+        break;
+
       [[fallthrough]];
     case READ_ENC_SYNC:
       if (!read_encryption_sync())
@@ -981,7 +1014,7 @@ Handshake::prepare_proxy_connect() {
 
 void
 Handshake::prepare_key_plus_pad() {
-  if (!m_encryption.initialize())
+  if (!m_encryption.initialize(m_manager->key_pool()))
     throw handshake_error(ConnectionManager::handshake_failed, e_handshake_invalid_value);
 
   m_encryption.key()->store_pub_key(m_writeBuffer.end(), 96);
@@ -44,6 +44,7 @@ public:
     PROXY_DONE,
 
     READ_ENC_KEY,
+    READ_ENC_SECRET,
     READ_ENC_SYNC,
     READ_ENC_SKEY,
     READ_ENC_NEGOT,
@@ -89,6 +90,7 @@ public:
   const void*         unread_data()                 { return m_readBuffer.position(); }
   uint32_t            unread_size() const           { return m_readBuffer.remaining(); }
 
+  std::chrono::microseconds started_time() const     { return m_started_time; }
   std::chrono::microseconds initialized_time() const { return m_initialized_time; }
 
   void                event_read() override;
@@ -109,6 +111,7 @@ protected:
   // Check what is unnessesary.
   bool                read_proxy_connect();
   bool                read_encryption_key();
+  bool                read_encryption_secret();
   bool                read_encryption_sync();
   bool                read_encryption_skey();
   bool                read_encryption_negotiation();
@@ -130,6 +133,8 @@ protected:
   void                write_extension_handshake();
   void                write_bitfield();
 
+  void                receive_encryption_secret();
+
   inline void         validate_download();
 
   uint32_t            read_unthrottled(void* buf, uint32_t length);
@@ -149,6 +154,7 @@ protected:
   ThrottleList*       m_downloadThrottle;
 
   utils::SchedulerEntry     m_task_timeout;
+  std::chrono::microseconds m_started_time;
   std::chrono::microseconds m_initialized_time;
 
   uint32_t            m_readPos;
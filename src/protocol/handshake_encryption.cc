@@ -37,7 +37,10 @@
 #include "config.h"
 
 #include "torrent/connection_manager.h"
+#include "torrent/exceptions.h"
+#include "torrent/utils/thread.h"
 #include "utils/diffie_hellman.h"
+#include "utils/diffie_hellman_pool.h"
 #include "utils/sha1.h"
 
 #include "handshake_encryption.h"
@@ -68,17 +71,38 @@ HandshakeEncryption::HandshakeEncryption(int options) :
 }
 
 bool
-HandshakeEncryption::initialize() {
-  m_key = std::make_unique<DiffieHellman>(dh_prime, dh_prime_length, dh_generator, dh_generator_length);
+HandshakeEncryption::initialize(DiffieHellmanPool* pool) {
+  m_pool = pool;
+  m_key = m_pool->take_key();
 
   return m_key->is_valid();
 }
 
 void
 HandshakeEncryption::cleanup() {
+  if (m_computing) {
+    m_pool->cancel(this_thread::thread(), this);
+    m_computing = false;
+  }
+
   m_key = nullptr;
 }
 
+void
+HandshakeEncryption::compute_secret(const unsigned char* pubkey, std::function<void ()>&& slot) {
+  if (m_computing || m_key == nullptr)
+    throw internal_error("HandshakeEncryption::compute_secret() called while computing or without a key.");
+
+  m_computing = true;
+
+  m_pool->compute_secret(this_thread::thread(), this, std::move(m_key), pubkey, dh_prime_length,
+                         [this, slot = std::move(slot)](auto key) {
+                           m_key = std::move(key);
+                           m_computing = false;
+                           slot();
+                         });
+}
+
 bool
 HandshakeEncryption::compare_vc(const void* buf) {
   return std::memcmp(buf, vc_data, vc_length) == 0;
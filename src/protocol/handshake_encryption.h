@@ -38,6 +38,7 @@
 #define LIBTORRENT_PROTOCOL_HANDSHAKE_ENCRYPTION_H
 
 #include <cstring>
+#include <functional>
 #include <memory>
 
 #include "encryption_info.h"
@@ -45,6 +46,7 @@
 namespace torrent {
 
 class DiffieHellman;
+class DiffieHellmanPool;
 
 class HandshakeEncryption {
 public:
@@ -93,9 +95,15 @@ public:
   unsigned int        length_ia() const                            { return m_lengthIA; }
   void                set_length_ia(unsigned int len)              { m_lengthIA = len; }
 
-  bool                initialize();
+  bool                initialize(DiffieHellmanPool* pool);
   void                cleanup();
 
+  // Computes the shared secret from the peer's public key on the
+  // pool's worker, 'slot' is called from the current thread once
+  // 'key()' is available again.
+  void                compute_secret(const unsigned char* pubkey, std::function<void ()>&& slot);
+  bool                is_computing_secret() const                  { return m_computing; }
+
   void                initialize_decrypt(const char* origHash, bool incoming);
   void                initialize_encrypt(const char* origHash, bool incoming);
 
@@ -109,6 +117,8 @@ public:
 
 private:
   std::unique_ptr<DiffieHellman> m_key;
+  DiffieHellmanPool*  m_pool{nullptr};
+  bool                m_computing{false};
 
   // A pointer instead?
   EncryptionInfo      m_info;
@@ -15,6 +15,8 @@
 #include "torrent/peer/client_list.h"
 #include "torrent/peer/connection_list.h"
 #include "torrent/utils/log.h"
+#include "torrent/utils/thread.h"
+#include "utils/instrumentation.h"
 
 #define LT_LOG_SA(sa, log_fmt, ...)                                     \
   lt_log_print(LOG_CONNECTION_HANDSHAKE, "handshake_manager->%s: " log_fmt, (sa)->address_str().c_str(), __VA_ARGS__);
@@ -163,6 +165,9 @@ HandshakeManager::receive_succeeded(Handshake* handshake) {
   erase(handshake);
   handshake->deactivate_connection();
 
+  instrumentation_update(INSTRUMENTATION_HANDSHAKE_SUCCEEDED_COUNT, 1);
+  instrumentation_update(INSTRUMENTATION_HANDSHAKE_SUCCEEDED_USEC, (this_thread::cached_time() - handshake->started_time()).count());
+
   DownloadMain* download = handshake->download();
   PeerConnectionBase* pcb;
 
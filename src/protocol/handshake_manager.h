@@ -6,9 +6,11 @@
 #include <string>
 
 #include "net/socket_fd.h"
+#include "protocol/handshake_encryption.h"
 #include "rak/socket_address.h"
 #include "rak/unordered_vector.h"
 #include "torrent/connection_manager.h"
+#include "utils/diffie_hellman_pool.h"
 
 namespace torrent {
 
@@ -57,6 +59,8 @@ public:
   void                receive_failed(Handshake* h, int message, int error);
   void                receive_timeout(Handshake* h);
 
+  DiffieHellmanPool*  key_pool()                                         { return &m_key_pool; }
+
   static ProtocolExtension*  default_extensions()                       { return &DefaultExtensions; }
 
 private:
@@ -72,6 +76,9 @@ private:
 
   slot_download       m_slot_download_id;
   slot_download       m_slot_download_obfuscated;
+
+  DiffieHellmanPool   m_key_pool{HandshakeEncryption::dh_prime, HandshakeEncryption::dh_prime_length,
+                                 HandshakeEncryption::dh_generator, HandshakeEncryption::dh_generator_length};
 };
 
 } // namespace torrent
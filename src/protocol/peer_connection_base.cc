@@ -11,6 +11,7 @@
 #include "torrent/chunk_manager.h"
 #include "torrent/connection_manager.h"
 #include "torrent/data/block.h"
+#include "torrent/data/file.h"
 #include "torrent/download/choke_group.h"
 #include "torrent/download/choke_queue.h"
 #include "torrent/download_info.h"
@@ -19,6 +20,7 @@
 #include "torrent/peer/peer_info.h"
 #include "torrent/throttle.h"
 #include "torrent/utils/log.h"
+#include "utils/bitfield_ops.h"
 #include "utils/instrumentation.h"
 
 #include "extensions.h"
@@ -52,14 +54,42 @@ log_mincore_stats_func(bool is_incore, bool new_index, bool& continous) {
   continous = is_incore;
 }
 
+// Fills 'vectors' with the memory ranges covered by 'itr', one per
+// chunk part, and returns the number of vectors used.
+static int
+fill_chunk_vectors(ChunkIterator& itr, iovec* vectors, int max_count) {
+  int count = 0;
+
+  do {
+    Chunk::data_type data = itr.data();
+
+    vectors[count].iov_base = data.first;
+    vectors[count].iov_len = data.second;
+    count++;
+
+  } while (count < max_count && itr.next());
+
+  return count;
+}
+
+// The allocations every connection holds, protocol buffers taken from
+// BufferPool are accounted for separately.
+static constexpr size_t connection_memory_usage = sizeof(PeerConnectionBase) + sizeof(ProtocolBase) * 2;
+
 PeerConnectionBase::PeerConnectionBase() :
   m_down(new ProtocolRead()),
   m_up(new ProtocolWrite()) {
 
   m_peerInfo = nullptr;
+
+  instrumentation_update(INSTRUMENTATION_MEMORY_PEER_CONNECTION_USAGE, connection_memory_usage);
+  instrumentation_update(INSTRUMENTATION_MEMORY_PEER_CONNECTION_COUNT, 1);
 }
 
 PeerConnectionBase::~PeerConnectionBase() {
+  instrumentation_update(INSTRUMENTATION_MEMORY_PEER_CONNECTION_USAGE, -static_cast<int64_t>(connection_memory_usage));
+  instrumentation_update(INSTRUMENTATION_MEMORY_PEER_CONNECTION_COUNT, -1);
+
   delete m_up;
   delete m_down;
 
@@ -80,10 +110,14 @@ PeerConnectionBase::initialize(DownloadMain* download, PeerInfo* peerInfo, Socke
   if (encryptionInfo->is_encrypted() != encryptionInfo->decrypt_valid())
     throw internal_error("Encryption and decryption inconsistent.");
 
+  if (download->peer_thread() == nullptr)
+    throw internal_error("PeerConnectionBase::initialize(...) download has no peer thread.");
+
   set_fd(fd);
 
-  m_peerInfo = peerInfo;
-  m_download = download;
+  m_peerInfo    = peerInfo;
+  m_download    = download;
+  m_peer_thread = download->peer_thread();
 
   m_encryption = *encryptionInfo;
   m_extensions = extensions;
@@ -122,10 +156,10 @@ PeerConnectionBase::initialize(DownloadMain* download, PeerInfo* peerInfo, Socke
     return;
   }
 
-  this_thread::poll()->open(this);
-  this_thread::poll()->insert_read(this);
-  this_thread::poll()->insert_write(this);
-  this_thread::poll()->insert_error(this);
+  peer_poll()->open(this);
+  peer_poll()->insert_read(this);
+  peer_poll()->insert_write(this);
+  peer_poll()->insert_error(this);
 
   m_time_last_read = this_thread::cached_time();
 
@@ -136,7 +170,13 @@ PeerConnectionBase::initialize(DownloadMain* download, PeerInfo* peerInfo, Socke
 
   m_peerChunks.download_cache()->clear();
 
-  if (!m_download->file_list()->is_done()) {
+  // Only interested if the peer has chunks we haven't completed,
+  // otherwise that is decided as HAVE messages arrive.
+  const Bitfield* completed = m_download->file_list()->bitfield();
+
+  if (!m_download->file_list()->is_done() &&
+      m_peerChunks.bitfield()->size_bytes() == completed->size_bytes() &&
+      bitfield_any_andnot(m_peerChunks.bitfield()->begin(), completed->begin(), completed->size_bytes())) {
     m_sendInterested = true;
     m_downInterested = true;
   }
@@ -166,7 +206,7 @@ PeerConnectionBase::cleanup() {
   if (!m_extensions->is_default())
     m_extensions->cleanup();
 
-  this_thread::poll()->remove_and_close(this);
+  peer_poll()->remove_and_close(this);
 
   manager->connection_manager()->dec_socket_count();
 
@@ -322,7 +362,7 @@ PeerConnectionBase::load_up_chunk() {
     throw storage_error("File chunk read error: " + std::string(m_upChunk.error_number().c_str()));
 
   if (is_encrypted() && m_encryptBuffer == nullptr) {
-    m_encryptBuffer = std::make_unique<EncryptBuffer>();
+    m_encryptBuffer = make_pooled<EncryptBuffer>();
     m_encryptBuffer->reset();
   }
 
@@ -473,29 +513,33 @@ PeerConnectionBase::down_chunk() {
   uint32_t quota = m_down->throttle()->node_quota(m_peerChunks.download_throttle());
 
   if (quota == 0) {
-    this_thread::poll()->remove_read(this);
+    peer_poll()->remove_read(this);
     m_down->throttle()->node_deactivate(m_peerChunks.download_throttle());
     return false;
   }
 
-  uint32_t bytesTransfered = 0;
   BlockTransfer* transfer = m_request_list.transfer();
 
-  Chunk::data_type data;
   ChunkIterator itr(m_downChunk.chunk(),
                     transfer->piece().offset() + transfer->position(),
                     transfer->piece().offset() + std::min(transfer->position() + quota, transfer->piece().length()));
 
-  do {
-    data = itr.data();
-    data.second = read_stream_throws(data.first, data.second);
+  // Scatter directly into all the chunk parts the block spans.
+  iovec vectors[max_chunk_vectors];
+  int count = fill_chunk_vectors(itr, vectors, max_chunk_vectors);
 
-    if (is_encrypted())
-      m_encryption.decrypt(data.first, data.second);
+  uint32_t bytesTransfered = read_vector_throws(vectors, count);
+
+  if (is_encrypted()) {
+    uint32_t remaining = bytesTransfered;
 
-    bytesTransfered += data.second;
+    for (iovec* itr = vectors; remaining != 0; itr++) {
+      uint32_t length = std::min<uint32_t>(itr->iov_len, remaining);
 
-  } while (data.second != 0 && itr.forward(data.second));
+      m_encryption.decrypt(itr->iov_base, length);
+      remaining -= length;
+    }
+  }
 
   transfer->adjust_position(bytesTransfered);
 
@@ -528,7 +572,7 @@ PeerConnectionBase::down_chunk_skip() {
   uint32_t quota = throttle->node_quota(m_peerChunks.download_throttle());
 
   if (quota == 0) {
-    this_thread::poll()->remove_read(this);
+    peer_poll()->remove_read(this);
     throttle->node_deactivate(m_peerChunks.download_throttle());
     return false;
   }
@@ -659,7 +703,7 @@ PeerConnectionBase::down_extension() {
   // If extension can't be processed yet (due to a pending write),
   // disable reads until the pending message is completely sent.
   if (m_extensions->is_complete() && !m_extensions->is_invalid() && !m_extensions->read_done()) {
-    this_thread::poll()->remove_read(this);
+    peer_poll()->remove_read(this);
     return false;
   }
 
@@ -688,8 +732,7 @@ PeerConnectionBase::up_chunk_encrypt(uint32_t quota) {
     quota = std::min<uint32_t>(quota - m_encryptBuffer->remaining(), m_encryptBuffer->reserved_left());
   }
 
-  m_upChunk.chunk()->to_buffer(m_encryptBuffer->end(), m_upPiece.offset() + m_encryptBuffer->remaining(), quota);
-  m_encryption.encrypt(m_encryptBuffer->end(), quota);
+  m_upChunk.chunk()->to_buffer_encrypted(m_encryptBuffer->end(), m_upPiece.offset() + m_encryptBuffer->remaining(), quota, &m_encryption);
   m_encryptBuffer->move_end(quota);
 
   return m_encryptBuffer->remaining();
@@ -706,7 +749,7 @@ PeerConnectionBase::up_chunk() {
   uint32_t quota = m_up->throttle()->node_quota(m_peerChunks.upload_throttle());
 
   if (quota == 0) {
-    this_thread::poll()->remove_write(this);
+    peer_poll()->remove_write(this);
     m_up->throttle()->node_deactivate(m_peerChunks.upload_throttle());
     return false;
   }
@@ -722,28 +765,94 @@ PeerConnectionBase::up_chunk() {
     bytesTransfered = write_stream_throws(m_encryptBuffer->position(), quota);
     m_encryptBuffer->consume(bytesTransfered);
 
+  } else if (!manager->connection_manager()->is_upload_sendfile()) {
+    ChunkIterator itr(m_upChunk.chunk(), m_upPiece.offset(), m_upPiece.offset() + std::min(quota, m_upPiece.length()));
+
+    iovec vectors[max_chunk_vectors];
+    int count = fill_chunk_vectors(itr, vectors, max_chunk_vectors);
+
+    bytesTransfered = write_vector_throws(vectors, count);
+
   } else {
     Chunk::data_type data;
     ChunkIterator itr(m_upChunk.chunk(), m_upPiece.offset(), m_upPiece.offset() + std::min(quota, m_upPiece.length()));
 
     do {
       data = itr.data();
-      data.second = write_stream_throws(data.first, data.second);
+
+      // Only mapped parts are guaranteed to match the file's page
+      // cache, padding has no file to send from.
+      const ChunkPart* part = itr.chunk_part();
+
+      if (part->mapped() == ChunkPart::MAPPED_MMAP &&
+          part->file() != nullptr && !part->file()->is_padding() && part->file()->is_open())
+        data.second = sendfile_stream_throws(part->file()->file_descriptor(),
+                                             part->file_offset() + itr.memory_chunk_first(),
+                                             data.second);
+      else
+        data.second = write_stream_throws(data.first, data.second);
 
       bytesTransfered += data.second;
 
     } while (data.second != 0 && itr.forward(data.second));
   }
 
-  m_up->throttle()->node_used(m_peerChunks.upload_throttle(), bytesTransfered);
-  m_download->info()->mutable_up_rate()->insert(bytesTransfered);
+  up_chunk_transferred(bytesTransfered);
+
+  return m_upPiece.length() == 0;
+}
+
+// Writes the PIECE message header in the write buffer together with
+// as much of the piece as the throttle allows, using a single writev
+// call. Only used for unencrypted connections. Returns true if the
+// whole header was written, the rest of the piece is then sent by
+// 'up_chunk'.
+bool
+PeerConnectionBase::up_chunk_with_header() {
+  if (!m_up->throttle()->is_throttled(m_peerChunks.upload_throttle()))
+    throw internal_error("PeerConnectionBase::up_chunk_with_header() tried to write a piece but is not in throttle list");
+
+  if (!m_upChunk.chunk()->is_readable())
+    throw internal_error("PeerConnectionBase::up_chunk_with_header() chunk not readable, permission denided");
+
+  if (is_encrypted())
+    throw internal_error("PeerConnectionBase::up_chunk_with_header() called on an encrypted connection");
+
+  uint32_t header_length = m_up->buffer()->remaining();
+  uint32_t quota = std::min(m_up->throttle()->node_quota(m_peerChunks.upload_throttle()), m_upPiece.length());
+
+  iovec vectors[1 + max_chunk_vectors];
+  vectors[0].iov_base = m_up->buffer()->position();
+  vectors[0].iov_len = header_length;
+
+  int count = 1;
+
+  // A zero quota is left to 'up_chunk' to handle.
+  if (quota != 0) {
+    ChunkIterator itr(m_upChunk.chunk(), m_upPiece.offset(), m_upPiece.offset() + quota);
+    count += fill_chunk_vectors(itr, vectors + 1, max_chunk_vectors);
+  }
+
+  uint32_t written = write_vector_throws(vectors, count);
+  uint32_t header_written = std::min(written, header_length);
+
+  m_up->buffer()->consume(m_up->throttle()->node_used_unthrottled(header_written));
+
+  if (written != header_written)
+    up_chunk_transferred(written - header_written);
+
+  return header_written == header_length;
+}
+
+void
+PeerConnectionBase::up_chunk_transferred(uint32_t bytes) {
+  m_up->throttle()->node_used(m_peerChunks.upload_throttle(), bytes);
+  m_download->info()->mutable_up_rate()->insert(bytes);
 
   // Just modifying the piece to cover the remaining data ends up
   // being much cleaner and we avoid an unnessesary position variable.
-  m_upPiece.set_offset(m_upPiece.offset() + bytesTransfered);
-  m_upPiece.set_length(m_upPiece.length() - bytesTransfered);
-
-  return m_upPiece.length() == 0;
+  m_upPiece.set_offset(m_upPiece.offset() + bytes);
+  m_upPiece.set_length(m_upPiece.length() - bytes);
 }
 
 bool
@@ -780,7 +889,7 @@ PeerConnectionBase::up_extension() {
     if (!m_extensions->read_done())
       throw internal_error("PeerConnectionBase::up_extension could not process complete extension message.");
 
-    this_thread::poll()->insert_read(this);
+    peer_poll()->insert_read(this);
   }
 
   return true;
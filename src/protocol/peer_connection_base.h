@@ -12,6 +12,8 @@
 #include "torrent/poll.h"
 #include "torrent/peer/peer.h"
 #include "torrent/peer/choke_status.h"
+#include "utils/buffer_pool.h"
+#include "utils/thread_internal.h"
 
 namespace torrent {
 
@@ -79,6 +81,7 @@ public:
   choke_status*       down_choke()                    { return &m_downChoke; }
 
   DownloadMain*       download()                      { return m_download; }
+  utils::Thread*      peer_thread()                   { return m_peer_thread; }
   RequestList*        request_list()                { return &m_request_list; }
   const RequestList*  request_list() const          { return &m_request_list; }
 
@@ -114,6 +117,14 @@ public:
 protected:
   static constexpr uint32_t extension_must_encrypt = ~uint32_t();
 
+  // Maximum number of chunk parts transferred by a single readv or
+  // writev call.
+  static constexpr int      max_chunk_vectors = 16;
+
+  // The poll of the thread that owns this connection's socket, which need not be the thread
+  // currently running.
+  Poll*               peer_poll()                     { return utils::ThreadInternal::poll(m_peer_thread); }
+
   inline bool         read_remaining();
   inline bool         write_remaining();
 
@@ -139,7 +150,9 @@ protected:
   bool                down_extension();
 
   bool                up_chunk();
+  bool                up_chunk_with_header();
   inline uint32_t     up_chunk_encrypt(uint32_t quota);
+  void                up_chunk_transferred(uint32_t bytes);
 
   bool                up_extension();
 
@@ -153,6 +166,7 @@ protected:
   bool                send_ext_message();
 
   DownloadMain*       m_download{};
+  utils::Thread*      m_peer_thread{};
 
   ProtocolRead*       m_down;
   ProtocolWrite*      m_up;
@@ -193,7 +207,7 @@ protected:
   DataBuffer          m_extensionMessage;
   uint32_t            m_extensionOffset;
 
-  std::unique_ptr<EncryptBuffer> m_encryptBuffer;
+  pooled_ptr<EncryptBuffer> m_encryptBuffer;
   EncryptionInfo      m_encryption;
   ProtocolExtension*  m_extensions{};
 
@@ -225,7 +239,7 @@ PeerConnectionBase::read_insert_poll_safe() {
   if (m_down->get_state() != ProtocolRead::IDLE)
     return;
 
-  this_thread::poll()->insert_read(this);
+  peer_poll()->insert_read(this);
 }
 
 inline void
@@ -233,7 +247,7 @@ PeerConnectionBase::write_insert_poll_safe() {
   if (m_up->get_state() != ProtocolWrite::IDLE)
     return;
 
-  this_thread::poll()->insert_write(this);
+  peer_poll()->insert_write(this);
 }
 
 } // namespace torrent
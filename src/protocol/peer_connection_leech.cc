@@ -8,6 +8,7 @@
 #include "download/download_main.h"
 #include "manager.h"
 #include "rak/string_manip.h"
+#include "torrent/connection_manager.h"
 #include "torrent/download/choke_group.h"
 #include "torrent/download/choke_queue.h"
 #include "torrent/download_info.h"
@@ -563,7 +564,12 @@ PeerConnection<type>::event_write() {
         fill_write_buffer();
 
         if (m_up->buffer()->remaining() == 0) {
-          this_thread::poll()->remove_write(this);
+          // Nothing left to upload, return the encrypt buffer to the
+          // pool until the next piece.
+          if (m_encryptBuffer != nullptr && m_encryptBuffer->remaining() == 0)
+            m_encryptBuffer = nullptr;
+
+          peer_poll()->remove_write(this);
           return;
         }
 
@@ -571,6 +577,29 @@ PeerConnection<type>::event_write() {
 
 	[[fallthrough]];
       case ProtocolWrite::MSG:
+        // Unencrypted piece messages are sent together with the start
+        // of the piece data.
+        if (m_up->last_command() == ProtocolBase::PIECE &&
+            !is_encrypted() && !manager->connection_manager()->is_upload_sendfile()) {
+          // Only load the chunk when the piece starts, not when resuming
+          // a partially written header.
+          if (m_up->buffer()->size_position() == 0 || !m_upChunk.is_valid())
+            load_up_chunk();
+
+          if (!up_chunk_with_header())
+            return;
+
+          m_up->buffer()->reset();
+
+          if (m_upPiece.length() == 0) {
+            m_up->set_state(ProtocolWrite::IDLE);
+            break;
+          }
+
+          m_up->set_state(ProtocolWrite::WRITE_PIECE);
+          continue;
+        }
+
         if (!m_up->buffer()->consume(m_up->throttle()->node_used_unthrottled(write_stream_throws(m_up->buffer()->position(), m_up->buffer()->remaining()))))
           return;
 
@@ -306,7 +306,7 @@ PeerConnectionMetadata::event_write() {
         fill_write_buffer();
 
         if (m_up->buffer()->remaining() == 0) {
-          this_thread::poll()->remove_write(this);
+          peer_poll()->remove_write(this);
           return;
         }
 
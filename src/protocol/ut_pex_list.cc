@@ -0,0 +1,147 @@
+#include "config.h"
+
+#include "protocol/ut_pex_list.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "protocol/extensions.h"
+#include "torrent/download_info.h"
+#include "torrent/exceptions.h"
+
+namespace torrent {
+
+// The order only needs to be consistent, so the compact addresses are
+// compared as bytes.
+template <typename Compact>
+static bool
+compact_less(const Compact& a, const Compact& b) {
+  return std::memcmp(&a, &b, sizeof(Compact)) < 0;
+}
+
+template <typename Compact>
+static bool
+compact_equal(const Compact& a, const Compact& b) {
+  return std::memcmp(&a, &b, sizeof(Compact)) == 0;
+}
+
+template <typename Compact>
+static bool
+erase_compact(std::vector<Compact>& list, const Compact& sa) {
+  auto itr = std::find_if(list.begin(), list.end(), [&sa](auto& v) { return compact_equal(v, sa); });
+
+  if (itr == list.end())
+    return false;
+
+  *itr = list.back();
+  list.pop_back();
+  return true;
+}
+
+uint32_t
+UtPexList::max_size() {
+  return DownloadInfo::max_size_pex_list();
+}
+
+void
+UtPexList::clear() {
+  m_inet.clear();
+  m_inet6.clear();
+
+  m_initial.clear();
+  m_delta.clear();
+}
+
+void
+UtPexList::update() {
+  m_delta.clear();
+
+  if (m_inet.added.empty() && m_inet.removed.empty() && m_inet6.added.empty() && m_inet6.removed.empty())
+    return;
+
+  m_delta = ProtocolExtension::generate_ut_pex_message(m_inet.added, m_inet.removed, m_inet6.added, m_inet6.removed);
+  m_delta.set_shared();
+
+  m_initial.clear();
+  m_initial = ProtocolExtension::generate_ut_pex_message(m_inet.advertised, list_type(), m_inet6.advertised, list6_type());
+  m_initial.set_shared();
+
+  m_inet.added.clear();
+  m_inet.removed.clear();
+  m_inet6.added.clear();
+  m_inet6.removed.clear();
+}
+
+template <typename Compact>
+void
+UtPexList::family_list<Compact>::insert(const Compact& sa) {
+  auto itr = std::lower_bound(advertised.begin(), advertised.end(), sa, compact_less<Compact>);
+
+  if ((itr != advertised.end() && compact_equal(*itr, sa)) || advertised.size() >= max_size()) {
+    held_back.push_back(sa);
+    return;
+  }
+
+  advertise(sa);
+}
+
+template <typename Compact>
+void
+UtPexList::family_list<Compact>::erase(const Compact& sa) {
+  if (erase_compact(held_back, sa))
+    return;
+
+  auto itr = std::lower_bound(advertised.begin(), advertised.end(), sa, compact_less<Compact>);
+
+  if (itr == advertised.end() || !compact_equal(*itr, sa))
+    throw internal_error("UtPexList::erase(...) address not found.");
+
+  withdraw(itr);
+
+  // Fill the freed slot with the first held back address not already
+  // advertised, which may be a duplicate of the one just withdrawn.
+  for (auto held_itr = held_back.begin(); held_itr != held_back.end(); held_itr++) {
+    if (std::binary_search(advertised.begin(), advertised.end(), *held_itr, compact_less<Compact>))
+      continue;
+
+    auto held_sa = *held_itr;
+    *held_itr = held_back.back();
+    held_back.pop_back();
+
+    advertise(held_sa);
+    break;
+  }
+}
+
+template <typename Compact>
+void
+UtPexList::family_list<Compact>::clear() {
+  advertised.clear();
+  held_back.clear();
+  added.clear();
+  removed.clear();
+}
+
+template <typename Compact>
+void
+UtPexList::family_list<Compact>::advertise(const Compact& sa) {
+  advertised.insert(std::upper_bound(advertised.begin(), advertised.end(), sa, compact_less<Compact>), sa);
+
+  if (!erase_compact(removed, sa))
+    added.push_back(sa);
+}
+
+template <typename Compact>
+void
+UtPexList::family_list<Compact>::withdraw(typename list_type::iterator itr) {
+  auto sa = *itr;
+  advertised.erase(itr);
+
+  if (!erase_compact(added, sa))
+    removed.push_back(sa);
+}
+
+template struct UtPexList::family_list<SocketAddressCompact>;
+template struct UtPexList::family_list<SocketAddressCompact6>;
+
+} // namespace torrent
@@ -0,0 +1,92 @@
+#ifndef LIBTORRENT_PROTOCOL_UT_PEX_LIST_H
+#define LIBTORRENT_PROTOCOL_UT_PEX_LIST_H
+
+#include <vector>
+
+#include "net/address_list.h"
+#include "net/data_buffer.h"
+
+namespace torrent {
+
+// The addresses of connected peers advertised through ut_pex, kept
+// up-to-date as peers connect and disconnect rather than rebuilt from
+// the connection list.
+//
+// Changes are collected until 'update' which encodes them as the delta
+// message, and the initial message for newly enabled peers is only
+// regenerated when something changed. Both messages are shared buffers
+// so connections queue clones of them without copying, and a clone
+// still waiting to be sent keeps its data alive after the next update.
+//
+// IPv4 and IPv6 addresses are kept apart, sent as 'added'/'dropped'
+// and 'added6'/'dropped6'. At most 'max_size' distinct addresses of
+// each family are advertised, the rest are held back and advertised as
+// space becomes available.
+
+class UtPexList {
+public:
+  using list_type  = std::vector<SocketAddressCompact>;
+  using list6_type = std::vector<SocketAddressCompact6>;
+
+  UtPexList() = default;
+  ~UtPexList() { clear(); }
+
+  UtPexList(const UtPexList&) = delete;
+  UtPexList& operator=(const UtPexList&) = delete;
+
+  static uint32_t     max_size();
+
+  // Insert and erase must be balanced, with the same address used for
+  // a peer while it is connected.
+  void                insert(const SocketAddressCompact& sa)    { m_inet.insert(sa); }
+  void                insert(const SocketAddressCompact6& sa)   { m_inet6.insert(sa); }
+  void                erase(const SocketAddressCompact& sa)     { m_inet.erase(sa); }
+  void                erase(const SocketAddressCompact6& sa)    { m_inet6.erase(sa); }
+
+  void                clear();
+
+  // Generates the delta message from the changes since the last
+  // update, or clears it if there were none.
+  void                update();
+
+  DataBuffer          initial_message() const      { return m_initial.clone(); }
+  DataBuffer          delta_message() const        { return m_delta.clone(); }
+
+  const list_type&    advertised() const           { return m_inet.advertised; }
+  const list6_type&   advertised6() const          { return m_inet6.advertised; }
+
+  size_t              held_back_size() const       { return m_inet.held_back.size() + m_inet6.held_back.size(); }
+  size_t              added_size() const           { return m_inet.added.size() + m_inet6.added.size(); }
+  size_t              removed_size() const         { return m_inet.removed.size() + m_inet6.removed.size(); }
+
+private:
+  // Advertised addresses are sorted and distinct, duplicates go in
+  // 'held_back'.
+  template <typename Compact>
+  struct family_list {
+    using list_type = std::vector<Compact>;
+
+    void                insert(const Compact& sa);
+    void                erase(const Compact& sa);
+    void                clear();
+
+    void                advertise(const Compact& sa);
+    void                withdraw(typename list_type::iterator itr);
+
+    list_type           advertised;
+    list_type           held_back;
+
+    list_type           added;
+    list_type           removed;
+  };
+
+  family_list<SocketAddressCompact>  m_inet;
+  family_list<SocketAddressCompact6> m_inet6;
+
+  DataBuffer          m_initial;
+  DataBuffer          m_delta;
+};
+
+} // namespace torrent
+
+#endif
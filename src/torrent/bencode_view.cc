@@ -0,0 +1,339 @@
+#include "config.h"
+
+#include "bencode_view.h"
+
+#include <limits>
+
+#include "exceptions.h"
+#include "object_stream.h"
+
+namespace torrent {
+
+void
+BencodeView::check_throw(char type) const {
+  if (m_node == nullptr || m_node->type != type)
+    throw bencode_error("Wrong object type.");
+}
+
+BencodeView::value_type
+BencodeView::as_value() const {
+  check_throw('i');
+  return m_node->value;
+}
+
+BencodeView::string_type
+BencodeView::as_string() const {
+  check_throw('s');
+  return string_type(m_data + m_node->offset, m_node->length);
+}
+
+BencodeView::list_type
+BencodeView::as_list() const {
+  check_throw('l');
+  return list_type(*this);
+}
+
+BencodeView::map_type
+BencodeView::as_map() const {
+  check_throw('d');
+  return map_type(*this);
+}
+
+raw_bencode
+BencodeView::as_raw_bencode() const {
+  if (m_node == nullptr)
+    return raw_bencode();
+
+  if (m_node->type != 's')
+    return raw_bencode(m_data + m_node->offset, m_node->length);
+
+  return raw_bencode(m_data + m_node->offset - m_node->value, m_node->length + m_node->value);
+}
+
+// Duplicate keys are resolved to the last entry, as when reading into
+// an Object.
+const BencodeView::node_type*
+BencodeView::find_key(string_type key) const {
+  check_throw('d');
+
+  const node_type* found = nullptr;
+
+  for (auto node = m_node + 1, last = m_node + m_node->size; node != last; ) {
+    auto value = node + 1;
+
+    if (string_type(m_data + node->offset, node->length) == key)
+      found = value;
+
+    node = value + value->size;
+  }
+
+  return found;
+}
+
+bool
+BencodeView::has_key(string_type key) const {
+  return find_key(key) != nullptr;
+}
+
+bool
+BencodeView::has_key_value(string_type key) const {
+  auto node = find_key(key);
+  return node != nullptr && node->type == 'i';
+}
+
+bool
+BencodeView::has_key_string(string_type key) const {
+  auto node = find_key(key);
+  return node != nullptr && node->type == 's';
+}
+
+bool
+BencodeView::has_key_list(string_type key) const {
+  auto node = find_key(key);
+  return node != nullptr && node->type == 'l';
+}
+
+bool
+BencodeView::has_key_map(string_type key) const {
+  auto node = find_key(key);
+  return node != nullptr && node->type == 'd';
+}
+
+BencodeView
+BencodeView::get_key(string_type key) const {
+  auto node = find_key(key);
+
+  if (node == nullptr)
+    throw bencode_error("BencodeView operator [" + std::string(key) + "] could not find element");
+
+  return BencodeView(node, m_data);
+}
+
+BencodeView::list_type
+BencodeView::get_key_list(string_type key) const {
+  return get_key(key).as_list();
+}
+
+BencodeView::map_type
+BencodeView::get_key_map(string_type key) const {
+  return get_key(key).as_map();
+}
+
+void
+BencodeView::to_object(Object* object) const {
+  if (m_node == nullptr) {
+    object->clear();
+    return;
+  }
+
+  switch (m_node->type) {
+  case 'i':
+    *object = Object(m_node->value);
+    return;
+
+  case 's':
+    *object = Object::create_string();
+    object->as_string().assign(m_data + m_node->offset, m_node->length);
+    return;
+
+  case 'l': {
+    *object = Object::create_list();
+
+    auto& list = object->as_list();
+    list.reserve(m_node->count);
+
+    for (const auto& view : as_list())
+      view.to_object(&list.emplace_back());
+
+    break;
+  }
+
+  default: {
+    *object = Object::create_map();
+
+    auto& map = object->as_map();
+
+    for (const auto& entry : as_map())
+      entry.second.to_object(&map[std::string(entry.first)]);
+
+    break;
+  }
+  }
+
+  object->set_internal_flags(m_node->flags & Object::flag_unordered);
+}
+
+void
+BencodeIndex::push_node(char type, const char* first, uint32_t length) {
+  auto& node = m_nodes.emplace_back();
+
+  node.offset = std::distance(m_data, first);
+  node.length = length;
+  node.size = 1;
+  node.count = 0;
+  node.value = 0;
+  node.type = type;
+  node.flags = 0;
+}
+
+// Pushes the string starting with its length prefix at 'first',
+// returning the position after it.
+const char*
+BencodeIndex::push_string(const char* first, const char* last) {
+  raw_string str = object_read_bencode_c_string(first, last);
+
+  push_node('s', str.data(), str.size());
+
+  auto& node = m_nodes.back();
+  node.value = std::distance(first, str.data());
+
+  if (*first == '0' && node.value > 2)
+    node.flags |= BencodeView::flag_non_canonical;
+
+  return str.end();
+}
+
+// Returns true if the root element is complete.
+bool
+BencodeIndex::finish_element(uint32_t flags) {
+  if (m_stack.empty())
+    return true;
+
+  auto& parent = m_nodes[m_stack.back().index];
+
+  parent.count++;
+  parent.flags |= flags & (Object::flag_unordered | BencodeView::flag_non_canonical);
+
+  return false;
+}
+
+// Iterative so that deeply nested data only grows 'm_stack', which
+// like 'm_nodes' keeps its capacity between calls.
+const char*
+BencodeIndex::parse(const char* first, const char* last) {
+  clear();
+  m_stack.clear();
+
+  if (static_cast<size_t>(std::distance(first, last)) >= std::numeric_limits<uint32_t>::max())
+    throw bencode_error("Bencode data too large.");
+
+  m_data = first;
+
+  try {
+    const char* itr = first;
+
+    while (true) {
+      if (itr == last)
+        throw bencode_error("Invalid bencode data.");
+
+      if (!m_stack.empty()) {
+        auto& open = m_stack.back();
+
+        if (*itr == 'e') {
+          auto& node = m_nodes[open.index];
+
+          node.length = std::distance(m_data + node.offset, ++itr);
+          node.size = m_nodes.size() - open.index;
+
+          m_stack.pop_back();
+
+          if (finish_element(node.flags))
+            return itr;
+
+          continue;
+        }
+
+        if (m_nodes[open.index].type == 'd') {
+          itr = push_string(itr, last);
+
+          auto& key = m_nodes.back();
+          std::string_view key_view(m_data + key.offset, key.length);
+
+          // As with Object, the first key is not compared so a single
+          // zero length key is ordered.
+          if (m_nodes[open.index].count != 0 && key_view <= open.prev_key)
+            m_nodes[open.index].flags |= Object::flag_unordered;
+
+          m_nodes[open.index].flags |= key.flags;
+          open.prev_key = key_view;
+
+          if (itr == last)
+            throw bencode_error("Invalid bencode data.");
+        }
+      }
+
+      switch (*itr) {
+      case 'i': {
+        const char* value_first = itr++;
+        bool        neg = false;
+
+        if (itr != last && *itr == '-') {
+          // Don't allow '-0', or '-' followed by non-numeral.
+          if (++itr == last || *itr <= '0' || *itr > '9')
+            throw bencode_error("Invalid bencode data.");
+
+          neg = true;
+        }
+
+        const char* digits_first = itr;
+        int64_t     value = 0;
+
+        while (itr != last && *itr >= '0' && *itr <= '9') {
+          int64_t digit = *itr++ - '0';
+
+          if (value > (std::numeric_limits<int64_t>::max() - digit) / 10)
+            throw bencode_error("Invalid bencode data.");
+
+          value = value * 10 + digit;
+        }
+
+        uint32_t flags = 0;
+
+        if (itr == digits_first || (*digits_first == '0' && itr - digits_first > 1))
+          flags |= BencodeView::flag_non_canonical;
+
+        if (itr == last || *itr++ != 'e')
+          throw bencode_error("Invalid bencode data.");
+
+        push_node('i', value_first, std::distance(value_first, itr));
+        m_nodes.back().value = neg ? -value : value;
+        m_nodes.back().flags = flags;
+
+        if (finish_element(flags))
+          return itr;
+
+        break;
+      }
+
+      case 'l':
+      case 'd':
+        if (m_stack.size() + 1 >= max_depth)
+          throw bencode_error("Invalid bencode data.");
+
+        m_stack.push_back(open_type{static_cast<uint32_t>(m_nodes.size()), std::string_view()});
+        push_node(*itr, itr, 0);
+
+        itr++;
+        break;
+
+      default: {
+        if (*itr < '0' || *itr > '9')
+          throw bencode_error("Invalid bencode data.");
+
+        itr = push_string(itr, last);
+
+        if (finish_element(m_nodes.back().flags))
+          return itr;
+
+        break;
+      }
+      }
+    }
+
+  } catch (const bencode_error&) {
+    clear();
+    throw;
+  }
+}
+
+} // namespace torrent
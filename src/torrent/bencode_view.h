@@ -0,0 +1,256 @@
+#ifndef LIBTORRENT_BENCODE_VIEW_H
+#define LIBTORRENT_BENCODE_VIEW_H
+
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <torrent/common.h>
+#include <torrent/object.h>
+#include <torrent/object_raw_bencode.h>
+
+namespace torrent {
+
+// Read-only access to bencoded data without copying it into an
+// Object tree.
+//
+// BencodeIndex parses a buffer in a single pass and records every
+// element as a node in a flat array, ordered depth first, holding the
+// offset and length of the element in the buffer. The buffer must
+// outlive the index, and the index must outlive any views into it.
+// Reusing an index for multiple buffers keeps the array's capacity, so
+// loading many files does not allocate once it has grown.
+//
+// BencodeView mirrors the read accessors of Object so that code can be
+// written for either, except that strings are returned as string views
+// into the buffer and lists and maps as ranges.
+
+class LIBTORRENT_EXPORT BencodeView {
+public:
+  using value_type  = int64_t;
+  using string_type = std::string_view;
+
+  class list_type;
+  class map_type;
+
+  // Set when the element contains integers or string lengths with
+  // leading zeros, or empty integers, which 'object_read_bencode_c'
+  // accepts but re-encoding an Object does not reproduce.
+  static constexpr uint32_t flag_non_canonical = 0x200;
+
+  BencodeView() = default;
+
+  bool                is_empty() const    { return m_node == nullptr; }
+  bool                is_value() const    { return m_node != nullptr && m_node->type == 'i'; }
+  bool                is_string() const   { return m_node != nullptr && m_node->type == 's'; }
+  bool                is_list() const     { return m_node != nullptr && m_node->type == 'l'; }
+  bool                is_map() const      { return m_node != nullptr && m_node->type == 'd'; }
+
+  // Only Object::flag_unordered and flag_non_canonical are set,
+  // inherited from nested elements the same way as when reading into
+  // an Object.
+  uint32_t            flags() const       { return m_node != nullptr ? m_node->flags : 0; }
+
+  value_type          as_value() const;
+  string_type         as_string() const;
+  list_type           as_list() const;
+  map_type            as_map() const;
+
+  // The bencoded element, e.g. for hashing the info dictionary.
+  raw_bencode         as_raw_bencode() const;
+
+  bool                has_key(string_type key) const;
+  bool                has_key_value(string_type key) const;
+  bool                has_key_string(string_type key) const;
+  bool                has_key_list(string_type key) const;
+  bool                has_key_map(string_type key) const;
+
+  BencodeView         get_key(string_type key) const;
+  value_type          get_key_value(string_type key) const  { return get_key(key).as_value(); }
+  string_type         get_key_string(string_type key) const { return get_key(key).as_string(); }
+  list_type           get_key_list(string_type key) const;
+  map_type            get_key_map(string_type key) const;
+
+  // Builds the Object in place, as Object copies drop the unordered
+  // flag and are deep.
+  void                to_object(Object* object) const;
+
+private:
+  friend class BencodeIndex;
+
+  // Strings hold the offset and length of the string data, with the
+  // length of the prefix in 'value', other types those of the whole
+  // element. The node count includes the node itself, so the next
+  // sibling is 'size' nodes ahead. Maps hold their entries as key and
+  // value node pairs.
+  struct node_type {
+    uint32_t          offset;
+    uint32_t          length;
+    uint32_t          size;
+    uint32_t          count;
+    value_type        value;
+    char              type;
+    uint32_t          flags;
+  };
+
+  BencodeView(const node_type* node, const char* data) : m_node(node), m_data(data) {}
+
+  void                check_throw(char type) const;
+  const node_type*    find_key(string_type key) const;
+
+  BencodeView         first_child() const    { return BencodeView(m_node + 1, m_data); }
+  BencodeView         next_sibling() const   { return BencodeView(m_node + m_node->size, m_data); }
+
+  const node_type*    m_node{nullptr};
+  const char*         m_data{nullptr};
+};
+
+class BencodeView::list_type {
+public:
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = BencodeView;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const BencodeView*;
+    using reference         = const BencodeView&;
+
+    const_iterator() = default;
+    explicit const_iterator(BencodeView view) : m_view(view) {}
+
+    reference         operator * () const { return m_view; }
+    pointer           operator -> () const { return &m_view; }
+
+    const_iterator&   operator ++ ()    { m_view = m_view.next_sibling(); return *this; }
+    const_iterator    operator ++ (int) { auto tmp = *this; ++*this; return tmp; }
+
+    bool operator == (const const_iterator& rhs) const { return m_view.m_node == rhs.m_view.m_node; }
+    bool operator != (const const_iterator& rhs) const { return m_view.m_node != rhs.m_view.m_node; }
+
+  private:
+    BencodeView       m_view;
+  };
+
+  using iterator  = const_iterator;
+  using size_type = uint32_t;
+
+  bool                empty() const { return m_view.m_node->count == 0; }
+  size_type           size() const  { return m_view.m_node->count; }
+
+  const_iterator      begin() const { return const_iterator(m_view.first_child()); }
+  const_iterator      end() const   { return const_iterator(m_view.next_sibling()); }
+
+private:
+  friend class BencodeView;
+
+  explicit list_type(BencodeView view) : m_view(view) {}
+
+  BencodeView         m_view;
+};
+
+class BencodeView::map_type {
+public:
+  using value_type = std::pair<string_type, BencodeView>;
+
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = map_type::value_type;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const value_type*;
+    using reference         = const value_type&;
+
+    const_iterator() = default;
+    explicit const_iterator(BencodeView key, BencodeView end) { set(key, end); }
+
+    reference         operator * () const  { return m_entry; }
+    pointer           operator -> () const { return &m_entry; }
+
+    const_iterator&   operator ++ ()    { set(m_entry.second.next_sibling(), m_end); return *this; }
+    const_iterator    operator ++ (int) { auto tmp = *this; ++*this; return tmp; }
+
+    bool operator == (const const_iterator& rhs) const { return m_key.m_node == rhs.m_key.m_node; }
+    bool operator != (const const_iterator& rhs) const { return m_key.m_node != rhs.m_key.m_node; }
+
+  private:
+    void              set(BencodeView key, BencodeView end);
+
+    BencodeView       m_key;
+    BencodeView       m_end;
+    value_type        m_entry;
+  };
+
+  using iterator  = const_iterator;
+  using size_type = uint32_t;
+
+  bool                empty() const { return m_view.m_node->count == 0; }
+  size_type           size() const  { return m_view.m_node->count; }
+
+  const_iterator      begin() const { return const_iterator(m_view.first_child(), m_view.next_sibling()); }
+  const_iterator      end() const   { return const_iterator(m_view.next_sibling(), m_view.next_sibling()); }
+
+private:
+  friend class BencodeView;
+
+  explicit map_type(BencodeView view) : m_view(view) {}
+
+  BencodeView         m_view;
+};
+
+class LIBTORRENT_EXPORT BencodeIndex {
+public:
+  // Limits nesting the same way as 'object_read_bencode_c'.
+  static constexpr uint32_t max_depth = 1024;
+
+  BencodeIndex() = default;
+  BencodeIndex(const char* first, const char* last) { parse(first, last); }
+
+  // Indexes the first bencoded element in the buffer and returns the
+  // position after it. Throws bencode_error on invalid data, leaving
+  // the index empty.
+  const char*         parse(const char* first, const char* last);
+  void                clear()                 { m_nodes.clear(); m_data = nullptr; }
+
+  bool                empty() const           { return m_nodes.empty(); }
+  size_t              size() const            { return m_nodes.size(); }
+
+  BencodeView         root() const;
+
+private:
+  using node_type = BencodeView::node_type;
+
+  struct open_type {
+    uint32_t          index;
+    std::string_view  prev_key;
+  };
+
+  void                push_node(char type, const char* first, uint32_t length);
+  const char*         push_string(const char* first, const char* last);
+  bool                finish_element(uint32_t flags);
+
+  std::vector<node_type> m_nodes;
+  std::vector<open_type> m_stack;
+  const char*            m_data{nullptr};
+};
+
+inline void
+BencodeView::map_type::const_iterator::set(BencodeView key, BencodeView end) {
+  m_key = key;
+  m_end = end;
+
+  if (key.m_node != end.m_node)
+    m_entry = value_type(string_type(key.m_data + key.m_node->offset, key.m_node->length), key.next_sibling());
+}
+
+inline BencodeView
+BencodeIndex::root() const {
+  if (m_nodes.empty())
+    return BencodeView();
+
+  return BencodeView(m_nodes.data(), m_data);
+}
+
+} // namespace torrent
+
+#endif
@@ -5,7 +5,7 @@
 #include <algorithm>
 
 #include "exceptions.h"
-#include "rak/algorithm.h"
+#include "utils/bitfield_ops.h"
 #include "utils/instrumentation.h"
 
 namespace torrent {
@@ -51,19 +51,7 @@ Bitfield::update() {
   // Clears the unused bits.
   clear_tail();
 
-  m_set = 0;
-
-  iterator itr = m_data.get();
-  iterator last = end();
-
-  while (itr + sizeof(unsigned int) <= last) {
-    m_set += rak::popcount_wrapper(*reinterpret_cast<unsigned int*>(itr));
-    itr += sizeof(unsigned int);
-  }
-
-  while (itr != last) {
-    m_set += rak::popcount_wrapper(*itr++);
-  }
+  m_set = bitfield_popcount(m_data.get(), size_bytes());
 }
 
 void
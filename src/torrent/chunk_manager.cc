@@ -6,6 +6,7 @@
 #include <sys/resource.h>
 
 #include "data/chunk_list.h"
+#include "data/storage_backend.h"
 #include "torrent/exceptions.h"
 #include "utils/instrumentation.h"
 
@@ -18,6 +19,26 @@ ChunkManager::~ChunkManager() {
   assert(m_memoryBlockCount == 0 && "ChunkManager::~ChunkManager() m_memoryBlockCount != 0.");
 }
 
+void
+ChunkManager::set_storage_backend(uint32_t backend) {
+  if (backend != storage_backend_mmap && backend != storage_backend_pread)
+    throw input_error("Invalid storage backend.");
+
+  m_storageBackend = backend;
+}
+
+uint64_t
+ChunkManager::storage_buffer_pool_size() const {
+  auto backend = static_cast<StorageBackendPread*>(StorageBackend::from_type(storage_backend_pread));
+  return backend->max_pooled();
+}
+
+void
+ChunkManager::set_storage_buffer_pool_size(uint64_t bytes) {
+  auto backend = static_cast<StorageBackendPread*>(StorageBackend::from_type(storage_backend_pread));
+  backend->set_max_pooled(bytes);
+}
+
 uint64_t
 ChunkManager::sync_queue_memory_usage() const {
   uint64_t size = 0;
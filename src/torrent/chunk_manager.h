@@ -55,6 +55,13 @@ public:
   uint32_t            timeout_safe_sync() const                 { return m_timeoutSafeSync; }
   void                set_timeout_safe_sync(uint32_t seconds)   { m_timeoutSafeSync = seconds; }
 
+  // Blocking syncs are replaced by an async sync of the chunk followed
+  // by fdatasync of its files on the disk thread, so that large syncs
+  // don't stall the main thread. With the pread backend the buffers
+  // are also written back by the disk thread.
+  bool                sync_on_disk_thread() const               { return m_syncOnDiskThread; }
+  void                set_sync_on_disk_thread(bool state)       { m_syncOnDiskThread = state; }
+
   // Set to 0 to disable preloading.
   //
   // How the value is used is yet to be determined, but it won't be
@@ -72,6 +79,23 @@ public:
   void                set_preload_required_rate(uint32_t bytes) { m_preloadRequiredRate = bytes; }
 
 
+  // Selects how new chunks access the files, chunks already held keep
+  // using the backend they were created with.
+  //
+  // The pread backend copies data into pooled heap buffers and writes
+  // it back when synced, avoiding large numbers of mappings and SIGBUS
+  // when the disk is full.
+  static constexpr uint32_t storage_backend_mmap  = 0;
+  static constexpr uint32_t storage_backend_pread = 1;
+
+  uint32_t            storage_backend() const                   { return m_storageBackend; }
+  void                set_storage_backend(uint32_t backend);
+
+  // Upper limit on the memory kept in the pread backend's buffer pool
+  // for reuse.
+  uint64_t            storage_buffer_pool_size() const;
+  void                set_storage_buffer_pool_size(uint64_t bytes);
+
   void                insert(ChunkList* chunkList);
   void                erase(ChunkList* chunkList);
 
@@ -121,11 +145,14 @@ private:
   bool                m_safeSync{false};
   uint32_t            m_timeoutSync{600};
   uint32_t            m_timeoutSafeSync{900};
+  bool                m_syncOnDiskThread{false};
 
   uint32_t            m_preloadType{0};
   uint32_t            m_preloadMinSize{256 << 10};
   uint32_t            m_preloadRequiredRate{5 << 10};
 
+  uint32_t            m_storageBackend{storage_backend_mmap};
+
   uint32_t            m_statsPreloaded{0};
   uint32_t            m_statsNotPreloaded{0};
 
@@ -33,6 +33,7 @@ enum tracker_enum {
 // headers clean.
 class AddressList;
 class AvailableList;
+class BencodeView;
 class Bitfield;
 class Block;
 class BlockFailed;
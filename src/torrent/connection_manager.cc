@@ -121,4 +121,21 @@ ConnectionManager::set_listen_backlog(int v) {
   m_listen_backlog = v;
 }
 
+bool
+ConnectionManager::is_upload_sendfile_supported() {
+#ifdef USE_SENDFILE
+  return true;
+#else
+  return false;
+#endif
+}
+
+void
+ConnectionManager::set_upload_sendfile(bool v) {
+  if (v && !is_upload_sendfile_supported())
+    throw input_error("sendfile is not supported on this platform");
+
+  m_upload_sendfile = v;
+}
+
 } // namespace torrent
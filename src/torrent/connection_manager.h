@@ -131,6 +131,15 @@ public:
   void                set_block_ipv4in6(bool v) { m_block_ipv4in6 = v; }
   void                set_prefer_ipv6(bool v)  { m_prefer_ipv6 = v; }
 
+  // Send unencrypted piece data with sendfile straight from the file
+  // rather than copying it from the mapped chunk. Parts backed by heap
+  // buffers always use the copying path, as the file might not yet
+  // contain their data.
+  static bool         is_upload_sendfile_supported();
+
+  bool                is_upload_sendfile() const { return m_upload_sendfile; }
+  void                set_upload_sendfile(bool v);
+
 private:
   size_type           m_size{0};
   size_type           m_maxSize{0};
@@ -155,6 +164,7 @@ private:
   bool                m_block_ipv6{false};
   bool                m_block_ipv4in6{false};
   bool                m_prefer_ipv6{false};
+  bool                m_upload_sendfile{false};
 };
 
 } // namespace torrent
@@ -73,8 +73,10 @@ File::prepare(bool hashing, int prot, int flags) {
   // set. If so don't quit as we need to try re-sizing, instead call
   // resize_file.
 
-  if (is_open() && has_permissions(prot))
+  if (is_open() && has_permissions(prot)) {
+    manager->file_manager()->touch(this);
     return true;
+  }
 
   // For now don't allow overridding this check in prepare.
   if (m_flags & flag_create_queued)
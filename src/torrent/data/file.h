@@ -9,6 +9,7 @@ namespace torrent {
 class LIBTORRENT_EXPORT File {
 public:
   friend class FileList;
+  friend class FileManager;
 
   using range_type = std::pair<uint32_t, uint32_t>;
 
@@ -82,6 +83,10 @@ public:
   uint64_t            last_touched() const                     { return m_last_touched; }
   void                set_last_touched(uint64_t t)             { m_last_touched = t; }
 
+  // Pinned files hold chunk parts and are not evicted by FileManager
+  // unless no other file is open.
+  bool                is_pinned() const                        { return m_pinned != 0; }
+
 protected:
   void                set_flags_protected(int flags)           { m_flags |= flags; }
   void                unset_flags_protected(int flags)         { m_flags &= ~flags; }
@@ -117,6 +122,12 @@ private:
   uint64_t            m_size{0};
   uint64_t            m_last_touched{0};
 
+  // Used by FileManager.
+  File*               m_lru_prev{nullptr};
+  File*               m_lru_next{nullptr};
+  uint32_t            m_open_index{0};
+  uint32_t            m_pinned{0};
+
   range_type          m_range;
 
   uint32_t            m_completed{0};
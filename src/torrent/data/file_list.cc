@@ -17,6 +17,8 @@
 #include "data/chunk.h"
 #include "data/memory_chunk.h"
 #include "data/socket_file.h"
+#include "data/storage_backend.h"
+#include "torrent/chunk_manager.h"
 #include "torrent/exceptions.h"
 #include "torrent/path.h"
 #include "torrent/data/file.h"
@@ -562,7 +564,8 @@ FileList::create_chunk_part(FileList::iterator itr, uint64_t offset, uint32_t le
   if (!(*itr)->prepare(hashing, prot, 0))
     return MemoryChunk();
 
-  auto mc = SocketFile((*itr)->file_descriptor()).create_chunk(offset, length, prot, MemoryChunk::map_shared);
+  auto backend = StorageBackend::from_type(manager->chunk_manager()->storage_backend());
+  auto mc = backend->create_chunk((*itr)->file_descriptor(), offset, length, prot);
 
   if (!mc.is_valid())
     return MemoryChunk();
@@ -574,6 +577,9 @@ FileList::create_chunk_part(FileList::iterator itr, uint64_t offset, uint32_t le
     throw internal_error("FileList::create_chunk(...) mc.size() > length.", data()->hash());
 
 #ifdef USE_MADVISE
+  if (backend->mapped() != ChunkPart::MAPPED_MMAP)
+    return mc;
+
   // TODO: Update all uses of madvise to posix_madvise.
   if (hashing) {
     if (manager->file_manager()->advise_random_hashing())
@@ -610,7 +616,10 @@ FileList::create_chunk(uint64_t offset, uint32_t length, bool hashing, int prot)
     if (!mc.is_valid())
       return nullptr;
 
-    chunk->push_back(ChunkPart::MAPPED_MMAP, mc);
+    if ((*itr)->is_padding())
+      chunk->push_back(ChunkPart::MAPPED_MMAP, mc);
+    else
+      chunk->push_back(StorageBackend::from_type(manager->chunk_manager()->storage_backend())->mapped(), mc);
     chunk->back().set_file(itr->get(), offset - (*itr)->offset());
 
     offset += mc.size();
@@ -2,10 +2,8 @@
 
 #include "file_manager.h"
 
-#include <algorithm>
 #include <cassert>
 #include <fcntl.h>
-#include <limits>
 
 #include "manager.h"
 #include "data/socket_file.h"
@@ -43,6 +41,8 @@ FileManager::open(value_type file, [[maybe_unused]] bool hashing, int prot, int
   if (size() == m_max_open_files)
     close_least_active();
 
+  m_files_missed_counter++;
+
   SocketFile fd;
 
   if (!fd.open(file->frozen_path(), prot, flags)) {
@@ -63,9 +63,10 @@ FileManager::open(value_type file, [[maybe_unused]] bool hashing, int prot, int
   }
 #endif
 
+  file->m_open_index = size();
   base_type::push_back(file);
 
-  // Consider storing the position of the file here.
+  list_push_back(list_for(file), file);
 
   m_files_opened_counter++;
   return true;
@@ -84,31 +85,97 @@ FileManager::close(value_type file) {
   file->set_protection(0);
   file->set_file_descriptor(-1);
 
-  auto itr = std::find(begin(), end(), file);
-
-  if (itr == end())
-    throw internal_error("FileManager::close_file(...) itr == end().");
+  if (file->m_open_index >= size() || (*this)[file->m_open_index] != file)
+    throw internal_error("FileManager::close_file(...) file not found.");
 
-  *itr = back();
+  back()->m_open_index = file->m_open_index;
+  (*this)[file->m_open_index] = back();
   base_type::pop_back();
 
+  list_erase(list_for(file), file);
+
   m_files_closed_counter++;
 }
 
 void
-FileManager::close_least_active() {
-  File* least = nullptr;
-  uint64_t last = std::numeric_limits<int64_t>::max();
-
-  for (auto f : *this) {
-    if (f->is_open() && f->last_touched() <= last) {
-      last = f->last_touched();
-      least = f;
-    }
+FileManager::touch(value_type file) {
+  if (!file->is_open() || file->is_padding())
+    return;
+
+  auto& list = list_for(file);
+
+  if (list.last != file) {
+    list_erase(list, file);
+    list_push_back(list, file);
   }
 
-  if (least)
-    close(least);
+  m_files_hit_counter++;
+}
+
+void
+FileManager::pin(value_type file) {
+  if (file->m_pinned++ != 0 || !file->is_open() || file->is_padding())
+    return;
+
+  list_erase(m_unpinned, file);
+  list_push_back(m_pinned, file);
+}
+
+void
+FileManager::unpin(value_type file) {
+  if (file->m_pinned == 0)
+    throw internal_error("FileManager::unpin(...) file is not pinned.");
+
+  if (--file->m_pinned != 0 || !file->is_open() || file->is_padding())
+    return;
+
+  list_erase(m_pinned, file);
+  list_push_back(m_unpinned, file);
+}
+
+void
+FileManager::close_least_active() {
+  File* least = m_unpinned.first != nullptr ? m_unpinned.first : m_pinned.first;
+
+  if (least == nullptr)
+    return;
+
+  close(least);
+  m_files_evicted_counter++;
+}
+
+FileManager::file_list_type&
+FileManager::list_for(File* file) {
+  return file->is_pinned() ? m_pinned : m_unpinned;
+}
+
+void
+FileManager::list_push_back(file_list_type& list, File* file) {
+  file->m_lru_prev = list.last;
+  file->m_lru_next = nullptr;
+
+  if (list.last != nullptr)
+    list.last->m_lru_next = file;
+  else
+    list.first = file;
+
+  list.last = file;
+}
+
+void
+FileManager::list_erase(file_list_type& list, File* file) {
+  if (file->m_lru_prev != nullptr)
+    file->m_lru_prev->m_lru_next = file->m_lru_next;
+  else
+    list.first = file->m_lru_next;
+
+  if (file->m_lru_next != nullptr)
+    file->m_lru_next->m_lru_prev = file->m_lru_prev;
+  else
+    list.last = file->m_lru_prev;
+
+  file->m_lru_prev = nullptr;
+  file->m_lru_next = nullptr;
 }
 
 } // namespace torrent
@@ -8,6 +8,12 @@ namespace torrent {
 
 class File;
 
+// Open files are kept in two intrusive lists ordered from least to
+// most recently touched, one for files pinned by chunk parts and one
+// for the rest, so touching, closing and picking the file to evict are
+// all constant time. Pinned files are only evicted when every open
+// file is pinned.
+
 class LIBTORRENT_EXPORT FileManager : private std::vector<File*> {
 public:
   using base_type = std::vector<File*>;
@@ -39,19 +45,45 @@ public:
   bool                open(value_type file, bool hashing, int prot, int flags);
   void                close(value_type file);
 
+  // Marks an open file as the most recently used.
+  void                touch(value_type file);
+
+  // Pinned by chunk parts using the file, counted.
+  void                pin(value_type file);
+  void                unpin(value_type file);
+
   // TODO: Close all files held by a download after hashing. Also flush all memory chunks.
 
   void                close_least_active();
 
   // Statistics:
-  uint64_t            files_opened_counter() const { return m_files_opened_counter; }
-  uint64_t            files_closed_counter() const { return m_files_closed_counter; }
-  uint64_t            files_failed_counter() const { return m_files_failed_counter; }
+  uint64_t            files_opened_counter() const  { return m_files_opened_counter; }
+  uint64_t            files_closed_counter() const  { return m_files_closed_counter; }
+  uint64_t            files_failed_counter() const  { return m_files_failed_counter; }
+
+  // Hits are files found open when prepared, misses those that needed
+  // opening, and evictions those closed to stay under the limit.
+  uint64_t            files_hit_counter() const     { return m_files_hit_counter; }
+  uint64_t            files_missed_counter() const  { return m_files_missed_counter; }
+  uint64_t            files_evicted_counter() const { return m_files_evicted_counter; }
 
 private:
   FileManager(const FileManager&) = delete;
   FileManager& operator=(const FileManager&) = delete;
 
+  struct file_list_type {
+    File*             first{nullptr};
+    File*             last{nullptr};
+  };
+
+  file_list_type&     list_for(File* file);
+
+  static void         list_push_back(file_list_type& list, File* file);
+  static void         list_erase(file_list_type& list, File* file);
+
+  file_list_type      m_unpinned;
+  file_list_type      m_pinned;
+
   size_type           m_max_open_files{0};
   bool                m_advise_random{false};
   bool                m_advise_random_hashing{false};
@@ -59,6 +91,9 @@ private:
   uint64_t            m_files_opened_counter{0};
   uint64_t            m_files_closed_counter{0};
   uint64_t            m_files_failed_counter{0};
+  uint64_t            m_files_hit_counter{0};
+  uint64_t            m_files_missed_counter{0};
+  uint64_t            m_files_evicted_counter{0};
 };
 
 } // namespace torrent
@@ -6,6 +6,7 @@
 #include <cassert>
 #include <functional>
 #include <set>
+#include <utility>
 
 #include "data/chunk.h"
 #include "peer/peer_info.h"
@@ -19,17 +20,22 @@
 namespace torrent {
 
 TransferList::~TransferList() {
-  assert(base_type::empty() && "TransferList::~TransferList() called on an non-empty object");
+  assert(empty() && "TransferList::~TransferList() called on an non-empty object");
 }
 
 TransferList::iterator
 TransferList::find(uint32_t index) {
-  return std::find_if(begin(), end(), [index](BlockList* b) { return index == b->index(); });
+  return std::as_const(*this).find(index);
 }
 
 TransferList::const_iterator
 TransferList::find(uint32_t index) const {
-  return std::find_if(begin(), end(), [index](BlockList* b) { return index == b->index(); });
+  auto itr = m_positions.find(index);
+
+  if (itr == m_positions.end())
+    return end();
+
+  return const_iterator(m_slots.data(), m_slots.data() + itr->second, m_slots.data() + m_slots.size());
 }
 
 void
@@ -41,31 +47,65 @@ TransferList::clear() {
     delete block_list;
   }
 
-  base_type::clear();
+  m_slots.clear();
+  m_size = 0;
+  m_positions.clear();
 }
 
 TransferList::iterator
 TransferList::insert(const Piece& piece, uint32_t blockSize) {
-  if (find(piece.index()) != end())
+  if (!m_positions.emplace(piece.index(), m_slots.size()).second)
     throw internal_error("Delegator::new_chunk(...) received an index that is already delegated.");
 
   auto blockList = new BlockList(piece, blockSize);
 
   m_slot_queued(piece.index());
 
-  return base_type::insert(end(), blockList);
+  m_slots.push_back(blockList);
+  m_size++;
+
+  return const_iterator(m_slots.data(), m_slots.data() + m_slots.size() - 1, m_slots.data() + m_slots.size());
 }
 
 // TODO: Create a destructor to ensure all blocklists have been cleared/invaldiated?
 
+// Compacting moves the slots, so the returned iterator is looked up by
+// the chunk index of the following block list.
 TransferList::iterator
 TransferList::erase(iterator itr) {
   if (itr == end())
     throw internal_error("TransferList::erase(...) itr == m_chunks.end().");
 
-  delete *itr;
+  auto position = m_positions.find((*itr)->index());
+
+  if (position == m_positions.end() || m_slots[position->second] != *itr)
+    throw internal_error("TransferList::erase(...) block list not found.");
+
+  auto next = std::next(itr);
+  auto has_next = next != end();
+  auto next_index = has_next ? (*next)->index() : 0;
+
+  delete m_slots[position->second];
+  m_slots[position->second] = nullptr;
+
+  m_positions.erase(position);
+  m_size--;
+
+  while (!m_slots.empty() && m_slots.back() == nullptr)
+    m_slots.pop_back();
+
+  if (m_slots.size() - m_size > m_size)
+    compact();
+
+  return has_next ? find(next_index) : end();
+}
+
+void
+TransferList::compact() {
+  m_slots.erase(std::remove(m_slots.begin(), m_slots.end(), nullptr), m_slots.end());
 
-  return base_type::erase(itr);
+  for (size_type i = 0; i < m_slots.size(); i++)
+    m_positions[m_slots[i]->index()] = i;
 }
 
 void
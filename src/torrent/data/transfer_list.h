@@ -2,37 +2,48 @@
 #define LIBTORRENT_TRANSFER_LIST_H
 
 #include <functional>
+#include <iterator>
+#include <unordered_map>
 #include <vector>
 #include <torrent/common.h>
 
 namespace torrent {
 
-class LIBTORRENT_EXPORT TransferList : public std::vector<BlockList*> {
+// BlockLists are kept in insertion order, with the slot of each chunk
+// index tracked so that find is O(1). Erasing leaves an empty slot that
+// iterators skip, and the slots are compacted once the empty ones
+// outnumber the block lists, so erase is amortized O(1). Only modify
+// the list through insert, erase and clear.
+
+class LIBTORRENT_EXPORT TransferList {
 public:
-  using base_type           = std::vector<BlockList*>;
+  using slot_list           = std::vector<BlockList*>;
   using completed_list_type = std::vector<std::pair<int64_t, uint32_t>>;
 
-  using base_type::value_type;
-  using base_type::reference;
-  using base_type::difference_type;
+  using value_type      = BlockList*;
+  using reference       = BlockList* const&;
+  using difference_type = std::ptrdiff_t;
+  using size_type       = slot_list::size_type;
 
-  using base_type::iterator;
-  using base_type::const_iterator;
-  using base_type::reverse_iterator;
-  using base_type::const_reverse_iterator;
-  using base_type::size;
-  using base_type::empty;
+  class const_iterator;
 
-  using base_type::begin;
-  using base_type::end;
-  using base_type::rbegin;
-  using base_type::rend;
+  using iterator               = const_iterator;
+  using reverse_iterator       = std::reverse_iterator<const_iterator>;
+  using const_reverse_iterator = reverse_iterator;
 
   TransferList() = default;
   ~TransferList();
   TransferList(const TransferList&) = delete;
   TransferList& operator=(const TransferList&) = delete;
 
+  size_type           size() const  { return m_size; }
+  bool                empty() const { return m_size == 0; }
+
+  const_iterator      begin() const;
+  const_iterator      end() const;
+  reverse_iterator    rbegin() const;
+  reverse_iterator    rend() const;
+
   iterator            find(uint32_t index);
   const_iterator      find(uint32_t index) const;
 
@@ -69,17 +80,70 @@ private:
 
   void                retry_most_popular(BlockList* blockList, Chunk* chunk);
 
+  void                compact();
+
   slot_chunk_index    m_slot_canceled;
   slot_chunk_index    m_slot_completed;
   slot_chunk_index    m_slot_queued;
   slot_peer_info      m_slot_corrupt;
 
+  slot_list           m_slots;
+  size_type           m_size{0};
+
+  std::unordered_map<uint32_t, size_type> m_positions;
+
   completed_list_type m_completedList;
 
   uint32_t            m_succeededCount{0};
   uint32_t            m_failedCount{0};
 };
 
+class TransferList::const_iterator {
+public:
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type        = TransferList::value_type;
+  using difference_type   = TransferList::difference_type;
+  using pointer           = BlockList* const*;
+  using reference         = TransferList::reference;
+
+  const_iterator() = default;
+
+  reference           operator * () const  { return *m_slot; }
+  pointer             operator -> () const { return m_slot; }
+
+  const_iterator&     operator ++ ()    { ++m_slot; skip_empty(); return *this; }
+  const_iterator      operator ++ (int) { auto tmp = *this; ++*this; return tmp; }
+  const_iterator&     operator -- ()    { do --m_slot; while (m_slot != m_first && *m_slot == nullptr); return *this; }
+  const_iterator      operator -- (int) { auto tmp = *this; --*this; return tmp; }
+
+  bool operator == (const const_iterator& rhs) const { return m_slot == rhs.m_slot; }
+  bool operator != (const const_iterator& rhs) const { return m_slot != rhs.m_slot; }
+
+private:
+  friend class TransferList;
+
+  const_iterator(pointer first, pointer slot, pointer last) : m_first(first), m_slot(slot), m_last(last) { skip_empty(); }
+
+  void                skip_empty() { while (m_slot != m_last && *m_slot == nullptr) ++m_slot; }
+
+  pointer             m_first{};
+  pointer             m_slot{};
+  pointer             m_last{};
+};
+
+inline TransferList::const_iterator
+TransferList::begin() const {
+  return const_iterator(m_slots.data(), m_slots.data(), m_slots.data() + m_slots.size());
+}
+
+inline TransferList::const_iterator
+TransferList::end() const {
+  return const_iterator(m_slots.data(), m_slots.data() + m_slots.size(), m_slots.data() + m_slots.size());
+}
+
+inline TransferList::reverse_iterator TransferList::rbegin() const { return reverse_iterator(end()); }
+inline TransferList::reverse_iterator TransferList::rend() const   { return reverse_iterator(begin()); }
+
 } // namespace torrent
 
 #endif
@@ -82,6 +82,8 @@ public:
 
   uint32_t            chunks_hashed() const;
 
+  // The number of peers seen with each chunk, saturated at 255. Valid
+  // until the download is closed.
   const uint8_t*      chunks_seen() const;
 
   // Set the number of finished chunks for closed torrents.
@@ -36,6 +36,9 @@
 
 #include "config.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "torrent/download_info.h"
 #include "torrent/exceptions.h"
 
@@ -44,11 +47,23 @@
 
 namespace torrent {
 
+size_t
+DownloadManager::hash_string_hash::operator () (const HashString& hash) const {
+  size_t result;
+  std::memcpy(&result, hash.data(), sizeof(size_t));
+  return result;
+}
+
 DownloadManager::iterator
 DownloadManager::insert(DownloadWrapper* d) {
-  if (find(d->info()->hash()) != end())
+  if (!m_hash_index.emplace(d->info()->hash(), d).second)
     throw internal_error("Could not add torrent as it already exists.");
 
+  if (!m_obfuscated_index.emplace(d->info()->hash_obfuscated(), d).second) {
+    m_hash_index.erase(d->info()->hash());
+    throw internal_error("Could not add torrent as its obfuscated hash already exists.");
+  }
+
   return base_type::insert(end(), d);
 }
 
@@ -58,13 +73,26 @@ DownloadManager::erase(DownloadWrapper* d) {
 
   if (itr == end())
     throw internal_error("Tried to remove a torrent that doesn't exist");
-    
+
+  auto hash_itr = m_hash_index.find(d->info()->hash());
+  auto obfuscated_itr = m_obfuscated_index.find(d->info()->hash_obfuscated());
+
+  if (hash_itr == m_hash_index.end() || hash_itr->second != d ||
+      obfuscated_itr == m_obfuscated_index.end() || obfuscated_itr->second != d)
+    throw internal_error("Tried to remove a torrent whose hash changed after it was added.");
+
+  m_hash_index.erase(hash_itr);
+  m_obfuscated_index.erase(obfuscated_itr);
+
   delete *itr;
   return base_type::erase(itr);
 }
 
 void
 DownloadManager::clear() {
+  m_hash_index.clear();
+  m_obfuscated_index.clear();
+
   while (!empty()) {
     delete base_type::back();
     base_type::pop_back();
@@ -78,12 +106,24 @@ DownloadManager::find(const std::string& hash) {
 
 DownloadManager::iterator
 DownloadManager::find(const HashString& hash) {
-  return std::find_if(begin(), end(), [hash](const auto& wrapper){ return hash == wrapper->info()->hash(); });
+  auto itr = m_hash_index.find(hash);
+
+  if (itr == m_hash_index.end())
+    return end();
+
+  return std::find(begin(), end(), itr->second);
 }
 
+// Hashes can't change while inserted, so a different download at the
+// hash means this one is not inserted.
 DownloadManager::iterator
 DownloadManager::find(DownloadInfo* info) {
-  return std::find_if(begin(), end(), [info](const auto& wrapper){ return info == wrapper->info(); });
+  auto itr = find(info->hash());
+
+  if (itr == end() || (*itr)->info() != info)
+    return end();
+
+  return itr;
 }
 
 DownloadManager::iterator
@@ -93,24 +133,22 @@ DownloadManager::find_chunk_list(ChunkList* cl) {
 
 DownloadMain*
 DownloadManager::find_main(const char* hash) {
-  auto hash_str = *HashString::cast_from(hash);
-  auto itr = std::find_if(begin(), end(), [hash_str](const auto& wrapper){ return hash_str == wrapper->info()->hash(); });
+  auto itr = m_hash_index.find(*HashString::cast_from(hash));
 
-  if (itr == end())
+  if (itr == m_hash_index.end())
     return NULL;
   else
-    return (*itr)->main();
+    return itr->second->main();
 }
 
 DownloadMain*
 DownloadManager::find_main_obfuscated(const char* hash) {
-  auto hash_str = *HashString::cast_from(hash);
-  auto itr = std::find_if(begin(), end(), [hash_str](const auto& wrapper){ return hash_str == wrapper->info()->hash_obfuscated(); });
+  auto itr = m_obfuscated_index.find(*HashString::cast_from(hash));
 
-  if (itr == end())
+  if (itr == m_obfuscated_index.end())
     return NULL;
   else
-    return (*itr)->main();
+    return itr->second->main();
 }
 
 } // namespace torrent
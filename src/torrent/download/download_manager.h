@@ -38,9 +38,11 @@
 #define LIBTORRENT_DOWNLOAD_MANAGER_H
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <torrent/common.h>
+#include <torrent/hash_string.h>
 
 namespace torrent {
 
@@ -49,6 +51,11 @@ class DownloadWrapper;
 class DownloadInfo;
 class DownloadMain;
 
+// The plain and obfuscated info hashes are indexed for handshake
+// lookups and 'find'. The index refers to the wrappers rather than
+// their position, so erasing does not renumber later downloads. Hashes
+// must not change while the download is inserted.
+
 class LIBTORRENT_EXPORT DownloadManager : private std::vector<DownloadWrapper*> {
 public:
   using base_type = std::vector<DownloadWrapper*>;
@@ -95,6 +102,18 @@ public:
   iterator            erase(DownloadWrapper* d) LIBTORRENT_NO_EXPORT;
 
   void                clear() LIBTORRENT_NO_EXPORT;
+
+private:
+  // Info hashes are uniformly distributed, so the leading bytes are
+  // used as is.
+  struct hash_string_hash {
+    size_t operator () (const HashString& hash) const;
+  };
+
+  using hash_index_type = std::unordered_map<HashString, DownloadWrapper*, hash_string_hash>;
+
+  hash_index_type     m_hash_index;
+  hash_index_type     m_obfuscated_index;
 };
 
 } // namespace torrent
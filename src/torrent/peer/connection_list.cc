@@ -69,6 +69,7 @@ ConnectionList::insert(PeerInfo* peerInfo, const SocketFd& fd, Bitfield* bitfiel
   }
 
   base_type::push_back(peerConnection);
+  m_download->ut_pex_insert(peerInfo);
 
   m_download->info()->change_flags(DownloadInfo::flag_accepting_new_peers, size() < m_maxSize);
 
@@ -97,6 +98,8 @@ ConnectionList::erase(iterator pos, int flags) {
   *pos = base_type::back();
   base_type::pop_back();
 
+  m_download->ut_pex_erase(peerConnection->mutable_peer_info());
+
   m_download->info()->change_flags(DownloadInfo::flag_accepting_new_peers, size() < m_maxSize);
 
   ::utils::slot_list_call(m_signalDisconnected, peerConnection);
@@ -65,6 +65,14 @@ Throttle::set_max_rate(uint64_t v) {
     m_ptr()->disable();
 }
 
+void
+Throttle::set_min_rate(uint64_t v) {
+  if (v > (UINT_MAX - 1))
+    throw input_error("Throttle rate must be between 0 and 4294967295.");
+
+  m_minRate = v;
+}
+
 const Rate*
 Throttle::rate() const {
   return m_throttleList->rate_slow();
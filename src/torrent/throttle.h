@@ -21,6 +21,12 @@ public:
   uint64_t            max_rate() const { return m_maxRate; }
   void                set_max_rate(uint64_t v);
 
+  // Rate a slave is guaranteed from its parent before the rest is
+  // shared fairly between the parent's slaves, 0 for none. Ignored on
+  // the root throttle.
+  uint64_t            min_rate() const { return m_minRate; }
+  void                set_min_rate(uint64_t v);
+
   const Rate*         rate() const;
 
   ThrottleList*       throttle_list()  { return m_throttleList; }
@@ -37,6 +43,7 @@ protected:
   uint32_t            calculate_interval() const LIBTORRENT_NO_EXPORT;
 
   uint64_t            m_maxRate;
+  uint64_t            m_minRate{0};
 
   ThrottleList*       m_throttleList;
 };
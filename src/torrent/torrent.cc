@@ -16,6 +16,7 @@
 #include "protocol/peer_factory.h"
 #include "rak/string_manip.h"
 #include "thread_main.h"
+#include "torrent/bencode_view.h"
 #include "torrent/connection_manager.h"
 #include "torrent/download/resource_manager.h"
 #include "torrent/download_info.h"
@@ -27,6 +28,7 @@
 #include "torrent/throttle.h"
 #include "tracker/thread_tracker.h"
 #include "utils/instrumentation.h"
+#include "utils/sha1.h"
 
 namespace torrent {
 
@@ -103,6 +105,10 @@ cleanup() {
   manager->cleanup();
 
   thread_tracker()->stop_thread_wait();
+
+  // Stopped here rather than in thread_disk, as the worker count may
+  // only be changed from the main thread.
+  thread_disk()->hash_check_queue()->set_worker_count(0);
   thread_disk()->stop_thread_wait();
   net_thread::thread()->stop_thread_wait();
 
@@ -144,6 +150,16 @@ total_handshakes() {
   return manager->handshake_manager()->size();
 }
 
+uint32_t
+hash_worker_count() {
+  return thread_disk()->hash_check_queue()->worker_count();
+}
+
+void
+set_hash_worker_count(uint32_t count) {
+  thread_disk()->hash_check_queue()->set_worker_count(count);
+}
+
 Throttle* down_throttle_global() { return manager->download_throttle(); }
 Throttle* up_throttle_global() { return manager->upload_throttle(); }
 
@@ -156,31 +172,81 @@ encoding_list() {
   return manager->encoding_list();
 }
 
-Download
-download_add(Object* object, uint32_t tracker_key) {
+static std::string
+download_info_hash(DownloadWrapper* download, const Object& info) {
+  if (download->info()->is_meta_download())
+    return info.get_key("pieces").as_string();
+
+  return object_sha1(&info);
+}
+
+// Hashed as found in the buffer, which matches re-encoding for the
+// ordered info dictionaries accepted by DownloadConstructor unless
+// some element is not canonically encoded. Those are re-encoded like
+// the Object path does.
+static std::string
+download_info_hash(DownloadWrapper* download, const BencodeView& info) {
+  if (download->info()->is_meta_download())
+    return std::string(info.get_key_string("pieces"));
+
+  if (info.flags() & BencodeView::flag_non_canonical) {
+    Object object;
+    info.to_object(&object);
+
+    return object_sha1(&object);
+  }
+
+  raw_bencode raw = info.as_raw_bencode();
+  char        buffer[20];
+
+  Sha1 sha;
+  sha.init();
+  sha.update(raw.data(), raw.size());
+  sha.final_c(buffer);
+
+  return std::string(buffer, 20);
+}
+
+static uint64_t
+download_metadata_size(const Object& info) {
+  char buffer[1024];
+  uint64_t metadata_size = 0;
+  object_write_bencode_c(&object_write_to_size, &metadata_size, object_buffer_t(buffer, buffer + sizeof(buffer)), &info);
+
+  return metadata_size;
+}
+
+static uint64_t
+download_metadata_size(const BencodeView& info) {
+  if (info.flags() & BencodeView::flag_non_canonical) {
+    Object object;
+    info.to_object(&object);
+
+    return download_metadata_size(object);
+  }
+
+  return info.as_raw_bencode().size();
+}
+
+template <typename Bencode>
+static std::unique_ptr<DownloadWrapper>
+download_create(Bencode& bencode, uint32_t tracker_key) {
   auto download = std::make_unique<DownloadWrapper>();
 
   DownloadConstructor ctor;
   ctor.set_download(download.get());
   ctor.set_encoding_list(manager->encoding_list());
 
-  ctor.initialize(*object);
+  ctor.initialize(bencode);
 
-  std::string infoHash;
-  if (download->info()->is_meta_download())
-    infoHash = object->get_key("info").get_key("pieces").as_string();
-  else
-    infoHash = object_sha1(&object->get_key("info"));
+  const auto& info = bencode.get_key("info");
+  std::string infoHash = download_info_hash(download.get(), info);
 
   if (manager->download_manager()->find(infoHash) != manager->download_manager()->end())
     throw input_error("Info hash already used by another torrent.");
 
-  if (!download->info()->is_meta_download()) {
-    char buffer[1024];
-    uint64_t metadata_size = 0;
-    object_write_bencode_c(&object_write_to_size, &metadata_size, object_buffer_t(buffer, buffer + sizeof(buffer)), &object->get_key("info"));
-    download->main()->set_metadata_size(metadata_size);
-  }
+  if (!download->info()->is_meta_download())
+    download->main()->set_metadata_size(download_metadata_size(info));
 
   std::string local_id = PEER_NAME + rak::generate_random<std::string>(20 - std::string(PEER_NAME).size());
 
@@ -189,7 +255,7 @@ download_add(Object* object, uint32_t tracker_key) {
 
   // Add trackers, etc, after setting the info hash so that log
   // entries look sane.
-  ctor.parse_tracker(*object);
+  ctor.parse_tracker(bencode);
 
   // Default PeerConnection factory functions.
   download->main()->connection_list()->slot_new_connection(&createPeerConnectionDefault);
@@ -199,10 +265,70 @@ download_add(Object* object, uint32_t tracker_key) {
   // go in there.
   manager->initialize_download(download.get());
 
+  return download;
+}
+
+Download
+download_add(Object* object, uint32_t tracker_key) {
+  auto download = download_create(*object, tracker_key);
+
   download->set_bencode(object);
   return Download(download.release());
 }
 
+// Converts the torrent for the Object kept by the download, except
+// for the piece hashes. Those are the largest part of most torrents,
+// and the stored info dictionary refers to the copy DownloadConstructor
+// already made for the download instead of holding another.
+static void
+download_bencode_from_view(DownloadWrapper* download, const BencodeView& bencode, Object* object) {
+  *object = Object::create_map();
+
+  for (const auto& entry : bencode.as_map()) {
+    auto& dest = object->as_map()[std::string(entry.first)];
+
+    if (entry.first != "info" || download->info()->is_meta_download()) {
+      entry.second.to_object(&dest);
+      continue;
+    }
+
+    dest = Object::create_map();
+
+    for (const auto& info_entry : entry.second.as_map()) {
+      if (info_entry.first == "pieces")
+        dest.as_map()[std::string(info_entry.first)] = raw_string(download->complete_hash().data(), download->complete_hash().size());
+      else
+        info_entry.second.to_object(&dest.as_map()[std::string(info_entry.first)]);
+    }
+
+    dest.set_internal_flags(entry.second.flags() & Object::flag_unordered);
+  }
+
+  object->set_internal_flags(bencode.flags() & Object::flag_unordered);
+}
+
+Download
+download_add(const BencodeView& bencode, uint32_t tracker_key) {
+  // Magnet URIs add keys to the torrent, so they need an Object.
+  if (!bencode.has_key_map("info")) {
+    auto object = std::make_unique<Object>();
+    bencode.to_object(object.get());
+
+    auto download = download_add(object.get(), tracker_key);
+
+    object.release();
+    return download;
+  }
+
+  auto download = download_create(bencode, tracker_key);
+  auto object   = std::make_unique<Object>();
+
+  download_bencode_from_view(download.get(), bencode, object.get());
+
+  download->set_bencode(object.release());
+  return Download(download.release());
+}
+
 void
 download_remove(Download d) {
   manager->cleanup_download(d.ptr());
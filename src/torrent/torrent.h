@@ -31,6 +31,11 @@ tracker::DhtController* dht_controller() LIBTORRENT_EXPORT;
 
 uint32_t            total_handshakes() LIBTORRENT_EXPORT;
 
+// Number of threads dedicated to hash checking chunks, when zero all
+// hashing is done by the disk thread. Only valid after 'initialize()'.
+uint32_t            hash_worker_count() LIBTORRENT_EXPORT;
+void                set_hash_worker_count(uint32_t count) LIBTORRENT_EXPORT;
+
 Throttle*           down_throttle_global() LIBTORRENT_EXPORT;
 Throttle*           up_throttle_global() LIBTORRENT_EXPORT;
 
@@ -54,6 +59,14 @@ EncodingList*       encoding_list() LIBTORRENT_EXPORT;
 //
 // Might consider redesigning that...
 Download            download_add(Object* s, uint32_t tracker_key) LIBTORRENT_EXPORT;
+
+// Parses the torrent from an index of the bencoded file, without first
+// reading it into an Object. The Object kept by the download is built
+// from the view once the torrent has been accepted, so the buffer and
+// index may be released after the call. In it 'info.pieces' is a raw
+// string referring to the download's piece hashes rather than a copy,
+// valid until the download is removed.
+Download            download_add(const BencodeView& bencode, uint32_t tracker_key) LIBTORRENT_EXPORT;
 void                download_remove(Download d) LIBTORRENT_EXPORT;
 
 // Add all downloads to dlist. The client is responsible for clearing
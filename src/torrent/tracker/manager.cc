@@ -9,6 +9,7 @@
 #include "torrent/tracker/tracker.h"
 #include "torrent/utils/log.h"
 #include "torrent/utils/thread.h"
+#include "tracker/http_scraper.h"
 #include "tracker/tracker_controller.h"
 #include "tracker/tracker_list.h"
 #include "tracker/tracker_worker.h"
@@ -27,8 +28,12 @@ Manager::Manager(utils::Thread* main_thread, utils::Thread* tracker_thread) :
 
   if (m_tracker_thread == nullptr)
     throw internal_error("tracker::Manager::Manager(...) tracker_thread is null.");
+
+  m_http_scraper = std::make_unique<HttpScraper>(m_main_thread);
 }
 
+Manager::~Manager() = default;
+
 TrackerControllerWrapper
 Manager::add_controller(DownloadInfo* download_info, std::shared_ptr<TrackerController> controller) {
   assert(std::this_thread::get_id() == m_main_thread->thread_id());
@@ -81,6 +86,20 @@ Manager::send_scrape(tracker::Tracker& tracker) {
   tracker.get_worker()->send_scrape();
 }
 
+void
+Manager::send_http_scrape(TrackerHttp* tracker, const std::string& scrape_url) {
+  assert(std::this_thread::get_id() == m_main_thread->thread_id());
+
+  m_http_scraper->request_scrape(tracker, scrape_url);
+}
+
+void
+Manager::cancel_http_scrape(TrackerHttp* tracker) {
+  assert(std::this_thread::get_id() == m_main_thread->thread_id());
+
+  m_http_scraper->cancel_scrape(tracker);
+}
+
 // Events are queued by the trackers and run in the main thread.
 void
 Manager::add_event(torrent::TrackerWorker* tracker_worker, std::function<void()> event) {
@@ -3,11 +3,19 @@
 #ifndef LIBTORRENT_TRACKER_MANAGER_H
 #define LIBTORRENT_TRACKER_MANAGER_H
 
+#include <memory>
 #include <mutex>
 #include <set>
 #include <torrent/tracker/tracker.h>
 #include <torrent/tracker/wrappers.h>
 
+namespace torrent {
+
+class HttpScraper;
+class TrackerHttp;
+
+} // namespace torrent
+
 namespace torrent::tracker {
 
 struct TrackerListEvent {
@@ -19,11 +27,12 @@ class LIBTORRENT_EXPORT Manager {
 public:
 
   Manager(utils::Thread* main_thread, utils::Thread* tracker_thread);
-  ~Manager() = default;
+  ~Manager();
 
 protected:
   friend class torrent::DownloadMain;
   friend class torrent::DownloadWrapper;
+  friend class torrent::TrackerHttp;
   friend class torrent::TrackerList;
   friend class torrent::ThreadTracker;
 
@@ -35,6 +44,11 @@ protected:
   void                send_event(tracker::Tracker& tracker, tracker::TrackerState::event_enum new_event);
   void                send_scrape(tracker::Tracker& tracker);
 
+  // HTTP scrapes with the same scrape url are collected for a short
+  // while and sent as a single request.
+  void                send_http_scrape(TrackerHttp* tracker, const std::string& scrape_url);
+  void                cancel_http_scrape(TrackerHttp* tracker);
+
   // Any thread:
 
   // remove_events() only removes events from the main thread.
@@ -51,6 +65,8 @@ private:
 
   std::mutex                         m_lock;
   std::set<TrackerControllerWrapper> m_controllers;
+
+  std::unique_ptr<HttpScraper>       m_http_scraper;
 };
 
 } // namespace torrent::tracker
@@ -0,0 +1,234 @@
+#include "config.h"
+
+#include "torrent/utils/callback_queue.h"
+
+#include "torrent/exceptions.h"
+
+namespace torrent::utils {
+
+CallbackQueue::CallbackQueue() :
+  m_tail(&m_stub),
+  m_head(&m_stub) {
+}
+
+CallbackQueue::~CallbackQueue() {
+  drain_pending();
+
+  while (m_pending_first != nullptr) {
+    auto node = m_pending_first;
+    m_pending_first = node->m_next.load(std::memory_order_relaxed);
+    delete node;
+  }
+}
+
+void
+CallbackQueue::push(const void* target, slot_type&& slot) {
+  auto node = allocate_node();
+
+  node->m_target = target;
+  node->m_slot = std::move(slot);
+
+  push_node(node);
+}
+
+void
+CallbackQueue::cancel(const void* target) {
+  auto lock = std::scoped_lock(m_lock);
+
+  drain_pending();
+
+  for (auto node = m_pending_first; node != nullptr; node = node->m_next.load(std::memory_order_relaxed))
+    if (node->m_target == target)
+      node->m_cancelled = true;
+
+  for (auto node = m_running_first; node != nullptr; node = node->m_next.load(std::memory_order_relaxed))
+    if (node->m_target == target)
+      node->m_cancelled = true;
+}
+
+// Nodes released by consumers go on a global lock-free stack, which
+// allocating threads take whole into a thread local cache. Only taking
+// the whole stack avoids the ABA problem of popping single nodes.
+CallbackQueue::node_type*
+CallbackQueue::allocate_node() {
+  struct node_cache {
+    ~node_cache() {
+      while (first != nullptr) {
+        auto node = first;
+        first = node->m_next.load(std::memory_order_relaxed);
+        delete node;
+      }
+    }
+
+    node_type* first{nullptr};
+  };
+
+  static thread_local node_cache cache;
+
+  if (cache.first == nullptr)
+    cache.first = free_nodes().exchange(nullptr, std::memory_order_acquire);
+
+  if (cache.first == nullptr)
+    return new node_type;
+
+  auto node = cache.first;
+  cache.first = node->m_next.load(std::memory_order_relaxed);
+
+  return node;
+}
+
+void
+CallbackQueue::release_nodes(node_type* first, node_type* last) {
+  auto& free_list = free_nodes();
+  auto  head      = free_list.load(std::memory_order_relaxed);
+
+  do {
+    last->m_next.store(head, std::memory_order_relaxed);
+  } while (!free_list.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+}
+
+std::atomic<CallbackQueue::node_type*>&
+CallbackQueue::free_nodes() {
+  struct node_list {
+    ~node_list() {
+      auto node = first.load();
+
+      while (node != nullptr) {
+        auto next = node->m_next.load(std::memory_order_relaxed);
+        delete node;
+        node = next;
+      }
+    }
+
+    std::atomic<node_type*> first{nullptr};
+  };
+
+  static node_list free_list;
+
+  return free_list.first;
+}
+
+// Producers swap themselves in as the new tail and then link the
+// previous tail to the node. Until the link is stored the consumer
+// sees the queue as empty past the previous tail.
+void
+CallbackQueue::push_node(node_type* node) {
+  node->m_next.store(nullptr, std::memory_order_relaxed);
+
+  auto prev = m_tail.exchange(node, std::memory_order_acq_rel);
+  prev->m_next.store(node, std::memory_order_release);
+}
+
+// Only called with 'm_lock' held, which makes the holder the single
+// consumer of the lock-free list. Returns nullptr if empty, or if a
+// producer has not yet linked its node.
+CallbackQueue::node_type*
+CallbackQueue::pop_node() {
+  auto head = m_head;
+  auto next = head->m_next.load(std::memory_order_acquire);
+
+  if (head == &m_stub) {
+    if (next == nullptr)
+      return nullptr;
+
+    m_head = next;
+    head = next;
+    next = next->m_next.load(std::memory_order_acquire);
+  }
+
+  if (next != nullptr) {
+    m_head = next;
+    return head;
+  }
+
+  if (head != m_tail.load(std::memory_order_acquire))
+    return nullptr;
+
+  push_node(&m_stub);
+
+  next = head->m_next.load(std::memory_order_acquire);
+
+  if (next == nullptr)
+    return nullptr;
+
+  m_head = next;
+  return head;
+}
+
+void
+CallbackQueue::drain_pending() {
+  while (auto node = pop_node()) {
+    node->m_next.store(nullptr, std::memory_order_relaxed);
+
+    if (m_pending_last != nullptr)
+      m_pending_last->m_next.store(node, std::memory_order_relaxed);
+    else
+      m_pending_first = node;
+
+    m_pending_last = node;
+  }
+}
+
+CallbackQueue::node_type*
+CallbackQueue::take_batch() {
+  auto lock = std::scoped_lock(m_lock);
+
+  if (m_running_first != nullptr)
+    throw internal_error("CallbackQueue::take_batch() called while processing callbacks.");
+
+  drain_pending();
+
+  m_running_first = m_pending_first;
+  m_running_last = m_pending_last;
+  m_pending_first = nullptr;
+  m_pending_last = nullptr;
+
+  return m_running_first;
+}
+
+// Nodes up to and including 'last' have been processed, or all of
+// them if 'last' is nullptr. The remaining nodes go back in front of
+// the pending list.
+//
+// Slots are destroyed before taking the lock as they may hold
+// arbitrary captures, while the target is only cleared once 'cancel'
+// can no longer see the node.
+void
+CallbackQueue::release_batch(node_type* last) {
+  if (last == nullptr)
+    last = m_running_last;
+
+  auto remaining = last->m_next.load(std::memory_order_relaxed);
+
+  for (auto node = m_running_first; node != remaining; node = node->m_next.load(std::memory_order_relaxed))
+    node->m_slot = nullptr;
+
+  node_type* first;
+
+  {
+    auto lock = std::scoped_lock(m_lock);
+
+    first = m_running_first;
+
+    if (remaining != nullptr) {
+      m_running_last->m_next.store(m_pending_first, std::memory_order_relaxed);
+
+      if (m_pending_first == nullptr)
+        m_pending_last = m_running_last;
+
+      m_pending_first = remaining;
+    }
+
+    m_running_first = nullptr;
+    m_running_last = nullptr;
+  }
+
+  for (auto node = first; node != remaining; node = node->m_next.load(std::memory_order_relaxed)) {
+    node->m_target = nullptr;
+    node->m_cancelled.store(false, std::memory_order_relaxed);
+  }
+
+  release_nodes(first, last);
+}
+
+} // namespace torrent::utils
@@ -0,0 +1,111 @@
+// Multi-producer single-consumer callback queue used by Thread.
+
+#ifndef LIBTORRENT_UTILS_CALLBACK_QUEUE_H
+#define LIBTORRENT_UTILS_CALLBACK_QUEUE_H
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+#include <torrent/common.h>
+
+namespace torrent::utils {
+
+// Producers push onto an intrusive lock-free list, callbacks are run in
+// the order they were pushed. Nodes are recycled through a global free
+// list with a per-thread cache, so pushing does not allocate once the
+// pool is warm.
+//
+// The consumer takes all pending callbacks as a batch with a single
+// lock of 'm_lock', which is shared only with 'cancel'. Cancelling
+// marks matching nodes that are pending or in the batch being run as
+// tombstones, which the consumer skips.
+
+class LIBTORRENT_EXPORT CallbackQueue {
+public:
+  using slot_type = std::function<void ()>;
+
+  class node_type {
+  public:
+    const void*         target() const       { return m_target; }
+    bool                is_cancelled() const { return m_cancelled.load(); }
+
+    void                call()               { m_slot(); }
+
+  private:
+    friend class CallbackQueue;
+
+    std::atomic<node_type*> m_next{nullptr};
+    const void*             m_target{nullptr};
+    std::atomic<bool>       m_cancelled{false};
+    slot_type               m_slot;
+  };
+
+  CallbackQueue();
+  ~CallbackQueue();
+
+  // Safe to call from any thread.
+  void                push(const void* target, slot_type&& slot);
+  void                cancel(const void* target);
+
+  // Only called by the consumer thread. Returns false if there was
+  // nothing to process. The 'invoke' function is called for every
+  // node in the batch, including cancelled ones, and is expected to
+  // check 'is_cancelled' before calling the node.
+  //
+  // If 'invoke' throws, the exception is passed on and the rest of the
+  // batch stays queued ahead of callbacks pushed since.
+  template <typename Invoke>
+  bool                process(Invoke&& invoke);
+
+private:
+  CallbackQueue(const CallbackQueue&) = delete;
+  CallbackQueue& operator=(const CallbackQueue&) = delete;
+
+  static node_type*   allocate_node();
+  static void         release_nodes(node_type* first, node_type* last);
+  static std::atomic<node_type*>& free_nodes();
+
+  void                push_node(node_type* node);
+  node_type*          pop_node();
+  void                drain_pending();
+
+  node_type*          take_batch();
+  void                release_batch(node_type* last);
+
+  std::atomic<node_type*> m_tail;
+  node_type*              m_head;
+  node_type               m_stub;
+
+  std::mutex          m_lock;
+  node_type*          m_pending_first{nullptr};
+  node_type*          m_pending_last{nullptr};
+  node_type*          m_running_first{nullptr};
+  node_type*          m_running_last{nullptr};
+};
+
+template <typename Invoke>
+inline bool
+CallbackQueue::process(Invoke&& invoke) {
+  auto node = take_batch();
+
+  if (node == nullptr)
+    return false;
+
+  // Holds the node being invoked if it throws, else nullptr once the
+  // whole batch is done.
+  struct release_guard {
+    ~release_guard() { queue->release_batch(current); }
+    CallbackQueue* queue;
+    node_type*&    current;
+  } guard{this, node};
+
+  for (; node != nullptr; node = node->m_next.load(std::memory_order_relaxed))
+    invoke(*node);
+
+  return true;
+}
+
+} // namespace torrent::utils
+
+#endif
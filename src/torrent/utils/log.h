@@ -118,6 +118,11 @@ enum {
 
   LOG_UI_EVENTS,
 
+  // Groups added since are appended here so that the values above
+  // stay the same.
+  LOG_INSTRUMENTATION_HASHING,
+  LOG_INSTRUMENTATION_HANDSHAKES,
+
   LOG_GROUP_MAX_SIZE
 };
 
@@ -205,6 +205,9 @@ constexpr const char* option_list_log_group[] = {
 
   "ui_events",
 
+  "instrumentation_hashing",
+  "instrumentation_handshakes",
+
   NULL
 };
 
@@ -13,6 +13,7 @@
 #include "peer/peer_info.h"
 #include "peer/peer_list.h"
 #include "torrent/common.h"
+#include "torrent/bencode_view.h"
 #include "torrent/bitfield.h"
 #include "torrent/download.h"
 #include "torrent/download_info.h"
@@ -36,14 +37,18 @@
 
 namespace torrent {
 
-void
-resume_load_progress(Download download, const Object& object) {
+static const std::string& resume_string(const std::string& str) { return str; }
+static std::string        resume_string(std::string_view str)   { return std::string(str); }
+
+template <typename Bencode>
+static void
+resume_load_progress_impl(Download download, const Bencode& object) {
   if (!object.has_key_list("files")) {
     LT_LOG_LOAD("could not find 'files' key", 0);
     return;
   }
 
-  const Object::list_type& files = object.get_key_list("files");
+  const auto& files = object.get_key_list("files");
 
   if (files.size() != download.file_list()->size_files()) {
     LT_LOG_LOAD_INVALID("number of resumable files does not match files in torrent", 0);
@@ -155,6 +160,16 @@ resume_load_progress(Download download, const Object& object) {
   resume_load_uncertain_pieces(download, object);
 }
 
+void
+resume_load_progress(Download download, const Object& object) {
+  resume_load_progress_impl(download, object);
+}
+
+void
+resume_load_progress(Download download, const BencodeView& object) {
+  resume_load_progress_impl(download, object);
+}
+
 void
 resume_save_progress(Download download, Object& object) {
   // We don't remove the old hash data since it might still be valid,
@@ -245,10 +260,11 @@ resume_clear_progress([[maybe_unused]] Download download, Object& object) {
   object.erase_key("bitfield");
 }
 
-bool
-resume_load_bitfield(Download download, const Object& object) {
+template <typename Bencode>
+static bool
+resume_load_bitfield_impl(Download download, const Bencode& object) {
   if (object.has_key_string("bitfield")) {
-    const Object::string_type& bitfield = object.get_key_string("bitfield");
+    const auto& bitfield = object.get_key_string("bitfield");
 
     if (bitfield.size() != download.file_list()->bitfield()->size_bytes()) {
       LT_LOG_LOAD_INVALID("size of resumable bitfield does not match bitfield size of torrent", 0);
@@ -257,10 +273,10 @@ resume_load_bitfield(Download download, const Object& object) {
 
     LT_LOG_LOAD("restoring partial bitfield", 0);
 
-    download.set_bitfield(reinterpret_cast<const uint8_t*>(bitfield.c_str()), (reinterpret_cast<const uint8_t*>(bitfield.c_str()) + bitfield.size()));
+    download.set_bitfield(reinterpret_cast<const uint8_t*>(bitfield.data()), (reinterpret_cast<const uint8_t*>(bitfield.data()) + bitfield.size()));
 
   } else if (object.has_key_value("bitfield")) {
-    Object::value_type chunksDone = object.get_key_value("bitfield");
+    int64_t chunksDone = object.get_key_value("bitfield");
 
     if (chunksDone == download.file_list()->bitfield()->size_bits()) {
       LT_LOG_LOAD("restoring completed bitfield", 0);
@@ -281,6 +297,16 @@ resume_load_bitfield(Download download, const Object& object) {
   return true;
 }
 
+bool
+resume_load_bitfield(Download download, const Object& object) {
+  return resume_load_bitfield_impl(download, object);
+}
+
+bool
+resume_load_bitfield(Download download, const BencodeView& object) {
+  return resume_load_bitfield_impl(download, object);
+}
+
 void
 resume_save_bitfield(Download download, Object& object) {
   const Bitfield* bitfield = download.file_list()->bitfield();
@@ -294,8 +320,9 @@ resume_save_bitfield(Download download, Object& object) {
   }
 }
 
-void
-resume_load_uncertain_pieces(Download download, const Object& object) {
+template <typename Bencode>
+static void
+resume_load_uncertain_pieces_impl(Download download, const Bencode& object) {
   // Don't rehash when loading resume data within the same session.
   if (!object.has_key_string("uncertain_pieces")) {
     LT_LOG_LOAD("no uncertain pieces marked", 0);
@@ -308,12 +335,12 @@ resume_load_uncertain_pieces(Download download, const Object& object) {
     return;
   }
 
-  const Object::string_type& uncertain = object.get_key_string("uncertain_pieces");
+  const auto& uncertain = object.get_key_string("uncertain_pieces");
 
   LT_LOG_LOAD("found %zu uncertain pieces", uncertain.size() / 2);
 
-  const char* itr  = uncertain.c_str();
-  const char* last = uncertain.c_str() + uncertain.size();
+  const char* itr  = uncertain.data();
+  const char* last = uncertain.data() + uncertain.size();
 
   while (itr + sizeof(uint32_t) <= last) {
     // Fix this so it does full ranges.
@@ -325,6 +352,16 @@ resume_load_uncertain_pieces(Download download, const Object& object) {
   }
 }
 
+void
+resume_load_uncertain_pieces(Download download, const Object& object) {
+  resume_load_uncertain_pieces_impl(download, object);
+}
+
+void
+resume_load_uncertain_pieces(Download download, const BencodeView& object) {
+  resume_load_uncertain_pieces_impl(download, object);
+}
+
 void
 resume_save_uncertain_pieces(Download download, Object& object) {
   // Add information on what chunks might still not have been properly
@@ -358,8 +395,9 @@ resume_save_uncertain_pieces(Download download, Object& object) {
   completed.append(reinterpret_cast<const char*>(&buffer.front()), buffer.size() * sizeof(uint32_t));
 }
 
-bool
-resume_check_target_files(Download download, [[maybe_unused]] const Object& object) {
+template <typename Bencode>
+static bool
+resume_check_target_files_impl(Download download, [[maybe_unused]] const Bencode& object) {
   FileList* fileList = download.file_list();
 
   if (!fileList->is_open())
@@ -396,12 +434,23 @@ resume_check_target_files(Download download, [[maybe_unused]] const Object& obje
   }
 }
 
-void
-resume_load_file_priorities(Download download, const Object& object) {
+bool
+resume_check_target_files(Download download, const Object& object) {
+  return resume_check_target_files_impl(download, object);
+}
+
+bool
+resume_check_target_files(Download download, const BencodeView& object) {
+  return resume_check_target_files_impl(download, object);
+}
+
+template <typename Bencode>
+static void
+resume_load_file_priorities_impl(Download download, const Bencode& object) {
   if (!object.has_key_list("files"))
     return;
 
-  const Object::list_type& files = object.get_key_list("files");
+  const auto& files = object.get_key_list("files");
 
   auto filesItr  = files.begin();
   auto filesLast = files.end();
@@ -430,6 +479,16 @@ resume_load_file_priorities(Download download, const Object& object) {
   }
 }
 
+void
+resume_load_file_priorities(Download download, const Object& object) {
+  resume_load_file_priorities_impl(download, object);
+}
+
+void
+resume_load_file_priorities(Download download, const BencodeView& object) {
+  resume_load_file_priorities_impl(download, object);
+}
+
 void
 resume_save_file_priorities(Download download, Object& object) {
   auto& files    = object.insert_preserve_copy("files", Object::create_list()).first->second.as_list();
@@ -447,8 +506,9 @@ resume_save_file_priorities(Download download, Object& object) {
   }
 }
 
-void
-resume_load_addresses(Download download, const Object& object) {
+template <typename Bencode>
+static void
+resume_load_addresses_impl(Download download, const Bencode& object) {
   if (!object.has_key_list("peers"))
     return;
 
@@ -462,7 +522,7 @@ resume_load_addresses(Download download, const Object& object) {
       continue;
 
     int flags = 0;
-    rak::socket_address socketAddress = *reinterpret_cast<const SocketAddressCompact*>(key.get_key_string("inet").c_str());
+    rak::socket_address socketAddress = *reinterpret_cast<const SocketAddressCompact*>(key.get_key_string("inet").data());
 
     if (socketAddress.port() != 0)
       flags |= PeerList::address_available;
@@ -479,6 +539,16 @@ resume_load_addresses(Download download, const Object& object) {
   // Tell rTorrent to harvest addresses.
 }
 
+void
+resume_load_addresses(Download download, const Object& object) {
+  resume_load_addresses_impl(download, object);
+}
+
+void
+resume_load_addresses(Download download, const BencodeView& object) {
+  resume_load_addresses_impl(download, object);
+}
+
 void
 resume_save_addresses(Download download, Object& object) {
   auto& dest = object.insert_key("peers", Object::create_list());
@@ -503,12 +573,13 @@ resume_save_addresses(Download download, Object& object) {
   }
 }
 
-void
-resume_load_tracker_settings(Download download, const Object& object) {
+template <typename Bencode>
+static void
+resume_load_tracker_settings_impl(Download download, const Bencode& object) {
   if (!object.has_key_map("trackers"))
     return;
 
-  auto& src          = object.get_key("trackers");
+  const auto& src    = object.get_key("trackers");
   auto  tracker_list = download.main()->tracker_list();
 
   for (const auto& map : src.as_map()) {
@@ -516,17 +587,19 @@ resume_load_tracker_settings(Download download, const Object& object) {
         !map.second.has_key("group"))
       continue;
 
-    if (tracker_list->find_url(map.first) != tracker_list->end())
+    const auto& url = resume_string(map.first);
+
+    if (tracker_list->find_url(url) != tracker_list->end())
       continue;
 
-    download.main()->tracker_list()->insert_url(map.second.get_key_value("group"), map.first);
+    download.main()->tracker_list()->insert_url(map.second.get_key_value("group"), url);
   }
 
   for (auto tracker : *tracker_list) {
     if (!src.has_key_map(tracker.url()))
       continue;
 
-    const Object& trackerObject = src.get_key(tracker.url());
+    const auto& trackerObject = src.get_key(tracker.url());
 
     if (trackerObject.has_key_value("enabled") && trackerObject.get_key_value("enabled") == 0)
       tracker.disable();
@@ -535,6 +608,16 @@ resume_load_tracker_settings(Download download, const Object& object) {
   }
 }
 
+void
+resume_load_tracker_settings(Download download, const Object& object) {
+  resume_load_tracker_settings_impl(download, object);
+}
+
+void
+resume_load_tracker_settings(Download download, const BencodeView& object) {
+  resume_load_tracker_settings_impl(download, object);
+}
+
 void
 resume_save_tracker_settings(Download download, Object& object) {
   auto& dest         = object.insert_preserve_copy("trackers", Object::create_map()).first->second;
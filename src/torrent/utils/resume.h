@@ -52,27 +52,37 @@ namespace torrent {
 // When saving resume data for a torrent that is currently active, set
 // 'onlyCompleted' to ensure that a crash, etc, will cause incomplete
 // files to be hashed.
+//
+// The load functions also accept a BencodeView of the resume data, so
+// it does not need to be read into an Object first.
 
 void resume_load_progress(Download download, const Object& object) LIBTORRENT_EXPORT;
+void resume_load_progress(Download download, const BencodeView& object) LIBTORRENT_EXPORT;
 void resume_save_progress(Download download, Object& object) LIBTORRENT_EXPORT;
 void resume_clear_progress(Download download, Object& object) LIBTORRENT_EXPORT;
 
 bool resume_load_bitfield(Download download, const Object& object) LIBTORRENT_EXPORT;
+bool resume_load_bitfield(Download download, const BencodeView& object) LIBTORRENT_EXPORT;
 void resume_save_bitfield(Download download, Object& object) LIBTORRENT_EXPORT;
 
 // Do not call 'resume_load_uncertain_pieces' directly.
 void resume_load_uncertain_pieces(Download download, const Object& object) LIBTORRENT_EXPORT;
+void resume_load_uncertain_pieces(Download download, const BencodeView& object) LIBTORRENT_EXPORT;
 void resume_save_uncertain_pieces(Download download, Object& object) LIBTORRENT_EXPORT;
 
 bool resume_check_target_files(Download download, const Object& object) LIBTORRENT_EXPORT;
+bool resume_check_target_files(Download download, const BencodeView& object) LIBTORRENT_EXPORT;
 
 void resume_load_file_priorities(Download download, const Object& object) LIBTORRENT_EXPORT;
+void resume_load_file_priorities(Download download, const BencodeView& object) LIBTORRENT_EXPORT;
 void resume_save_file_priorities(Download download, Object& object) LIBTORRENT_EXPORT;
 
 void resume_load_addresses(Download download, const Object& object) LIBTORRENT_EXPORT;
+void resume_load_addresses(Download download, const BencodeView& object) LIBTORRENT_EXPORT;
 void resume_save_addresses(Download download, Object& object) LIBTORRENT_EXPORT;
 
 void resume_load_tracker_settings(Download download, const Object& object) LIBTORRENT_EXPORT;
+void resume_load_tracker_settings(Download download, const BencodeView& object) LIBTORRENT_EXPORT;
 void resume_save_tracker_settings(Download download, Object& object) LIBTORRENT_EXPORT;
 
 } // namespace torrent
@@ -21,17 +21,69 @@ SchedulerEntry::~SchedulerEntry() {
 
 
 inline void
-Scheduler::make_heap() {
-  std::make_heap(begin(), end(), [](const SchedulerEntry* a, const SchedulerEntry* b) {
-      return a->time() > b->time();
-    });
+Scheduler::heap_set(size_t index, SchedulerEntry* entry) {
+  base_type::operator[](index) = entry;
+  entry->set_index(index);
 }
 
-inline void
-Scheduler::push_heap() {
-  std::push_heap(begin(), end(), [](const SchedulerEntry* a, const SchedulerEntry* b) {
-      return a->time() > b->time();
-    });
+void
+Scheduler::heap_sift_up(size_t index) {
+  SchedulerEntry* entry = base_type::operator[](index);
+
+  while (index != 0) {
+    size_t parent = (index - 1) / 2;
+
+    if (!(entry->time() < base_type::operator[](parent)->time()))
+      break;
+
+    heap_set(index, base_type::operator[](parent));
+    index = parent;
+  }
+
+  heap_set(index, entry);
+}
+
+void
+Scheduler::heap_sift_down(size_t index) {
+  SchedulerEntry* entry = base_type::operator[](index);
+
+  while (true) {
+    size_t child = 2 * index + 1;
+
+    if (child >= size())
+      break;
+
+    if (child + 1 < size() && base_type::operator[](child + 1)->time() < base_type::operator[](child)->time())
+      child++;
+
+    if (!(base_type::operator[](child)->time() < entry->time()))
+      break;
+
+    heap_set(index, base_type::operator[](child));
+    index = child;
+  }
+
+  heap_set(index, entry);
+}
+
+void
+Scheduler::heap_update(size_t index) {
+  if (index != 0 && base_type::operator[](index)->time() < base_type::operator[]((index - 1) / 2)->time())
+    heap_sift_up(index);
+  else
+    heap_sift_down(index);
+}
+
+void
+Scheduler::heap_remove(size_t index) {
+  SchedulerEntry* last = base_type::back();
+  base_type::pop_back();
+
+  if (index == size())
+    return;
+
+  heap_set(index, last);
+  heap_update(index);
 }
 
 Scheduler::time_type
@@ -58,18 +110,14 @@ Scheduler::erase(SchedulerEntry* entry) {
   if (entry->scheduler() != this)
     throw torrent::internal_error("Scheduler::erase(...) called on an entry that is in another scheduler.");
 
-  auto itr = std::find_if(begin(), end(), [entry](const SchedulerEntry* e) {
-      return e == entry;
-    });
-
-  if (itr == end())
+  if (entry->index() >= size() || base_type::operator[](entry->index()) != entry)
     throw torrent::internal_error("Scheduler::erase(...) could not find item in queue.");
 
+  heap_remove(entry->index());
+
   entry->set_scheduler(nullptr);
   entry->set_time(Scheduler::time_type{});
-
-  base_type::erase(itr);
-  make_heap();
+  entry->set_index(0);
 }
 
 void
@@ -92,7 +140,7 @@ Scheduler::wait_until(SchedulerEntry* entry, Scheduler::time_type time) {
   entry->set_time(time);
 
   base_type::push_back(entry);
-  push_heap();
+  heap_sift_up(size() - 1);
 }
 
 void
@@ -129,7 +177,7 @@ Scheduler::update_wait_until(SchedulerEntry* entry, Scheduler::time_type time) {
       throw torrent::internal_error("Scheduler::update_wait(...) called on an entry that is in another scheduler.");
 
     entry->set_time(time);
-    make_heap();
+    heap_update(entry->index());
     return;
   }
 
@@ -137,7 +185,7 @@ Scheduler::update_wait_until(SchedulerEntry* entry, Scheduler::time_type time) {
   entry->set_time(time);
 
   base_type::push_back(entry);
-  push_heap();
+  heap_sift_up(size() - 1);
 }
 
 void
@@ -161,13 +209,11 @@ Scheduler::perform(Scheduler::time_type current_time) {
   while (!empty() && base_type::front()->time() <= current_time) {
     auto entry = base_type::front();
 
-    std::pop_heap(begin(), end(), [](const SchedulerEntry* a, const SchedulerEntry* b) {
-        return a->time() > b->time();
-      });
-    base_type::pop_back();
+    heap_remove(0);
 
     entry->set_scheduler(nullptr);
     entry->set_time(Scheduler::time_type{});
+    entry->set_index(0);
     entry->slot()();
   }
 }
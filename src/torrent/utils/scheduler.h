@@ -45,8 +45,13 @@ protected:
   void                set_cached_time(time_type t)      { m_cached_time = t; }
 
 private:
-  void                make_heap();
-  void                push_heap();
+  // The queue is a binary min-heap on time, with each entry holding
+  // its position so erasing and rescheduling only sift that entry.
+  void                heap_set(size_t index, SchedulerEntry* entry);
+  void                heap_sift_up(size_t index);
+  void                heap_sift_down(size_t index);
+  void                heap_update(size_t index);
+  void                heap_remove(size_t index);
 
   std::atomic<std::thread::id> m_thread_id;
   time_type                    m_cached_time{};
@@ -72,6 +77,9 @@ protected:
   void                set_scheduler(Scheduler* s) { m_scheduler = s; }
   void                set_time(time_type t)       { m_time = t; }
 
+  size_t              index() const               { return m_index; }
+  void                set_index(size_t index)     { m_index = index; }
+
 private:
   SchedulerEntry(const SchedulerEntry&) = delete;
   SchedulerEntry& operator=(const SchedulerEntry&) = delete;
@@ -79,6 +87,9 @@ private:
   slot_type           m_slot;
   Scheduler*          m_scheduler{};
   time_type           m_time{};
+
+  // Position in the scheduler's heap, only meaningful while scheduled.
+  size_t              m_index{};
 };
 
 class LIBTORRENT_EXPORT ExternalScheduler : public Scheduler {
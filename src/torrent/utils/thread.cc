@@ -66,23 +66,15 @@ Thread::stop_thread_wait() {
 
 void
 Thread::callback(void* target, std::function<void ()>&& fn) {
-  {
-    auto lock = std::scoped_lock(m_callbacks_lock);
-
-    m_callbacks.emplace(target, std::move(fn));
-  }
+  m_callbacks.push(target, std::move(fn));
 
   interrupt();
 }
 
 void
 Thread::callback_interrupt_pollling(void* target, std::function<void ()>&& fn) {
-  {
-    auto lock = std::scoped_lock(m_callbacks_lock);
-
-    m_interrupt_callbacks.emplace(target, std::move(fn));
-    m_callbacks_should_interrupt_polling = true;
-  }
+  m_interrupt_callbacks.push(target, std::move(fn));
+  m_callbacks_should_interrupt_polling = true;
 
   interrupt();
 }
@@ -92,10 +84,8 @@ Thread::cancel_callback(void* target) {
   if (target == nullptr)
     throw internal_error("Thread::cancel_callback called with a null pointer target.");
 
-  auto lock = std::scoped_lock(m_callbacks_lock);
-
-  m_callbacks.erase(target);
-  m_interrupt_callbacks.erase(target);
+  m_callbacks.cancel(target);
+  m_interrupt_callbacks.cancel(target);
 }
 
 void
@@ -250,29 +240,28 @@ void
 Thread::process_callbacks(bool only_interrupt) {
   m_callbacks_should_interrupt_polling = false;
 
-  while (true) {
-    std::function<void ()> callback;
-
-    {
-      auto lock = std::scoped_lock(m_callbacks_lock);
-
-      if (!m_interrupt_callbacks.empty())
-        callback = m_interrupt_callbacks.extract(m_interrupt_callbacks.begin()).mapped();
-      else if (!only_interrupt && !m_callbacks.empty())
-        callback = m_callbacks.extract(m_callbacks.begin()).mapped();
-      else
-        break;
-
-      // The 'm_callbacks_processing_lock' is used by 'cancel_callback_and_wait' as a way to wait
-      // for the processing of the callbacks to finish.
-      m_callbacks_processing_lock.lock();
-      m_callbacks_processing = true;
-    }
+  // The 'm_callbacks_processing_lock' is used by 'cancel_callback_and_wait' as a way to wait for
+  // the processing of the callbacks to finish. The processing flag is set before checking for a
+  // tombstone, while cancelling sets the tombstone before checking the flag, so either the
+  // callback is skipped or the canceller waits for it.
+  auto invoke = [this](CallbackQueue::node_type& node) {
+    auto lock = std::scoped_lock(m_callbacks_processing_lock);
+    m_callbacks_processing = true;
 
-    callback();
+    if (!node.is_cancelled())
+      node.call();
 
     m_callbacks_processing = false;
-    m_callbacks_processing_lock.unlock();
+  };
+
+  while (true) {
+    bool processed = m_interrupt_callbacks.process(invoke);
+
+    if (!only_interrupt)
+      processed |= m_callbacks.process(invoke);
+
+    if (!processed)
+      break;
   }
 }
 
@@ -3,11 +3,11 @@
 
 #include <atomic>
 #include <functional>
-#include <map>
 #include <mutex>
 #include <pthread.h>
 #include <sys/types.h>
 #include <torrent/common.h>
+#include <torrent/utils/callback_queue.h>
 #include <torrent/utils/signal_bitfield.h>
 
 namespace torrent {
@@ -130,12 +130,11 @@ protected:
   std::unique_ptr<SignalInterrupt> m_interrupt_sender;
   std::unique_ptr<SignalInterrupt> m_interrupt_receiver;
 
-  std::mutex                                         m_callbacks_lock;
-  std::multimap<const void*, std::function<void ()>> m_callbacks;
-  std::multimap<const void*, std::function<void ()>> m_interrupt_callbacks;
-  std::atomic<bool>                                  m_callbacks_should_interrupt_polling{false};
-  std::mutex                                         m_callbacks_processing_lock;
-  std::atomic<bool>                                  m_callbacks_processing{false};
+  CallbackQueue                    m_callbacks;
+  CallbackQueue                    m_interrupt_callbacks;
+  std::atomic<bool>                m_callbacks_should_interrupt_polling{false};
+  std::mutex                       m_callbacks_processing_lock;
+  std::atomic<bool>                m_callbacks_processing{false};
 };
 
 inline bool
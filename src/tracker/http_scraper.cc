@@ -0,0 +1,248 @@
+#include "config.h"
+
+#include "tracker/http_scraper.h"
+
+#include <algorithm>
+#include <sstream>
+#include <rak/string_manip.h>
+
+#include "torrent/exceptions.h"
+#include "torrent/object.h"
+#include "torrent/object_stream.h"
+#include "torrent/net/http_stack.h"
+#include "torrent/utils/log.h"
+#include "torrent/utils/thread.h"
+#include "torrent/utils/uri_parser.h"
+#include "tracker/tracker_http.h"
+
+#define LT_LOG(log_fmt, ...)                                            \
+  lt_log_print(LOG_TRACKER_REQUESTS, "tracker_http_scraper : " log_fmt, __VA_ARGS__);
+
+namespace torrent {
+
+HttpScraper::HttpScraper(utils::Thread* thread) :
+  m_thread(thread) {
+
+  m_task_flush.slot() = [this] { flush(); };
+}
+
+HttpScraper::~HttpScraper() {
+  if (m_task_flush.is_scheduled())
+    m_task_flush.scheduler()->erase(&m_task_flush);
+
+  for (auto& request : m_requests) {
+    request->get.close();
+    request->get.cancel_slot_callbacks(m_thread);
+  }
+}
+
+unsigned int
+HttpScraper::pending_size() const {
+  unsigned int size = 0;
+
+  for (auto& pending : m_pending)
+    size += pending.second.size();
+
+  return size;
+}
+
+void
+HttpScraper::request_scrape(TrackerHttp* tracker, const std::string& scrape_url) {
+  auto& pending = m_pending[scrape_url];
+
+  if (std::find(pending.begin(), pending.end(), tracker) != pending.end())
+    throw internal_error("HttpScraper::request_scrape(...) tracker already pending.");
+
+  pending.push_back(tracker);
+
+  if (!m_task_flush.is_scheduled())
+    this_thread::scheduler()->wait_for(&m_task_flush, scrape_delay);
+}
+
+void
+HttpScraper::cancel_scrape(TrackerHttp* tracker) {
+  for (auto itr = m_pending.begin(); itr != m_pending.end(); ) {
+    auto& pending = itr->second;
+    pending.erase(std::remove(pending.begin(), pending.end(), tracker), pending.end());
+
+    if (pending.empty())
+      itr = m_pending.erase(itr);
+    else
+      itr++;
+  }
+
+  if (m_pending.empty())
+    this_thread::scheduler()->erase(&m_task_flush);
+
+  if (m_dispatching != nullptr)
+    std::replace(m_dispatching->begin(), m_dispatching->end(), tracker, static_cast<TrackerHttp*>(nullptr));
+
+  for (auto itr = m_requests.begin(); itr != m_requests.end(); ) {
+    auto& trackers = (*itr)->trackers;
+    std::replace(trackers.begin(), trackers.end(), tracker, static_cast<TrackerHttp*>(nullptr));
+
+    if (!std::all_of(trackers.begin(), trackers.end(), [](TrackerHttp* t) { return t == nullptr; })) {
+      itr++;
+      continue;
+    }
+
+    LT_LOG("closing request without trackers : url:%s", (*itr)->get.url().c_str());
+
+    (*itr)->get.close();
+    (*itr)->get.cancel_slot_callbacks(m_thread);
+
+    itr = m_requests.erase(itr);
+  }
+}
+
+std::string
+HttpScraper::scrape_url(const std::string& scrape_url, const std::vector<HashString>& hashes) {
+  std::stringstream s;
+  s.imbue(std::locale::classic());
+
+  s << scrape_url;
+
+  char delimiter = utils::uri_has_query(scrape_url) ? '&' : '?';
+
+  for (auto& hash : hashes) {
+    char escaped[61];
+    *rak::copy_escape_html(hash.begin(), hash.end(), escaped) = '\0';
+
+    s << delimiter << "info_hash=" << escaped;
+    delimiter = '&';
+  }
+
+  return s.str();
+}
+
+void
+HttpScraper::flush() {
+  auto pending = std::move(m_pending);
+  m_pending.clear();
+
+  for (auto& itr : pending) {
+    auto first = itr.second.begin();
+
+    while (first != itr.second.end()) {
+      auto last = first + std::min<size_t>(max_scrape_hashes, std::distance(first, itr.second.end()));
+
+      start_request(itr.first, std::vector<TrackerHttp*>(first, last));
+      first = last;
+    }
+  }
+}
+
+void
+HttpScraper::start_request(const std::string& url, std::vector<TrackerHttp*> trackers) {
+  std::vector<HashString> hashes;
+
+  for (auto tracker : trackers)
+    hashes.push_back(tracker->info().info_hash);
+
+  auto request = std::make_unique<scrape_request>();
+  auto request_ptr = request.get();
+
+  request->data = std::make_shared<std::stringstream>();
+  request->trackers = std::move(trackers);
+
+  request->get.reset(scrape_url(url, hashes), request->data);
+  request->get.add_done_slot([this, request_ptr] { receive_done(request_ptr); });
+  request->get.add_failed_slot([this, request_ptr](const auto& msg) { receive_failed(request_ptr, msg); });
+
+  LT_LOG("sending scrape : url:%s hashes:%zu", url.c_str(), hashes.size());
+
+  m_requests.push_back(std::move(request));
+  net_thread::http_stack()->start_get(request_ptr->get);
+}
+
+std::unique_ptr<HttpScraper::scrape_request>
+HttpScraper::take_request(scrape_request* request) {
+  auto itr = std::find_if(m_requests.begin(), m_requests.end(), [request](auto& r) { return r.get() == request; });
+
+  if (itr == m_requests.end())
+    throw internal_error("HttpScraper::take_request(...) request not found.");
+
+  auto result = std::move(*itr);
+  m_requests.erase(itr);
+
+  result->get.close();
+  result->get.cancel_slot_callbacks(m_thread);
+
+  return result;
+}
+
+// Trackers cancel their scrape when closed, so the request is taken
+// out of the list before dispatching. Its trackers are left visible
+// to 'cancel_scrape' through 'm_dispatching', as the callbacks may
+// close or delete trackers later in the list.
+void
+HttpScraper::receive_done(scrape_request* request) {
+  auto taken = take_request(request);
+
+  Object object;
+  *taken->data >> object;
+
+  std::string msg;
+
+  if (taken->data->fail())
+    msg = "Could not parse bencoded data: " + rak::sanitize(rak::striptags(taken->data->str())).substr(0,99);
+  else if (!object.is_map())
+    msg = "Root not a bencoded map";
+  else if (object.has_key("failure reason"))
+    msg = "Failure reason \"" + (object.get_key("failure reason").is_string() ?
+                                 object.get_key_string("failure reason") :
+                                 std::string("failure reason not a string")) + "\"";
+  else if (!object.has_key_map("files"))
+    msg = "Tracker scrape does not have files entry.";
+
+  if (!msg.empty()) {
+    LT_LOG("received scrape failure : url:%s msg:%s", taken->get.url().c_str(), msg.c_str());
+
+    dispatch(taken->trackers, [&msg](TrackerHttp* tracker) { tracker->receive_scrape_failed(msg); });
+    return;
+  }
+
+  const Object& files = object.get_key("files");
+
+  LT_LOG("received scrape : url:%s hashes:%zu files:%zu", taken->get.url().c_str(), taken->trackers.size(), files.as_map().size());
+
+  dispatch(taken->trackers, [&files](TrackerHttp* tracker) {
+      if (!files.has_key_map(tracker->info().info_hash.str())) {
+        tracker->receive_scrape_failed("Tracker scrape replay did not contain infohash.");
+        return;
+      }
+
+      tracker->receive_scrape(files.get_key(tracker->info().info_hash.str()));
+    });
+}
+
+void
+HttpScraper::receive_failed(scrape_request* request, const std::string& msg) {
+  auto taken = take_request(request);
+
+  LT_LOG("received scrape failure : url:%s msg:%s", taken->get.url().c_str(), msg.c_str());
+
+  dispatch(taken->trackers, [&msg](TrackerHttp* tracker) { tracker->receive_scrape_failed(msg); });
+}
+
+// Entries are read as they are reached, so trackers cancelled by
+// earlier callbacks are skipped.
+void
+HttpScraper::dispatch(std::vector<TrackerHttp*>& trackers, const std::function<void(TrackerHttp*)>& slot) {
+  auto previous = m_dispatching;
+  m_dispatching = &trackers;
+
+  try {
+    for (size_t i = 0; i != trackers.size(); i++)
+      if (trackers[i] != nullptr)
+        slot(trackers[i]);
+
+  } catch (...) {
+    m_dispatching = previous;
+    throw;
+  }
+
+  m_dispatching = previous;
+}
+
+} // namespace torrent
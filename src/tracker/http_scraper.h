@@ -0,0 +1,82 @@
+#ifndef LIBTORRENT_TRACKER_HTTP_SCRAPER_H
+#define LIBTORRENT_TRACKER_HTTP_SCRAPER_H
+
+#include <chrono>
+#include <functional>
+#include <iosfwd>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "torrent/hash_string.h"
+#include "torrent/net/http_get.h"
+#include "torrent/utils/scheduler.h"
+
+namespace torrent {
+
+class TrackerHttp;
+
+// Collects scrapes from HTTP trackers for 'scrape_delay' and sends
+// those with the same scrape url as one request with an 'info_hash'
+// parameter per tracker, up to 'max_scrape_hashes' each. The 'files'
+// dictionary of the reply is dispatched back to each tracker.
+//
+// Owned by tracker::Manager and used from the main thread.
+
+class HttpScraper {
+public:
+  static constexpr std::chrono::seconds scrape_delay{5};
+  static constexpr unsigned int         max_scrape_hashes = 64;
+
+  HttpScraper(utils::Thread* thread);
+  ~HttpScraper();
+
+  // The result is passed to 'TrackerHttp::receive_scrape' or
+  // 'TrackerHttp::receive_scrape_failed'.
+  void                request_scrape(TrackerHttp* tracker, const std::string& scrape_url);
+  void                cancel_scrape(TrackerHttp* tracker);
+
+  unsigned int        pending_size() const;
+  unsigned int        request_size() const { return m_requests.size(); }
+
+  static std::string  scrape_url(const std::string& scrape_url, const std::vector<HashString>& hashes);
+
+private:
+  HttpScraper(const HttpScraper&) = delete;
+  HttpScraper& operator=(const HttpScraper&) = delete;
+
+  // Trackers are replaced by nullptr when cancelled.
+  struct scrape_request {
+    net::HttpGet                       get;
+    std::shared_ptr<std::stringstream> data;
+    std::vector<TrackerHttp*>          trackers;
+  };
+
+  using request_list = std::list<std::unique_ptr<scrape_request>>;
+
+  void                flush();
+  void                start_request(const std::string& url, std::vector<TrackerHttp*> trackers);
+
+  void                receive_done(scrape_request* request);
+  void                receive_failed(scrape_request* request, const std::string& msg);
+  void                dispatch(std::vector<TrackerHttp*>& trackers, const std::function<void(TrackerHttp*)>& slot);
+
+  std::unique_ptr<scrape_request> take_request(scrape_request* request);
+
+  utils::Thread*                                   m_thread;
+
+  std::map<std::string, std::vector<TrackerHttp*>> m_pending;
+  request_list                                     m_requests;
+  utils::SchedulerEntry                            m_task_flush;
+
+  // The trackers of the request being dispatched, which has already
+  // been taken out of 'm_requests'. Tracker callbacks may close other
+  // trackers in it.
+  std::vector<TrackerHttp*>*                       m_dispatching{nullptr};
+};
+
+} // namespace torrent
+
+#endif
@@ -6,6 +6,7 @@
 
 #include "torrent/exceptions.h"
 #include "torrent/tracker/manager.h"
+#include "tracker/udp_router.h"
 #include "utils/instrumentation.h"
 
 namespace torrent {
@@ -20,6 +21,7 @@ ThreadTracker::create_thread(utils::Thread* main_thread) {
 
   m_thread_tracker = new ThreadTracker();
   m_thread_tracker.load()->m_tracker_manager = std::make_unique<tracker::Manager>(main_thread, m_thread_tracker);
+  m_thread_tracker.load()->m_udp_router = std::make_unique<UdpRouter>();
 }
 
 ThreadTracker*
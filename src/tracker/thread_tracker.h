@@ -9,6 +9,8 @@
 
 namespace torrent {
 
+class UdpRouter;
+
 namespace tracker {
 class Manager;
 } // namespace tracker
@@ -32,6 +34,9 @@ public:
 
   tracker::Manager*     tracker_manager() { return m_tracker_manager.get(); }
 
+  // Shared by all UDP tracker workers, used from the main thread.
+  UdpRouter*            udp_router() { return m_udp_router.get(); }
+
   // void                send_event(tracker::Tracker& tracker, tracker::TrackerState::event_enum new_event);
 
 protected:
@@ -48,6 +53,7 @@ private:
   static std::atomic<ThreadTracker*> m_thread_tracker;
 
   std::unique_ptr<tracker::Manager>  m_tracker_manager;
+  std::unique_ptr<UdpRouter>         m_udp_router;
   unsigned int                       m_signal_send_event{~0u};
 
   // std::mutex                    m_send_events_lock;
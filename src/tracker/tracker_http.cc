@@ -16,9 +16,11 @@
 #include "torrent/net/socket_address.h"
 #include "torrent/net/utils.h"
 #include "torrent/object_stream.h"
+#include "torrent/tracker/manager.h"
 #include "torrent/utils/log.h"
 #include "torrent/utils/option_strings.h"
 #include "torrent/utils/uri_parser.h"
+#include "tracker/thread_tracker.h"
 
 #include "manager.h"
 
@@ -50,7 +52,7 @@ TrackerHttp::~TrackerHttp() {
 
 bool
 TrackerHttp::is_busy() const {
-  return m_data != nullptr;
+  return m_data != nullptr || m_scraping;
 }
 
 void
@@ -199,18 +201,8 @@ TrackerHttp::delayed_send_scrape() {
 
   lock_and_set_latest_event(tracker::TrackerState::EVENT_SCRAPE);
 
-  std::stringstream s;
-  s.imbue(std::locale::classic());
-
-  request_prefix(&s, utils::uri_generate_scrape_url(info().url));
-
-  std::string request_url = s.str();
-
-  m_data = std::make_unique<std::stringstream>();
-  m_get.reset(request_url, m_data);
-
-  LT_LOG_DUMP(request_url.c_str(), request_url.size(), "tracker scrape", 0);
-  torrent::net_thread::http_stack()->start_get(m_get);
+  m_scraping = true;
+  thread_tracker()->tracker_manager()->send_http_scrape(this, utils::uri_generate_scrape_url(info().url));
 }
 
 void
@@ -231,6 +223,11 @@ TrackerHttp::type() const {
 
 void
 TrackerHttp::close_directly() {
+  if (m_scraping) {
+    thread_tracker()->tracker_manager()->cancel_http_scrape(this);
+    m_scraping = false;
+  }
+
   if (m_data == nullptr) {
     LT_LOG("closing directly (already closed) : state:%s url:%s",
            option_as_string(OPTION_TRACKER_EVENT, state().latest_event()), info().url.c_str());
@@ -291,12 +288,6 @@ TrackerHttp::receive_done() {
 
   // If no failures, set intervals to defaults prior to processing
 
-  if (state().latest_event() == tracker::TrackerState::EVENT_SCRAPE) {
-    m_requested_scrape = false;
-    process_scrape(b);
-    return;
-  }
-
   process_success(b);
 
   if (m_requested_scrape && !is_busy())
@@ -324,12 +315,6 @@ TrackerHttp::receive_failed(const std::string& msg) {
 
   close_directly();
 
-  if (state().latest_event() == tracker::TrackerState::EVENT_SCRAPE) {
-    m_requested_scrape = false;
-    m_slot_scrape_failure(msg);
-    return;
-  }
-
   m_slot_failure(msg);
 
   if (m_requested_scrape && !is_busy())
@@ -415,17 +400,9 @@ TrackerHttp::process_success(const Object& object) {
 }
 
 void
-TrackerHttp::process_scrape(const Object& object) {
-  if (!object.has_key_map("files"))
-    return receive_failed("Tracker scrape does not have files entry.");
-
-  // Add better validation here...
-  const Object& files = object.get_key("files");
-
-  if (!files.has_key_map(info().info_hash.str()))
-    return receive_failed("Tracker scrape replay did not contain infohash.");
-
-  const Object& stats = files.get_key(info().info_hash.str());
+TrackerHttp::receive_scrape(const Object& stats) {
+  m_scraping = false;
+  m_requested_scrape = false;
 
   {
     auto guard = lock_guard();
@@ -439,14 +416,25 @@ TrackerHttp::process_scrape(const Object& object) {
     if (stats.has_key_value("downloaded"))
       state().m_scrape_downloaded = std::max<int64_t>(stats.get_key_value("downloaded"), 0);
 
-    LT_LOG("tracker scrape for %zu torrents : complete:%u incomplete:%u downloaded:%u",
-           files.as_map().size(), state().m_scrape_complete, state().m_scrape_incomplete, state().m_scrape_downloaded);
+    LT_LOG("received scrape : complete:%u incomplete:%u downloaded:%u",
+           state().m_scrape_complete, state().m_scrape_incomplete, state().m_scrape_downloaded);
   }
 
   close_directly();
   m_slot_scrape_success();
 }
 
+void
+TrackerHttp::receive_scrape_failed(const std::string& msg) {
+  LT_LOG("received scrape failure : msg:%s", msg.c_str());
+
+  m_scraping = false;
+  m_requested_scrape = false;
+
+  close_directly();
+  m_slot_scrape_failure(msg);
+}
+
 void
 TrackerHttp::update_tracker_id(const std::string& id) {
   if (id.empty())
@@ -13,7 +13,10 @@
 namespace torrent {
 
 class Http;
+class HttpScraper;
 
+// Scrapes are sent through the HttpScraper owned by tracker::Manager,
+// which combines those for the same scrape url into one request.
 class TrackerHttp : public TrackerWorker {
 public:
   static constexpr uint32_t http_timeout = 60;
@@ -29,6 +32,14 @@ public:
 
   tracker_enum        type() const override;
 
+protected:
+  friend class HttpScraper;
+
+  // Called by the scraper with the tracker's entry in the 'files'
+  // dictionary.
+  void                receive_scrape(const Object& stats);
+  void                receive_scrape_failed(const std::string& msg);
+
 private:
   void                close_directly();
 
@@ -42,7 +53,6 @@ private:
 
   void                process_failure(const Object& object);
   void                process_success(const Object& object);
-  void                process_scrape(const Object& object);
 
   void                update_tracker_id(const std::string& id);
 
@@ -52,7 +62,8 @@ private:
   bool                  m_drop_deliminator;
   std::string           m_current_tracker_id;
 
-  bool                  m_requested_scrape;
+  bool                  m_requested_scrape{false};
+  bool                  m_scraping{false};
   utils::SchedulerEntry m_delay_scrape;
 };
 
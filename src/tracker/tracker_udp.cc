@@ -5,16 +5,18 @@
 #include "tracker_udp.h"
 
 #include <cstdio>
+#include <cstring>
 #include <netdb.h>
 
 #include "manager.h"
 #include "net/address_list.h"
-#include "rak/error_number.h"
 #include "torrent/connection_manager.h"
 #include "torrent/net/resolver.h"
 #include "torrent/net/socket_address.h"
 #include "torrent/utils/log.h"
 #include "torrent/utils/option_strings.h"
+#include "tracker/thread_tracker.h"
+#include "tracker/udp_router.h"
 
 #define LT_LOG(log_fmt, ...)                                            \
   lt_log_print_hash(LOG_TRACKER_REQUESTS, info().info_hash, "tracker_udp", "%p : " log_fmt, static_cast<TrackerWorker*>(this), __VA_ARGS__);
@@ -26,7 +28,9 @@
 namespace torrent {
 
 TrackerUdp::TrackerUdp(const TrackerInfo& info, int flags) :
-  TrackerWorker(info, flags) {
+  TrackerWorker(info, flags | tracker::TrackerState::flag_scrapable),
+  m_read_buffer(std::make_unique<ReadBuffer>()),
+  m_write_buffer(std::make_unique<WriteBuffer>()) {
 
   m_task_timeout.slot() = [this] { receive_timeout(); };
 }
@@ -37,33 +41,67 @@ TrackerUdp::~TrackerUdp() {
 
 bool
 TrackerUdp::is_busy() const {
-  return get_fd().is_valid();
+  return m_transaction_id != 0;
+}
+
+UdpRouter*
+TrackerUdp::router() {
+  return thread_tracker()->udp_router();
 }
 
 void
 TrackerUdp::send_event(tracker::TrackerState::event_enum new_state) {
   LT_LOG("sending event : state:%s url:%s", option_as_string(OPTION_TRACKER_EVENT, new_state), info().url.c_str());
 
-  // TODO: Don't close fd for every new request.
   close_directly();
 
   hostname_type hostname;
+  m_send_state = new_state;
 
   if (!parse_udp_url(info().url, hostname, m_port))
     return receive_failed("could not parse hostname or port");
 
   lock_and_set_latest_event(new_state);
 
-  m_send_state = new_state;
-  m_resolver_requesting = true;
-  m_sending_announce = true;
+  m_sending_request = true;
 
-  LT_LOG("resolving hostname : address:%s", hostname.data());
+  resolve_or_start(hostname);
+}
+
+void
+TrackerUdp::send_scrape() {
+  if (is_busy()) {
+    LT_LOG("scrape requested, but tracker is busy : url:%s", info().url.c_str());
+    return;
+  }
+
+  LT_LOG("sending scrape : url:%s", info().url.c_str());
+
+  close_directly();
+
+  hostname_type hostname;
+  m_send_state = tracker::TrackerState::EVENT_SCRAPE;
 
+  if (!parse_udp_url(info().url, hostname, m_port))
+    return receive_failed("could not parse hostname or port");
+
+  lock_and_set_latest_event(tracker::TrackerState::EVENT_SCRAPE);
+
+  m_sending_request = true;
+
+  resolve_or_start(hostname);
+}
+
+void
+TrackerUdp::resolve_or_start(const hostname_type& hostname) {
   if ((m_inet_address == nullptr && m_inet6_address == nullptr) ||
       (this_thread::cached_time() - m_time_last_resolved) > 24h ||
       m_failed_since_last_resolved > 3) {
 
+    LT_LOG("resolving hostname : address:%s", hostname.data());
+
+    m_resolver_requesting = true;
+
     // Currently discarding SOCK_DGRAM filter.
     this_thread::resolver()->resolve_both(static_cast<TrackerWorker*>(this), hostname.data(), AF_UNSPEC,
                                           [this](c_sin_shared_ptr sin, c_sin6_shared_ptr sin6, int err) {
@@ -72,12 +110,10 @@ TrackerUdp::send_event(tracker::TrackerState::event_enum new_state) {
     return;
   }
 
-  start_announce();
-}
-
-void
-TrackerUdp::send_scrape() {
-  throw internal_error("Tracker type UDP does not support scrape.");
+  if (m_send_state == tracker::TrackerState::EVENT_SCRAPE)
+    start_scrape();
+  else
+    start_announce();
 }
 
 bool
@@ -114,18 +150,14 @@ TrackerUdp::close_directly() {
   this_thread::scheduler()->erase(&m_task_timeout);
 
   m_resolver_requesting = false;
-  m_sending_announce = false;
-
-  m_read_buffer = nullptr;
-  m_write_buffer = nullptr;
+  m_sending_request = false;
+  m_awaiting_connection_id = false;
 
-  if (!get_fd().is_valid())
+  if (m_transaction_id == 0)
     return;
 
-  this_thread::event_remove_and_close(this);
-
-  get_fd().close();
-  get_fd().clear();
+  router()->close_transaction(this);
+  m_transaction_id = 0;
 }
 
 tracker_enum
@@ -138,6 +170,12 @@ TrackerUdp::receive_failed(const std::string& msg) {
   m_failed_since_last_resolved++;
 
   close_directly();
+
+  if (m_send_state == tracker::TrackerState::EVENT_SCRAPE) {
+    m_slot_scrape_failure(msg);
+    return;
+  }
+
   m_slot_failure(msg);
 }
 
@@ -177,7 +215,10 @@ TrackerUdp::receive_resolved(c_sin_shared_ptr& sin, c_sin6_shared_ptr& sin6, int
   m_time_last_resolved = this_thread::cached_time();
   m_failed_since_last_resolved = 0;
 
-  start_announce();
+  if (m_send_state == tracker::TrackerState::EVENT_SCRAPE)
+    start_scrape();
+  else
+    start_announce();
 }
 
 void
@@ -191,15 +232,19 @@ TrackerUdp::receive_timeout() {
   }
 
   this_thread::scheduler()->wait_for_ceil_seconds(&m_task_timeout, std::chrono::seconds(udp_timeout));
-  this_thread::event_insert_write(this);
+
+  if (m_send_state == tracker::TrackerState::EVENT_SCRAPE)
+    router()->request_scrape(this, m_current_address);
+  else
+    send_request();
 }
 
-void
-TrackerUdp::start_announce() {
-  if (!m_sending_announce)
-    throw internal_error("TrackerUdp::start_announce() called but m_sending_announce is false.");
+bool
+TrackerUdp::select_address() {
+  if (!m_sending_request)
+    throw internal_error("TrackerUdp::select_address() called but m_sending_request is false.");
 
-  m_sending_announce = false;
+  m_sending_request = false;
 
   // TODO: Properly select preferred protocol and on failure try the other one.
 
@@ -208,77 +253,122 @@ TrackerUdp::start_announce() {
   else if (m_inet6_address != nullptr)
     m_current_address = reinterpret_cast<sockaddr*>(m_inet6_address.get());
   else
-    throw internal_error("TrackerUdp::start_announce() called but both m_inet_address and m_inet6_address are nullptr.");
+    throw internal_error("TrackerUdp::select_address() called but both m_inet_address and m_inet6_address are nullptr.");
+
+  m_transaction_id = router()->open_transaction(this);
+
+  if (m_transaction_id == 0) {
+    receive_failed("could not open UDP socket");
+    return false;
+  }
+
+  m_tries = udp_tries;
+  this_thread::scheduler()->wait_for_ceil_seconds(&m_task_timeout, std::chrono::seconds(udp_timeout));
+
+  return true;
+}
+
+void
+TrackerUdp::start_announce() {
+  if (!select_address())
+    return;
 
   LT_LOG("starting announce : address:%s", sa_pretty_str(m_current_address).c_str());
 
-  // TODO: Make each of these a separate error... at the very least separate open and bind.
-  if (!get_fd().open_datagram() || !get_fd().set_nonblock()) {
-    LT_LOG("could not open UDP socket", 0);
-    return receive_failed("could not open UDP socket");
+  if (router()->find_connection_id(m_current_address, &m_connection_id)) {
+    LT_LOG("using cached connection id : id:%" PRIx64, m_connection_id);
+    prepare_announce_input();
+  } else {
+    m_awaiting_connection_id = true;
   }
 
-  auto bind_address = rak::socket_address::cast_from(manager->connection_manager()->bind_address());
+  send_request();
+}
+
+// The router sends the scrape together with those of other trackers
+// using the same endpoint, the transaction id is only used to track
+// whether the tracker is busy.
+void
+TrackerUdp::start_scrape() {
+  if (!select_address())
+    return;
 
-  if (bind_address->is_bindable() && !get_fd().bind(*bind_address)) {
-    LT_LOG("failed to bind socket to udp address : address:%s error:'%s'",
-           bind_address->pretty_address_str().c_str(), rak::error_number::current().c_str());
+  LT_LOG("starting scrape : address:%s", sa_pretty_str(m_current_address).c_str());
 
-    return receive_failed("failed to bind socket to udp address '" + bind_address->pretty_address_str() +
-                          "' with error '" + rak::error_number::current().c_str() + "'");
+  router()->request_scrape(this, m_current_address);
+}
+
+void
+TrackerUdp::send_request() {
+  if (m_awaiting_connection_id) {
+    router()->request_connection_id(this, m_current_address);
+    return;
   }
 
-  // TODO: Don't recreate buffers.
-  m_read_buffer = std::make_unique<ReadBuffer>();
-  m_write_buffer = std::make_unique<WriteBuffer>();
+  if (m_write_buffer->size_end() == 0)
+    throw internal_error("TrackerUdp::send_request() called but the write buffer is empty.");
+
+  router()->send(m_current_address, reinterpret_cast<const char*>(m_write_buffer->begin()), m_write_buffer->size_end());
+}
 
-  prepare_connect_input();
+void
+TrackerUdp::receive_connection_id(uint64_t connection_id) {
+  if (!m_awaiting_connection_id)
+    throw internal_error("TrackerUdp::receive_connection_id() called but not waiting for a connection id.");
 
-  // TODO: Add socket counting.
-  this_thread::event_open(this);
-  this_thread::event_insert_read(this);
-  this_thread::event_insert_write(this);
-  this_thread::event_insert_error(this);
+  m_awaiting_connection_id = false;
+  m_connection_id = connection_id;
+
+  prepare_announce_input();
+
+  this_thread::scheduler()->update_wait_for_ceil_seconds(&m_task_timeout, std::chrono::seconds(udp_timeout));
 
   m_tries = udp_tries;
+  send_request();
+}
 
-  this_thread::scheduler()->wait_for_ceil_seconds(&m_task_timeout, std::chrono::seconds(udp_timeout));
+void
+TrackerUdp::receive_connection_failed(const std::string& msg) {
+  receive_failed(msg);
 }
 
 void
-TrackerUdp::event_read() {
-  rak::socket_address sa;
+TrackerUdp::receive_scrape(uint32_t complete, uint32_t downloaded, uint32_t incomplete) {
+  {
+    auto guard = lock_guard();
 
-  int s = read_datagram(m_read_buffer->begin(), m_read_buffer->reserved(), &sa);
+    state().m_scrape_complete   = complete;
+    state().m_scrape_downloaded = downloaded;
+    state().m_scrape_incomplete = incomplete;
+  }
 
-  if (s < 0)
-    return;
+  LT_LOG("received scrape : complete:%" PRIu32 " downloaded:%" PRIu32 " incomplete:%" PRIu32, complete, downloaded, incomplete);
 
-  m_read_buffer->reset_position();
-  m_read_buffer->set_end(s);
+  close_directly();
+  m_slot_scrape_success();
+}
 
-  LT_LOG("received reply : size:%d", s);
-  LT_LOG_DUMP(reinterpret_cast<const char*>(m_read_buffer->begin()), s, "received reply", 0);
+void
+TrackerUdp::receive_scrape_failed(const std::string& msg) {
+  receive_failed(msg);
+}
 
-  if (s < 4)
-    return;
+void
+TrackerUdp::receive_packet(const char* data, uint32_t length) {
+  uint32_t size = std::min<uint32_t>(length, m_read_buffer->reserved());
 
-  // Make sure sa is from the source we expected?
+  std::memcpy(m_read_buffer->begin(), data, size);
 
-  // Do something with the content here.
-  switch (m_read_buffer->read_32()) {
-  case 0:
-    if (m_action != 0 || !process_connect_output())
-      return;
-
-    prepare_announce_input();
+  m_read_buffer->reset_position();
+  m_read_buffer->set_end(size);
 
-    this_thread::scheduler()->update_wait_for_ceil_seconds(&m_task_timeout, std::chrono::seconds(udp_timeout));
+  LT_LOG("received reply : size:%" PRIu32, length);
+  LT_LOG_DUMP(reinterpret_cast<const char*>(m_read_buffer->begin()), size, "received reply", 0);
 
-    m_tries = udp_tries;
-    this_thread::event_insert_write(this);
+  if (size < 4 || m_awaiting_connection_id)
     return;
 
+  switch (m_read_buffer->read_32()) {
   case 1:
     if (m_action != 1 || !process_announce_output())
       return;
@@ -296,37 +386,13 @@ TrackerUdp::event_read() {
   }
 }
 
-void
-TrackerUdp::event_write() {
-  if (m_write_buffer->size_end() == 0)
-    throw internal_error("TrackerUdp::write() called but the write buffer is empty.");
-
-  [[maybe_unused]] int s = write_datagram_sa(m_write_buffer->begin(), m_write_buffer->size_end(), m_current_address);
-
-  this_thread::event_remove_write(this);
-}
-
-void
-TrackerUdp::event_error() {
-}
-
-void
-TrackerUdp::prepare_connect_input() {
-  m_write_buffer->reset();
-  m_write_buffer->write_64(m_connection_id = magic_connection_id);
-  m_write_buffer->write_32(m_action = 0);
-  m_write_buffer->write_32(m_transaction_id = random());
-
-  LT_LOG_DUMP(m_write_buffer->begin(), m_write_buffer->size_end(), "prepare connect (id:%" PRIx32 ")", m_transaction_id);
-}
-
 void
 TrackerUdp::prepare_announce_input() {
   m_write_buffer->reset();
 
   m_write_buffer->write_64(m_connection_id);
   m_write_buffer->write_32(m_action = 1);
-  m_write_buffer->write_32(m_transaction_id = random());
+  m_write_buffer->write_32(m_transaction_id);
 
   m_write_buffer->write_range(info().info_hash.begin(), info().info_hash.end());
   m_write_buffer->write_range(info().local_id.begin(), info().local_id.end());
@@ -359,17 +425,6 @@ TrackerUdp::prepare_announce_input() {
               m_transaction_id, parameters.uploaded_adjusted, parameters.completed_adjusted, parameters.download_left);
 }
 
-bool
-TrackerUdp::process_connect_output() {
-  if (m_read_buffer->size_end() < 16 ||
-      m_read_buffer->read_32() != m_transaction_id)
-    return false;
-
-  m_connection_id = m_read_buffer->read_64();
-
-  return true;
-}
-
 bool
 TrackerUdp::process_announce_output() {
   if (m_read_buffer->size_end() < 20 ||
@@ -408,6 +463,9 @@ TrackerUdp::process_error_output() {
       m_read_buffer->read_32() != m_transaction_id)
     return false;
 
+  // The error may be caused by an expired connection id.
+  router()->erase_connection_id(m_current_address);
+
   receive_failed("received error message: " + std::string(m_read_buffer->position(), m_read_buffer->end()));
   return true;
 }
@@ -5,29 +5,31 @@
 #include <memory>
 
 #include "net/protocol_buffer.h"
-#include "net/socket_datagram.h"
 #include "torrent/net/types.h"
 #include "torrent/utils/scheduler.h"
 #include "tracker/tracker_worker.h"
 
 namespace torrent {
 
-class TrackerUdp : public SocketDatagram, public TrackerWorker {
+class UdpRouter;
+
+// Packets are sent and received through the UdpRouter shared by all
+// UDP trackers, which also caches the connection ids and aggregates
+// scrapes to the same endpoint.
+class TrackerUdp : public TrackerWorker {
 public:
   using hostname_type = std::array<char, 1024>;
 
   using ReadBuffer  = ProtocolBuffer<512>;
   using WriteBuffer = ProtocolBuffer<512>;
 
-  static constexpr uint64_t magic_connection_id = 0x0000041727101980ll;
-
   static constexpr uint32_t udp_timeout = 30;
   static constexpr uint32_t udp_tries = 2;
 
   TrackerUdp(const TrackerInfo& info, int flags = 0);
   ~TrackerUdp() override;
 
-  const char*         type_name() const override { return "tracker_udp"; }
+  const char*         type_name() const { return "tracker_udp"; }
 
   bool                is_busy() const override;
 
@@ -38,30 +40,41 @@ public:
 
   tracker_enum        type() const override;
 
-  void                event_read() override;
-  void                event_write() override;
-  void                event_error() override;
+protected:
+  friend class UdpRouter;
+
+  // Called by the router.
+  void                receive_packet(const char* data, uint32_t length);
+  void                receive_connection_id(uint64_t connection_id);
+  void                receive_connection_failed(const std::string& msg);
+  void                receive_scrape(uint32_t complete, uint32_t downloaded, uint32_t incomplete);
+  void                receive_scrape_failed(const std::string& msg);
 
 private:
+  static UdpRouter*   router();
+
   void                close_directly();
 
   void                receive_failed(const std::string& msg);
   void                receive_resolved(c_sin_shared_ptr& sin, c_sin6_shared_ptr& sin6, int err);
   void                receive_timeout();
 
+  void                resolve_or_start(const hostname_type& hostname);
+  bool                select_address();
+
   void                start_announce();
+  void                start_scrape();
+  void                send_request();
 
-  void                prepare_connect_input();
   void                prepare_announce_input();
 
-  bool                process_connect_output();
   bool                process_announce_output();
   bool                process_error_output();
 
   static bool         parse_udp_url(const std::string& url, hostname_type& hostname, int& port);
 
   bool                m_resolver_requesting{false};
-  bool                m_sending_announce{false};
+  bool                m_sending_request{false};
 
   sockaddr*           m_current_address{nullptr};
   sin_unique_ptr      m_inet_address;
@@ -73,6 +86,7 @@ private:
   uint32_t            m_action{};
   uint64_t            m_connection_id{};
   uint32_t            m_transaction_id{};
+  bool                m_awaiting_connection_id{false};
 
   std::unique_ptr<ReadBuffer>  m_read_buffer;
   std::unique_ptr<WriteBuffer> m_write_buffer;
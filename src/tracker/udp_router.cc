@@ -0,0 +1,515 @@
+#include "config.h"
+
+#include "tracker/udp_router.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "manager.h"
+#include "net/protocol_buffer.h"
+#include "rak/error_number.h"
+#include "rak/socket_address.h"
+#include "torrent/connection_manager.h"
+#include "torrent/exceptions.h"
+#include "torrent/net/socket_address.h"
+#include "torrent/utils/log.h"
+#include "tracker/tracker_udp.h"
+
+#define LT_LOG(log_fmt, ...)                                            \
+  lt_log_print(LOG_TRACKER_REQUESTS, "tracker_udp_router : " log_fmt, __VA_ARGS__);
+
+namespace torrent {
+
+static uint32_t
+read_32(const char* data) {
+  uint32_t value;
+  std::memcpy(&value, data, sizeof(uint32_t));
+  return ntohl(value);
+}
+
+UdpRouter::UdpRouter() {
+  m_task_scrape.slot() = [this] { flush_scrapes(); };
+}
+
+UdpRouter::~UdpRouter() {
+  this_thread::scheduler()->erase(&m_task_scrape);
+
+  if (get_fd().is_valid()) {
+    this_thread::event_remove_and_close(this);
+
+    get_fd().close();
+    get_fd().clear();
+  }
+}
+
+std::string
+UdpRouter::endpoint_key(const sockaddr* sa) {
+  return sa_pretty_str(sa);
+}
+
+uint32_t
+UdpRouter::open_transaction(TrackerUdp* tracker) {
+  if (!get_fd().is_valid() && !open_socket())
+    return 0;
+
+  uint32_t transaction_id = new_transaction_id();
+
+  m_transactions[transaction_id] = tracker;
+  return transaction_id;
+}
+
+void
+UdpRouter::close_transaction(TrackerUdp* tracker) {
+  for (auto itr = m_transactions.begin(); itr != m_transactions.end(); ) {
+    if (itr->second == tracker)
+      itr = m_transactions.erase(itr);
+    else
+      itr++;
+  }
+
+  for (auto itr = m_scrapes.begin(); itr != m_scrapes.end(); ) {
+    auto& pending = itr->second.pending;
+    pending.erase(std::remove(pending.begin(), pending.end(), tracker), pending.end());
+
+    if (pending.empty())
+      itr = m_scrapes.erase(itr);
+    else
+      itr++;
+  }
+
+  for (auto itr = m_scrape_transactions.begin(); itr != m_scrape_transactions.end(); ) {
+    auto& trackers = itr->second.trackers;
+    std::replace(trackers.begin(), trackers.end(), tracker, static_cast<TrackerUdp*>(nullptr));
+
+    if (std::all_of(trackers.begin(), trackers.end(), [](TrackerUdp* t) { return t == nullptr; }))
+      itr = m_scrape_transactions.erase(itr);
+    else
+      itr++;
+  }
+
+  // Connect requests are kept while scrapes to the endpoint wait on
+  // them.
+  for (auto itr = m_connects.begin(); itr != m_connects.end(); ) {
+    auto& waiting = itr->second.waiting;
+    waiting.erase(std::remove(waiting.begin(), waiting.end(), tracker), waiting.end());
+
+    if (waiting.empty() && m_scrapes.find(itr->first) == m_scrapes.end())
+      itr = m_connects.erase(itr);
+    else
+      itr++;
+  }
+
+  close_socket_if_idle();
+}
+
+bool
+UdpRouter::find_connection_id(const sockaddr* sa, uint64_t* connection_id) {
+  auto itr = m_connection_ids.find(endpoint_key(sa));
+
+  if (itr == m_connection_ids.end())
+    return false;
+
+  if (itr->second.expires <= this_thread::cached_time()) {
+    m_connection_ids.erase(itr);
+    return false;
+  }
+
+  *connection_id = itr->second.id;
+  return true;
+}
+
+void
+UdpRouter::erase_connection_id(const sockaddr* sa) {
+  m_connection_ids.erase(endpoint_key(sa));
+}
+
+void
+UdpRouter::request_connection_id(TrackerUdp* tracker, const sockaddr* sa) {
+  if (!get_fd().is_valid())
+    throw internal_error("UdpRouter::request_connection_id(...) called without an open socket.");
+
+  auto itr = find_or_create_connect(sa);
+
+  if (std::find(itr->second.waiting.begin(), itr->second.waiting.end(), tracker) == itr->second.waiting.end())
+    itr->second.waiting.push_back(tracker);
+
+  send_connect(itr->second);
+}
+
+// Calling it again for a tracker already in a scrape transaction, e.g.
+// on timeout, moves it back to the pending list.
+void
+UdpRouter::request_scrape(TrackerUdp* tracker, const sockaddr* sa) {
+  if (!get_fd().is_valid())
+    throw internal_error("UdpRouter::request_scrape(...) called without an open socket.");
+
+  for (auto& transaction : m_scrape_transactions)
+    std::replace(transaction.second.trackers.begin(), transaction.second.trackers.end(), tracker, static_cast<TrackerUdp*>(nullptr));
+
+  auto itr = m_scrapes.find(endpoint_key(sa));
+
+  if (itr == m_scrapes.end()) {
+    itr = m_scrapes.emplace(endpoint_key(sa), scrape_endpoint{}).first;
+    std::memcpy(&itr->second.address, sa, sa_length(sa));
+  }
+
+  if (std::find(itr->second.pending.begin(), itr->second.pending.end(), tracker) == itr->second.pending.end())
+    itr->second.pending.push_back(tracker);
+
+  if (!m_task_scrape.is_scheduled())
+    this_thread::scheduler()->wait_for(&m_task_scrape, scrape_delay);
+}
+
+void
+UdpRouter::send(const sockaddr* sa, const char* data, uint32_t length) {
+  if (!get_fd().is_valid())
+    throw internal_error("UdpRouter::send(...) called without an open socket.");
+
+  if (length == 0)
+    throw internal_error("UdpRouter::send(...) called with an empty packet.");
+
+  m_queue.emplace_back();
+  std::memcpy(&m_queue.back().address, sa, sa_length(sa));
+  m_queue.back().data.assign(data, length);
+
+  this_thread::event_insert_write(this);
+}
+
+UdpRouter::connect_map::iterator
+UdpRouter::find_or_create_connect(const sockaddr* sa) {
+  auto itr = m_connects.find(endpoint_key(sa));
+
+  if (itr == m_connects.end()) {
+    itr = m_connects.emplace(endpoint_key(sa), connect_request{new_transaction_id(), sockaddr_storage{}, {}}).first;
+    std::memcpy(&itr->second.address, sa, sa_length(sa));
+
+    LT_LOG("sending connect : address:%s id:%" PRIx32, itr->first.c_str(), itr->second.transaction_id);
+
+  } else {
+    LT_LOG("resending connect : address:%s id:%" PRIx32 " waiting:%zu", itr->first.c_str(), itr->second.transaction_id, itr->second.waiting.size());
+  }
+
+  return itr;
+}
+
+void
+UdpRouter::send_connect(const connect_request& request) {
+  ProtocolBuffer<16> buffer;
+
+  buffer.reset();
+  buffer.write_64(magic_connection_id);
+  buffer.write_32(action_connect);
+  buffer.write_32(request.transaction_id);
+
+  send(reinterpret_cast<const sockaddr*>(&request.address), reinterpret_cast<const char*>(buffer.begin()), buffer.size_end());
+}
+
+bool
+UdpRouter::open_socket() {
+  if (!get_fd().open_datagram() || !get_fd().set_nonblock()) {
+    LT_LOG("could not open UDP socket : error:'%s'", rak::error_number::current().c_str());
+
+    get_fd().close();
+    get_fd().clear();
+    return false;
+  }
+
+  auto bind_address = rak::socket_address::cast_from(manager->connection_manager()->bind_address());
+
+  if (bind_address->is_bindable() && !get_fd().bind(*bind_address)) {
+    LT_LOG("failed to bind socket to udp address : address:%s error:'%s'",
+           bind_address->pretty_address_str().c_str(), rak::error_number::current().c_str());
+
+    get_fd().close();
+    get_fd().clear();
+    return false;
+  }
+
+  LT_LOG("opened socket : fd:%i", get_fd().get_fd());
+
+  this_thread::event_open(this);
+  this_thread::event_insert_read(this);
+  this_thread::event_insert_error(this);
+
+  return true;
+}
+
+void
+UdpRouter::close_socket_if_idle() {
+  if (!m_transactions.empty() || !m_connects.empty() || !m_scrapes.empty() || !get_fd().is_valid())
+    return;
+
+  LT_LOG("closing idle socket : fd:%i", get_fd().get_fd());
+
+  this_thread::scheduler()->erase(&m_task_scrape);
+  this_thread::event_remove_and_close(this);
+
+  get_fd().close();
+  get_fd().clear();
+
+  m_queue.clear();
+}
+
+uint32_t
+UdpRouter::new_transaction_id() const {
+  while (true) {
+    uint32_t transaction_id = ::random();
+
+    if (transaction_id == 0 || m_transactions.find(transaction_id) != m_transactions.end())
+      continue;
+
+    if (std::any_of(m_connects.begin(), m_connects.end(), [transaction_id](auto& c) { return c.second.transaction_id == transaction_id; }))
+      continue;
+
+    if (m_scrape_transactions.find(transaction_id) != m_scrape_transactions.end())
+      continue;
+
+    return transaction_id;
+  }
+}
+
+void
+UdpRouter::event_read() {
+  while (get_fd().is_valid()) {
+    int count = read_datagrams(m_read_batch);
+
+    if (count <= 0)
+      break;
+
+    for (int i = 0; i != count; i++)
+      process_datagram(m_read_batch.data(i), m_read_batch.length(i));
+
+    if (static_cast<unsigned int>(count) != m_read_batch.capacity())
+      break;
+  }
+}
+
+// Trackers may close their transaction while handling a reply, which
+// may in turn close the socket.
+void
+UdpRouter::process_datagram(const char* data, uint32_t length) {
+  if (length < 8)
+    return;
+
+  uint32_t action = read_32(data);
+  uint32_t transaction_id = read_32(data + 4);
+
+  auto connect_itr = std::find_if(m_connects.begin(), m_connects.end(),
+                                  [transaction_id](auto& c) { return c.second.transaction_id == transaction_id; });
+
+  if (connect_itr != m_connects.end()) {
+    process_connect_reply(connect_itr, data, length);
+    return;
+  }
+
+  if (m_scrape_transactions.find(transaction_id) != m_scrape_transactions.end()) {
+    process_scrape_reply(transaction_id, data, length);
+    return;
+  }
+
+  auto itr = m_transactions.find(transaction_id);
+
+  if (itr == m_transactions.end()) {
+    LT_LOG("received reply for unknown transaction : action:%" PRIu32 " id:%" PRIx32 " size:%" PRIu32, action, transaction_id, length);
+    return;
+  }
+
+  itr->second->receive_packet(data, length);
+}
+
+void
+UdpRouter::process_connect_reply(connect_map::iterator itr, const char* data, uint32_t length) {
+  std::string key = itr->first;
+  std::vector<TrackerUdp*> waiting;
+  waiting.swap(itr->second.waiting);
+
+  m_connects.erase(itr);
+
+  uint32_t action = read_32(data);
+  uint64_t connection_id = 0;
+  std::string msg;
+
+  if (action == action_connect && length >= 16) {
+    for (int i = 8; i != 16; i++)
+      connection_id = (connection_id << 8) | static_cast<uint8_t>(data[i]);
+
+    m_connection_ids[key] = connection_id_type{connection_id, this_thread::cached_time() + connection_id_lifetime};
+
+    LT_LOG("received connection id : address:%s waiting:%zu", key.c_str(), waiting.size());
+
+    for (auto tracker : waiting)
+      tracker->receive_connection_id(connection_id);
+
+  } else {
+    msg = action == action_error ? "received error message: " + std::string(data + 8, data + length) : "invalid connect reply";
+
+    LT_LOG("connect failed : address:%s waiting:%zu", key.c_str(), waiting.size());
+
+    for (auto tracker : waiting)
+      tracker->receive_connection_failed(msg);
+  }
+
+  auto scrape_itr = m_scrapes.find(key);
+
+  if (scrape_itr != m_scrapes.end() && scrape_itr->second.connecting) {
+    if (msg.empty())
+      send_scrapes(scrape_itr, connection_id);
+    else
+      fail_scrapes(scrape_itr, msg);
+  }
+
+  close_socket_if_idle();
+}
+
+void
+UdpRouter::process_scrape_reply(uint32_t transaction_id, const char* data, uint32_t length) {
+  auto itr = m_scrape_transactions.find(transaction_id);
+  auto transaction = std::move(itr->second);
+
+  m_scrape_transactions.erase(itr);
+
+  uint32_t action = read_32(data);
+
+  if (action != action_scrape) {
+    std::string msg = action == action_error ? "received error message: " + std::string(data + 8, data + length) : "invalid scrape reply";
+
+    LT_LOG("scrape failed : address:%s trackers:%zu",
+           sa_pretty_str(reinterpret_cast<sockaddr*>(&transaction.address)).c_str(), transaction.trackers.size());
+
+    // The error may be caused by an expired connection id.
+    erase_connection_id(reinterpret_cast<sockaddr*>(&transaction.address));
+
+    for (auto tracker : transaction.trackers)
+      if (tracker != nullptr)
+        tracker->receive_scrape_failed(msg);
+
+    return;
+  }
+
+  LT_LOG("received scrape : address:%s trackers:%zu size:%" PRIu32,
+         sa_pretty_str(reinterpret_cast<sockaddr*>(&transaction.address)).c_str(), transaction.trackers.size(), length);
+
+  // Each info hash has seeders, completed and leechers, in the order
+  // they were requested.
+  for (size_t i = 0; i != transaction.trackers.size(); i++) {
+    TrackerUdp* tracker = transaction.trackers[i];
+
+    if (tracker == nullptr)
+      continue;
+
+    const char* entry = data + 8 + 12 * i;
+
+    if (entry + 12 > data + length) {
+      tracker->receive_scrape_failed("truncated scrape reply");
+      continue;
+    }
+
+    tracker->receive_scrape(read_32(entry), read_32(entry + 4), read_32(entry + 8));
+  }
+}
+
+// Requests a connection id for endpoints without a cached one, the
+// scrapes are sent when the connect reply arrives.
+void
+UdpRouter::flush_scrapes() {
+  std::vector<std::string> keys;
+
+  for (auto& scrape : m_scrapes)
+    keys.push_back(scrape.first);
+
+  for (auto& key : keys) {
+    auto itr = m_scrapes.find(key);
+
+    if (itr == m_scrapes.end())
+      continue;
+
+    auto address = reinterpret_cast<const sockaddr*>(&itr->second.address);
+    uint64_t connection_id;
+
+    if (find_connection_id(address, &connection_id)) {
+      send_scrapes(itr, connection_id);
+      continue;
+    }
+
+    itr->second.connecting = true;
+    send_connect(find_or_create_connect(address)->second);
+  }
+}
+
+void
+UdpRouter::send_scrapes(scrape_map::iterator itr, uint64_t connection_id) {
+  auto endpoint = std::move(itr->second);
+  m_scrapes.erase(itr);
+
+  auto address = reinterpret_cast<const sockaddr*>(&endpoint.address);
+
+  for (auto first = endpoint.pending.begin(); first != endpoint.pending.end(); ) {
+    auto last = first + std::min<size_t>(max_scrape_hashes, std::distance(first, endpoint.pending.end()));
+
+    uint32_t transaction_id = new_transaction_id();
+    ProtocolBuffer<16 + 20 * max_scrape_hashes> buffer;
+
+    buffer.reset();
+    buffer.write_64(connection_id);
+    buffer.write_32(action_scrape);
+    buffer.write_32(transaction_id);
+
+    for (auto tracker_itr = first; tracker_itr != last; tracker_itr++)
+      buffer.write_range((*tracker_itr)->info().info_hash.begin(), (*tracker_itr)->info().info_hash.end());
+
+    auto& transaction = m_scrape_transactions[transaction_id];
+    std::memcpy(&transaction.address, address, sa_length(address));
+    transaction.trackers.assign(first, last);
+
+    LT_LOG("sending scrape : address:%s id:%" PRIx32 " hashes:%zu",
+           sa_pretty_str(address).c_str(), transaction_id, transaction.trackers.size());
+
+    send(address, reinterpret_cast<const char*>(buffer.begin()), buffer.size_end());
+
+    first = last;
+  }
+}
+
+void
+UdpRouter::fail_scrapes(scrape_map::iterator itr, const std::string& msg) {
+  std::vector<TrackerUdp*> pending;
+  pending.swap(itr->second.pending);
+
+  m_scrapes.erase(itr);
+
+  for (auto tracker : pending)
+    tracker->receive_scrape_failed(msg);
+}
+
+// Unsent packets are kept if the socket would block, other errors
+// drop the packet and leave it to the tracker's timeout.
+void
+UdpRouter::event_write() {
+  while (!m_queue.empty()) {
+    m_write_batch.clear();
+
+    for (auto itr = m_queue.begin(); itr != m_queue.end() && !m_write_batch.full(); itr++)
+      m_write_batch.push_back(itr->data.data(), itr->data.size(), reinterpret_cast<sockaddr*>(&itr->address));
+
+    int count = write_datagrams(m_write_batch);
+
+    if (count < 0) {
+      if (rak::error_number::current().is_blocked_momentary())
+        return;
+
+      LT_LOG("could not send packet : error:'%s'", rak::error_number::current().c_str());
+      count = 1;
+    }
+
+    m_queue.erase(m_queue.begin(), m_queue.begin() + count);
+  }
+
+  this_thread::event_remove_write(this);
+}
+
+void
+UdpRouter::event_error() {
+}
+
+} // namespace torrent
@@ -0,0 +1,159 @@
+#ifndef LIBTORRENT_TRACKER_UDP_ROUTER_H
+#define LIBTORRENT_TRACKER_UDP_ROUTER_H
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+
+#include "net/datagram_batch.h"
+#include "net/socket_datagram.h"
+#include "torrent/utils/scheduler.h"
+
+namespace torrent {
+
+class TrackerUdp;
+
+// Shares a single UDP socket between all UDP tracker workers, with
+// replies dispatched to the worker owning the transaction id.
+//
+// Connection ids are cached per tracker endpoint for the one minute
+// BEP 15 allows, and connect requests to the same endpoint made while
+// one is in flight wait for its reply instead of sending their own.
+// Outgoing packets are queued and written back-to-back when the
+// socket becomes writable, so requests made in the same poll
+// iteration go out together.
+//
+// Scrapes are collected for 'scrape_delay' and sent as BEP 15
+// multi-infohash scrapes, one per 'max_scrape_hashes' trackers with
+// the same endpoint.
+//
+// The socket is opened on demand and closed when no transactions are
+// left. Owned by ThreadTracker, but like the UDP tracker workers it is
+// currently driven from the main thread.
+
+class UdpRouter : public SocketDatagram {
+public:
+  static constexpr std::chrono::seconds connection_id_lifetime{60};
+
+  static constexpr uint64_t magic_connection_id = 0x0000041727101980ll;
+
+  static constexpr uint32_t action_connect  = 0;
+  static constexpr uint32_t action_announce = 1;
+  static constexpr uint32_t action_scrape   = 2;
+  static constexpr uint32_t action_error    = 3;
+
+  static constexpr unsigned int max_scrape_hashes = 74;
+  static constexpr std::chrono::seconds scrape_delay{1};
+
+  static constexpr unsigned int batch_size       = 32;
+  static constexpr uint32_t     read_buffer_size = 2048;
+
+  UdpRouter();
+  ~UdpRouter() override;
+
+  const char*         type_name() const override { return "tracker_udp_router"; }
+
+  // Returns a transaction id unique among those in flight, or zero if
+  // the socket could not be opened.
+  uint32_t            open_transaction(TrackerUdp* tracker);
+
+  // Closes the tracker's transaction and stops any connect requests
+  // it is waiting on.
+  void                close_transaction(TrackerUdp* tracker);
+
+  bool                find_connection_id(const sockaddr* sa, uint64_t* connection_id);
+  void                erase_connection_id(const sockaddr* sa);
+
+  // The result is passed to 'TrackerUdp::receive_connection_id' or
+  // 'TrackerUdp::receive_connection_failed'. Calling it again while
+  // waiting resends the connect request.
+  void                request_connection_id(TrackerUdp* tracker, const sockaddr* sa);
+
+  // The result is passed to 'TrackerUdp::receive_scrape' or
+  // 'TrackerUdp::receive_scrape_failed'. The tracker must have an open
+  // transaction.
+  void                request_scrape(TrackerUdp* tracker, const sockaddr* sa);
+
+  // The data is copied.
+  void                send(const sockaddr* sa, const char* data, uint32_t length);
+
+  unsigned int        transaction_size() const           { return m_transactions.size(); }
+  unsigned int        cached_connection_size() const     { return m_connection_ids.size(); }
+  unsigned int        queued_size() const                { return m_queue.size(); }
+  unsigned int        scrape_transaction_size() const    { return m_scrape_transactions.size(); }
+
+  void                event_read() override;
+  void                event_write() override;
+  void                event_error() override;
+
+private:
+  struct connection_id_type {
+    uint64_t                  id;
+    std::chrono::microseconds expires;
+  };
+
+  struct connect_request {
+    uint32_t                  transaction_id;
+    sockaddr_storage          address;
+    std::vector<TrackerUdp*>  waiting;
+  };
+
+  struct scrape_endpoint {
+    sockaddr_storage          address;
+    std::vector<TrackerUdp*>  pending;
+    bool                      connecting{false};
+  };
+
+  // Trackers are kept in the order of their info hashes in the
+  // request, closed trackers are replaced by nullptr.
+  struct scrape_transaction {
+    sockaddr_storage          address;
+    std::vector<TrackerUdp*>  trackers;
+  };
+
+  using connect_map = std::map<std::string, connect_request>;
+  using scrape_map  = std::map<std::string, scrape_endpoint>;
+
+  struct queued_packet {
+    sockaddr_storage          address;
+    std::string               data;
+  };
+
+  static std::string  endpoint_key(const sockaddr* sa);
+
+  bool                open_socket();
+  void                close_socket_if_idle();
+
+  uint32_t            new_transaction_id() const;
+
+  void                process_datagram(const char* data, uint32_t length);
+  void                process_connect_reply(connect_map::iterator itr, const char* data, uint32_t length);
+  void                process_scrape_reply(uint32_t transaction_id, const char* data, uint32_t length);
+
+  connect_map::iterator find_or_create_connect(const sockaddr* sa);
+  void                send_connect(const connect_request& request);
+
+  void                flush_scrapes();
+  void                send_scrapes(scrape_map::iterator itr, uint64_t connection_id);
+  void                fail_scrapes(scrape_map::iterator itr, const std::string& msg);
+
+  std::map<uint32_t, TrackerUdp*>          m_transactions;
+  connect_map                              m_connects;
+  std::map<std::string, connection_id_type> m_connection_ids;
+
+  scrape_map                                   m_scrapes;
+  std::map<uint32_t, scrape_transaction>       m_scrape_transactions;
+  utils::SchedulerEntry                        m_task_scrape;
+
+  std::deque<queued_packet>                m_queue;
+
+  DatagramBatch                            m_read_batch{batch_size, read_buffer_size};
+  DatagramBatch                            m_write_batch{batch_size, 0};
+};
+
+} // namespace torrent
+
+#endif
@@ -0,0 +1,248 @@
+#include "config.h"
+
+#include "utils/bitfield_ops.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "torrent/exceptions.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define LT_BITFIELD_OPS_X86 1
+#endif
+
+namespace torrent {
+
+namespace {
+
+// Loads up to 8 bytes as a big endian word, so that bit order matches
+// Bitfield and '__builtin_clzll' gives the bit offset.
+[[gnu::always_inline]] inline uint64_t
+load_be64(const uint8_t* p, size_t length = 8) {
+  uint64_t v = 0;
+  std::memcpy(&v, p, std::min<size_t>(length, 8));
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  return __builtin_bswap64(v);
+#else
+  return v;
+#endif
+}
+
+struct op_first  { uint64_t operator()(uint64_t a, uint64_t)   const { return a; } };
+struct op_and    { uint64_t operator()(uint64_t a, uint64_t b) const { return a & b; } };
+struct op_andnot { uint64_t operator()(uint64_t a, uint64_t b) const { return a & ~b; } };
+
+// The scalar kernels are forced inline so each engine gets a copy
+// compiled for its target.
+template <typename Op>
+[[gnu::always_inline]] inline uint32_t
+count_words(const uint8_t* a, const uint8_t* b, size_t length, size_t first = 0) {
+  uint32_t count = 0;
+  size_t i = first;
+
+  for (; i + 8 <= length; i += 8)
+    count += __builtin_popcountll(Op()(load_be64(a + i), load_be64(b + i)));
+
+  if (i < length)
+    count += __builtin_popcountll(Op()(load_be64(a + i, length - i), load_be64(b + i, length - i)));
+
+  return count;
+}
+
+template <typename Op>
+[[gnu::always_inline]] inline bool
+any_words(const uint8_t* a, const uint8_t* b, size_t length, size_t first = 0) {
+  size_t i = first;
+
+  for (; i + 8 <= length; i += 8)
+    if (Op()(load_be64(a + i), load_be64(b + i)))
+      return true;
+
+  return i < length && Op()(load_be64(a + i, length - i), load_be64(b + i, length - i));
+}
+
+[[gnu::always_inline]] inline uint32_t
+find_next_and_words(const uint8_t* a, const uint8_t* b, uint32_t first, uint32_t last) {
+  if (first >= last)
+    return last;
+
+  size_t   last_byte = (static_cast<size_t>(last) + 7) / 8;
+  size_t   byte = first / 8;
+  uint64_t mask = ~uint64_t() >> (first % 8);
+
+  while (byte < last_byte) {
+    size_t   length = last_byte - byte;
+    uint64_t word = load_be64(a + byte, length) & load_be64(b + byte, length) & mask;
+
+    if (word != 0)
+      return std::min<uint32_t>(byte * 8 + __builtin_clzll(word), last);
+
+    byte += 8;
+    mask = ~uint64_t();
+  }
+
+  return last;
+}
+
+uint32_t popcount_scalar(const uint8_t* a, size_t length)                        { return count_words<op_first>(a, a, length); }
+uint32_t count_and_scalar(const uint8_t* a, const uint8_t* b, size_t length)     { return count_words<op_and>(a, b, length); }
+uint32_t count_andnot_scalar(const uint8_t* a, const uint8_t* b, size_t length)  { return count_words<op_andnot>(a, b, length); }
+bool     any_and_scalar(const uint8_t* a, const uint8_t* b, size_t length)       { return any_words<op_and>(a, b, length); }
+bool     any_andnot_scalar(const uint8_t* a, const uint8_t* b, size_t length)    { return any_words<op_andnot>(a, b, length); }
+
+uint32_t find_next_and_scalar(const uint8_t* a, const uint8_t* b, uint32_t first, uint32_t last) {
+  return find_next_and_words(a, b, first, last);
+}
+
+#ifdef LT_BITFIELD_OPS_X86
+
+[[gnu::target("popcnt")]] uint32_t popcount_popcnt(const uint8_t* a, size_t length)                       { return count_words<op_first>(a, a, length); }
+[[gnu::target("popcnt")]] uint32_t count_and_popcnt(const uint8_t* a, const uint8_t* b, size_t length)    { return count_words<op_and>(a, b, length); }
+[[gnu::target("popcnt")]] uint32_t count_andnot_popcnt(const uint8_t* a, const uint8_t* b, size_t length) { return count_words<op_andnot>(a, b, length); }
+
+struct avx2_first  { [[gnu::target("avx2")]] __m256i operator()(__m256i a, __m256i)   const { return a; } };
+struct avx2_and    { [[gnu::target("avx2")]] __m256i operator()(__m256i a, __m256i b) const { return _mm256_and_si256(a, b); } };
+struct avx2_andnot { [[gnu::target("avx2")]] __m256i operator()(__m256i a, __m256i b) const { return _mm256_andnot_si256(b, a); } };
+
+[[gnu::target("avx2")]] inline __m256i
+avx2_load(const uint8_t* p) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+// Counts bytes with a nibble lookup table and sums them with 'sad',
+// see Mula, Kurz and Lemire, "Faster Population Counts Using AVX2
+// Instructions".
+template <typename VectorOp, typename Op>
+[[gnu::target("avx2,popcnt")]] uint32_t
+count_avx2(const uint8_t* a, const uint8_t* b, size_t length) {
+  const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                          0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low_mask = _mm256_set1_epi8(0x0f);
+
+  __m256i total = _mm256_setzero_si256();
+  size_t i = 0;
+
+  for (; i + 32 <= length; i += 32) {
+    __m256i v  = VectorOp()(avx2_load(a + i), avx2_load(b + i));
+    __m256i lo = _mm256_and_si256(v, low_mask);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+
+    __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+    total = _mm256_add_epi64(total, _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+  }
+
+  uint32_t count = _mm256_extract_epi64(total, 0) + _mm256_extract_epi64(total, 1) +
+                   _mm256_extract_epi64(total, 2) + _mm256_extract_epi64(total, 3);
+
+  return count + count_words<Op>(a, b, length, i);
+}
+
+template <typename VectorOp, typename Op>
+[[gnu::target("avx2,popcnt")]] bool
+any_avx2(const uint8_t* a, const uint8_t* b, size_t length) {
+  size_t i = 0;
+
+  for (; i + 32 <= length; i += 32) {
+    __m256i v = VectorOp()(avx2_load(a + i), avx2_load(b + i));
+
+    if (!_mm256_testz_si256(v, v))
+      return true;
+  }
+
+  return any_words<Op>(a, b, length, i);
+}
+
+[[gnu::target("avx2,popcnt")]] uint32_t popcount_avx2(const uint8_t* a, size_t length)                       { return count_avx2<avx2_first, op_first>(a, a, length); }
+[[gnu::target("avx2,popcnt")]] uint32_t count_and_avx2(const uint8_t* a, const uint8_t* b, size_t length)    { return count_avx2<avx2_and, op_and>(a, b, length); }
+[[gnu::target("avx2,popcnt")]] uint32_t count_andnot_avx2(const uint8_t* a, const uint8_t* b, size_t length) { return count_avx2<avx2_andnot, op_andnot>(a, b, length); }
+[[gnu::target("avx2,popcnt")]] bool     any_and_avx2(const uint8_t* a, const uint8_t* b, size_t length)      { return any_avx2<avx2_and, op_and>(a, b, length); }
+[[gnu::target("avx2,popcnt")]] bool     any_andnot_avx2(const uint8_t* a, const uint8_t* b, size_t length)   { return any_avx2<avx2_andnot, op_andnot>(a, b, length); }
+
+// Skips 32 byte blocks without any bits in common, the word holding
+// 'first' and the block with a match are searched word by word.
+[[gnu::target("avx2,popcnt")]] uint32_t
+find_next_and_avx2(const uint8_t* a, const uint8_t* b, uint32_t first, uint32_t last) {
+  uint32_t word_end = std::min<uint64_t>(last, (static_cast<uint64_t>(first) / 8 + 8) * 8);
+  uint32_t result = find_next_and_words(a, b, first, word_end);
+
+  if (result != word_end || word_end == last)
+    return result;
+
+  size_t byte = word_end / 8;
+  size_t full_bytes = last / 8;
+
+  while (byte + 32 <= full_bytes && _mm256_testz_si256(avx2_load(a + byte), avx2_load(b + byte)))
+    byte += 32;
+
+  return find_next_and_words(a, b, byte * 8, last);
+}
+
+#endif
+
+const bitfield_ops ops_scalar = {
+  bitfield_ops::ENGINE_SCALAR, "scalar",
+  &popcount_scalar, &count_and_scalar, &count_andnot_scalar, &any_and_scalar, &any_andnot_scalar, &find_next_and_scalar
+};
+
+#ifdef LT_BITFIELD_OPS_X86
+const bitfield_ops ops_popcnt = {
+  bitfield_ops::ENGINE_POPCNT, "popcnt",
+  &popcount_popcnt, &count_and_popcnt, &count_andnot_popcnt, &any_and_scalar, &any_andnot_scalar, &find_next_and_scalar
+};
+
+const bitfield_ops ops_avx2 = {
+  bitfield_ops::ENGINE_AVX2, "avx2",
+  &popcount_avx2, &count_and_avx2, &count_andnot_avx2, &any_and_avx2, &any_andnot_avx2, &find_next_and_avx2
+};
+#endif
+
+} // namespace
+
+const bitfield_ops*
+bitfield_ops::get() {
+  static const bitfield_ops* ops = [] {
+      if (is_engine_supported(ENGINE_AVX2))
+        return get(ENGINE_AVX2);
+
+      if (is_engine_supported(ENGINE_POPCNT))
+        return get(ENGINE_POPCNT);
+
+      return get(ENGINE_SCALAR);
+    }();
+
+  return ops;
+}
+
+const bitfield_ops*
+bitfield_ops::get(engine_type engine) {
+  if (!is_engine_supported(engine))
+    throw internal_error("bitfield_ops::get(...) engine not supported by this cpu.");
+
+  switch (engine) {
+#ifdef LT_BITFIELD_OPS_X86
+  case ENGINE_POPCNT: return &ops_popcnt;
+  case ENGINE_AVX2:   return &ops_avx2;
+#endif
+  default:            return &ops_scalar;
+  }
+}
+
+bool
+bitfield_ops::is_engine_supported(engine_type engine) {
+  switch (engine) {
+  case ENGINE_SCALAR:
+    return true;
+#ifdef LT_BITFIELD_OPS_X86
+  case ENGINE_POPCNT:
+    return __builtin_cpu_supports("popcnt");
+  case ENGINE_AVX2:
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+#endif
+  default:
+    return false;
+  }
+}
+
+} // namespace torrent
@@ -0,0 +1,78 @@
+#ifndef LIBTORRENT_UTILS_BITFIELD_OPS_H
+#define LIBTORRENT_UTILS_BITFIELD_OPS_H
+
+#include <cinttypes>
+#include <cstddef>
+
+namespace torrent {
+
+// Kernels over raw bitfield data in Bitfield's bit order, where bit 0
+// is the most significant bit of the first byte. Lengths are in bytes
+// and bits past the end of a Bitfield are always cleared, so whole
+// bytes may be used.
+//
+// The engine is chosen once at runtime, AVX2 when supported and
+// otherwise 64 bit words with the popcnt instruction if available.
+
+struct bitfield_ops {
+  enum engine_type {
+    ENGINE_SCALAR,
+    ENGINE_POPCNT,
+    ENGINE_AVX2,
+  };
+
+  engine_type engine;
+  const char* name;
+
+  uint32_t (*popcount)(const uint8_t* a, size_t length);
+
+  // Bits set in 'a & b' and 'a & ~b'.
+  uint32_t (*count_and)(const uint8_t* a, const uint8_t* b, size_t length);
+  uint32_t (*count_andnot)(const uint8_t* a, const uint8_t* b, size_t length);
+
+  bool     (*any_and)(const uint8_t* a, const uint8_t* b, size_t length);
+  bool     (*any_andnot)(const uint8_t* a, const uint8_t* b, size_t length);
+
+  // Returns the first bit index in [first, last) set in 'a & b', or
+  // 'last' if there is none.
+  uint32_t (*find_next_and)(const uint8_t* a, const uint8_t* b, uint32_t first, uint32_t last);
+
+  static const bitfield_ops* get();
+  static const bitfield_ops* get(engine_type engine);
+
+  static bool                is_engine_supported(engine_type engine);
+};
+
+inline uint32_t
+bitfield_popcount(const uint8_t* a, size_t length) {
+  return bitfield_ops::get()->popcount(a, length);
+}
+
+inline uint32_t
+bitfield_count_and(const uint8_t* a, const uint8_t* b, size_t length) {
+  return bitfield_ops::get()->count_and(a, b, length);
+}
+
+inline uint32_t
+bitfield_count_andnot(const uint8_t* a, const uint8_t* b, size_t length) {
+  return bitfield_ops::get()->count_andnot(a, b, length);
+}
+
+inline bool
+bitfield_any_and(const uint8_t* a, const uint8_t* b, size_t length) {
+  return bitfield_ops::get()->any_and(a, b, length);
+}
+
+inline bool
+bitfield_any_andnot(const uint8_t* a, const uint8_t* b, size_t length) {
+  return bitfield_ops::get()->any_andnot(a, b, length);
+}
+
+inline uint32_t
+bitfield_find_next_and(const uint8_t* a, const uint8_t* b, uint32_t first, uint32_t last) {
+  return bitfield_ops::get()->find_next_and(a, b, first, last);
+}
+
+} // namespace torrent
+
+#endif
@@ -0,0 +1,103 @@
+#include "config.h"
+
+#include "buffer_pool.h"
+
+#include "torrent/exceptions.h"
+#include "utils/instrumentation.h"
+
+namespace torrent {
+
+BufferPool::~BufferPool() {
+  clear();
+}
+
+BufferPool*
+BufferPool::thread_pool() {
+  static thread_local BufferPool pool;
+  return &pool;
+}
+
+unsigned int
+BufferPool::size_class(size_t size) {
+  if (size > max_size + header_size)
+    throw internal_error("BufferPool::size_class(...) size too large.");
+
+  unsigned int result = 0;
+
+  while (class_size(result) < size)
+    result++;
+
+  return result;
+}
+
+char*
+BufferPool::allocate(size_t size) {
+  unsigned int index = size_class(size);
+  size_t bytes = class_size(index);
+
+  instrumentation_update(INSTRUMENTATION_MEMORY_PROTOCOL_BUFFER_USAGE, bytes);
+  instrumentation_update(INSTRUMENTATION_MEMORY_PROTOCOL_BUFFER_COUNT, 1);
+
+  if (m_free[index].empty())
+    return new char[bytes];
+
+  char* buffer = m_free[index].back();
+  m_free[index].pop_back();
+
+  instrumentation_update(INSTRUMENTATION_MEMORY_PROTOCOL_BUFFER_POOLED, -static_cast<int64_t>(bytes));
+  return buffer;
+}
+
+void
+BufferPool::release(char* buffer, size_t size) {
+  if (buffer == nullptr)
+    return;
+
+  unsigned int index = size_class(size);
+  size_t bytes = class_size(index);
+
+  instrumentation_update(INSTRUMENTATION_MEMORY_PROTOCOL_BUFFER_USAGE, -static_cast<int64_t>(bytes));
+  instrumentation_update(INSTRUMENTATION_MEMORY_PROTOCOL_BUFFER_COUNT, -1);
+
+  if ((m_free[index].size() + 1) * bytes > max_cached_bytes) {
+    delete [] buffer;
+    return;
+  }
+
+  m_free[index].push_back(buffer);
+  instrumentation_update(INSTRUMENTATION_MEMORY_PROTOCOL_BUFFER_POOLED, bytes);
+}
+
+void
+BufferPool::clear() {
+  for (unsigned int index = 0; index < class_count; index++) {
+    instrumentation_update(INSTRUMENTATION_MEMORY_PROTOCOL_BUFFER_POOLED, -static_cast<int64_t>(m_free[index].size() * class_size(index)));
+
+    for (auto buffer : m_free[index])
+      delete [] buffer;
+
+    m_free[index].clear();
+  }
+}
+
+size_t
+BufferPool::cached_size() const {
+  size_t result = 0;
+
+  for (auto& free_list : m_free)
+    result += free_list.size();
+
+  return result;
+}
+
+size_t
+BufferPool::cached_bytes() const {
+  size_t result = 0;
+
+  for (unsigned int index = 0; index < class_count; index++)
+    result += m_free[index].size() * class_size(index);
+
+  return result;
+}
+
+} // namespace torrent
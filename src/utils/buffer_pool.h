@@ -0,0 +1,85 @@
+#ifndef LIBTORRENT_UTILS_BUFFER_POOL_H
+#define LIBTORRENT_UTILS_BUFFER_POOL_H
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace torrent {
+
+// Per-thread free lists of protocol buffers, so that connections only
+// hold their larger buffers while they use them.
+//
+// Buffers are grouped in power of two size classes from 'min_size' to
+// 'max_size', each with 'header_size' extra bytes so objects wrapping
+// a power of two sized array, like ProtocolBuffer, fit their class.
+// Released buffers are kept for reuse until a class caches
+// 'max_cached_bytes', further ones are freed.
+//
+// Buffers must be released on the thread that allocated them, using
+// the same size.
+
+class BufferPool {
+public:
+  static constexpr size_t       min_size         = 512;
+  static constexpr unsigned int class_count      = 7;
+  static constexpr size_t       max_size         = min_size << (class_count - 1);
+  static constexpr size_t       header_size      = 64;
+  static constexpr size_t       max_cached_bytes = 1 << 20;
+
+  BufferPool() = default;
+  ~BufferPool();
+
+  static BufferPool*  thread_pool();
+
+  static unsigned int size_class(size_t size);
+  static size_t       class_size(unsigned int size_class) { return (min_size << size_class) + header_size; }
+
+  char*               allocate(size_t size);
+  void                release(char* buffer, size_t size);
+
+  // Frees all cached buffers.
+  void                clear();
+
+  size_t              cached_size() const;
+  size_t              cached_bytes() const;
+
+private:
+  BufferPool(const BufferPool&) = delete;
+  BufferPool& operator=(const BufferPool&) = delete;
+
+  std::array<std::vector<char*>, class_count> m_free;
+};
+
+struct buffer_pool_deleter {
+  template <typename T>
+  void operator()(T* object) const {
+    object->~T();
+    BufferPool::thread_pool()->release(reinterpret_cast<char*>(object), sizeof(T));
+  }
+};
+
+template <typename T>
+using pooled_ptr = std::unique_ptr<T, buffer_pool_deleter>;
+
+template <typename T>
+inline pooled_ptr<T>
+make_pooled() {
+  static_assert(sizeof(T) <= BufferPool::max_size + BufferPool::header_size, "object too large for BufferPool");
+  static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "object alignment too large for BufferPool");
+
+  char* buffer = BufferPool::thread_pool()->allocate(sizeof(T));
+
+  try {
+    return pooled_ptr<T>(new (buffer) T());
+  } catch (...) {
+    BufferPool::thread_pool()->release(buffer, sizeof(T));
+    throw;
+  }
+}
+
+} // namespace torrent
+
+#endif
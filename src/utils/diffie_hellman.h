@@ -20,6 +20,7 @@ public:
   DiffieHellman& operator=(const DiffieHellman&) = delete;
 
   bool         is_valid() const;
+  bool         has_secret() const   { return m_secret != nullptr && m_size > 0; }
 
   bool         compute_secret(const unsigned char pubkey[], unsigned int length);
   void         store_pub_key(unsigned char* dest, unsigned int length);
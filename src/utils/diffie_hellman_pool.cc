@@ -0,0 +1,170 @@
+#include "config.h"
+
+#include "utils/diffie_hellman_pool.h"
+
+#include <algorithm>
+
+#include "torrent/exceptions.h"
+#include "torrent/utils/chrono.h"
+#include "torrent/utils/thread.h"
+#include "utils/instrumentation.h"
+
+namespace torrent {
+
+DiffieHellmanPool::DiffieHellmanPool(const unsigned char prime[], int prime_length,
+                                     const unsigned char generator[], int generator_length) :
+  m_prime(prime),
+  m_prime_length(prime_length),
+  m_generator(generator),
+  m_generator_length(generator_length) {
+}
+
+DiffieHellmanPool::~DiffieHellmanPool() {
+  {
+    auto lock = std::scoped_lock(m_lock);
+    m_stopping = true;
+  }
+
+  m_worker_cv.notify_all();
+
+  if (m_worker.joinable())
+    m_worker.join();
+
+  instrumentation_update(INSTRUMENTATION_HANDSHAKE_KEYPOOL_SIZE, -static_cast<int64_t>(m_keys.size()));
+}
+
+unsigned int
+DiffieHellmanPool::size() {
+  auto lock = std::scoped_lock(m_lock);
+  return m_keys.size();
+}
+
+DiffieHellmanPool::key_type
+DiffieHellmanPool::take_key() {
+  {
+    auto lock = std::unique_lock(m_lock);
+
+    if (!m_worker.joinable())
+      m_worker = std::thread(&DiffieHellmanPool::worker_loop, this);
+
+    if (!m_keys.empty()) {
+      auto key = std::move(m_keys.back());
+      m_keys.pop_back();
+
+      lock.unlock();
+      m_worker_cv.notify_one();
+
+      instrumentation_update(INSTRUMENTATION_HANDSHAKE_KEYPOOL_SIZE, -1);
+      return key;
+    }
+  }
+
+  instrumentation_update(INSTRUMENTATION_HANDSHAKE_KEYPOOL_MISSES, 1);
+  return generate_key();
+}
+
+void
+DiffieHellmanPool::compute_secret(utils::Thread* thread, void* target, key_type key,
+                                  const unsigned char pubkey[], unsigned int length, slot_secret&& slot) {
+  if (target == nullptr || key == nullptr)
+    throw internal_error("DiffieHellmanPool::compute_secret(...) called with a null target or key.");
+
+  auto job = std::make_shared<job_type>();
+
+  job->thread = thread;
+  job->target = target;
+  job->key = std::move(key);
+  job->pubkey.assign(pubkey, pubkey + length);
+  job->slot = std::move(slot);
+  job->started = utils::time_since_epoch();
+
+  {
+    auto lock = std::scoped_lock(m_lock);
+
+    if (!m_worker.joinable())
+      m_worker = std::thread(&DiffieHellmanPool::worker_loop, this);
+
+    m_jobs.push_back(std::move(job));
+  }
+
+  m_worker_cv.notify_one();
+}
+
+// Completions are queued by the worker while holding 'm_lock', so once
+// the lock has been taken here no new callback for 'target' can be
+// queued and cancelling the thread's callbacks removes the rest.
+void
+DiffieHellmanPool::cancel(utils::Thread* thread, void* target) {
+  {
+    auto lock = std::scoped_lock(m_lock);
+
+    m_jobs.erase(std::remove_if(m_jobs.begin(), m_jobs.end(), [target](auto& job) { return job->target == target; }),
+                 m_jobs.end());
+
+    if (m_running != nullptr && m_running->target == target)
+      m_running = nullptr;
+  }
+
+  thread->cancel_callback(target);
+}
+
+DiffieHellmanPool::key_type
+DiffieHellmanPool::generate_key() const {
+  return std::make_unique<DiffieHellman>(m_prime, m_prime_length, m_generator, m_generator_length);
+}
+
+void
+DiffieHellmanPool::worker_loop() {
+#if defined(HAS_PTHREAD_SETNAME_NP_DARWIN)
+  pthread_setname_np("rtorrent dh");
+#elif defined(HAS_PTHREAD_SETNAME_NP_GENERIC)
+  pthread_setname_np(pthread_self(), "rtorrent dh");
+#endif
+
+  auto lock = std::unique_lock(m_lock);
+
+  while (true) {
+    m_worker_cv.wait(lock, [this] { return m_stopping || !m_jobs.empty() || m_keys.size() < max_keys; });
+
+    if (m_stopping)
+      break;
+
+    if (!m_jobs.empty()) {
+      auto job = std::move(m_jobs.front());
+      m_jobs.pop_front();
+
+      perform_job(job, lock);
+      continue;
+    }
+
+    lock.unlock();
+    auto key = generate_key();
+    lock.lock();
+
+    m_keys.push_back(std::move(key));
+    instrumentation_update(INSTRUMENTATION_HANDSHAKE_KEYPOOL_SIZE, 1);
+  }
+}
+
+void
+DiffieHellmanPool::perform_job(const job_ptr& job, std::unique_lock<std::mutex>& lock) {
+  m_running = job;
+
+  lock.unlock();
+  job->key->compute_secret(job->pubkey.data(), job->pubkey.size());
+  lock.lock();
+
+  if (m_running != job)
+    return;
+
+  m_running = nullptr;
+
+  job->thread->callback(job->target, [job] {
+      instrumentation_update(INSTRUMENTATION_HANDSHAKE_SECRET_COUNT, 1);
+      instrumentation_update(INSTRUMENTATION_HANDSHAKE_SECRET_USEC, (utils::time_since_epoch() - job->started).count());
+
+      job->slot(std::move(job->key));
+    });
+}
+
+} // namespace torrent
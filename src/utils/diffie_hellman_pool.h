@@ -0,0 +1,94 @@
+#ifndef LIBTORRENT_UTILS_DIFFIE_HELLMAN_POOL_H
+#define LIBTORRENT_UTILS_DIFFIE_HELLMAN_POOL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "utils/diffie_hellman.h"
+
+namespace torrent {
+
+namespace utils {
+class Thread;
+}
+
+// Keeps a supply of Diffie-Hellman keys generated by a worker thread,
+// and computes shared secrets on the same worker so that neither
+// modular exponentiation is done by the thread handling handshakes.
+//
+// The worker is started when the first key is taken. Secret
+// computations take priority over refilling the pool, and completions
+// are passed back through the requesting thread's callback queue using
+// the caller's target, which must be cancelled with 'cancel' before
+// the target is destroyed.
+
+class DiffieHellmanPool {
+public:
+  using key_type    = std::unique_ptr<DiffieHellman>;
+  using slot_secret = std::function<void (key_type)>;
+
+  static constexpr unsigned int max_keys = 32;
+
+  DiffieHellmanPool(const unsigned char prime[], int prime_length,
+                    const unsigned char generator[], int generator_length);
+  ~DiffieHellmanPool();
+
+  unsigned int        size();
+
+  // Returns a precomputed key, or one generated by the calling thread
+  // if the pool is empty.
+  key_type            take_key();
+
+  // The key is passed to 'slot' with the secret computed, or with
+  // 'DiffieHellman::has_secret' false if the public key was invalid.
+  void                compute_secret(utils::Thread* thread, void* target, key_type key,
+                                     const unsigned char pubkey[], unsigned int length, slot_secret&& slot);
+
+  // Drops pending computations for 'target', after which 'slot' is
+  // never called for them.
+  void                cancel(utils::Thread* thread, void* target);
+
+private:
+  DiffieHellmanPool(const DiffieHellmanPool&) = delete;
+  DiffieHellmanPool& operator=(const DiffieHellmanPool&) = delete;
+
+  struct job_type {
+    utils::Thread*             thread;
+    void*                      target;
+    key_type                   key;
+    std::vector<unsigned char> pubkey;
+    slot_secret                slot;
+    std::chrono::microseconds  started;
+  };
+
+  using job_ptr = std::shared_ptr<job_type>;
+
+  key_type            generate_key() const;
+
+  void                worker_loop();
+  void                perform_job(const job_ptr& job, std::unique_lock<std::mutex>& lock);
+
+  const unsigned char*    m_prime;
+  int                     m_prime_length;
+  const unsigned char*    m_generator;
+  int                     m_generator_length;
+
+  std::mutex              m_lock;
+  std::condition_variable m_worker_cv;
+  std::thread             m_worker;
+  bool                    m_stopping{false};
+
+  std::vector<key_type>   m_keys;
+  std::deque<job_ptr>     m_jobs;
+  job_ptr                 m_running;
+};
+
+} // namespace torrent
+
+#endif
@@ -18,12 +18,36 @@ instrumentation_fetch_and_clear(instrumentation_enum type) {
 void
 instrumentation_tick() {
   lt_log_print(LOG_INSTRUMENTATION_MEMORY,
-               "%" PRIi64 " %" PRIi64 " %" PRIi64  " %" PRIi64 " %" PRIi64,
+               "%" PRIi64 " %" PRIi64 " %" PRIi64  " %" PRIi64 " %" PRIi64
+               " %" PRIi64 " %" PRIi64 " %" PRIi64  " %" PRIi64 " %" PRIi64,
                instrumentation_values[INSTRUMENTATION_MEMORY_CHUNK_USAGE].load(),
                instrumentation_values[INSTRUMENTATION_MEMORY_CHUNK_COUNT].load(),
                instrumentation_values[INSTRUMENTATION_MEMORY_HASHING_CHUNK_USAGE].load(),
                instrumentation_values[INSTRUMENTATION_MEMORY_HASHING_CHUNK_COUNT].load(),
-               instrumentation_values[INSTRUMENTATION_MEMORY_BITFIELDS].load());
+               instrumentation_values[INSTRUMENTATION_MEMORY_BITFIELDS].load(),
+
+               instrumentation_values[INSTRUMENTATION_MEMORY_PEER_CONNECTION_USAGE].load(),
+               instrumentation_values[INSTRUMENTATION_MEMORY_PEER_CONNECTION_COUNT].load(),
+               instrumentation_values[INSTRUMENTATION_MEMORY_PROTOCOL_BUFFER_USAGE].load(),
+               instrumentation_values[INSTRUMENTATION_MEMORY_PROTOCOL_BUFFER_COUNT].load(),
+               instrumentation_values[INSTRUMENTATION_MEMORY_PROTOCOL_BUFFER_POOLED].load());
+
+  lt_log_print(LOG_INSTRUMENTATION_HASHING,
+               "%" PRIi64 " %" PRIi64 " %" PRIi64  " %" PRIi64 " %" PRIi64,
+               instrumentation_values[INSTRUMENTATION_HASHING_WORKERS].load(),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_HASHING_DISK_CHUNKS),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_HASHING_DISK_BYTES),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_HASHING_WORKER_CHUNKS),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_HASHING_WORKER_BYTES));
+
+  lt_log_print(LOG_INSTRUMENTATION_HANDSHAKES,
+               "%" PRIi64 " %" PRIi64 " %" PRIi64  " %" PRIi64 " %" PRIi64 " %" PRIi64,
+               instrumentation_values[INSTRUMENTATION_HANDSHAKE_KEYPOOL_SIZE].load(),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_HANDSHAKE_KEYPOOL_MISSES),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_HANDSHAKE_SECRET_COUNT),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_HANDSHAKE_SECRET_USEC),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_HANDSHAKE_SUCCEEDED_COUNT),
+               instrumentation_fetch_and_clear(INSTRUMENTATION_HANDSHAKE_SUCCEEDED_USEC));
 
   lt_log_print(LOG_INSTRUMENTATION_MINCORE,
                "%"  PRIi64 " %" PRIi64 " %" PRIi64 " %" PRIi64 " %" PRIi64
@@ -101,6 +125,17 @@ instrumentation_tick() {
 
 void
 instrumentation_reset() {
+  instrumentation_fetch_and_clear(INSTRUMENTATION_HASHING_DISK_CHUNKS);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_HASHING_DISK_BYTES);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_HASHING_WORKER_CHUNKS);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_HASHING_WORKER_BYTES);
+
+  instrumentation_fetch_and_clear(INSTRUMENTATION_HANDSHAKE_KEYPOOL_MISSES);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_HANDSHAKE_SECRET_COUNT);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_HANDSHAKE_SECRET_USEC);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_HANDSHAKE_SUCCEEDED_COUNT);
+  instrumentation_fetch_and_clear(INSTRUMENTATION_HANDSHAKE_SUCCEEDED_USEC);
+
   instrumentation_fetch_and_clear(INSTRUMENTATION_MINCORE_INCORE_TOUCHED);
   instrumentation_fetch_and_clear(INSTRUMENTATION_MINCORE_INCORE_NEW);
   instrumentation_fetch_and_clear(INSTRUMENTATION_MINCORE_NOT_INCORE_TOUCHED);
@@ -17,6 +17,29 @@ enum instrumentation_enum {
   INSTRUMENTATION_MEMORY_HASHING_CHUNK_USAGE,
   INSTRUMENTATION_MEMORY_HASHING_CHUNK_COUNT,
 
+  // Fixed per-connection allocations and pooled protocol buffers,
+  // bytes per connection is their usage divided by the count.
+  INSTRUMENTATION_MEMORY_PEER_CONNECTION_USAGE,
+  INSTRUMENTATION_MEMORY_PEER_CONNECTION_COUNT,
+  INSTRUMENTATION_MEMORY_PROTOCOL_BUFFER_USAGE,
+  INSTRUMENTATION_MEMORY_PROTOCOL_BUFFER_COUNT,
+  INSTRUMENTATION_MEMORY_PROTOCOL_BUFFER_POOLED,
+
+  INSTRUMENTATION_HASHING_WORKERS,
+  INSTRUMENTATION_HASHING_DISK_CHUNKS,
+  INSTRUMENTATION_HASHING_DISK_BYTES,
+  INSTRUMENTATION_HASHING_WORKER_CHUNKS,
+  INSTRUMENTATION_HASHING_WORKER_BYTES,
+
+  // Latencies are the sum in microseconds, divide by the count for
+  // the average.
+  INSTRUMENTATION_HANDSHAKE_KEYPOOL_SIZE,
+  INSTRUMENTATION_HANDSHAKE_KEYPOOL_MISSES,
+  INSTRUMENTATION_HANDSHAKE_SECRET_COUNT,
+  INSTRUMENTATION_HANDSHAKE_SECRET_USEC,
+  INSTRUMENTATION_HANDSHAKE_SUCCEEDED_COUNT,
+  INSTRUMENTATION_HANDSHAKE_SUCCEEDED_USEC,
+
   INSTRUMENTATION_MINCORE_INCORE_TOUCHED,
   INSTRUMENTATION_MINCORE_INCORE_NEW,
   INSTRUMENTATION_MINCORE_NOT_INCORE_TOUCHED,
@@ -0,0 +1,452 @@
+#include "config.h"
+
+#include "utils/sha1_batch.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "torrent/exceptions.h"
+#include "utils/sha1.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define LT_SHA1_BATCH_X86 1
+#endif
+
+namespace torrent {
+
+namespace {
+
+typedef uint32_t sha1_v4 __attribute__((vector_size(16)));
+typedef uint32_t sha1_v8 __attribute__((vector_size(32)));
+typedef uint32_t sha1_v16 __attribute__((vector_size(64)));
+
+constexpr uint32_t sha1_iv[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+
+alignas(64) constexpr uint8_t sha1_zero_block[64] = {};
+
+#define SHA1_ROTL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+inline uint32_t
+sha1_load_be32(const uint8_t* p) {
+  return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+inline void
+sha1_store_be32(char* p, uint32_t v) {
+  p[0] = v >> 24;
+  p[1] = v >> 16;
+  p[2] = v >> 8;
+  p[3] = v;
+}
+
+// Hands out a message one 64 byte block at a time, including the
+// final padding blocks. Whole blocks within a segment are returned
+// in-place, only blocks straddling segments or the end of the message
+// are copied.
+class sha1_lane_reader {
+public:
+  void           reset(const Sha1Batch::segment_list* segments);
+  const uint8_t* next_block();
+
+private:
+  const Sha1Batch::segment_list* m_segments;
+
+  size_t         m_segment;
+  uint32_t       m_offset;
+  uint64_t       m_length;
+
+  unsigned int   m_pad_blocks;
+  unsigned int   m_pad_index;
+
+  alignas(64) uint8_t m_buffer[128];
+};
+
+void
+sha1_lane_reader::reset(const Sha1Batch::segment_list* segments) {
+  m_segments = segments;
+  m_segment = 0;
+  m_offset = 0;
+  m_length = 0;
+  m_pad_blocks = 0;
+  m_pad_index = 0;
+}
+
+const uint8_t*
+sha1_lane_reader::next_block() {
+  if (m_pad_blocks != 0)
+    return m_pad_index != m_pad_blocks ? m_buffer + 64 * m_pad_index++ : nullptr;
+
+  const auto& segments = *m_segments;
+
+  while (m_segment != segments.size() && m_offset == segments[m_segment].second) {
+    m_segment++;
+    m_offset = 0;
+  }
+
+  if (m_segment != segments.size() && segments[m_segment].second - m_offset >= 64) {
+    auto block = reinterpret_cast<const uint8_t*>(segments[m_segment].first) + m_offset;
+
+    m_offset += 64;
+    m_length += 64;
+    return block;
+  }
+
+  unsigned int fill = 0;
+
+  while (fill != 64 && m_segment != segments.size()) {
+    uint32_t length = std::min<uint32_t>(64 - fill, segments[m_segment].second - m_offset);
+
+    std::memcpy(m_buffer + fill, segments[m_segment].first + m_offset, length);
+
+    fill     += length;
+    m_offset += length;
+
+    if (m_offset == segments[m_segment].second) {
+      m_segment++;
+      m_offset = 0;
+    }
+  }
+
+  m_length += fill;
+
+  if (fill == 64)
+    return m_buffer;
+
+  m_pad_blocks = fill < 56 ? 1 : 2;
+  m_pad_index = 1;
+
+  unsigned int end = 64 * m_pad_blocks;
+  uint64_t     bits = m_length * 8;
+
+  m_buffer[fill] = 0x80;
+  std::memset(m_buffer + fill + 1, 0, end - fill - 1 - 8);
+
+  for (unsigned int i = 0; i < 8; i++)
+    m_buffer[end - 1 - i] = bits >> (8 * i);
+
+  return m_buffer;
+}
+
+void
+sha1_compress_scalar(uint32_t* state, const uint8_t* block) {
+  uint32_t w[16];
+
+  for (int t = 0; t < 16; t++)
+    w[t] = sha1_load_be32(block + 4 * t);
+
+  uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+
+  for (int t = 0; t < 80; t++) {
+    if (t >= 16) {
+      uint32_t x = w[(t - 3) & 15] ^ w[(t - 8) & 15] ^ w[(t - 14) & 15] ^ w[t & 15];
+      w[t & 15] = SHA1_ROTL(x, 1);
+    }
+
+    uint32_t f;
+
+    if (t < 20)
+      f = (d ^ (b & (c ^ d))) + 0x5a827999;
+    else if (t < 40)
+      f = (b ^ c ^ d) + 0x6ed9eba1;
+    else if (t < 60)
+      f = ((b & c) | (d & (b | c))) + 0x8f1bbcdc;
+    else
+      f = (b ^ c ^ d) + 0xca62c1d6;
+
+    uint32_t tmp = SHA1_ROTL(a, 5) + f + e + w[t & 15];
+
+    e = d;
+    d = c;
+    c = SHA1_ROTL(b, 30);
+    b = a;
+    a = tmp;
+  }
+
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+}
+
+// The state is stored lane-interleaved, 'state[i * lanes + lane]', so
+// that each of the five words load directly into a vector.
+//
+// Compiled for each vector width from a function with the matching
+// target attribute, which lets the compiler pick the instruction set
+// without requiring it for the rest of the library.
+template <typename Vector, unsigned int lanes>
+[[gnu::always_inline]] inline void
+sha1_compress_simd(uint32_t* state, const uint8_t* const* blocks) {
+  Vector w[16];
+
+  for (unsigned int t = 0; t < 16; t++)
+    for (unsigned int lane = 0; lane < lanes; lane++)
+      w[t][lane] = sha1_load_be32(blocks[lane] + 4 * t);
+
+  Vector a, b, c, d, e;
+  std::memcpy(&a, state + 0 * lanes, sizeof(Vector));
+  std::memcpy(&b, state + 1 * lanes, sizeof(Vector));
+  std::memcpy(&c, state + 2 * lanes, sizeof(Vector));
+  std::memcpy(&d, state + 3 * lanes, sizeof(Vector));
+  std::memcpy(&e, state + 4 * lanes, sizeof(Vector));
+
+  Vector sa = a, sb = b, sc = c, sd = d, se = e;
+
+  for (unsigned int t = 0; t < 80; t++) {
+    if (t >= 16) {
+      Vector x = w[(t - 3) & 15] ^ w[(t - 8) & 15] ^ w[(t - 14) & 15] ^ w[t & 15];
+      w[t & 15] = SHA1_ROTL(x, 1);
+    }
+
+    Vector f;
+
+    if (t < 20)
+      f = (d ^ (b & (c ^ d))) + 0x5a827999;
+    else if (t < 40)
+      f = (b ^ c ^ d) + 0x6ed9eba1;
+    else if (t < 60)
+      f = ((b & c) | (d & (b | c))) + 0x8f1bbcdc;
+    else
+      f = (b ^ c ^ d) + 0xca62c1d6;
+
+    Vector tmp = SHA1_ROTL(a, 5) + f + e + w[t & 15];
+
+    e = d;
+    d = c;
+    c = SHA1_ROTL(b, 30);
+    b = a;
+    a = tmp;
+  }
+
+  a += sa;
+  b += sb;
+  c += sc;
+  d += sd;
+  e += se;
+
+  std::memcpy(state + 0 * lanes, &a, sizeof(Vector));
+  std::memcpy(state + 1 * lanes, &b, sizeof(Vector));
+  std::memcpy(state + 2 * lanes, &c, sizeof(Vector));
+  std::memcpy(state + 3 * lanes, &d, sizeof(Vector));
+  std::memcpy(state + 4 * lanes, &e, sizeof(Vector));
+}
+
+void
+sha1_compress_x4(uint32_t* state, const uint8_t* const* blocks) {
+  sha1_compress_simd<sha1_v4, 4>(state, blocks);
+}
+
+#ifdef LT_SHA1_BATCH_X86
+[[gnu::target("avx2")]] void
+sha1_compress_x8(uint32_t* state, const uint8_t* const* blocks) {
+  sha1_compress_simd<sha1_v8, 8>(state, blocks);
+}
+
+[[gnu::target("avx512f")]] void
+sha1_compress_x16(uint32_t* state, const uint8_t* const* blocks) {
+  sha1_compress_simd<sha1_v16, 16>(state, blocks);
+}
+#endif
+
+// Keeps every lane busy by starting the next message in a lane as soon
+// as its current message is done. Once only a single lane is left the
+// remaining blocks are hashed with the scalar compression function.
+template <unsigned int lanes>
+void
+sha1_perform_simd(const std::vector<Sha1Batch::segment_list>& messages, char* digests,
+                  void (*compress)(uint32_t*, const uint8_t* const*)) {
+  alignas(64) uint32_t state[5 * lanes];
+  sha1_lane_reader     readers[lanes];
+  size_t               lane_message[lanes];
+  const uint8_t*       blocks[lanes];
+
+  size_t next_message = 0;
+  const size_t idle = ~size_t();
+
+  auto assign_lane = [&](unsigned int lane) {
+      if (next_message == messages.size()) {
+        lane_message[lane] = idle;
+        return;
+      }
+
+      lane_message[lane] = next_message;
+      readers[lane].reset(&messages[next_message++]);
+
+      for (unsigned int i = 0; i < 5; i++)
+        state[i * lanes + lane] = sha1_iv[i];
+    };
+
+  for (unsigned int lane = 0; lane < lanes; lane++)
+    assign_lane(lane);
+
+  while (true) {
+    unsigned int active = 0;
+    unsigned int last_active = 0;
+
+    for (unsigned int lane = 0; lane < lanes; lane++) {
+      while (lane_message[lane] != idle && (blocks[lane] = readers[lane].next_block()) == nullptr) {
+        char* digest = digests + 20 * lane_message[lane];
+
+        for (unsigned int i = 0; i < 5; i++)
+          sha1_store_be32(digest + 4 * i, state[i * lanes + lane]);
+
+        assign_lane(lane);
+      }
+
+      if (lane_message[lane] == idle) {
+        blocks[lane] = sha1_zero_block;
+        continue;
+      }
+
+      active++;
+      last_active = lane;
+    }
+
+    if (active == 0)
+      break;
+
+    if (active != 1) {
+      compress(state, blocks);
+      continue;
+    }
+
+    uint32_t lane_state[5];
+
+    for (unsigned int i = 0; i < 5; i++)
+      lane_state[i] = state[i * lanes + last_active];
+
+    sha1_compress_scalar(lane_state, blocks[last_active]);
+
+    for (unsigned int i = 0; i < 5; i++)
+      state[i * lanes + last_active] = lane_state[i];
+  }
+}
+
+#ifdef LT_SHA1_BATCH_X86
+bool
+sha1_cpu_has_sha_ni() {
+  unsigned int eax, ebx, ecx, edx;
+
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+    return false;
+
+  return ebx & (1 << 29);
+}
+#endif
+
+} // namespace
+
+Sha1Batch::Sha1Batch(engine_type engine) :
+    m_engine(engine) {
+
+  if (!is_engine_supported(engine))
+    throw internal_error("Sha1Batch::Sha1Batch(...) engine not supported by this cpu.");
+}
+
+Sha1Batch::engine_type
+Sha1Batch::default_engine() {
+  static const engine_type engine = [] {
+#ifdef LT_SHA1_BATCH_X86
+      if (sha1_cpu_has_sha_ni())
+        return ENGINE_OPENSSL;
+
+      if (is_engine_supported(ENGINE_SIMD_X16))
+        return ENGINE_SIMD_X16;
+
+      if (is_engine_supported(ENGINE_SIMD_X8))
+        return ENGINE_SIMD_X8;
+
+      return ENGINE_SIMD_X4;
+#else
+      // Other architectures usually have SHA-1 instructions that
+      // OpenSSL uses.
+      return ENGINE_OPENSSL;
+#endif
+    }();
+
+  return engine;
+}
+
+bool
+Sha1Batch::is_engine_supported(engine_type engine) {
+  switch (engine) {
+  case ENGINE_OPENSSL:
+  case ENGINE_SIMD_X4:
+    return true;
+#ifdef LT_SHA1_BATCH_X86
+  case ENGINE_SIMD_X8:
+    return __builtin_cpu_supports("avx2");
+  case ENGINE_SIMD_X16:
+    return __builtin_cpu_supports("avx512f");
+#endif
+  default:
+    return false;
+  }
+}
+
+const char*
+Sha1Batch::engine_name(engine_type engine) {
+  switch (engine) {
+  case ENGINE_OPENSSL:  return "openssl";
+  case ENGINE_SIMD_X4:  return "simd_x4";
+  case ENGINE_SIMD_X8:  return "simd_x8";
+  case ENGINE_SIMD_X16: return "simd_x16";
+  default:              return "unknown";
+  }
+}
+
+unsigned int
+Sha1Batch::engine_lanes(engine_type engine) {
+  switch (engine) {
+  case ENGINE_SIMD_X4:  return 4;
+  case ENGINE_SIMD_X8:  return 8;
+  case ENGINE_SIMD_X16: return 16;
+  default:              return 1;
+  }
+}
+
+unsigned int
+Sha1Batch::push_back(segment_list segments) {
+  m_messages.push_back(std::move(segments));
+
+  return m_messages.size() - 1;
+}
+
+void
+Sha1Batch::perform(char* digests) {
+  switch (m_engine) {
+  case ENGINE_SIMD_X4:
+    sha1_perform_simd<4>(m_messages, digests, &sha1_compress_x4);
+    break;
+#ifdef LT_SHA1_BATCH_X86
+  case ENGINE_SIMD_X8:
+    sha1_perform_simd<8>(m_messages, digests, &sha1_compress_x8);
+    break;
+  case ENGINE_SIMD_X16:
+    sha1_perform_simd<16>(m_messages, digests, &sha1_compress_x16);
+    break;
+#endif
+  default:
+    perform_openssl(digests);
+    break;
+  }
+}
+
+void
+Sha1Batch::perform_openssl(char* digests) {
+  Sha1 sha1;
+
+  for (const auto& segments : m_messages) {
+    sha1.init();
+
+    for (const auto& segment : segments)
+      sha1.update(segment.first, segment.second);
+
+    sha1.final_c(digests);
+    digests += 20;
+  }
+}
+
+} // namespace torrent
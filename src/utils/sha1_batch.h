@@ -0,0 +1,67 @@
+#ifndef LIBTORRENT_UTILS_SHA1_BATCH_H
+#define LIBTORRENT_UTILS_SHA1_BATCH_H
+
+#include <cinttypes>
+#include <utility>
+#include <vector>
+
+namespace torrent {
+
+// Hashes groups of independent messages, using multi-buffer SHA-1
+// where every SIMD lane processes a different message.
+//
+// When the CPU has the SHA extensions OpenSSL is already faster than
+// any multi-buffer engine, so 'default_engine()' picks the plain Sha1
+// path in that case.
+//
+// Messages are lists of memory segments so that chunks spanning
+// several files can be hashed without copying them.
+
+class Sha1Batch {
+public:
+  using segment_type = std::pair<const char*, uint32_t>;
+  using segment_list = std::vector<segment_type>;
+
+  enum engine_type {
+    ENGINE_OPENSSL,
+    ENGINE_SIMD_X4,
+    ENGINE_SIMD_X8,
+    ENGINE_SIMD_X16,
+  };
+
+  static constexpr unsigned int max_lanes = 16;
+
+  Sha1Batch() : Sha1Batch(default_engine()) {}
+  Sha1Batch(engine_type engine);
+
+  static engine_type  default_engine();
+  static bool         is_engine_supported(engine_type engine);
+  static const char*  engine_name(engine_type engine);
+  static unsigned int engine_lanes(engine_type engine);
+
+  engine_type         engine() const     { return m_engine; }
+
+  // Number of messages the engine hashes in parallel, callers should
+  // try to feed at least this many messages to each 'perform()'.
+  unsigned int        lanes() const      { return engine_lanes(m_engine); }
+
+  bool                empty() const      { return m_messages.empty(); }
+  unsigned int        size() const       { return m_messages.size(); }
+
+  void                clear()            { m_messages.clear(); }
+  unsigned int        push_back(segment_list segments);
+
+  // Hash all added messages, 'digests' must hold 20 bytes per message
+  // in the order they were added.
+  void                perform(char* digests);
+
+private:
+  void                perform_openssl(char* digests);
+
+  engine_type               m_engine;
+  std::vector<segment_list> m_messages;
+};
+
+} // namespace torrent
+
+#endif
@@ -21,6 +21,10 @@ public:
   static Poll*                     poll()           { return Thread::m_self->m_poll.get(); }
   static Scheduler*                scheduler()      { return Thread::m_self->m_scheduler.get(); }
   static net::Resolver*            resolver()       { return Thread::m_self->m_resolver.get(); }
+
+  // Used by objects that are owned by a specific thread, and must register with its poll even
+  // when setup is done from another thread's event loop.
+  static Poll*                     poll(Thread* thread) { return thread->m_poll.get(); }
 };
 
 } // namespace torrent::utils
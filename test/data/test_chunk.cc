@@ -0,0 +1,107 @@
+#include "config.h"
+
+#include "test_chunk.h"
+
+#include <cstring>
+#include <memory>
+#include <sys/mman.h>
+
+#include "data/chunk.h"
+#include "helpers/test_utils.h"
+#include "protocol/encryption_info.h"
+#include "torrent/exceptions.h"
+#include "utils/rc4.h"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(test_chunk, "data");
+
+static const unsigned char test_key[] = "0123456789abcdefghij";
+
+// Part sizes are odd so that part boundaries fall on unaligned offsets.
+static std::unique_ptr<torrent::Chunk>
+create_chunk(const std::vector<char>& data, std::initializer_list<uint32_t> part_sizes) {
+  auto chunk = std::make_unique<torrent::Chunk>();
+  uint32_t position = 0;
+
+  for (auto size : part_sizes) {
+    char* memory = static_cast<char*>(mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0));
+
+    if (memory == MAP_FAILED)
+      throw torrent::internal_error("create_chunk() failed: " + std::string(strerror(errno)));
+
+    std::memcpy(memory, data.data() + position, size);
+    position += size;
+
+    chunk->push_back(torrent::ChunkPart::MAPPED_MMAP, torrent::MemoryChunk(memory, memory, memory + size, torrent::MemoryChunk::prot_read, 0));
+  }
+
+  if (position != data.size())
+    throw torrent::internal_error("create_chunk() part sizes do not match the data size.");
+
+  return chunk;
+}
+
+static torrent::RC4
+create_rc4() {
+  return torrent::RC4(test_key, sizeof(test_key) - 1);
+}
+
+void
+test_chunk::test_to_buffer_encrypted() {
+  auto data = create_random_data(7 + 4096 + 13 + 1001);
+  auto chunk = create_chunk(data, {7, 4096, 13, 1001});
+
+  CPPUNIT_ASSERT(chunk->chunk_size() == data.size());
+
+  std::pair<uint32_t, uint32_t> ranges[] = {
+    {0, 1}, {0, 7}, {3, 9}, {5, 4100}, {7, 4096}, {4100, 15}, {4102, 1015}, {1, 7 + 4096 + 13 + 1000}, {0, 7 + 4096 + 13 + 1001}
+  };
+
+  for (auto [position, length] : ranges) {
+    std::vector<char> expected(length);
+    std::vector<char> result(length);
+
+    CPPUNIT_ASSERT(chunk->to_buffer(expected.data(), position, length));
+    CPPUNIT_ASSERT(std::memcmp(expected.data(), data.data() + position, length) == 0);
+
+    create_rc4().crypt(expected.data(), length);
+
+    torrent::EncryptionInfo encryption;
+    encryption.set_encrypt(create_rc4());
+
+    CPPUNIT_ASSERT(chunk->to_buffer_encrypted(result.data(), position, length, &encryption));
+    CPPUNIT_ASSERT(result == expected);
+  }
+
+  torrent::EncryptionInfo encryption;
+  encryption.set_encrypt(create_rc4());
+
+  char unused;
+  CPPUNIT_ASSERT(chunk->to_buffer_encrypted(&unused, 0, 0, &encryption));
+  CPPUNIT_ASSERT_THROW(chunk->to_buffer_encrypted(&unused, data.size() - 1, 2, &encryption), torrent::internal_error);
+}
+
+// Consecutive calls must continue the same key stream, as when a piece
+// is sent in several writes.
+void
+test_chunk::test_to_buffer_encrypted_stream() {
+  auto data = create_random_data(501 + 333 + 777);
+  auto chunk = create_chunk(data, {501, 333, 777});
+
+  std::vector<char> expected(data.begin() + 11, data.end());
+  create_rc4().crypt(expected.data(), expected.size());
+
+  torrent::EncryptionInfo encryption;
+  encryption.set_encrypt(create_rc4());
+
+  std::vector<char> result(expected.size());
+  uint32_t offset = 0;
+
+  for (uint32_t length : {1u, 499u, 3u, 330u, 700u}) {
+    CPPUNIT_ASSERT(chunk->to_buffer_encrypted(result.data() + offset, 11 + offset, length, &encryption));
+    offset += length;
+  }
+
+  CPPUNIT_ASSERT(offset + 11 + 67 == data.size());
+  CPPUNIT_ASSERT(chunk->to_buffer_encrypted(result.data() + offset, 11 + offset, 67, &encryption));
+  CPPUNIT_ASSERT(result == expected);
+}
@@ -0,0 +1,14 @@
+#include "helpers/test_fixture.h"
+
+class test_chunk : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_chunk);
+
+  CPPUNIT_TEST(test_to_buffer_encrypted);
+  CPPUNIT_TEST(test_to_buffer_encrypted_stream);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_to_buffer_encrypted();
+  void test_to_buffer_encrypted_stream();
+};
@@ -0,0 +1,170 @@
+#include "config.h"
+
+#include "test_disk_io.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <unistd.h>
+#include <vector>
+
+#include "helpers/test_utils.h"
+
+#include "data/disk_io.h"
+#include "data/thread_disk.h"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(test_disk_io, "data");
+
+namespace {
+
+constexpr int no_result = 1 << 30;
+
+} // namespace
+
+void
+test_disk_io::setUp() {
+  TestFixtureWithMainAndDiskThread::setUp();
+
+  char path[] = "/tmp/libtorrent_test_disk_io_XXXXXX";
+
+  m_fd = mkstemp(path);
+  m_path = path;
+
+  CPPUNIT_ASSERT(m_fd != -1);
+}
+
+void
+test_disk_io::tearDown() {
+  ::close(m_fd);
+  ::unlink(m_path.c_str());
+
+  TestFixtureWithMainAndDiskThread::tearDown();
+}
+
+int
+test_disk_io::wait_for_result(int* result) {
+  CPPUNIT_ASSERT(wait_for_true([this, result] {
+      m_main_thread->test_process_events_without_cached_time();
+      return *result != no_result;
+    }));
+
+  int value = *result;
+  *result = no_result;
+
+  return value;
+}
+
+void
+test_disk_io::verify_write(torrent::DiskIo* disk_io) {
+  auto data = create_random_data(1 << 20);
+
+  int result = no_result;
+  auto slot = [&result](int r) { result = r; };
+
+  // Unaligned offsets and lengths, and a write extending the file.
+  disk_io->write(this, m_fd, 0, data.data(), 4096, slot);
+  CPPUNIT_ASSERT(wait_for_result(&result) == 0);
+
+  disk_io->write(this, m_fd, 4096, data.data() + 4096, 12345, slot);
+  CPPUNIT_ASSERT(wait_for_result(&result) == 0);
+
+  disk_io->write(this, m_fd, 4096 + 12345, data.data() + 4096 + 12345, data.size() - 4096 - 12345, slot);
+  CPPUNIT_ASSERT(wait_for_result(&result) == 0);
+
+  std::vector<char> read_back(data.size());
+
+  CPPUNIT_ASSERT(pread(m_fd, read_back.data(), read_back.size(), 0) == static_cast<ssize_t>(data.size()));
+  CPPUNIT_ASSERT(read_back == data);
+
+  CPPUNIT_ASSERT(disk_io->pending() == 0);
+}
+
+void
+test_disk_io::verify_fdatasync(torrent::DiskIo* disk_io) {
+  std::vector<char> data(1 << 20);
+
+  for (size_t i = 0; i < data.size(); i++)
+    data[i] = i * 7;
+
+  CPPUNIT_ASSERT(pwrite(m_fd, data.data(), data.size(), 4096) == static_cast<ssize_t>(data.size()));
+
+  int result = no_result;
+  auto slot = [&result](int r) { result = r; };
+
+  disk_io->fdatasync(this, m_fd, slot);
+  CPPUNIT_ASSERT(wait_for_result(&result) == 0);
+
+  // The file descriptor is duplicated, so closing it does not affect
+  // the pending request.
+  int fd = ::dup(m_fd);
+
+  disk_io->fdatasync(this, fd, slot);
+  ::close(fd);
+  CPPUNIT_ASSERT(wait_for_result(&result) == 0);
+
+  CPPUNIT_ASSERT(disk_io->pending() == 0);
+}
+
+void
+test_disk_io::test_engine() {
+  auto disk_io = torrent::thread_disk()->disk_io();
+
+  CPPUNIT_ASSERT(disk_io != nullptr);
+  verify_write(disk_io);
+  verify_fdatasync(disk_io);
+}
+
+void
+test_disk_io::test_thread_pool() {
+  auto disk_io = torrent::DiskIo::create_thread_pool(nullptr, 2);
+
+  CPPUNIT_ASSERT(std::string(disk_io->name()) == "thread_pool");
+  verify_write(disk_io.get());
+  verify_fdatasync(disk_io.get());
+}
+
+void
+test_disk_io::test_bad_fd() {
+  auto disk_io = torrent::thread_disk()->disk_io();
+
+  int result = no_result;
+
+  disk_io->fdatasync(this, -1, [&result](int r) { result = r; });
+  CPPUNIT_ASSERT(wait_for_result(&result) == -EBADF);
+
+  char buffer[16] = {};
+
+  disk_io->write(this, -1, 0, buffer, sizeof(buffer), [&result](int r) { result = r; });
+  CPPUNIT_ASSERT(wait_for_result(&result) == -EBADF);
+}
+
+void
+test_disk_io::test_cancel() {
+  auto disk_io = torrent::thread_disk()->disk_io();
+  int calls = 0;
+
+  for (int i = 0; i < 64; i++)
+    disk_io->fdatasync(this, m_fd, [&calls](int) { calls++; });
+
+  disk_io->cancel(this);
+
+  CPPUNIT_ASSERT(disk_io->pending() == 0);
+
+  m_main_thread->test_process_events_without_cached_time();
+  CPPUNIT_ASSERT(calls == 0);
+}
+
+void
+test_disk_io::test_wait() {
+  auto disk_io = torrent::thread_disk()->disk_io();
+  int calls = 0;
+
+  for (int i = 0; i < 64; i++)
+    disk_io->fdatasync(this, m_fd, [&calls](int) { calls++; });
+
+  disk_io->wait(this);
+
+  CPPUNIT_ASSERT(disk_io->pending() == 0);
+
+  m_main_thread->test_process_events_without_cached_time();
+  CPPUNIT_ASSERT(calls == 0);
+}
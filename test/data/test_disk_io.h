@@ -0,0 +1,35 @@
+#include "helpers/test_main_thread.h"
+
+namespace torrent {
+class DiskIo;
+}
+
+class test_disk_io : public TestFixtureWithMainAndDiskThread {
+  CPPUNIT_TEST_SUITE(test_disk_io);
+
+  CPPUNIT_TEST(test_engine);
+  CPPUNIT_TEST(test_thread_pool);
+  CPPUNIT_TEST(test_bad_fd);
+  CPPUNIT_TEST(test_cancel);
+  CPPUNIT_TEST(test_wait);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp() override;
+  void tearDown() override;
+
+  void test_engine();
+  void test_thread_pool();
+  void test_bad_fd();
+  void test_cancel();
+  void test_wait();
+
+private:
+  void         verify_write(torrent::DiskIo* disk_io);
+  void         verify_fdatasync(torrent::DiskIo* disk_io);
+  int          wait_for_result(int* result);
+
+  int          m_fd{-1};
+  std::string  m_path;
+};
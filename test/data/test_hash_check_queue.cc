@@ -160,6 +160,82 @@ test_hash_check_queue::test_erase() {
   // CLEANUP_CHUNK_LIST();
 }
 
+void
+test_hash_check_queue::test_workers() {
+  SETUP_CHUNK_LIST();
+  torrent::HashCheckQueue hash_queue;
+
+  done_chunks_type done_chunks;
+  hash_queue.slot_chunk_done() = std::bind(&chunk_done, &done_chunks, std::placeholders::_1, std::placeholders::_2);
+
+  hash_queue.set_worker_count(4);
+  CPPUNIT_ASSERT(hash_queue.worker_count() == 4);
+
+  handle_list handles;
+
+  for (unsigned int i = 0; i < 20; i++) {
+    handles.push_back(chunk_list->get(i, torrent::ChunkList::get_not_hashing | torrent::ChunkList::get_blocking));
+
+    hash_queue.push_back(new torrent::HashChunk(handles.back()));
+  }
+
+  // The workers own the queue, so perform should not touch it.
+  hash_queue.perform();
+
+  for (unsigned int i = 0; i < 20; i++)
+    CPPUNIT_ASSERT(wait_for_true(std::bind(&verify_hash, &done_chunks, i, hash_for_index(i))));
+
+  uint64_t worker_chunks = 0;
+
+  for (unsigned int i = 0; i < hash_queue.worker_count(); i++)
+    worker_chunks += hash_queue.worker_chunks(i);
+
+  CPPUNIT_ASSERT(worker_chunks == 20);
+  CPPUNIT_ASSERT(hash_queue.empty());
+
+  hash_queue.set_worker_count(0);
+  CPPUNIT_ASSERT(hash_queue.worker_count() == 0);
+
+  for (unsigned int i = 0; i < 20; i++)
+    chunk_list->release(&handles[i], torrent::ChunkList::release_default);
+
+  CLEANUP_CHUNK_LIST();
+}
+
+void
+test_hash_check_queue::test_workers_stop_pending() {
+  SETUP_CHUNK_LIST();
+
+  torrent::HashCheckQueue* hash_queue = torrent::thread_disk()->hash_check_queue();
+
+  done_chunks_type done_chunks;
+  hash_queue->slot_chunk_done() = std::bind(&chunk_done, &done_chunks, std::placeholders::_1, std::placeholders::_2);
+
+  hash_queue->set_worker_count(1);
+
+  handle_list handles;
+
+  for (unsigned int i = 0; i < 20; i++) {
+    handles.push_back(chunk_list->get(i, torrent::ChunkList::get_not_hashing | torrent::ChunkList::get_blocking));
+
+    hash_queue->push_back(new torrent::HashChunk(handles.back()));
+  }
+
+  // Whatever the worker left behind must be picked up by thread_disk
+  // without anyone else interrupting it.
+  hash_queue->set_worker_count(0);
+
+  for (unsigned int i = 0; i < 20; i++)
+    CPPUNIT_ASSERT(wait_for_true(std::bind(&verify_hash, &done_chunks, i, hash_for_index(i))));
+
+  CPPUNIT_ASSERT(hash_queue->empty());
+
+  for (unsigned int i = 0; i < 20; i++)
+    chunk_list->release(&handles[i], torrent::ChunkList::release_default);
+
+  CLEANUP_CHUNK_LIST();
+}
+
 void
 test_hash_check_queue::test_thread_interrupt() {
   SETUP_CHUNK_LIST();
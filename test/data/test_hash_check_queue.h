@@ -15,6 +15,8 @@ class test_hash_check_queue : public TestFixtureWithMainAndDiskThread {
   CPPUNIT_TEST(test_single);
   CPPUNIT_TEST(test_multiple);
   CPPUNIT_TEST(test_erase);
+  CPPUNIT_TEST(test_workers);
+  CPPUNIT_TEST(test_workers_stop_pending);
 
   CPPUNIT_TEST(test_thread_interrupt);
 
@@ -24,6 +26,8 @@ public:
   void test_single();
   void test_multiple();
   void test_erase();
+  void test_workers();
+  void test_workers_stop_pending();
 
   void test_thread_interrupt();
 };
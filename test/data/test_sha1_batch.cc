@@ -0,0 +1,126 @@
+#include "config.h"
+
+#include "test_sha1_batch.h"
+
+#include <random>
+#include <vector>
+
+#include "helpers/test_utils.h"
+#include "torrent/hash_string.h"
+#include "utils/sha1.h"
+#include "utils/sha1_batch.h"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(test_sha1_batch, "data");
+
+namespace {
+
+using segment_type = torrent::Sha1Batch::segment_type;
+using segment_list = torrent::Sha1Batch::segment_list;
+
+const torrent::Sha1Batch::engine_type all_engines[] = {
+  torrent::Sha1Batch::ENGINE_OPENSSL,
+  torrent::Sha1Batch::ENGINE_SIMD_X4,
+  torrent::Sha1Batch::ENGINE_SIMD_X8,
+  torrent::Sha1Batch::ENGINE_SIMD_X16,
+};
+
+std::string
+openssl_digest(const segment_list& segments) {
+  torrent::Sha1 sha1;
+  char digest[20];
+
+  sha1.init();
+
+  for (const auto& segment : segments)
+    sha1.update(segment.first, segment.second);
+
+  sha1.final_c(digest);
+  return std::string(digest, 20);
+}
+
+bool
+verify_batch(torrent::Sha1Batch::engine_type engine, const std::vector<segment_list>& messages) {
+  torrent::Sha1Batch batch(engine);
+
+  for (const auto& segments : messages)
+    batch.push_back(segments);
+
+  std::vector<char> digests(messages.size() * 20);
+  batch.perform(digests.data());
+
+  for (size_t i = 0; i < messages.size(); i++)
+    if (std::string(digests.data() + i * 20, 20) != openssl_digest(messages[i]))
+      return false;
+
+  return true;
+}
+
+} // namespace
+
+void
+test_sha1_batch::test_basic() {
+  torrent::Sha1Batch batch;
+
+  CPPUNIT_ASSERT(batch.empty());
+  CPPUNIT_ASSERT(batch.engine() == torrent::Sha1Batch::default_engine());
+  CPPUNIT_ASSERT(batch.lanes() >= 1 && batch.lanes() <= torrent::Sha1Batch::max_lanes);
+
+  CPPUNIT_ASSERT(batch.push_back(segment_list{segment_type("abc", 3)}) == 0);
+  CPPUNIT_ASSERT(batch.push_back(segment_list{}) == 1);
+  CPPUNIT_ASSERT(batch.size() == 2);
+
+  char digests[40];
+  batch.perform(digests);
+
+  CPPUNIT_ASSERT(torrent::hash_string_to_hex_str(*torrent::HashString::cast_from(digests)) == "A9993E364706816ABA3E25717850C26C9CD0D89D");
+  CPPUNIT_ASSERT(torrent::hash_string_to_hex_str(*torrent::HashString::cast_from(digests + 20)) == "DA39A3EE5E6B4B0D3255BFEF95601890AFD80709");
+}
+
+void
+test_sha1_batch::test_segments() {
+  auto data = create_random_data(1 << 16);
+
+  // Lengths around the 55, 56 and 64 byte padding boundaries, and
+  // segments splitting blocks at odd offsets.
+  for (auto engine : all_engines) {
+    if (!torrent::Sha1Batch::is_engine_supported(engine))
+      continue;
+
+    std::vector<segment_list> messages;
+
+    for (uint32_t length = 0; length < 200; length++)
+      messages.push_back(segment_list{segment_type(data.data(), length)});
+
+    for (uint32_t split = 0; split < 130; split++)
+      messages.push_back(segment_list{segment_type(data.data(), split), segment_type(data.data() + 1000, 0),
+                                      segment_type(data.data() + 2000, 130 - split), segment_type(data.data() + 3000, 7)});
+
+    CPPUNIT_ASSERT(verify_batch(engine, messages));
+  }
+}
+
+void
+test_sha1_batch::test_engines() {
+  auto data = create_random_data(1 << 20);
+  std::mt19937 rng(0);
+
+  for (auto engine : all_engines) {
+    if (!torrent::Sha1Batch::is_engine_supported(engine))
+      continue;
+
+    for (int iteration = 0; iteration < 20; iteration++) {
+      std::vector<segment_list> messages(rng() % 40 + 1);
+
+      for (auto& segments : messages) {
+        for (unsigned int count = rng() % 5; count != 0; count--) {
+          uint32_t length = rng() % 3 ? rng() % 300 : rng() % (64 << 10);
+          uint32_t offset = rng() % (data.size() - length);
+
+          segments.emplace_back(data.data() + offset, length);
+        }
+      }
+
+      CPPUNIT_ASSERT(verify_batch(engine, messages));
+    }
+  }
+}
@@ -0,0 +1,16 @@
+#include "helpers/test_fixture.h"
+
+class test_sha1_batch : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_sha1_batch);
+
+  CPPUNIT_TEST(test_basic);
+  CPPUNIT_TEST(test_segments);
+  CPPUNIT_TEST(test_engines);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_basic();
+  void test_segments();
+  void test_engines();
+};
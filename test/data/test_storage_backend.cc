@@ -0,0 +1,153 @@
+#include "config.h"
+
+#include "test_storage_backend.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <unistd.h>
+#include <vector>
+
+#include "data/storage_backend.h"
+#include "helpers/test_utils.h"
+#include "torrent/chunk_manager.h"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(test_storage_backend, "data");
+
+namespace {
+
+void
+write_file(int fd, const std::vector<char>& data) {
+  CPPUNIT_ASSERT(ftruncate(fd, 0) == 0);
+  CPPUNIT_ASSERT(pwrite(fd, data.data(), data.size(), 0) == static_cast<ssize_t>(data.size()));
+}
+
+torrent::StorageBackendPread*
+pread_backend() {
+  return static_cast<torrent::StorageBackendPread*>(torrent::StorageBackend::from_type(torrent::ChunkManager::storage_backend_pread));
+}
+
+const uint32_t all_backends[] = {
+  torrent::ChunkManager::storage_backend_mmap,
+  torrent::ChunkManager::storage_backend_pread,
+};
+
+} // namespace
+
+void
+test_storage_backend::setUp() {
+  test_fixture::setUp();
+
+  char path[] = "/tmp/libtorrent_test_storage_XXXXXX";
+
+  m_fd = mkstemp(path);
+  m_path = path;
+
+  CPPUNIT_ASSERT(m_fd != -1);
+}
+
+void
+test_storage_backend::tearDown() {
+  ::close(m_fd);
+  ::unlink(m_path.c_str());
+
+  test_fixture::tearDown();
+}
+
+void
+test_storage_backend::test_read() {
+  auto data = create_random_data(1 << 20);
+  write_file(m_fd, data);
+
+  for (auto type : all_backends) {
+    auto backend = torrent::StorageBackend::from_type(type);
+
+    for (uint64_t offset : { 0u, 1u, 4095u, 4096u, 12345u }) {
+      auto mc = backend->create_chunk(m_fd, offset, 64 << 10, torrent::MemoryChunk::prot_read);
+
+      CPPUNIT_ASSERT(mc.is_valid());
+      CPPUNIT_ASSERT(mc.size() == (64 << 10));
+      CPPUNIT_ASSERT(std::equal(mc.begin(), mc.end(), data.begin() + offset));
+
+      backend->release_chunk(mc);
+    }
+  }
+}
+
+void
+test_storage_backend::test_write() {
+  auto prot = torrent::MemoryChunk::prot_read | torrent::MemoryChunk::prot_write;
+
+  for (auto type : all_backends) {
+    auto data = create_random_data(256 << 10);
+    write_file(m_fd, data);
+
+    auto backend = torrent::StorageBackend::from_type(type);
+    auto mc = backend->create_chunk(m_fd, 1000, 100 << 10, prot);
+
+    CPPUNIT_ASSERT(mc.is_valid());
+
+    std::fill(mc.begin(), mc.end(), 'x');
+    std::fill(data.begin() + 1000, data.begin() + 1000 + (100 << 10), 'x');
+
+    CPPUNIT_ASSERT(backend->write_chunk(m_fd, 1000, mc, torrent::MemoryChunk::sync_sync));
+    backend->release_chunk(mc);
+
+    std::vector<char> result(data.size());
+
+    CPPUNIT_ASSERT(pread(m_fd, result.data(), result.size(), 0) == static_cast<ssize_t>(result.size()));
+    CPPUNIT_ASSERT(result == data);
+  }
+}
+
+void
+test_storage_backend::test_out_of_range() {
+  write_file(m_fd, create_random_data(64 << 10));
+
+  for (auto type : all_backends) {
+    auto backend = torrent::StorageBackend::from_type(type);
+
+    CPPUNIT_ASSERT(!backend->create_chunk(m_fd, 0, 0, torrent::MemoryChunk::prot_read).is_valid());
+    CPPUNIT_ASSERT(!backend->create_chunk(m_fd, 1, 64 << 10, torrent::MemoryChunk::prot_read).is_valid());
+    CPPUNIT_ASSERT(!backend->create_chunk(m_fd, 128 << 10, 1, torrent::MemoryChunk::prot_read).is_valid());
+  }
+}
+
+void
+test_storage_backend::test_pool() {
+  write_file(m_fd, create_random_data(256 << 10));
+
+  auto backend = pread_backend();
+  auto max_pooled = backend->max_pooled();
+
+  CPPUNIT_ASSERT(torrent::StorageBackendPread::buffer_size_class(1) == torrent::MemoryChunk::page_size());
+  CPPUNIT_ASSERT(torrent::StorageBackendPread::buffer_size_class(100 << 10) == (128 << 10));
+  CPPUNIT_ASSERT(torrent::StorageBackendPread::buffer_size_class(128 << 10) == (128 << 10));
+
+  backend->set_max_pooled(0);
+  backend->set_max_pooled(256 << 10);
+
+  auto mc1 = backend->create_chunk(m_fd, 0, 100 << 10, torrent::MemoryChunk::prot_read);
+  auto mc2 = backend->create_chunk(m_fd, 0, 128 << 10, torrent::MemoryChunk::prot_read);
+  auto mc3 = backend->create_chunk(m_fd, 0, 128 << 10, torrent::MemoryChunk::prot_read);
+  char* ptr1 = mc1.ptr();
+
+  CPPUNIT_ASSERT(reinterpret_cast<uintptr_t>(mc1.ptr()) % torrent::MemoryChunk::page_size() == 0);
+
+  backend->release_chunk(mc1);
+  backend->release_chunk(mc2);
+  CPPUNIT_ASSERT(backend->pooled_bytes() == (256 << 10));
+
+  // Pool is full, so this buffer gets freed.
+  backend->release_chunk(mc3);
+  CPPUNIT_ASSERT(backend->pooled_bytes() == (256 << 10));
+
+  auto mc4 = backend->create_chunk(m_fd, 0, 128 << 10, torrent::MemoryChunk::prot_read);
+  CPPUNIT_ASSERT(backend->pooled_bytes() == (128 << 10));
+  CPPUNIT_ASSERT(mc4.ptr() == ptr1 || mc4.ptr() == mc2.ptr());
+
+  backend->release_chunk(mc4);
+  backend->set_max_pooled(0);
+  CPPUNIT_ASSERT(backend->pooled_bytes() == 0);
+
+  backend->set_max_pooled(max_pooled);
+}
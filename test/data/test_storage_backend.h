@@ -0,0 +1,25 @@
+#include "helpers/test_fixture.h"
+
+class test_storage_backend : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_storage_backend);
+
+  CPPUNIT_TEST(test_read);
+  CPPUNIT_TEST(test_write);
+  CPPUNIT_TEST(test_out_of_range);
+  CPPUNIT_TEST(test_pool);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp() override;
+  void tearDown() override;
+
+  void test_read();
+  void test_write();
+  void test_out_of_range();
+  void test_pool();
+
+private:
+  int          m_fd{-1};
+  std::string  m_path;
+};
@@ -0,0 +1,94 @@
+#include "config.h"
+
+#include "test_chunk_rarity_index.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "torrent/exceptions.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestChunkRarityIndex);
+
+using index_list = std::vector<std::pair<uint32_t, uint32_t>>;
+
+// Returns (count, index) pairs in visiting order, sorted by index
+// within each count.
+static index_list
+rarest_list(const torrent::ChunkRarityIndex& rarity_index, unsigned int max_size = ~0u) {
+  index_list result;
+
+  rarity_index.for_each_rarest([&](uint32_t index, uint32_t count) {
+      result.emplace_back(count, index);
+      return result.size() < max_size;
+    });
+
+  std::stable_sort(result.begin(), result.end());
+  return result;
+}
+
+void
+TestChunkRarityIndex::test_basic() {
+  torrent::ChunkRarityIndex rarity_index;
+  rarity_index.initialize(8);
+
+  CPPUNIT_ASSERT(rarity_index.size() == 0);
+  CPPUNIT_ASSERT(rarest_list(rarity_index).empty());
+
+  rarity_index.link(3, 2);
+  rarity_index.link(5, 0);
+  rarity_index.link(1, 2);
+  rarity_index.link(7, 10);
+
+  CPPUNIT_ASSERT(rarity_index.size() == 4);
+  CPPUNIT_ASSERT(rarity_index.is_linked(3) && !rarity_index.is_linked(4));
+  CPPUNIT_ASSERT((rarest_list(rarity_index) == index_list{{0, 5}, {2, 1}, {2, 3}, {10, 7}}));
+  CPPUNIT_ASSERT((rarest_list(rarity_index, 1) == index_list{{0, 5}}));
+
+  CPPUNIT_ASSERT_THROW(rarity_index.link(3, 1), torrent::internal_error);
+  CPPUNIT_ASSERT_THROW(rarity_index.link(8, 1), torrent::internal_error);
+  CPPUNIT_ASSERT_THROW(rarity_index.unlink(4, 1), torrent::internal_error);
+}
+
+void
+TestChunkRarityIndex::test_move() {
+  torrent::ChunkRarityIndex rarity_index;
+  rarity_index.initialize(8);
+
+  rarity_index.link(0, 1);
+  rarity_index.link(1, 1);
+  rarity_index.link(2, 1);
+
+  rarity_index.move(1, 1, 0);
+  rarity_index.move(0, 1, 3);
+  rarity_index.move(6, 1, 3);
+
+  CPPUNIT_ASSERT(rarity_index.size() == 3);
+  CPPUNIT_ASSERT(!rarity_index.is_linked(6));
+  CPPUNIT_ASSERT((rarest_list(rarity_index) == index_list{{0, 1}, {1, 2}, {3, 0}}));
+}
+
+void
+TestChunkRarityIndex::test_unlink() {
+  torrent::ChunkRarityIndex rarity_index;
+  rarity_index.initialize(8);
+
+  for (uint32_t i = 0; i < 6; i++)
+    rarity_index.link(i, i % 2);
+
+  rarity_index.unlink(2, 0);
+  rarity_index.unlink(4, 0);
+  rarity_index.unlink(5, 1);
+
+  CPPUNIT_ASSERT(rarity_index.size() == 3);
+  CPPUNIT_ASSERT((rarest_list(rarity_index) == index_list{{0, 0}, {1, 1}, {1, 3}}));
+
+  rarity_index.unlink_all();
+
+  CPPUNIT_ASSERT(rarity_index.size() == 0);
+  CPPUNIT_ASSERT(!rarity_index.is_linked(0));
+  CPPUNIT_ASSERT(rarest_list(rarity_index).empty());
+
+  rarity_index.link(0, 4);
+  CPPUNIT_ASSERT((rarest_list(rarity_index) == index_list{{4, 0}}));
+}
@@ -0,0 +1,19 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "download/chunk_rarity_index.h"
+
+class TestChunkRarityIndex : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(TestChunkRarityIndex);
+  CPPUNIT_TEST(test_basic);
+  CPPUNIT_TEST(test_move);
+  CPPUNIT_TEST(test_unlink);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp() override {}
+  void tearDown() override {}
+
+  void test_basic();
+  void test_move();
+  void test_unlink();
+};
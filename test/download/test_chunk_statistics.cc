@@ -0,0 +1,64 @@
+#include "config.h"
+
+#include "test_chunk_statistics.h"
+
+#include <memory>
+#include <vector>
+
+#include "protocol/peer_chunks.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestChunkStatistics);
+
+static std::unique_ptr<torrent::PeerChunks>
+new_peer_chunks(uint32_t size, std::initializer_list<uint32_t> indices) {
+  auto peer_chunks = std::make_unique<torrent::PeerChunks>();
+
+  peer_chunks->bitfield()->set_size_bits(size);
+  peer_chunks->bitfield()->allocate();
+  peer_chunks->bitfield()->unset_all();
+
+  for (auto index : indices)
+    peer_chunks->bitfield()->set(index);
+
+  return peer_chunks;
+}
+
+void
+TestChunkStatistics::test_saturated_counts() {
+  torrent::ChunkStatistics chunk_statistics;
+  chunk_statistics.initialize(4);
+
+  const uint8_t* counts = chunk_statistics.saturated_counts();
+  CPPUNIT_ASSERT(counts[0] == 0 && counts[1] == 0 && counts[2] == 0 && counts[3] == 0);
+
+  std::vector<std::unique_ptr<torrent::PeerChunks>> peers;
+
+  for (int i = 0; i < 300; i++) {
+    peers.push_back(new_peer_chunks(4, {0, 2}));
+    chunk_statistics.received_connect(peers.back().get());
+  }
+
+  peers.push_back(new_peer_chunks(4, {1, 2}));
+  chunk_statistics.received_connect(peers.back().get());
+
+  // The same buffer is updated in place as peers connect.
+  CPPUNIT_ASSERT(chunk_statistics.saturated_counts() == counts);
+  CPPUNIT_ASSERT(chunk_statistics.rarity(0) == 300 && counts[0] == 255);
+  CPPUNIT_ASSERT(chunk_statistics.rarity(1) == 1 && counts[1] == 1);
+  CPPUNIT_ASSERT(chunk_statistics.rarity(2) == 301 && counts[2] == 255);
+  CPPUNIT_ASSERT(counts[3] == 0);
+
+  while (peers.size() > 201) {
+    chunk_statistics.received_disconnect(peers.front().get());
+    peers.erase(peers.begin());
+  }
+
+  CPPUNIT_ASSERT(counts[0] == 200 && counts[1] == 1 && counts[2] == 201 && counts[3] == 0);
+
+  for (auto& peer_chunks : peers)
+    chunk_statistics.received_disconnect(peer_chunks.get());
+
+  CPPUNIT_ASSERT(counts[0] == 0 && counts[1] == 0 && counts[2] == 0 && counts[3] == 0);
+
+  chunk_statistics.clear();
+}
@@ -0,0 +1,12 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "download/chunk_statistics.h"
+
+class TestChunkStatistics : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(TestChunkStatistics);
+  CPPUNIT_TEST(test_saturated_counts);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_saturated_counts();
+};
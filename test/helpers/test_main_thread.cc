@@ -82,6 +82,7 @@ TestFixtureWithMainAndDiskThread::setUp() {
 
 void
 TestFixtureWithMainAndDiskThread::tearDown() {
+  torrent::thread_disk()->hash_check_queue()->set_worker_count(0);
   torrent::thread_disk()->stop_thread_wait();
   delete torrent::thread_disk();
 
@@ -2,6 +2,8 @@
 #define LIBTORRENT_TEST_UTILS_H
 
 #include <functional>
+#include <random>
+#include <vector>
 #include <unistd.h>
 
 inline bool
@@ -18,4 +20,16 @@ wait_for_true(std::function<bool ()> test_function) {
   return false;
 }
 
+// Deterministic for a given size.
+inline std::vector<char>
+create_random_data(size_t size) {
+  std::mt19937 rng(size);
+  std::vector<char> data(size);
+
+  for (auto& c : data)
+    c = rng();
+
+  return data;
+}
+
 #endif // LIBTORRENT_TEST_UTILS_H
@@ -0,0 +1,160 @@
+#include "config.h"
+
+#include "test_socket_datagram.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "net/socket_datagram.h"
+#include "torrent/exceptions.h"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(test_socket_datagram, "net");
+
+namespace {
+
+class test_datagram : public torrent::SocketDatagram {
+public:
+  test_datagram(int fd)   { set_fd(torrent::SocketFd(fd)); }
+  ~test_datagram() override { set_fd(torrent::SocketFd()); }
+
+  void event_read() override  {}
+  void event_write() override {}
+  void event_error() override {}
+};
+
+int
+open_udp_loopback(sockaddr_in* sa) {
+  int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+
+  if (fd == -1)
+    return -1;
+
+  std::memset(sa, 0, sizeof(sockaddr_in));
+  sa->sin_family = AF_INET;
+  sa->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  socklen_t length = sizeof(sockaddr_in);
+
+  if (::bind(fd, reinterpret_cast<sockaddr*>(sa), sizeof(sockaddr_in)) == -1 ||
+      ::getsockname(fd, reinterpret_cast<sockaddr*>(sa), &length) == -1 ||
+      ::fcntl(fd, F_SETFL, O_NONBLOCK) == -1) {
+    ::close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+} // namespace
+
+void
+test_socket_datagram::setUp() {
+  test_fixture::setUp();
+
+  sockaddr_in sender_address;
+
+  m_sender = open_udp_loopback(&sender_address);
+  m_receiver = open_udp_loopback(&m_receiver_address);
+
+  CPPUNIT_ASSERT(m_sender != -1);
+  CPPUNIT_ASSERT(m_receiver != -1);
+}
+
+void
+test_socket_datagram::tearDown() {
+  ::close(m_sender);
+  ::close(m_receiver);
+
+  test_fixture::tearDown();
+}
+
+void
+test_socket_datagram::test_batch() {
+  torrent::DatagramBatch batch(2, 0);
+
+  CPPUNIT_ASSERT(batch.capacity() == 2);
+  CPPUNIT_ASSERT(batch.empty());
+
+  batch.push_back("a", 1, nullptr);
+  batch.push_back("b", 1, nullptr);
+
+  CPPUNIT_ASSERT(batch.size() == 2);
+  CPPUNIT_ASSERT(batch.full());
+  CPPUNIT_ASSERT_THROW(batch.push_back("c", 1, nullptr), torrent::internal_error);
+
+  // Send-only batches have no receive buffers.
+  CPPUNIT_ASSERT_THROW(batch.prepare_read(), torrent::internal_error);
+
+  batch.clear();
+  CPPUNIT_ASSERT(batch.empty());
+
+  CPPUNIT_ASSERT_THROW(torrent::DatagramBatch(0, 0), torrent::internal_error);
+}
+
+void
+test_socket_datagram::test_write_read() {
+  std::string messages[3] = { "first", "second datagram", "third" };
+
+  test_datagram sender(m_sender);
+  test_datagram receiver(m_receiver);
+
+  torrent::DatagramBatch write_batch(8, 0);
+
+  for (const auto& message : messages)
+    write_batch.push_back(message.data(), message.size(), reinterpret_cast<sockaddr*>(&m_receiver_address));
+
+  CPPUNIT_ASSERT(sender.write_datagrams(write_batch) == 3);
+
+  for (unsigned int i = 0; i != 3; i++)
+    CPPUNIT_ASSERT(write_batch.length(i) == messages[i].size());
+
+  torrent::DatagramBatch read_batch(8, 2048);
+
+  CPPUNIT_ASSERT(receiver.read_datagrams(read_batch) == 3);
+  CPPUNIT_ASSERT(read_batch.size() == 3);
+
+  for (unsigned int i = 0; i != 3; i++) {
+    CPPUNIT_ASSERT(std::string(read_batch.data(i), read_batch.length(i)) == messages[i]);
+    CPPUNIT_ASSERT(read_batch.address(i)->sa_family == AF_INET);
+  }
+
+  // Sending again from an offset only sends the remaining entries.
+  CPPUNIT_ASSERT(sender.write_datagrams(write_batch, 2) == 1);
+  CPPUNIT_ASSERT(receiver.read_datagrams(read_batch) == 1);
+  CPPUNIT_ASSERT(std::string(read_batch.data(0), read_batch.length(0)) == messages[2]);
+
+  CPPUNIT_ASSERT_THROW(sender.write_datagrams(write_batch, 3), torrent::internal_error);
+}
+
+void
+test_socket_datagram::test_read_empty() {
+  test_datagram receiver(m_receiver);
+  torrent::DatagramBatch read_batch(4, 2048);
+
+  CPPUNIT_ASSERT(receiver.read_datagrams(read_batch) == -1);
+  CPPUNIT_ASSERT(errno == EAGAIN || errno == EWOULDBLOCK);
+  CPPUNIT_ASSERT(read_batch.empty());
+}
+
+void
+test_socket_datagram::test_read_capacity() {
+  test_datagram sender(m_sender);
+  test_datagram receiver(m_receiver);
+
+  torrent::DatagramBatch write_batch(5, 0);
+
+  for (int i = 0; i != 5; i++)
+    write_batch.push_back("data", 4, reinterpret_cast<sockaddr*>(&m_receiver_address));
+
+  CPPUNIT_ASSERT(sender.write_datagrams(write_batch) == 5);
+
+  torrent::DatagramBatch read_batch(3, 16);
+
+  CPPUNIT_ASSERT(receiver.read_datagrams(read_batch) == 3);
+  CPPUNIT_ASSERT(receiver.read_datagrams(read_batch) == 2);
+  CPPUNIT_ASSERT(receiver.read_datagrams(read_batch) == -1);
+}
@@ -0,0 +1,26 @@
+#include "helpers/test_fixture.h"
+
+class test_socket_datagram : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_socket_datagram);
+
+  CPPUNIT_TEST(test_batch);
+  CPPUNIT_TEST(test_write_read);
+  CPPUNIT_TEST(test_read_empty);
+  CPPUNIT_TEST(test_read_capacity);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp() override;
+  void tearDown() override;
+
+  void test_batch();
+  void test_write_read();
+  void test_read_empty();
+  void test_read_capacity();
+
+private:
+  int          m_sender{-1};
+  int          m_receiver{-1};
+  sockaddr_in  m_receiver_address{};
+};
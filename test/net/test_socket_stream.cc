@@ -0,0 +1,153 @@
+#include "config.h"
+
+#include "test_socket_stream.h"
+
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "net/socket_stream.h"
+#include "torrent/connection_manager.h"
+#include "torrent/exceptions.h"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(test_socket_stream, "net");
+
+namespace {
+
+class test_stream : public torrent::SocketStream {
+public:
+  test_stream(int fd)   { set_fd(torrent::SocketFd(fd)); }
+  ~test_stream() override { set_fd(torrent::SocketFd()); }
+
+  void event_read() override  {}
+  void event_write() override {}
+  void event_error() override {}
+};
+
+} // namespace
+
+void
+test_socket_stream::setUp() {
+  test_fixture::setUp();
+
+  char path[] = "/tmp/libtorrent_test_socket_stream_XXXXXX";
+
+  m_file_fd = mkstemp(path);
+  m_path = path;
+
+  CPPUNIT_ASSERT(m_file_fd != -1);
+  CPPUNIT_ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, m_sockets) == 0);
+}
+
+void
+test_socket_stream::tearDown() {
+  ::close(m_sockets[0]);
+  ::close(m_sockets[1]);
+  ::close(m_file_fd);
+  ::unlink(m_path.c_str());
+
+  test_fixture::tearDown();
+}
+
+void
+test_socket_stream::test_sendfile() {
+  if (!torrent::ConnectionManager::is_upload_sendfile_supported())
+    return;
+
+  std::vector<char> data(16 << 10);
+
+  for (size_t i = 0; i < data.size(); i++)
+    data[i] = i * 13;
+
+  CPPUNIT_ASSERT(pwrite(m_file_fd, data.data(), data.size(), 0) == static_cast<ssize_t>(data.size()));
+
+  test_stream stream(m_sockets[0]);
+
+  CPPUNIT_ASSERT(stream.sendfile_stream_throws(m_file_fd, 1000, 4000) == 4000);
+
+  std::vector<char> buffer(4000);
+
+  CPPUNIT_ASSERT(recv(m_sockets[1], buffer.data(), buffer.size(), MSG_WAITALL) == 4000);
+  CPPUNIT_ASSERT(std::equal(buffer.begin(), buffer.end(), data.begin() + 1000));
+
+  // The file offset is not modified.
+  CPPUNIT_ASSERT(lseek(m_file_fd, 0, SEEK_CUR) == 0);
+}
+
+void
+test_socket_stream::test_sendfile_end_of_file() {
+  if (!torrent::ConnectionManager::is_upload_sendfile_supported())
+    return;
+
+  std::vector<char> data(1000);
+  CPPUNIT_ASSERT(pwrite(m_file_fd, data.data(), data.size(), 0) == static_cast<ssize_t>(data.size()));
+
+  test_stream stream(m_sockets[0]);
+
+  CPPUNIT_ASSERT_THROW(stream.sendfile_stream_throws(m_file_fd, 1000, 100), torrent::storage_error);
+}
+
+void
+test_socket_stream::test_write_vector() {
+  std::string header("header");
+  std::string first("first part ");
+  std::string second("second part");
+
+  iovec vectors[3] = {
+    { &header[0], header.size() },
+    { &first[0],  first.size() },
+    { &second[0], second.size() }
+  };
+
+  test_stream stream(m_sockets[0]);
+
+  uint32_t length = header.size() + first.size() + second.size();
+
+  CPPUNIT_ASSERT(stream.write_vector_throws(vectors, 3) == length);
+
+  std::vector<char> buffer(length);
+
+  CPPUNIT_ASSERT(recv(m_sockets[1], buffer.data(), buffer.size(), MSG_WAITALL) == static_cast<ssize_t>(length));
+  CPPUNIT_ASSERT(std::string(buffer.begin(), buffer.end()) == header + first + second);
+
+  CPPUNIT_ASSERT_THROW(stream.write_vector(vectors, 0), torrent::internal_error);
+}
+
+void
+test_socket_stream::test_read_vector() {
+  std::string data("0123456789abcdef");
+
+  CPPUNIT_ASSERT(send(m_sockets[1], data.data(), data.size(), 0) == static_cast<ssize_t>(data.size()));
+
+  char first[4];
+  char second[16];
+
+  iovec vectors[2] = {
+    { first,  sizeof(first) },
+    { second, sizeof(second) }
+  };
+
+  test_stream stream(m_sockets[0]);
+
+  CPPUNIT_ASSERT(stream.read_vector_throws(vectors, 2) == data.size());
+  CPPUNIT_ASSERT(std::string(first, 4) == "0123");
+  CPPUNIT_ASSERT(std::string(second, 12) == "456789abcdef");
+
+  // Nothing more to read on a non-blocking socket.
+  CPPUNIT_ASSERT(fcntl(m_sockets[0], F_SETFL, O_NONBLOCK) == 0);
+  CPPUNIT_ASSERT(stream.read_vector_throws(vectors, 2) == 0);
+}
+
+void
+test_socket_stream::test_read_vector_closed() {
+  ::shutdown(m_sockets[1], SHUT_WR);
+
+  char buffer[16];
+  iovec vectors[1] = { { buffer, sizeof(buffer) } };
+
+  test_stream stream(m_sockets[0]);
+
+  CPPUNIT_ASSERT_THROW(stream.read_vector_throws(vectors, 1), torrent::close_connection);
+}
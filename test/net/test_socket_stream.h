@@ -0,0 +1,28 @@
+#include "helpers/test_fixture.h"
+
+class test_socket_stream : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_socket_stream);
+
+  CPPUNIT_TEST(test_sendfile);
+  CPPUNIT_TEST(test_sendfile_end_of_file);
+  CPPUNIT_TEST(test_write_vector);
+  CPPUNIT_TEST(test_read_vector);
+  CPPUNIT_TEST(test_read_vector_closed);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp() override;
+  void tearDown() override;
+
+  void test_sendfile();
+  void test_sendfile_end_of_file();
+  void test_write_vector();
+  void test_read_vector();
+  void test_read_vector_closed();
+
+private:
+  int          m_file_fd{-1};
+  std::string  m_path;
+  int          m_sockets[2]{-1, -1};
+};
@@ -0,0 +1,149 @@
+#include "config.h"
+
+#include "test_throttle.h"
+
+#include "net/throttle_list.h"
+#include "net/throttle_node.h"
+#include "torrent/exceptions.h"
+#include "torrent/throttle.h"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(test_throttle, "net");
+
+namespace {
+
+struct throttle_guard {
+  throttle_guard() : root(torrent::Throttle::create_throttle()) {}
+  ~throttle_guard() { torrent::Throttle::destroy_throttle(root); }
+
+  torrent::Throttle* root;
+};
+
+}
+
+void
+test_throttle::test_node_states() {
+  torrent::ThrottleList list;
+  torrent::ThrottleNode node(30);
+
+  unsigned int activated = 0;
+  node.set_list_iterator(list.end());
+  node.slot_activate() = [&activated] { activated++; };
+
+  list.enable();
+  list.insert(&node);
+
+  CPPUNIT_ASSERT(list.is_throttled(&node));
+  CPPUNIT_ASSERT(list.is_active(&node));
+  CPPUNIT_ASSERT(!list.is_inactive(&node));
+
+  list.node_deactivate(&node);
+
+  CPPUNIT_ASSERT(!list.is_active(&node));
+  CPPUNIT_ASSERT(list.is_inactive(&node));
+  CPPUNIT_ASSERT_THROW(list.node_quota(&node), torrent::internal_error);
+
+  // Quota given to the list becomes available to nodes on the
+  // following update.
+  list.update_quota(1 << 16);
+  CPPUNIT_ASSERT(list.is_inactive(&node));
+
+  list.update_quota(1 << 16);
+  CPPUNIT_ASSERT(list.is_active(&node));
+  CPPUNIT_ASSERT(activated == 1);
+  CPPUNIT_ASSERT(list.node_quota(&node) >= list.min_chunk_size());
+
+  list.node_deactivate(&node);
+  list.erase(&node);
+
+  CPPUNIT_ASSERT(!list.is_throttled(&node));
+  CPPUNIT_ASSERT(!list.is_active(&node));
+  CPPUNIT_ASSERT(!list.is_inactive(&node));
+
+  // Disabling activates all waiting nodes.
+  list.insert(&node);
+  list.node_deactivate(&node);
+  list.disable();
+
+  CPPUNIT_ASSERT(list.is_active(&node));
+  CPPUNIT_ASSERT(activated == 2);
+
+  list.erase(&node);
+}
+
+void
+test_throttle::test_slave_shares() {
+  throttle_guard guard;
+
+  auto slave_a = guard.root->create_slave();
+  auto slave_b = guard.root->create_slave();
+
+  slave_a->set_max_rate(1000000);
+  slave_b->set_max_rate(1000000);
+
+  // Enabling the root hands out one second of quota, which is split
+  // evenly between the slaves and the root's own list.
+  guard.root->set_max_rate(1000000);
+
+  uint32_t quota_a = slave_a->throttle_list()->unthrottled_quota();
+  uint32_t quota_b = slave_b->throttle_list()->unthrottled_quota();
+  uint32_t quota_root = guard.root->throttle_list()->unthrottled_quota();
+
+  CPPUNIT_ASSERT(quota_a > 300000);
+  CPPUNIT_ASSERT(quota_a == quota_b);
+  CPPUNIT_ASSERT(quota_root >= quota_a && quota_root <= quota_a + 2);
+}
+
+void
+test_throttle::test_slave_min_rate() {
+  throttle_guard guard;
+
+  auto slave_a = guard.root->create_slave();
+  auto slave_b = guard.root->create_slave();
+
+  slave_a->set_max_rate(1000000);
+  slave_b->set_max_rate(1000000);
+  slave_a->set_min_rate(800000);
+
+  CPPUNIT_ASSERT_THROW(slave_b->set_min_rate(uint64_t(1) << 32), torrent::input_error);
+
+  guard.root->set_max_rate(1000000);
+
+  // The guaranteed rate comes first, and the rest is shared.
+  uint32_t quota_a = slave_a->throttle_list()->unthrottled_quota();
+  uint32_t quota_b = slave_b->throttle_list()->unthrottled_quota();
+
+  CPPUNIT_ASSERT(quota_a >= 800000);
+  CPPUNIT_ASSERT(quota_b > 0 && quota_b < 100000);
+  CPPUNIT_ASSERT(quota_a + quota_b <= 1000000);
+}
+
+void
+test_throttle::test_slave_idle() {
+  throttle_guard guard;
+
+  auto slave_a = guard.root->create_slave();
+  auto slave_b = guard.root->create_slave();
+
+  slave_a->set_max_rate(1000000);
+  slave_b->set_max_rate(1000000);
+  guard.root->set_max_rate(1000000);
+
+  auto list_a = slave_a->throttle_list();
+  auto list_b = slave_b->throttle_list();
+
+  // Only slave 'a' uses its quota, after a few ticks the idle slave
+  // and root list are only offered a little more than they use.
+  for (int i = 0; i < 10; i++) {
+    list_a->node_used_unthrottled(list_a->unthrottled_quota() + list_a->unallocated_quota());
+
+    m_main_thread->test_add_cached_time(1s);
+    m_main_thread->test_process_events_without_cached_time();
+  }
+
+  uint32_t quota_a = list_a->unthrottled_quota();
+  uint32_t quota_b = list_b->unthrottled_quota();
+
+  CPPUNIT_ASSERT(quota_b <= list_b->max_chunk_size());
+  CPPUNIT_ASSERT(quota_a > 4 * quota_b);
+  CPPUNIT_ASSERT(quota_a > 500000);
+}
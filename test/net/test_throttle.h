@@ -0,0 +1,18 @@
+#include "helpers/test_main_thread.h"
+
+class test_throttle : public TestFixtureWithMainThread {
+  CPPUNIT_TEST_SUITE(test_throttle);
+
+  CPPUNIT_TEST(test_node_states);
+  CPPUNIT_TEST(test_slave_shares);
+  CPPUNIT_TEST(test_slave_min_rate);
+  CPPUNIT_TEST(test_slave_idle);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_node_states();
+  void test_slave_shares();
+  void test_slave_min_rate();
+  void test_slave_idle();
+};
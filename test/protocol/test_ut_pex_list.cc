@@ -0,0 +1,208 @@
+#include "config.h"
+
+#include "test_ut_pex_list.h"
+
+#include <string>
+
+#include "torrent/exceptions.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestUtPexList);
+
+static torrent::SocketAddressCompact
+make_compact(uint32_t addr, uint16_t port) {
+  return torrent::SocketAddressCompact(htonl(addr), htons(port));
+}
+
+static torrent::SocketAddressCompact6
+make_compact6(uint8_t last, uint16_t port) {
+  in6_addr addr{};
+  addr.s6_addr[0] = 0x20;
+  addr.s6_addr[1] = 0x01;
+  addr.s6_addr[15] = last;
+
+  return torrent::SocketAddressCompact6(addr, htons(port));
+}
+
+template <typename Compact>
+static std::string
+compact_str(std::initializer_list<Compact> list) {
+  std::string result;
+
+  for (auto& sa : list)
+    result.append(sa.c_str(), sizeof(Compact));
+
+  return result;
+}
+
+static std::string
+pex_message(std::initializer_list<torrent::SocketAddressCompact> added, std::initializer_list<torrent::SocketAddressCompact> removed) {
+  auto added_str = compact_str<torrent::SocketAddressCompact>(added);
+  auto removed_str = compact_str<torrent::SocketAddressCompact>(removed);
+
+  return "d5:added" + std::to_string(added_str.size()) + ":" + added_str +
+    "7:dropped" + std::to_string(removed_str.size()) + ":" + removed_str + "e";
+}
+
+static std::string
+pex_message6(std::initializer_list<torrent::SocketAddressCompact> added, std::initializer_list<torrent::SocketAddressCompact6> added6,
+             std::initializer_list<torrent::SocketAddressCompact> removed, std::initializer_list<torrent::SocketAddressCompact6> removed6) {
+  auto added_str = compact_str<torrent::SocketAddressCompact>(added);
+  auto added6_str = compact_str<torrent::SocketAddressCompact6>(added6);
+  auto removed_str = compact_str<torrent::SocketAddressCompact>(removed);
+  auto removed6_str = compact_str<torrent::SocketAddressCompact6>(removed6);
+
+  return "d5:added" + std::to_string(added_str.size()) + ":" + added_str +
+    "6:added6" + std::to_string(added6_str.size()) + ":" + added6_str +
+    "7:dropped" + std::to_string(removed_str.size()) + ":" + removed_str +
+    "8:dropped6" + std::to_string(removed6_str.size()) + ":" + removed6_str + "e";
+}
+
+static std::string
+message_str(torrent::DataBuffer buffer) {
+  std::string result(buffer.data(), buffer.length());
+
+  buffer.clear();
+  return result;
+}
+
+void
+TestUtPexList::test_basic() {
+  torrent::UtPexList list;
+
+  list.update();
+  CPPUNIT_ASSERT(list.initial_message().empty());
+  CPPUNIT_ASSERT(list.delta_message().empty());
+
+  list.insert(make_compact(0x0a000002, 6881));
+  list.insert(make_compact(0x0a000001, 6881));
+  list.update();
+
+  CPPUNIT_ASSERT(list.advertised().size() == 2);
+  CPPUNIT_ASSERT(message_str(list.delta_message()) == pex_message({make_compact(0x0a000002, 6881), make_compact(0x0a000001, 6881)}, {}));
+  CPPUNIT_ASSERT(message_str(list.initial_message()) == pex_message({make_compact(0x0a000001, 6881), make_compact(0x0a000002, 6881)}, {}));
+
+  list.update();
+  CPPUNIT_ASSERT(list.delta_message().empty());
+  CPPUNIT_ASSERT(message_str(list.initial_message()) == pex_message({make_compact(0x0a000001, 6881), make_compact(0x0a000002, 6881)}, {}));
+
+  list.erase(make_compact(0x0a000001, 6881));
+  list.update();
+
+  CPPUNIT_ASSERT(message_str(list.delta_message()) == pex_message({}, {make_compact(0x0a000001, 6881)}));
+  CPPUNIT_ASSERT(message_str(list.initial_message()) == pex_message({make_compact(0x0a000002, 6881)}, {}));
+
+  CPPUNIT_ASSERT_THROW(list.erase(make_compact(0x0a000003, 6881)), torrent::internal_error);
+}
+
+void
+TestUtPexList::test_pending() {
+  torrent::UtPexList list;
+
+  list.insert(make_compact(0x0a000001, 6881));
+  list.erase(make_compact(0x0a000001, 6881));
+
+  CPPUNIT_ASSERT(list.added_size() == 0 && list.removed_size() == 0);
+
+  list.insert(make_compact(0x0a000001, 6881));
+  list.update();
+
+  list.erase(make_compact(0x0a000001, 6881));
+  list.insert(make_compact(0x0a000001, 6881));
+
+  CPPUNIT_ASSERT(list.added_size() == 0 && list.removed_size() == 0);
+
+  list.update();
+  CPPUNIT_ASSERT(list.delta_message().empty());
+}
+
+void
+TestUtPexList::test_shared() {
+  torrent::UtPexList list;
+
+  list.insert(make_compact(0x0a000001, 6881));
+  list.update();
+
+  auto queued = list.delta_message();
+
+  CPPUNIT_ASSERT(!queued.owned() && queued.shared());
+
+  list.insert(make_compact(0x0a000002, 6881));
+  list.update();
+
+  CPPUNIT_ASSERT(queued.data() != list.delta_message().data());
+  CPPUNIT_ASSERT(message_str(queued) == pex_message({make_compact(0x0a000001, 6881)}, {}));
+}
+
+void
+TestUtPexList::test_duplicate() {
+  torrent::UtPexList list;
+
+  list.insert(make_compact(0x0a000001, 6881));
+  list.insert(make_compact(0x0a000001, 6881));
+
+  CPPUNIT_ASSERT(list.advertised().size() == 1);
+  CPPUNIT_ASSERT(list.held_back_size() == 1);
+
+  list.update();
+  list.erase(make_compact(0x0a000001, 6881));
+
+  CPPUNIT_ASSERT(list.advertised().size() == 1);
+  CPPUNIT_ASSERT(list.held_back_size() == 0);
+
+  list.update();
+  CPPUNIT_ASSERT(list.delta_message().empty());
+
+  list.erase(make_compact(0x0a000001, 6881));
+  CPPUNIT_ASSERT(list.advertised().empty());
+}
+
+void
+TestUtPexList::test_held_back() {
+  torrent::UtPexList list;
+
+  for (uint32_t i = 0; i < torrent::UtPexList::max_size() + 2; i++)
+    list.insert(make_compact(0x0a000000 + i, 6881));
+
+  CPPUNIT_ASSERT(list.advertised().size() == torrent::UtPexList::max_size());
+  CPPUNIT_ASSERT(list.held_back_size() == 2);
+
+  list.update();
+  list.erase(make_compact(0x0a000000, 6881));
+
+  CPPUNIT_ASSERT(list.advertised().size() == torrent::UtPexList::max_size());
+  CPPUNIT_ASSERT(list.held_back_size() == 1);
+  CPPUNIT_ASSERT(list.added_size() == 1 && list.removed_size() == 1);
+
+  list.erase(make_compact(0x0a000000 + torrent::UtPexList::max_size() + 1, 6881));
+  list.erase(make_compact(0x0a000000 + torrent::UtPexList::max_size(), 6881));
+
+  CPPUNIT_ASSERT(list.advertised().size() == torrent::UtPexList::max_size() - 1);
+  CPPUNIT_ASSERT(list.held_back_size() == 0);
+  CPPUNIT_ASSERT(list.added_size() == 0 && list.removed_size() == 1);
+}
+
+void
+TestUtPexList::test_inet6() {
+  torrent::UtPexList list;
+
+  list.insert(make_compact6(1, 6881));
+  list.insert(make_compact(0x0a000001, 6881));
+  list.update();
+
+  CPPUNIT_ASSERT(list.advertised().size() == 1);
+  CPPUNIT_ASSERT(list.advertised6().size() == 1);
+  CPPUNIT_ASSERT(message_str(list.delta_message()) == pex_message6({make_compact(0x0a000001, 6881)}, {make_compact6(1, 6881)}, {}, {}));
+
+  list.insert(make_compact6(2, 6881));
+  list.erase(make_compact6(1, 6881));
+  list.update();
+
+  CPPUNIT_ASSERT(message_str(list.delta_message()) == pex_message6({}, {make_compact6(2, 6881)}, {}, {make_compact6(1, 6881)}));
+  CPPUNIT_ASSERT(message_str(list.initial_message()) == pex_message6({make_compact(0x0a000001, 6881)}, {make_compact6(2, 6881)}, {}, {}));
+
+  list.erase(make_compact6(2, 6881));
+  list.update();
+
+  CPPUNIT_ASSERT(message_str(list.delta_message()) == pex_message6({}, {}, {}, {make_compact6(2, 6881)}));
+  CPPUNIT_ASSERT(message_str(list.initial_message()) == pex_message({make_compact(0x0a000001, 6881)}, {}));
+}
@@ -0,0 +1,25 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "protocol/ut_pex_list.h"
+
+class TestUtPexList : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(TestUtPexList);
+  CPPUNIT_TEST(test_basic);
+  CPPUNIT_TEST(test_pending);
+  CPPUNIT_TEST(test_shared);
+  CPPUNIT_TEST(test_duplicate);
+  CPPUNIT_TEST(test_held_back);
+  CPPUNIT_TEST(test_inet6);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp() override {}
+  void tearDown() override {}
+
+  void test_basic();
+  void test_pending();
+  void test_shared();
+  void test_duplicate();
+  void test_held_back();
+  void test_inet6();
+};
@@ -0,0 +1,252 @@
+#include "config.h"
+
+#include "test_bencode_view.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "torrent/bencode_view.h"
+#include "torrent/exceptions.h"
+#include "torrent/object_stream.h"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(test_bencode_view, "torrent");
+
+// The string must outlive the index.
+static torrent::BencodeView
+index_string(torrent::BencodeIndex& index, const char* str) {
+  const char* last = index.parse(str, str + std::strlen(str));
+
+  if (last != str + std::strlen(str))
+    throw torrent::bencode_error("index_string(...) did not consume all data");
+
+  return index.root();
+}
+
+static bool
+index_string_throws(const std::string& str) {
+  torrent::BencodeIndex index;
+
+  try {
+    index.parse(str.data(), str.data() + str.size());
+  } catch (const torrent::bencode_error&) {
+    return index.empty();
+  }
+
+  return false;
+}
+
+static std::string
+write_object(const torrent::Object& object) {
+  char buffer[1024];
+  char* last = torrent::object_write_bencode(buffer, buffer + sizeof(buffer), &object).first;
+
+  return std::string(buffer, last);
+}
+
+void
+test_bencode_view::test_basic() {
+  torrent::BencodeIndex index;
+
+  CPPUNIT_ASSERT(index.empty());
+  CPPUNIT_ASSERT(index.root().is_empty());
+
+  CPPUNIT_ASSERT(index_string(index, "i42e").as_value() == 42);
+  CPPUNIT_ASSERT(index_string(index, "i-42e").as_value() == -42);
+  CPPUNIT_ASSERT(index_string(index, "0:").as_string().empty());
+  CPPUNIT_ASSERT(index_string(index, "5:hello").as_string() == "hello");
+
+  auto list = index_string(index, "li1e3:twoli3eee");
+
+  CPPUNIT_ASSERT(list.is_list());
+  CPPUNIT_ASSERT(list.as_list().size() == 3);
+  CPPUNIT_ASSERT(index.size() == 5);
+
+  auto itr = list.as_list().begin();
+
+  CPPUNIT_ASSERT(itr->as_value() == 1);
+  CPPUNIT_ASSERT((++itr)->as_string() == "two");
+  CPPUNIT_ASSERT((++itr)->as_list().begin()->as_value() == 3);
+  CPPUNIT_ASSERT(++itr == list.as_list().end());
+
+  CPPUNIT_ASSERT_THROW(list.as_value(), torrent::bencode_error);
+  CPPUNIT_ASSERT_THROW(list.as_map(), torrent::bencode_error);
+
+  CPPUNIT_ASSERT(index_string(index, "le").as_list().empty());
+  CPPUNIT_ASSERT(index_string(index, "de").as_map().empty());
+
+  // Data following the first element is left for the caller.
+  std::string trailing = "i1ei2e";
+  CPPUNIT_ASSERT(index.parse(trailing.data(), trailing.data() + trailing.size()) == trailing.data() + 3);
+}
+
+void
+test_bencode_view::test_keys() {
+  torrent::BencodeIndex index;
+  auto map = index_string(index, "d1:ai1e1:bl1:xe1:cd1:di2ee1:e3:fooe");
+
+  CPPUNIT_ASSERT(map.as_map().size() == 4);
+
+  CPPUNIT_ASSERT(map.has_key_value("a") && !map.has_key_string("a"));
+  CPPUNIT_ASSERT(map.has_key_list("b") && !map.has_key_map("b"));
+  CPPUNIT_ASSERT(map.has_key_map("c") && !map.has_key_value("c"));
+  CPPUNIT_ASSERT(map.has_key_string("e") && !map.has_key_list("e"));
+  CPPUNIT_ASSERT(!map.has_key("f"));
+
+  CPPUNIT_ASSERT(map.get_key_value("a") == 1);
+  CPPUNIT_ASSERT(map.get_key_list("b").begin()->as_string() == "x");
+  CPPUNIT_ASSERT(map.get_key("c").get_key_value("d") == 2);
+  CPPUNIT_ASSERT(map.get_key_string("e") == "foo");
+
+  CPPUNIT_ASSERT_THROW(map.get_key("f"), torrent::bencode_error);
+  CPPUNIT_ASSERT_THROW(map.get_key_value("e"), torrent::bencode_error);
+  CPPUNIT_ASSERT_THROW(map.get_key("b").has_key("a"), torrent::bencode_error);
+
+  std::string keys;
+
+  for (const auto& entry : map.as_map())
+    keys += entry.first;
+
+  CPPUNIT_ASSERT(keys == "abce");
+
+  // Duplicate keys resolve to the last entry, as with Object.
+  CPPUNIT_ASSERT(index_string(index, "d1:ai1e1:ai2ee").get_key_value("a") == 2);
+}
+
+void
+test_bencode_view::test_invalid() {
+  CPPUNIT_ASSERT(index_string_throws(""));
+  CPPUNIT_ASSERT(index_string_throws("i"));
+  CPPUNIT_ASSERT(index_string_throws("i1"));
+  CPPUNIT_ASSERT(index_string_throws("i-0e"));
+  CPPUNIT_ASSERT(index_string_throws("i-e"));
+  CPPUNIT_ASSERT(index_string_throws("1"));
+  CPPUNIT_ASSERT(index_string_throws("1:"));
+  CPPUNIT_ASSERT(index_string_throws("5:abcd"));
+  CPPUNIT_ASSERT(index_string_throws("l"));
+  CPPUNIT_ASSERT(index_string_throws("li1e"));
+  CPPUNIT_ASSERT(index_string_throws("d"));
+  CPPUNIT_ASSERT(index_string_throws("d1:a"));
+  CPPUNIT_ASSERT(index_string_throws("di1ei2ee"));
+  CPPUNIT_ASSERT(index_string_throws("e"));
+  CPPUNIT_ASSERT(index_string_throws("x"));
+
+  // Integers that don't fit in 64 bits.
+  CPPUNIT_ASSERT(index_string_throws("i9223372036854775808e"));
+  CPPUNIT_ASSERT(index_string_throws("i-9223372036854775808e"));
+  CPPUNIT_ASSERT(index_string_throws("i99999999999999999999e"));
+  CPPUNIT_ASSERT(index_string_throws("d1:ai18446744073709551626ee"));
+
+  torrent::BencodeIndex index;
+
+  CPPUNIT_ASSERT(index_string(index, "i9223372036854775807e").as_value() == INT64_MAX);
+  CPPUNIT_ASSERT(index_string(index, "i-9223372036854775807e").as_value() == -INT64_MAX);
+}
+
+void
+test_bencode_view::test_depth() {
+  torrent::BencodeIndex index;
+
+  auto max_nested = std::string(torrent::BencodeIndex::max_depth - 1, 'l') + std::string(torrent::BencodeIndex::max_depth - 1, 'e');
+  auto too_nested = std::string(torrent::BencodeIndex::max_depth, 'l') + std::string(torrent::BencodeIndex::max_depth, 'e');
+
+  CPPUNIT_ASSERT(index_string(index, max_nested.c_str()).is_list());
+  CPPUNIT_ASSERT(index_string_throws(too_nested));
+}
+
+void
+test_bencode_view::test_unordered() {
+  torrent::BencodeIndex index;
+
+  CPPUNIT_ASSERT(!(index_string(index, "d1:ai1e1:bi2ee").flags() & torrent::Object::flag_unordered));
+  CPPUNIT_ASSERT(!(index_string(index, "d0:i1ee").flags() & torrent::Object::flag_unordered));
+
+  CPPUNIT_ASSERT(index_string(index, "d1:bi1e1:ai2ee").flags() & torrent::Object::flag_unordered);
+  CPPUNIT_ASSERT(index_string(index, "d1:ai1e1:ai2ee").flags() & torrent::Object::flag_unordered);
+  CPPUNIT_ASSERT(index_string(index, "d0:i1e0:i2ee").flags() & torrent::Object::flag_unordered);
+
+  // Inherited from nested maps and lists, but not by the unordered
+  // map itself from its keys' values.
+  auto nested = index_string(index, "d1:ald1:bi1e1:ai2eee1:cd1:ai1eee");
+
+  CPPUNIT_ASSERT(nested.flags() & torrent::Object::flag_unordered);
+  CPPUNIT_ASSERT(nested.get_key("a").flags() & torrent::Object::flag_unordered);
+  CPPUNIT_ASSERT(!(nested.get_key("c").flags() & torrent::Object::flag_unordered));
+}
+
+void
+test_bencode_view::test_non_canonical() {
+  torrent::BencodeIndex index;
+
+  CPPUNIT_ASSERT(!(index_string(index, "i0e").flags() & torrent::BencodeView::flag_non_canonical));
+  CPPUNIT_ASSERT(!(index_string(index, "i-10e").flags() & torrent::BencodeView::flag_non_canonical));
+  CPPUNIT_ASSERT(!(index_string(index, "0:").flags() & torrent::BencodeView::flag_non_canonical));
+  CPPUNIT_ASSERT(!(index_string(index, "d3:abci10e1:bl0:ee").flags() & torrent::BencodeView::flag_non_canonical));
+
+  CPPUNIT_ASSERT(index_string(index, "i007e").flags() & torrent::BencodeView::flag_non_canonical);
+  CPPUNIT_ASSERT(index_string(index, "ie").flags() & torrent::BencodeView::flag_non_canonical);
+  CPPUNIT_ASSERT(index_string(index, "03:abc").flags() & torrent::BencodeView::flag_non_canonical);
+  CPPUNIT_ASSERT(index_string(index, "00:").flags() & torrent::BencodeView::flag_non_canonical);
+
+  // Inherited from keys, values and nested elements.
+  CPPUNIT_ASSERT(index_string(index, "d03:abci1ee").flags() & torrent::BencodeView::flag_non_canonical);
+  CPPUNIT_ASSERT(index_string(index, "d3:abci01ee").flags() & torrent::BencodeView::flag_non_canonical);
+
+  auto nested = index_string(index, "d1:ald1:bi01eee1:ci1ee");
+
+  CPPUNIT_ASSERT(nested.flags() & torrent::BencodeView::flag_non_canonical);
+  CPPUNIT_ASSERT(nested.get_key("a").flags() & torrent::BencodeView::flag_non_canonical);
+  CPPUNIT_ASSERT(!(nested.get_key("c").flags() & torrent::BencodeView::flag_non_canonical));
+
+  // Not part of the Object's flags.
+  torrent::Object object;
+  nested.to_object(&object);
+
+  CPPUNIT_ASSERT(!(object.flags() & torrent::BencodeView::flag_non_canonical));
+  CPPUNIT_ASSERT(write_object(object) == "d1:ald1:bi1eee1:ci1ee");
+}
+
+void
+test_bencode_view::test_raw_bencode() {
+  torrent::BencodeIndex index;
+  auto list = index_string(index, "l1:55:helloi-3ed1:ai1eee");
+  auto itr = list.as_list().begin();
+
+  CPPUNIT_ASSERT(torrent::raw_bencode_equal_c_str(itr->as_raw_bencode(), "1:5"));
+  CPPUNIT_ASSERT(torrent::raw_bencode_equal_c_str((++itr)->as_raw_bencode(), "5:hello"));
+  CPPUNIT_ASSERT(torrent::raw_bencode_equal_c_str((++itr)->as_raw_bencode(), "i-3e"));
+  CPPUNIT_ASSERT(torrent::raw_bencode_equal_c_str((++itr)->as_raw_bencode(), "d1:ai1ee"));
+  CPPUNIT_ASSERT(torrent::raw_bencode_equal_c_str(list.as_raw_bencode(), "l1:55:helloi-3ed1:ai1eee"));
+}
+
+void
+test_bencode_view::test_to_object() {
+  const char* inputs[] = {
+    "i0e",
+    "4:test",
+    "le",
+    "de",
+    "li1e2:abl1:cee",
+    "d1:ai1e1:bl1:xi2ee1:cd1:ddee1:elleee",
+    "d1:ei0e4:ipv44:XXXX1:md11:upload_onlyi3e6:ut_pexi1ee1:v15:uuTorrent 1.8.4e",
+  };
+
+  torrent::BencodeIndex index;
+
+  for (auto input : inputs) {
+    torrent::Object expected;
+    torrent::object_read_bencode_c(input, input + std::strlen(input), &expected);
+
+    torrent::Object object;
+    index_string(index, input).to_object(&object);
+
+    CPPUNIT_ASSERT(write_object(object) == write_object(expected));
+    CPPUNIT_ASSERT(write_object(object) == input);
+  }
+
+  torrent::Object unordered;
+  index_string(index, "d1:bi1e1:ai2ee").to_object(&unordered);
+
+  CPPUNIT_ASSERT(unordered.flags() & torrent::Object::flag_unordered);
+  CPPUNIT_ASSERT(unordered.get_key_value("a") == 2);
+}
@@ -0,0 +1,26 @@
+#include "helpers/test_fixture.h"
+
+class test_bencode_view : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_bencode_view);
+
+  CPPUNIT_TEST(test_basic);
+  CPPUNIT_TEST(test_keys);
+  CPPUNIT_TEST(test_invalid);
+  CPPUNIT_TEST(test_depth);
+  CPPUNIT_TEST(test_unordered);
+  CPPUNIT_TEST(test_non_canonical);
+  CPPUNIT_TEST(test_raw_bencode);
+  CPPUNIT_TEST(test_to_object);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_basic();
+  void test_keys();
+  void test_invalid();
+  void test_depth();
+  void test_unordered();
+  void test_non_canonical();
+  void test_raw_bencode();
+  void test_to_object();
+};
@@ -0,0 +1,225 @@
+#include "config.h"
+
+#include "test_download_add.h"
+
+#include <memory>
+#include <string>
+
+#include "thread_main.h"
+#include "torrent/bencode_view.h"
+#include "torrent/bitfield.h"
+#include "torrent/download.h"
+#include "torrent/download_info.h"
+#include "torrent/object.h"
+#include "torrent/object_stream.h"
+#include "torrent/path.h"
+#include "torrent/torrent.h"
+#include "torrent/data/file.h"
+#include "torrent/data/file_list.h"
+#include "torrent/utils/resume.h"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(test_download_add, "torrent");
+
+// Two files spanning four chunks, with 'piece_length' inserted as
+// given so that it may be non-canonically encoded.
+static std::string
+make_torrent(const std::string& piece_length) {
+  std::string torrent =
+    "d8:announce18:http://example.com4:infod5:filesld6:lengthi20000e4:pathl1:aeed6:lengthi30000e4:pathl1:beee"
+    "4:name4:test12:piece length" + piece_length + "6:pieces80:";
+
+  for (int i = 0; i < 80; i++)
+    torrent.push_back(static_cast<char>(i));
+
+  return torrent + "ee";
+}
+
+static torrent::Download
+add_object(const std::string& torrent) {
+  auto object = std::make_unique<torrent::Object>();
+  torrent::object_read_bencode_c(torrent.data(), torrent.data() + torrent.size(), object.get());
+
+  auto download = torrent::download_add(object.get(), 0);
+
+  object.release();
+  return download;
+}
+
+static torrent::Download
+add_view(const std::string& torrent) {
+  torrent::BencodeIndex index(torrent.data(), torrent.data() + torrent.size());
+
+  return torrent::download_add(index.root(), 0);
+}
+
+static std::string
+write_bencode(const torrent::Object* object) {
+  char buffer[1024];
+  char* last = torrent::object_write_bencode(buffer, buffer + sizeof(buffer), object).first;
+
+  return std::string(buffer, last);
+}
+
+static std::string
+remove_info_hash(torrent::Download download) {
+  std::string hash = download.info()->hash().str();
+
+  torrent::download_remove(download);
+  return hash;
+}
+
+// Chunks 0, 1 and 3 done, with chunk 3 uncertain, and the second file
+// disabled.
+static std::string
+make_resume() {
+  return std::string("d8:bitfield1:\xD0"
+                     "5:filesld9:completedi2e8:priorityi2eed9:completedi1e8:priorityi0eee"
+                     "16:uncertain_pieces4:") + std::string("\0\0\0\x03", 4) +
+    "26:uncertain_pieces.timestampi1ee";
+}
+
+static std::string
+download_state(torrent::Download download) {
+  std::string state;
+
+  for (const auto& file : *download.file_list()) {
+    state += file->path()->as_string() + ' ' +
+      std::to_string(file->size_bytes()) + ' ' +
+      std::to_string(file->range().first) + '-' + std::to_string(file->range().second) + ' ' +
+      std::to_string(file->priority()) + ' ' +
+      std::to_string(file->completed_chunks()) + '\n';
+  }
+
+  const torrent::Bitfield* bitfield = download.file_list()->bitfield();
+
+  if (!bitfield->empty())
+    state.append(reinterpret_cast<const char*>(bitfield->begin()), bitfield->size_bytes());
+
+  return state;
+}
+
+template <typename Bencode>
+static void
+load_resume(torrent::Download download, const Bencode& resume, std::string* after_partial, std::string* after_progress) {
+  CPPUNIT_ASSERT(torrent::resume_load_bitfield(download, resume));
+  torrent::resume_load_uncertain_pieces(download, resume);
+  torrent::resume_load_file_priorities(download, resume);
+
+  *after_partial = download_state(download);
+
+  // None of the files exist, so all ranges get cleared.
+  torrent::resume_load_progress(download, resume);
+
+  *after_progress = download_state(download);
+}
+
+void
+test_download_add::setUp() {
+  test_fixture::setUp();
+
+  mock_redirect_defaults();
+
+  torrent::initialize_main_thread();
+  torrent::initialize();
+}
+
+void
+test_download_add::tearDown() {
+  torrent::cleanup();
+  delete torrent::ThreadMain::thread_main();
+
+  test_fixture::tearDown();
+}
+
+void
+test_download_add::test_info_hash() {
+  auto torrent = make_torrent("i16384e");
+
+  auto object_hash = remove_info_hash(add_object(torrent));
+  auto view_hash   = remove_info_hash(add_view(torrent));
+
+  CPPUNIT_ASSERT(object_hash == view_hash);
+}
+
+// The Object path hashes a re-encoding of the info dictionary, so the
+// view path must do the same rather than hash the buffer.
+void
+test_download_add::test_info_hash_non_canonical() {
+  auto canonical_hash = remove_info_hash(add_view(make_torrent("i16384e")));
+
+  auto leading_zero_length = make_torrent("i16384e");
+  leading_zero_length.replace(leading_zero_length.find("4:test"), 6, "04:test");
+
+  for (const auto& torrent : {make_torrent("i016384e"), make_torrent("i0000016384e"), leading_zero_length}) {
+
+    auto object_hash = remove_info_hash(add_object(torrent));
+    auto view_hash   = remove_info_hash(add_view(torrent));
+
+    CPPUNIT_ASSERT(object_hash == view_hash);
+    CPPUNIT_ASSERT(object_hash == canonical_hash);
+  }
+}
+
+// Loading the same torrent and resume data through the Object and
+// view overloads gives the same files, priorities and bitfield.
+void
+test_download_add::test_resume() {
+  auto torrent = make_torrent("i16384e");
+  auto resume  = make_resume();
+
+  std::string object_state, object_partial, object_progress;
+  std::string view_state, view_partial, view_progress;
+
+  {
+    auto download = add_object(torrent);
+    object_state = download_state(download);
+
+    torrent::Object object;
+    torrent::object_read_bencode_c(resume.data(), resume.data() + resume.size(), &object);
+
+    load_resume(download, object, &object_partial, &object_progress);
+    torrent::download_remove(download);
+  }
+
+  {
+    auto download = add_view(torrent);
+    view_state = download_state(download);
+
+    torrent::BencodeIndex index(resume.data(), resume.data() + resume.size());
+
+    load_resume(download, index.root(), &view_partial, &view_progress);
+    torrent::download_remove(download);
+  }
+
+  CPPUNIT_ASSERT(object_state == "/a 20000 0-2 1 0\n/b 30000 1-4 1 0\n");
+  CPPUNIT_ASSERT(object_partial == "/a 20000 0-2 2 2\n/b 30000 1-4 0 1\n\xC0");
+  CPPUNIT_ASSERT(object_progress == std::string("/a 20000 0-2 2 2\n/b 30000 1-4 0 1\n") + '\0');
+
+  CPPUNIT_ASSERT(object_state == view_state);
+  CPPUNIT_ASSERT(object_partial == view_partial);
+  CPPUNIT_ASSERT(object_progress == view_progress);
+}
+
+// The Object kept by a download added from a view encodes the same as
+// the torrent, with the piece hashes referring to the download's own
+// copy rather than the released buffer.
+void
+test_download_add::test_bencode() {
+  auto torrent = make_torrent("i16384e");
+
+  auto object_download = add_object(torrent);
+  CPPUNIT_ASSERT(write_bencode(object_download.bencode()) == torrent);
+  torrent::download_remove(object_download);
+
+  auto buffer = std::make_unique<std::string>(torrent);
+  auto view_download = add_view(*buffer);
+  buffer.reset();
+
+  const auto& pieces = view_download.bencode()->get_key("info").get_key("pieces");
+
+  CPPUNIT_ASSERT(pieces.is_raw_string());
+  CPPUNIT_ASSERT(pieces.as_raw_string().size() == 80);
+  CPPUNIT_ASSERT(write_bencode(view_download.bencode()) == torrent);
+
+  torrent::download_remove(view_download);
+}
@@ -0,0 +1,21 @@
+#include "helpers/test_fixture.h"
+
+class test_download_add : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_download_add);
+
+  CPPUNIT_TEST(test_info_hash);
+  CPPUNIT_TEST(test_info_hash_non_canonical);
+  CPPUNIT_TEST(test_resume);
+  CPPUNIT_TEST(test_bencode);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp() override;
+  void tearDown() override;
+
+  void test_info_hash();
+  void test_info_hash_non_canonical();
+  void test_resume();
+  void test_bencode();
+};
@@ -0,0 +1,98 @@
+#include "config.h"
+
+#include "test_download_manager.h"
+
+#include <memory>
+
+#include "download/download_wrapper.h"
+#include "torrent/download_info.h"
+#include "torrent/exceptions.h"
+#include "torrent/download/download_manager.h"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(test_download_manager, "torrent");
+
+static torrent::DownloadWrapper*
+new_download(char hash_char) {
+  auto download = new torrent::DownloadWrapper;
+
+  download->info()->mutable_hash().assign(std::string(20, hash_char).c_str());
+  download->info()->mutable_hash_obfuscated().assign(std::string(20, hash_char + 1).c_str());
+
+  return download;
+}
+
+void
+test_download_manager::test_find() {
+  torrent::DownloadManager download_manager;
+
+  auto download_a = new_download('a');
+  auto download_c = new_download('c');
+
+  download_manager.insert(download_a);
+  download_manager.insert(download_c);
+
+  CPPUNIT_ASSERT(download_manager.find_main(std::string(20, 'a').c_str()) == download_a->main());
+  CPPUNIT_ASSERT(download_manager.find_main(std::string(20, 'c').c_str()) == download_c->main());
+  CPPUNIT_ASSERT(download_manager.find_main(std::string(20, 'b').c_str()) == nullptr);
+
+  CPPUNIT_ASSERT(download_manager.find_main_obfuscated(std::string(20, 'b').c_str()) == download_a->main());
+  CPPUNIT_ASSERT(download_manager.find_main_obfuscated(std::string(20, 'd').c_str()) == download_c->main());
+  CPPUNIT_ASSERT(download_manager.find_main_obfuscated(std::string(20, 'a').c_str()) == nullptr);
+
+  CPPUNIT_ASSERT(download_manager.find(std::string(20, 'c')) == download_manager.begin() + 1);
+  CPPUNIT_ASSERT(download_manager.find(std::string(20, 'b')) == download_manager.end());
+
+  CPPUNIT_ASSERT(download_manager.find(download_c->info()) == download_manager.begin() + 1);
+
+  std::unique_ptr<torrent::DownloadWrapper> download_other(new_download('c'));
+  CPPUNIT_ASSERT(download_manager.find(download_other->info()) == download_manager.end());
+}
+
+void
+test_download_manager::test_erase() {
+  torrent::DownloadManager download_manager;
+
+  auto download_a = new_download('a');
+  auto download_c = new_download('c');
+  auto download_e = new_download('e');
+
+  download_manager.insert(download_a);
+  download_manager.insert(download_c);
+  download_manager.insert(download_e);
+
+  std::unique_ptr<torrent::DownloadWrapper> download_other(new_download('g'));
+  CPPUNIT_ASSERT_THROW(download_manager.erase(download_other.get()), torrent::internal_error);
+
+  download_manager.erase(download_e);
+  download_manager.erase(download_a);
+
+  CPPUNIT_ASSERT(download_manager.size() == 1);
+  CPPUNIT_ASSERT(download_manager.find_main(std::string(20, 'e').c_str()) == nullptr);
+  CPPUNIT_ASSERT(download_manager.find_main(std::string(20, 'a').c_str()) == nullptr);
+  CPPUNIT_ASSERT(download_manager.find_main_obfuscated(std::string(20, 'b').c_str()) == nullptr);
+  CPPUNIT_ASSERT(download_manager.find_main(std::string(20, 'c').c_str()) == download_c->main());
+  CPPUNIT_ASSERT(download_manager.find_main_obfuscated(std::string(20, 'd').c_str()) == download_c->main());
+  CPPUNIT_ASSERT(download_manager.find(std::string(20, 'c')) == download_manager.begin());
+
+  // Changing the hash of an inserted download is not allowed.
+  download_c->info()->mutable_hash().assign(std::string(20, 'e').c_str());
+  CPPUNIT_ASSERT_THROW(download_manager.erase(download_c), torrent::internal_error);
+
+  download_c->info()->mutable_hash().assign(std::string(20, 'c').c_str());
+  download_manager.erase(download_c);
+
+  CPPUNIT_ASSERT(download_manager.empty());
+}
+
+void
+test_download_manager::test_duplicate() {
+  torrent::DownloadManager download_manager;
+
+  download_manager.insert(new_download('a'));
+
+  std::unique_ptr<torrent::DownloadWrapper> duplicate(new_download('a'));
+  CPPUNIT_ASSERT_THROW(download_manager.insert(duplicate.get()), torrent::internal_error);
+
+  CPPUNIT_ASSERT(download_manager.size() == 1);
+  CPPUNIT_ASSERT(download_manager.find_main_obfuscated(std::string(20, 'b').c_str()) != nullptr);
+}
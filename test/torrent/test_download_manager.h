@@ -0,0 +1,16 @@
+#include "helpers/test_main_thread.h"
+
+class test_download_manager : public TestFixtureWithMainThread {
+  CPPUNIT_TEST_SUITE(test_download_manager);
+
+  CPPUNIT_TEST(test_find);
+  CPPUNIT_TEST(test_erase);
+  CPPUNIT_TEST(test_duplicate);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_find();
+  void test_erase();
+  void test_duplicate();
+};
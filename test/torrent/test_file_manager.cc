@@ -0,0 +1,182 @@
+#include "config.h"
+
+#include "test_file_manager.h"
+
+#include <array>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "data/memory_chunk.h"
+#include "torrent/exceptions.h"
+#include "torrent/data/file.h"
+#include "torrent/data/file_manager.h"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(test_file_manager, "torrent");
+
+namespace {
+
+class temp_file : public torrent::File {
+public:
+  temp_file() {
+    char path[] = "/tmp/libtorrent_test_file_manager_XXXXXX";
+    int fd = ::mkstemp(path);
+
+    if (fd == -1)
+      throw torrent::internal_error("temp_file::temp_file() mkstemp failed.");
+
+    ::close(fd);
+    set_frozen_path(path);
+  }
+
+  ~temp_file() { ::unlink(frozen_path().c_str()); }
+};
+
+struct file_set {
+  explicit file_set(torrent::FileManager& fm) : manager(fm) {}
+  ~file_set() {
+    for (auto& file : files)
+      manager.close(&file);
+  }
+
+  bool open(unsigned int index) {
+    return manager.open(&files[index], false, torrent::MemoryChunk::prot_read, 0);
+  }
+
+  bool is_open(std::initializer_list<unsigned int> indices) {
+    unsigned int count = 0;
+
+    for (auto index : indices)
+      if (!files[index].is_open())
+        return false;
+
+    for (auto& file : files)
+      count += file.is_open();
+
+    return count == indices.size();
+  }
+
+  torrent::FileManager&  manager;
+  std::array<temp_file, 8> files;
+};
+
+} // namespace
+
+void
+test_file_manager::test_basic() {
+  torrent::FileManager fm;
+  fm.set_max_open_files(4);
+
+  file_set set(fm);
+
+  CPPUNIT_ASSERT(set.open(0));
+  CPPUNIT_ASSERT(set.open(1));
+  CPPUNIT_ASSERT(set.open(2));
+  CPPUNIT_ASSERT(fm.open_files() == 3);
+  CPPUNIT_ASSERT(set.is_open({0, 1, 2}));
+
+  fm.close(&set.files[0]);
+  CPPUNIT_ASSERT(fm.open_files() == 2);
+  CPPUNIT_ASSERT(set.is_open({1, 2}));
+
+  fm.close(&set.files[2]);
+  fm.close(&set.files[1]);
+  CPPUNIT_ASSERT(fm.open_files() == 0);
+
+  CPPUNIT_ASSERT(fm.files_opened_counter() == 3);
+  CPPUNIT_ASSERT(fm.files_closed_counter() == 3);
+  CPPUNIT_ASSERT(fm.files_missed_counter() == 3);
+  CPPUNIT_ASSERT(fm.files_evicted_counter() == 0);
+}
+
+void
+test_file_manager::test_lru_order() {
+  torrent::FileManager fm;
+  fm.set_max_open_files(4);
+
+  file_set set(fm);
+
+  for (unsigned int i = 0; i < 4; i++)
+    CPPUNIT_ASSERT(set.open(i));
+
+  fm.touch(&set.files[0]);
+  fm.touch(&set.files[1]);
+  CPPUNIT_ASSERT(fm.files_hit_counter() == 2);
+
+  CPPUNIT_ASSERT(set.open(4));
+  CPPUNIT_ASSERT(set.is_open({0, 1, 3, 4}));
+
+  CPPUNIT_ASSERT(set.open(5));
+  CPPUNIT_ASSERT(set.is_open({0, 1, 4, 5}));
+
+  fm.touch(&set.files[4]);
+
+  CPPUNIT_ASSERT(set.open(6));
+  CPPUNIT_ASSERT(set.is_open({1, 4, 5, 6}));
+
+  CPPUNIT_ASSERT(fm.files_evicted_counter() == 3);
+  CPPUNIT_ASSERT(fm.files_missed_counter() == 7);
+}
+
+void
+test_file_manager::test_pinned() {
+  torrent::FileManager fm;
+  fm.set_max_open_files(4);
+
+  file_set set(fm);
+
+  fm.pin(&set.files[0]);
+
+  for (unsigned int i = 0; i < 4; i++)
+    CPPUNIT_ASSERT(set.open(i));
+
+  CPPUNIT_ASSERT(set.files[0].is_pinned());
+
+  fm.pin(&set.files[1]);
+  fm.pin(&set.files[1]);
+
+  CPPUNIT_ASSERT(set.open(4));
+  CPPUNIT_ASSERT(set.is_open({0, 1, 3, 4}));
+
+  fm.pin(&set.files[3]);
+  fm.pin(&set.files[4]);
+
+  // Only pinned files are open, so the least recently used is evicted.
+  CPPUNIT_ASSERT(set.open(5));
+  CPPUNIT_ASSERT(set.is_open({1, 3, 4, 5}));
+
+  fm.pin(&set.files[5]);
+  fm.unpin(&set.files[1]);
+  CPPUNIT_ASSERT(set.files[1].is_pinned());
+  fm.unpin(&set.files[1]);
+  CPPUNIT_ASSERT(!set.files[1].is_pinned());
+
+  CPPUNIT_ASSERT(set.open(6));
+  CPPUNIT_ASSERT(set.is_open({3, 4, 5, 6}));
+
+  CPPUNIT_ASSERT_THROW(fm.unpin(&set.files[1]), torrent::internal_error);
+
+  fm.unpin(&set.files[0]);
+  fm.unpin(&set.files[3]);
+  fm.unpin(&set.files[4]);
+  fm.unpin(&set.files[5]);
+}
+
+void
+test_file_manager::test_max_open_files() {
+  torrent::FileManager fm;
+  fm.set_max_open_files(8);
+
+  file_set set(fm);
+
+  for (unsigned int i = 0; i < 8; i++)
+    CPPUNIT_ASSERT(set.open(i));
+
+  fm.pin(&set.files[0]);
+  fm.touch(&set.files[1]);
+
+  fm.set_max_open_files(4);
+  CPPUNIT_ASSERT(set.is_open({0, 1, 6, 7}));
+  CPPUNIT_ASSERT(fm.files_evicted_counter() == 4);
+
+  fm.unpin(&set.files[0]);
+}
@@ -0,0 +1,18 @@
+#include "helpers/test_fixture.h"
+
+class test_file_manager : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_file_manager);
+
+  CPPUNIT_TEST(test_basic);
+  CPPUNIT_TEST(test_lru_order);
+  CPPUNIT_TEST(test_pinned);
+  CPPUNIT_TEST(test_max_open_files);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_basic();
+  void test_lru_order();
+  void test_pinned();
+  void test_max_open_files();
+};
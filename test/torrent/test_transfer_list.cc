@@ -0,0 +1,151 @@
+#include "config.h"
+
+#include "test_transfer_list.h"
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include "torrent/exceptions.h"
+#include "torrent/data/block_list.h"
+#include "torrent/data/piece.h"
+#include "torrent/data/transfer_list.h"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(test_transfer_list, "torrent");
+
+#define SETUP_TRANSFER_LIST()                                           \
+  torrent::TransferList transfer_list;                                  \
+  transfer_list.slot_canceled() = [](uint32_t) {};                      \
+  transfer_list.slot_queued()   = [](uint32_t) {};
+
+static void
+insert_indices(torrent::TransferList& transfer_list, std::initializer_list<uint32_t> indices) {
+  for (auto index : indices)
+    transfer_list.insert(torrent::Piece(index, 0, 1 << 14), 1 << 14);
+}
+
+static bool
+verify_order(torrent::TransferList& transfer_list, std::initializer_list<uint32_t> indices) {
+  if (transfer_list.size() != indices.size())
+    return false;
+
+  auto itr = transfer_list.begin();
+
+  for (auto index : indices) {
+    if ((*itr)->index() != index || transfer_list.find(index) != itr)
+      return false;
+
+    itr++;
+  }
+
+  return true;
+}
+
+void
+test_transfer_list::test_find() {
+  SETUP_TRANSFER_LIST();
+
+  insert_indices(transfer_list, {5, 2, 9});
+
+  CPPUNIT_ASSERT(verify_order(transfer_list, {5, 2, 9}));
+  CPPUNIT_ASSERT(transfer_list.find(3) == transfer_list.end());
+
+  const torrent::TransferList& const_list = transfer_list;
+  CPPUNIT_ASSERT(const_list.find(2) == std::next(const_list.begin()));
+
+  CPPUNIT_ASSERT_THROW(insert_indices(transfer_list, {2}), torrent::internal_error);
+  CPPUNIT_ASSERT(verify_order(transfer_list, {5, 2, 9}));
+
+  transfer_list.clear();
+
+  CPPUNIT_ASSERT(transfer_list.find(5) == transfer_list.end());
+}
+
+void
+test_transfer_list::test_erase() {
+  SETUP_TRANSFER_LIST();
+
+  insert_indices(transfer_list, {5, 2, 9, 7});
+
+  auto next_itr = transfer_list.erase(transfer_list.find(2));
+  CPPUNIT_ASSERT(next_itr == transfer_list.find(9));
+  CPPUNIT_ASSERT(verify_order(transfer_list, {5, 9, 7}));
+  CPPUNIT_ASSERT(transfer_list.find(2) == transfer_list.end());
+
+  next_itr = transfer_list.erase(transfer_list.find(7));
+  CPPUNIT_ASSERT(next_itr == transfer_list.end());
+  CPPUNIT_ASSERT(verify_order(transfer_list, {5, 9}));
+
+  insert_indices(transfer_list, {2});
+  transfer_list.erase(transfer_list.find(5));
+  CPPUNIT_ASSERT(verify_order(transfer_list, {9, 2}));
+
+  transfer_list.clear();
+}
+
+void
+test_transfer_list::test_erase_compact() {
+  SETUP_TRANSFER_LIST();
+
+  for (uint32_t index = 0; index < 100; index++)
+    insert_indices(transfer_list, {index});
+
+  // Erase from the front and middle so that the empty slots are not
+  // trimmed from the back, forcing compaction along the way.
+  std::vector<uint32_t> remaining;
+
+  for (uint32_t index = 0; index < 100; index++) {
+    if (index % 4 == 3) {
+      remaining.push_back(index);
+      continue;
+    }
+
+    transfer_list.erase(transfer_list.find(index));
+
+    CPPUNIT_ASSERT(transfer_list.find(index) == transfer_list.end());
+    CPPUNIT_ASSERT(transfer_list.size() == 99 - index + remaining.size());
+  }
+
+  CPPUNIT_ASSERT(transfer_list.size() == remaining.size());
+  CPPUNIT_ASSERT(std::equal(transfer_list.begin(), transfer_list.end(), remaining.begin(),
+                            [](auto block_list, auto index) { return block_list->index() == index; }));
+
+  for (auto index : remaining)
+    CPPUNIT_ASSERT((*transfer_list.find(index))->index() == index);
+
+  CPPUNIT_ASSERT((*transfer_list.rbegin())->index() == 99);
+  CPPUNIT_ASSERT((*std::prev(transfer_list.end()))->index() == 99);
+
+  insert_indices(transfer_list, {200});
+  CPPUNIT_ASSERT((*transfer_list.rbegin())->index() == 200);
+  CPPUNIT_ASSERT(std::distance(transfer_list.begin(), transfer_list.end()) == 26);
+
+  transfer_list.clear();
+  CPPUNIT_ASSERT(transfer_list.empty());
+}
+
+void
+test_transfer_list::test_reverse() {
+  SETUP_TRANSFER_LIST();
+
+  insert_indices(transfer_list, {5, 2, 9, 7, 4});
+
+  // Leaves empty slots at the front and in the middle.
+  transfer_list.erase(transfer_list.find(5));
+  transfer_list.erase(transfer_list.find(9));
+
+  std::vector<uint32_t> reversed;
+
+  for (auto itr = transfer_list.rbegin(); itr != transfer_list.rend(); itr++)
+    reversed.push_back((*itr)->index());
+
+  CPPUNIT_ASSERT(reversed == std::vector<uint32_t>({4, 7, 2}));
+  CPPUNIT_ASSERT(std::prev(transfer_list.end(), 3) == transfer_list.begin());
+  CPPUNIT_ASSERT(std::prev(transfer_list.find(7)) == transfer_list.find(2));
+
+  // Erasing everything through the returned iterators.
+  for (auto itr = transfer_list.begin(); itr != transfer_list.end(); )
+    itr = transfer_list.erase(itr);
+
+  CPPUNIT_ASSERT(transfer_list.empty());
+}
@@ -0,0 +1,18 @@
+#include "helpers/test_fixture.h"
+
+class test_transfer_list : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_transfer_list);
+
+  CPPUNIT_TEST(test_find);
+  CPPUNIT_TEST(test_erase);
+  CPPUNIT_TEST(test_erase_compact);
+  CPPUNIT_TEST(test_reverse);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_find();
+  void test_erase();
+  void test_erase_compact();
+  void test_reverse();
+};
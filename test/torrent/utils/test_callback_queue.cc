@@ -0,0 +1,178 @@
+#include "config.h"
+
+#include "test_callback_queue.h"
+
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "torrent/utils/callback_queue.h"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(test_callback_queue, "torrent/utils");
+
+using torrent::utils::CallbackQueue;
+
+namespace {
+
+bool
+process_all(CallbackQueue& queue) {
+  return queue.process([](CallbackQueue::node_type& node) {
+      if (!node.is_cancelled())
+        node.call();
+    });
+}
+
+}
+
+void
+test_callback_queue::test_basic() {
+  CallbackQueue queue;
+  std::vector<int> called;
+
+  CPPUNIT_ASSERT(!process_all(queue));
+
+  int targets[3];
+
+  // Callbacks run in the order pushed, not in target order.
+  queue.push(&targets[2], [&] { called.push_back(0); });
+  queue.push(&targets[0], [&] { called.push_back(1); });
+  queue.push(&targets[1], [&] { called.push_back(2); });
+  queue.push(&targets[0], [&] { called.push_back(3); });
+
+  CPPUNIT_ASSERT(process_all(queue));
+  CPPUNIT_ASSERT((called == std::vector<int>{0, 1, 2, 3}));
+  CPPUNIT_ASSERT(!process_all(queue));
+
+  // Callbacks pushed while processing are run by the next batch.
+  called.clear();
+  queue.push(&targets[0], [&] {
+      called.push_back(0);
+      queue.push(&targets[0], [&] { called.push_back(1); });
+    });
+
+  CPPUNIT_ASSERT(process_all(queue));
+  CPPUNIT_ASSERT((called == std::vector<int>{0}));
+  CPPUNIT_ASSERT(process_all(queue));
+  CPPUNIT_ASSERT((called == std::vector<int>{0, 1}));
+}
+
+void
+test_callback_queue::test_cancel() {
+  CallbackQueue queue;
+  std::vector<int> called;
+
+  int targets[2];
+
+  queue.push(&targets[0], [&] { called.push_back(0); });
+  queue.push(&targets[1], [&] { called.push_back(1); });
+  queue.push(&targets[0], [&] { called.push_back(2); });
+
+  queue.cancel(&targets[0]);
+
+  // Only callbacks pushed before cancelling are affected.
+  queue.push(&targets[0], [&] { called.push_back(3); });
+
+  CPPUNIT_ASSERT(process_all(queue));
+  CPPUNIT_ASSERT((called == std::vector<int>{1, 3}));
+
+  called.clear();
+  queue.push(&targets[1], [&] { called.push_back(0); });
+  queue.cancel(&targets[0]);
+
+  CPPUNIT_ASSERT(process_all(queue));
+  CPPUNIT_ASSERT((called == std::vector<int>{0}));
+}
+
+void
+test_callback_queue::test_cancel_running() {
+  CallbackQueue queue;
+  std::vector<int> called;
+
+  int targets[2];
+
+  queue.push(&targets[0], [&] { called.push_back(0); queue.cancel(&targets[1]); });
+  queue.push(&targets[1], [&] { called.push_back(1); });
+  queue.push(&targets[0], [&] { called.push_back(2); });
+
+  CPPUNIT_ASSERT(process_all(queue));
+  CPPUNIT_ASSERT((called == std::vector<int>{0, 2}));
+}
+
+void
+test_callback_queue::test_throw() {
+  CallbackQueue queue;
+  std::vector<int> called;
+
+  int targets[2];
+
+  queue.push(&targets[0], [&] { called.push_back(0); });
+  queue.push(&targets[0], [&] { called.push_back(1); throw std::runtime_error("test"); });
+  queue.push(&targets[0], [&] { called.push_back(2); });
+  queue.push(&targets[1], [&] { called.push_back(3); });
+  queue.push(&targets[0], [&] { called.push_back(4); });
+
+  CPPUNIT_ASSERT_THROW(process_all(queue), std::runtime_error);
+  CPPUNIT_ASSERT((called == std::vector<int>{0, 1}));
+
+  // The rest of the batch runs before callbacks pushed after the throw,
+  // and can still be cancelled.
+  queue.push(&targets[0], [&] { called.push_back(5); });
+  queue.cancel(&targets[1]);
+
+  CPPUNIT_ASSERT(process_all(queue));
+  CPPUNIT_ASSERT((called == std::vector<int>{0, 1, 2, 4, 5}));
+  CPPUNIT_ASSERT(!process_all(queue));
+
+  // Throwing from the last callback leaves nothing behind.
+  called.clear();
+  queue.push(&targets[0], [&] { called.push_back(0); });
+  queue.push(&targets[0], [&] { called.push_back(1); throw std::runtime_error("test"); });
+
+  CPPUNIT_ASSERT_THROW(process_all(queue), std::runtime_error);
+  CPPUNIT_ASSERT(!process_all(queue));
+
+  queue.push(&targets[0], [&] { called.push_back(2); });
+
+  CPPUNIT_ASSERT(process_all(queue));
+  CPPUNIT_ASSERT((called == std::vector<int>{0, 1, 2}));
+}
+
+void
+test_callback_queue::test_producers() {
+  constexpr int producer_count = 4;
+  constexpr int push_count = 20000;
+
+  CallbackQueue queue;
+  std::atomic<bool> done{false};
+  std::vector<int> last(producer_count, -1);
+  bool ordered = true;
+  int called = 0;
+
+  std::vector<std::thread> producers;
+
+  for (int p = 0; p < producer_count; p++)
+    producers.emplace_back([&, p] {
+        for (int i = 0; i < push_count; i++)
+          queue.push(&queue, [&, p, i] {
+              ordered = ordered && last[p] + 1 == i;
+              last[p] = i;
+              called++;
+            });
+      });
+
+  std::thread consumer([&] {
+      while (!done)
+        process_all(queue);
+
+      process_all(queue);
+    });
+
+  for (auto& producer : producers)
+    producer.join();
+
+  done = true;
+  consumer.join();
+
+  CPPUNIT_ASSERT(ordered);
+  CPPUNIT_ASSERT(called == producer_count * push_count);
+}
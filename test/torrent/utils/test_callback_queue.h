@@ -0,0 +1,20 @@
+#include "helpers/test_fixture.h"
+
+class test_callback_queue : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_callback_queue);
+
+  CPPUNIT_TEST(test_basic);
+  CPPUNIT_TEST(test_cancel);
+  CPPUNIT_TEST(test_cancel_running);
+  CPPUNIT_TEST(test_throw);
+  CPPUNIT_TEST(test_producers);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_basic();
+  void test_cancel();
+  void test_cancel_running();
+  void test_throw();
+  void test_producers();
+};
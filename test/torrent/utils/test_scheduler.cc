@@ -0,0 +1,151 @@
+#include "config.h"
+
+#include "test_scheduler.h"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "torrent/exceptions.h"
+#include "torrent/utils/scheduler.h"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(test_scheduler, "torrent/utils");
+
+using torrent::utils::SchedulerEntry;
+
+namespace {
+
+constexpr std::chrono::microseconds base_time = 365 * 24h;
+
+struct test_entries {
+  test_entries(unsigned int count) : entries(count) {
+    for (unsigned int i = 0; i < count; i++) {
+      entries[i] = std::make_unique<SchedulerEntry>();
+      entries[i]->slot() = [this, i] { performed.push_back(i); };
+    }
+  }
+
+  ~test_entries() {
+    for (auto& entry : entries)
+      scheduler.erase(entry.get());
+  }
+
+  SchedulerEntry* operator[](unsigned int i) { return entries[i].get(); }
+
+  // Performs everything scheduled, returning the performed entries
+  // in order.
+  std::vector<unsigned int> perform_all() {
+    performed.clear();
+    scheduler.external_perform(base_time + 100 * 365 * 24h);
+    return performed;
+  }
+
+  torrent::utils::ExternalScheduler            scheduler;
+  std::vector<std::unique_ptr<SchedulerEntry>> entries;
+  std::vector<unsigned int>                    performed;
+};
+
+}
+
+void
+test_scheduler::test_basic() {
+  test_entries e(4);
+
+  e.scheduler.wait_until(e[0], base_time + 3s);
+  e.scheduler.wait_until(e[1], base_time + 1s);
+  e.scheduler.wait_until(e[2], base_time + 4s);
+  e.scheduler.wait_until(e[3], base_time + 2s);
+
+  CPPUNIT_ASSERT(e.scheduler.size() == 4);
+  CPPUNIT_ASSERT(e.scheduler.front() == e[1]);
+  CPPUNIT_ASSERT_THROW(e.scheduler.wait_until(e[0], base_time + 5s), torrent::internal_error);
+
+  e.scheduler.external_perform(base_time + 2s);
+
+  CPPUNIT_ASSERT(e.performed == std::vector<unsigned int>({1, 3}));
+  CPPUNIT_ASSERT(!e[1]->is_scheduled() && e[1]->time() == std::chrono::microseconds());
+  CPPUNIT_ASSERT(e.perform_all() == std::vector<unsigned int>({0, 2}));
+  CPPUNIT_ASSERT(e.scheduler.empty());
+}
+
+void
+test_scheduler::test_erase() {
+  test_entries e(5);
+
+  for (unsigned int i = 0; i < 5; i++)
+    e.scheduler.wait_until(e[i], base_time + std::chrono::seconds(i + 1));
+
+  e.scheduler.erase(e[0]);
+  e.scheduler.erase(e[3]);
+  e.scheduler.erase(e[4]);
+  e.scheduler.erase(e[4]);
+
+  CPPUNIT_ASSERT(!e[0]->is_scheduled());
+  CPPUNIT_ASSERT(e.scheduler.size() == 2);
+
+  torrent::utils::ExternalScheduler other;
+  e.scheduler.erase(e[0]);
+  CPPUNIT_ASSERT_THROW(other.erase(e[1]), torrent::internal_error);
+
+  CPPUNIT_ASSERT(e.perform_all() == std::vector<unsigned int>({1, 2}));
+}
+
+void
+test_scheduler::test_update() {
+  test_entries e(4);
+
+  for (unsigned int i = 0; i < 4; i++)
+    e.scheduler.wait_until(e[i], base_time + std::chrono::seconds(i + 1));
+
+  // Move the first last, the last first and schedule one anew.
+  e.scheduler.update_wait_until(e[0], base_time + 10s);
+  e.scheduler.update_wait_until(e[3], base_time + 500ms);
+  e.scheduler.erase(e[2]);
+  e.scheduler.update_wait_until(e[2], base_time + 2500ms);
+
+  CPPUNIT_ASSERT(e[0]->time() == base_time + 10s);
+  CPPUNIT_ASSERT(e.perform_all() == std::vector<unsigned int>({3, 1, 2, 0}));
+}
+
+void
+test_scheduler::test_random() {
+  constexpr unsigned int count = 200;
+
+  test_entries e(count);
+  std::mt19937 rng(1);
+
+  for (unsigned int round = 0; round < 5000; round++) {
+    auto entry = e[rng() % count];
+    auto time = base_time + std::chrono::milliseconds(1 + rng() % 10000);
+
+    switch (rng() % 3) {
+    case 0: e.scheduler.erase(entry); break;
+    case 1: e.scheduler.update_wait_until(entry, time); break;
+    default:
+      if (!entry->is_scheduled())
+        e.scheduler.wait_until(entry, time);
+      break;
+    }
+  }
+
+  unsigned int scheduled = e.scheduler.size();
+  auto last = std::chrono::microseconds();
+
+  for (unsigned int i = 0; i < count; i++)
+    e[i]->slot() = [&e, i] {
+      CPPUNIT_ASSERT(e[i]->time() == std::chrono::microseconds());
+      e.performed.push_back(i);
+    };
+
+  // Entries must come out in time order.
+  while (!e.scheduler.empty()) {
+    auto next = e.scheduler.front()->time();
+
+    CPPUNIT_ASSERT(next >= last);
+    last = next;
+
+    e.scheduler.external_perform(next);
+  }
+
+  CPPUNIT_ASSERT(e.performed.size() == scheduled);
+}
@@ -0,0 +1,18 @@
+#include "helpers/test_fixture.h"
+
+class test_scheduler : public test_fixture {
+  CPPUNIT_TEST_SUITE(test_scheduler);
+
+  CPPUNIT_TEST(test_basic);
+  CPPUNIT_TEST(test_erase);
+  CPPUNIT_TEST(test_update);
+  CPPUNIT_TEST(test_random);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_basic();
+  void test_erase();
+  void test_update();
+  void test_random();
+};
@@ -0,0 +1,134 @@
+#include "config.h"
+
+#include "test_http_scraper.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <unistd.h>
+
+#include "helpers/test_utils.h"
+#include "tracker/http_scraper.h"
+#include "tracker/tracker_http.h"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(test_http_scraper, "tracker");
+
+namespace {
+
+class TestTrackerHttp : public torrent::TrackerHttp {
+public:
+  TestTrackerHttp(const std::string& url, char hash_char) :
+    TrackerHttp(make_info(url, hash_char), torrent::tracker::TrackerState::flag_enabled) {
+
+    m_slot_close = [] {};
+    m_slot_scrape_success = [this] { slot_scrape(); };
+    m_slot_scrape_failure = [this](const auto&) { slot_scrape(); };
+  }
+
+  std::function<void()> slot_scrape;
+
+private:
+  static torrent::TrackerInfo make_info(const std::string& url, char hash_char) {
+    torrent::TrackerInfo info;
+    info.url = url;
+    info.info_hash.assign(std::string(20, hash_char).c_str());
+    return info;
+  }
+};
+
+} // namespace
+
+void
+test_http_scraper::setUp() {
+  TestFixtureWithMainNetTrackerThread::setUp();
+
+  char path[] = "/tmp/libtorrent_test_http_scraper_XXXXXX";
+
+  CPPUNIT_ASSERT(mkdtemp(path) != nullptr);
+  m_dir = path;
+}
+
+void
+test_http_scraper::tearDown() {
+  ::unlink((m_dir + "/scrape").c_str());
+  ::rmdir(m_dir.c_str());
+
+  TestFixtureWithMainNetTrackerThread::tearDown();
+}
+
+// Returns the announce url of a tracker scraping both 'a' and 'b'
+// hashes.
+std::string
+test_http_scraper::write_scrape_file() {
+  std::ofstream(m_dir + "/scrape")
+    << "d5:filesd"
+    << "20:" << std::string(20, 'a') << "d8:completei1ee"
+    << "20:" << std::string(20, 'b') << "d8:completei2ee"
+    << "ee";
+
+  return "file://" + m_dir + "/announce";
+}
+
+// Trackers delay the scrape by 10 seconds, and the scraper collects
+// them for another 5.
+void
+test_http_scraper::process_scrape(const std::function<bool()>& done) {
+  m_main_thread->test_add_cached_time(11s);
+  m_main_thread->test_process_events_without_cached_time();
+
+  m_main_thread->test_add_cached_time(torrent::HttpScraper::scrape_delay + 1s);
+  m_main_thread->test_process_events_without_cached_time();
+
+  CPPUNIT_ASSERT(wait_for_true([&] {
+      m_main_thread->test_process_events_without_cached_time();
+      return done();
+    }));
+
+  m_main_thread->test_process_events_without_cached_time();
+}
+
+// Both trackers share a scrape url, so they get one request. Whichever
+// is dispatched first closes the other, which must then be skipped.
+void
+test_http_scraper::test_close_while_dispatching() {
+  auto url = write_scrape_file();
+
+  TestTrackerHttp tracker_a(url, 'a');
+  TestTrackerHttp tracker_b(url, 'b');
+
+  int scrapes_a = 0;
+  int scrapes_b = 0;
+
+  tracker_a.slot_scrape = [&] { scrapes_a++; tracker_b.close(); };
+  tracker_b.slot_scrape = [&] { scrapes_b++; tracker_a.close(); };
+
+  tracker_a.send_scrape();
+  tracker_b.send_scrape();
+
+  process_scrape([&] { return scrapes_a + scrapes_b != 0; });
+
+  CPPUNIT_ASSERT(scrapes_a + scrapes_b == 1);
+}
+
+// As above, but deleting the other tracker.
+void
+test_http_scraper::test_delete_while_dispatching() {
+  auto url = write_scrape_file();
+
+  auto tracker_a = std::make_unique<TestTrackerHttp>(url, 'a');
+  auto tracker_b = std::make_unique<TestTrackerHttp>(url, 'b');
+
+  int scrapes = 0;
+
+  tracker_a->slot_scrape = [&] { scrapes++; tracker_b.reset(); };
+  tracker_b->slot_scrape = [&] { scrapes++; tracker_a.reset(); };
+
+  tracker_a->send_scrape();
+  tracker_b->send_scrape();
+
+  process_scrape([&] { return scrapes != 0; });
+
+  CPPUNIT_ASSERT(scrapes == 1);
+  CPPUNIT_ASSERT((tracker_a == nullptr) != (tracker_b == nullptr));
+}
@@ -0,0 +1,23 @@
+#include "helpers/test_main_thread.h"
+
+class test_http_scraper : public TestFixtureWithMainNetTrackerThread {
+  CPPUNIT_TEST_SUITE(test_http_scraper);
+
+  CPPUNIT_TEST(test_close_while_dispatching);
+  CPPUNIT_TEST(test_delete_while_dispatching);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp() override;
+  void tearDown() override;
+
+  void test_close_while_dispatching();
+  void test_delete_while_dispatching();
+
+private:
+  std::string write_scrape_file();
+  void        process_scrape(const std::function<bool()>& done);
+
+  std::string m_dir;
+};
@@ -2,6 +2,7 @@
 
 #include "test_tracker_http.h"
 
+#include "tracker/http_scraper.h"
 #include "tracker/tracker_http.h"
 
 CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(test_tracker_http, "tracker");
@@ -9,3 +10,22 @@ CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(test_tracker_http, "tracker");
 void
 test_tracker_http::test_basic() {
 }
+
+void
+test_tracker_http::test_scrape_url() {
+  auto hash_a = torrent::HashString::new_zero();
+  auto hash_b = torrent::HashString::new_zero();
+
+  hash_a.assign(std::string(20, 'a').c_str());
+  hash_b.assign(std::string(19, 'b').append(1, '/').c_str());
+
+  std::string expected_a = "info_hash=" + std::string(20, 'a');
+  std::string expected_b = "info_hash=" + std::string(19, 'b') + "%2F";
+
+  CPPUNIT_ASSERT(torrent::HttpScraper::scrape_url("http://example.com/scrape", {hash_a}) ==
+                 "http://example.com/scrape?" + expected_a);
+  CPPUNIT_ASSERT(torrent::HttpScraper::scrape_url("http://example.com/scrape", {hash_a, hash_b}) ==
+                 "http://example.com/scrape?" + expected_a + "&" + expected_b);
+  CPPUNIT_ASSERT(torrent::HttpScraper::scrape_url("http://example.com/scrape?passkey=1", {hash_a, hash_b}) ==
+                 "http://example.com/scrape?passkey=1&" + expected_a + "&" + expected_b);
+}
@@ -0,0 +1,254 @@
+#include "config.h"
+
+#include "test_udp_router.h"
+
+#include <cstring>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "manager.h"
+#include "test/helpers/mock_function.h"
+#include "tracker/tracker_udp.h"
+#include "tracker/udp_router.h"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(test_udp_router, "tracker");
+
+#define EXPECT_ROUTER_OPEN(router)                                      \
+  mock_expect(&torrent::this_thread::event_open, static_cast<torrent::Event*>(&router)); \
+  mock_expect(&torrent::this_thread::event_insert_read, static_cast<torrent::Event*>(&router)); \
+  mock_expect(&torrent::this_thread::event_insert_error, static_cast<torrent::Event*>(&router));
+
+#define EXPECT_ROUTER_CLOSE(router)                                     \
+  mock_expect(&torrent::this_thread::event_remove_and_close, static_cast<torrent::Event*>(&router));
+
+namespace {
+
+class ScrapeTracker : public torrent::TrackerUdp {
+public:
+  ScrapeTracker(char hash_char) : torrent::TrackerUdp(make_info(hash_char)) {
+    m_slot_close = [] {};
+    m_slot_scrape_success = [this] { m_scrape_success++; };
+    m_slot_scrape_failure = [this](const std::string&) { m_scrape_failure++; };
+  }
+
+  const torrent::tracker::TrackerState& test_state() const { return state(); }
+
+  static torrent::TrackerInfo make_info(char hash_char) {
+    torrent::TrackerInfo info;
+    info.info_hash.assign(std::string(20, hash_char).c_str());
+    info.url = "udp://127.0.0.1:6969";
+    return info;
+  }
+
+  int m_scrape_success{0};
+  int m_scrape_failure{0};
+};
+
+void
+write_32(char* buffer, uint32_t value) {
+  value = htonl(value);
+  std::memcpy(buffer, &value, sizeof(uint32_t));
+}
+
+uint32_t
+read_32(const char* buffer) {
+  uint32_t value;
+  std::memcpy(&value, buffer, sizeof(uint32_t));
+  return ntohl(value);
+}
+
+} // namespace
+
+void
+test_udp_router::setUp() {
+  TestFixtureWithMainNetTrackerThread::setUp();
+
+  torrent::manager = new torrent::Manager;
+
+  m_tracker_fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+  CPPUNIT_ASSERT(m_tracker_fd != -1);
+
+  m_tracker_address.sin_family = AF_INET;
+  m_tracker_address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  socklen_t length = sizeof(m_tracker_address);
+
+  CPPUNIT_ASSERT(::bind(m_tracker_fd, reinterpret_cast<sockaddr*>(&m_tracker_address), sizeof(m_tracker_address)) == 0);
+  CPPUNIT_ASSERT(::getsockname(m_tracker_fd, reinterpret_cast<sockaddr*>(&m_tracker_address), &length) == 0);
+}
+
+void
+test_udp_router::tearDown() {
+  ::close(m_tracker_fd);
+
+  delete torrent::manager;
+  torrent::manager = nullptr;
+
+  TestFixtureWithMainNetTrackerThread::tearDown();
+}
+
+void
+test_udp_router::test_send() {
+  torrent::UdpRouter router;
+  auto tracker_sa = reinterpret_cast<const sockaddr*>(&m_tracker_address);
+
+  EXPECT_ROUTER_OPEN(router);
+  uint32_t transaction_id = router.open_transaction(nullptr);
+
+  CPPUNIT_ASSERT(transaction_id != 0);
+  CPPUNIT_ASSERT(router.is_open());
+  CPPUNIT_ASSERT(router.transaction_size() == 1);
+
+  mock_expect(&torrent::this_thread::event_insert_write, static_cast<torrent::Event*>(&router));
+  mock_expect(&torrent::this_thread::event_insert_write, static_cast<torrent::Event*>(&router));
+  router.send(tracker_sa, "first", 5);
+  router.send(tracker_sa, "second", 6);
+
+  CPPUNIT_ASSERT(router.queued_size() == 2);
+
+  mock_expect(&torrent::this_thread::event_remove_write, static_cast<torrent::Event*>(&router));
+  router.event_write();
+
+  CPPUNIT_ASSERT(router.queued_size() == 0);
+
+  char buffer[16];
+
+  CPPUNIT_ASSERT(::recv(m_tracker_fd, buffer, sizeof(buffer), 0) == 5);
+  CPPUNIT_ASSERT(std::memcmp(buffer, "first", 5) == 0);
+  CPPUNIT_ASSERT(::recv(m_tracker_fd, buffer, sizeof(buffer), 0) == 6);
+  CPPUNIT_ASSERT(std::memcmp(buffer, "second", 6) == 0);
+
+  // The socket is closed once the last transaction is.
+  EXPECT_ROUTER_CLOSE(router);
+  router.close_transaction(nullptr);
+
+  CPPUNIT_ASSERT(!router.is_open());
+  CPPUNIT_ASSERT(router.transaction_size() == 0);
+}
+
+void
+test_udp_router::test_unknown_transaction() {
+  torrent::UdpRouter router;
+  auto tracker_sa = reinterpret_cast<const sockaddr*>(&m_tracker_address);
+
+  EXPECT_ROUTER_OPEN(router);
+  CPPUNIT_ASSERT(router.open_transaction(nullptr) != 0);
+
+  mock_expect(&torrent::this_thread::event_insert_write, static_cast<torrent::Event*>(&router));
+  router.send(tracker_sa, "request", 7);
+
+  mock_expect(&torrent::this_thread::event_remove_write, static_cast<torrent::Event*>(&router));
+  router.event_write();
+
+  char buffer[16];
+  sockaddr_storage from;
+  socklen_t from_length = sizeof(from);
+
+  CPPUNIT_ASSERT(::recvfrom(m_tracker_fd, buffer, sizeof(buffer), 0, reinterpret_cast<sockaddr*>(&from), &from_length) == 7);
+
+  // Replies for transactions not in flight, and connect replies not
+  // requested, are dropped.
+  const char reply[16] = { 0, 0, 0, 0, 1, 2, 3, 4, 0, 0, 0, 0, 0, 0, 0, 1 };
+
+  CPPUNIT_ASSERT(::sendto(m_tracker_fd, reply, sizeof(reply), 0, reinterpret_cast<sockaddr*>(&from), from_length) == sizeof(reply));
+  ::usleep(10000);
+
+  router.event_read();
+
+  uint64_t connection_id;
+  CPPUNIT_ASSERT(!router.find_connection_id(tracker_sa, &connection_id));
+  CPPUNIT_ASSERT(router.cached_connection_size() == 0);
+
+  EXPECT_ROUTER_CLOSE(router);
+  router.close_transaction(nullptr);
+}
+
+void
+test_udp_router::test_scrape() {
+  torrent::UdpRouter router;
+  auto tracker_sa = reinterpret_cast<const sockaddr*>(&m_tracker_address);
+
+  ScrapeTracker tracker_a('a');
+  ScrapeTracker tracker_b('b');
+
+  EXPECT_ROUTER_OPEN(router);
+  CPPUNIT_ASSERT(router.open_transaction(&tracker_a) != 0);
+  CPPUNIT_ASSERT(router.open_transaction(&tracker_b) != 0);
+
+  router.request_scrape(&tracker_a, tracker_sa);
+  router.request_scrape(&tracker_b, tracker_sa);
+
+  // Scrapes are collected until the delay passes, then a single connect
+  // request is sent for the endpoint.
+  CPPUNIT_ASSERT(router.queued_size() == 0);
+
+  mock_expect(&torrent::this_thread::event_insert_write, static_cast<torrent::Event*>(&router));
+  m_main_thread->test_add_cached_time(torrent::UdpRouter::scrape_delay);
+  m_main_thread->test_process_events_without_cached_time();
+
+  CPPUNIT_ASSERT(router.queued_size() == 1);
+
+  mock_expect(&torrent::this_thread::event_remove_write, static_cast<torrent::Event*>(&router));
+  router.event_write();
+
+  char buffer[256];
+  sockaddr_storage from;
+  socklen_t from_length = sizeof(from);
+
+  CPPUNIT_ASSERT(::recvfrom(m_tracker_fd, buffer, sizeof(buffer), 0, reinterpret_cast<sockaddr*>(&from), &from_length) == 16);
+  CPPUNIT_ASSERT(read_32(buffer + 8) == torrent::UdpRouter::action_connect);
+
+  char connect_reply[16];
+  write_32(connect_reply, torrent::UdpRouter::action_connect);
+  std::memcpy(connect_reply + 4, buffer + 12, 4);
+  write_32(connect_reply + 8, 0x11223344);
+  write_32(connect_reply + 12, 0x55667788);
+
+  CPPUNIT_ASSERT(::sendto(m_tracker_fd, connect_reply, 16, 0, reinterpret_cast<sockaddr*>(&from), from_length) == 16);
+  ::usleep(10000);
+
+  // Both info hashes are sent in one scrape request.
+  mock_expect(&torrent::this_thread::event_insert_write, static_cast<torrent::Event*>(&router));
+  router.event_read();
+
+  CPPUNIT_ASSERT(router.cached_connection_size() == 1);
+  CPPUNIT_ASSERT(router.scrape_transaction_size() == 1);
+
+  mock_expect(&torrent::this_thread::event_remove_write, static_cast<torrent::Event*>(&router));
+  router.event_write();
+
+  CPPUNIT_ASSERT(::recv(m_tracker_fd, buffer, sizeof(buffer), 0) == 16 + 2 * 20);
+  CPPUNIT_ASSERT(read_32(buffer) == 0x11223344 && read_32(buffer + 4) == 0x55667788);
+  CPPUNIT_ASSERT(read_32(buffer + 8) == torrent::UdpRouter::action_scrape);
+  CPPUNIT_ASSERT(std::string(buffer + 16, 20) == std::string(20, 'a'));
+  CPPUNIT_ASSERT(std::string(buffer + 36, 20) == std::string(20, 'b'));
+
+  char scrape_reply[8 + 2 * 12];
+  write_32(scrape_reply, torrent::UdpRouter::action_scrape);
+  std::memcpy(scrape_reply + 4, buffer + 12, 4);
+
+  for (uint32_t i = 0; i != 6; i++)
+    write_32(scrape_reply + 8 + 4 * i, i + 1);
+
+  CPPUNIT_ASSERT(::sendto(m_tracker_fd, scrape_reply, sizeof(scrape_reply), 0, reinterpret_cast<sockaddr*>(&from), from_length) == sizeof(scrape_reply));
+  ::usleep(10000);
+
+  router.event_read();
+
+  CPPUNIT_ASSERT(router.scrape_transaction_size() == 0);
+
+  CPPUNIT_ASSERT(tracker_a.m_scrape_success == 1 && tracker_a.m_scrape_failure == 0);
+  CPPUNIT_ASSERT(tracker_a.test_state().scrape_complete() == 1);
+  CPPUNIT_ASSERT(tracker_a.test_state().scrape_downloaded() == 2);
+  CPPUNIT_ASSERT(tracker_a.test_state().scrape_incomplete() == 3);
+
+  CPPUNIT_ASSERT(tracker_b.m_scrape_success == 1 && tracker_b.m_scrape_failure == 0);
+  CPPUNIT_ASSERT(tracker_b.test_state().scrape_complete() == 4);
+  CPPUNIT_ASSERT(tracker_b.test_state().scrape_downloaded() == 5);
+  CPPUNIT_ASSERT(tracker_b.test_state().scrape_incomplete() == 6);
+
+  router.close_transaction(&tracker_a);
+
+  EXPECT_ROUTER_CLOSE(router);
+  router.close_transaction(&tracker_b);
+}
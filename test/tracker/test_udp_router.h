@@ -0,0 +1,25 @@
+#include "helpers/test_main_thread.h"
+
+#include <netinet/in.h>
+
+class test_udp_router : public TestFixtureWithMainNetTrackerThread {
+  CPPUNIT_TEST_SUITE(test_udp_router);
+
+  CPPUNIT_TEST(test_send);
+  CPPUNIT_TEST(test_unknown_transaction);
+  CPPUNIT_TEST(test_scrape);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp() override;
+  void tearDown() override;
+
+  void test_send();
+  void test_unknown_transaction();
+  void test_scrape();
+
+private:
+  int          m_tracker_fd{-1};
+  sockaddr_in  m_tracker_address{};
+};
@@ -0,0 +1,146 @@
+#include "config.h"
+
+#include "test_bitfield_ops.h"
+
+#include <random>
+#include <vector>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestBitfieldOps);
+
+using torrent::bitfield_ops;
+
+using data_type = std::vector<uint8_t>;
+
+static const bitfield_ops::engine_type all_engines[] = {
+  bitfield_ops::ENGINE_SCALAR,
+  bitfield_ops::ENGINE_POPCNT,
+  bitfield_ops::ENGINE_AVX2,
+};
+
+// Lengths around the 8 and 32 byte block sizes used by the kernels.
+static const size_t test_lengths[] = { 0, 1, 3, 7, 8, 9, 31, 32, 33, 63, 64, 65, 100, 257 };
+
+static bool
+bit_at(const data_type& data, uint32_t index) {
+  return data[index / 8] & (0x80 >> (index % 8));
+}
+
+// Sparse data makes 'any' and 'find' results depend on the position
+// of the few set bits.
+static data_type
+random_data(std::mt19937& rng, size_t length, unsigned int density) {
+  data_type data(length);
+
+  for (auto& byte : data)
+    for (int i = 0; i < 8; i++)
+      if (rng() % 256 < density)
+        byte |= 0x80 >> i;
+
+  return data;
+}
+
+static uint32_t
+reference_count(const data_type& a, const data_type* b, bool invert) {
+  uint32_t count = 0;
+
+  for (uint32_t i = 0; i < a.size() * 8; i++)
+    if (bit_at(a, i) && (b == nullptr || bit_at(*b, i) != invert))
+      count++;
+
+  return count;
+}
+
+static uint32_t
+reference_find(const data_type& a, const data_type& b, uint32_t first, uint32_t last) {
+  for (; first < last; first++)
+    if (bit_at(a, first) && bit_at(b, first))
+      return first;
+
+  return last;
+}
+
+void
+TestBitfieldOps::test_counts() {
+  std::mt19937 rng(1);
+
+  for (auto engine : all_engines) {
+    if (!bitfield_ops::is_engine_supported(engine))
+      continue;
+
+    auto ops = bitfield_ops::get(engine);
+
+    for (auto length : test_lengths) {
+      for (unsigned int density : { 0u, 3u, 128u, 256u }) {
+        auto a = random_data(rng, length, density);
+        auto b = random_data(rng, length, 128);
+
+        CPPUNIT_ASSERT(ops->popcount(a.data(), length) == reference_count(a, nullptr, false));
+        CPPUNIT_ASSERT(ops->count_and(a.data(), b.data(), length) == reference_count(a, &b, false));
+        CPPUNIT_ASSERT(ops->count_andnot(a.data(), b.data(), length) == reference_count(a, &b, true));
+      }
+    }
+  }
+}
+
+void
+TestBitfieldOps::test_any() {
+  for (auto engine : all_engines) {
+    if (!bitfield_ops::is_engine_supported(engine))
+      continue;
+
+    auto ops = bitfield_ops::get(engine);
+
+    for (auto length : test_lengths) {
+      data_type a(length);
+      data_type b(length, 0xff);
+
+      CPPUNIT_ASSERT(!ops->any_and(a.data(), b.data(), length));
+      CPPUNIT_ASSERT(!ops->any_andnot(a.data(), b.data(), length));
+
+      // A single bit at each position must be found.
+      for (uint32_t i = 0; i < length * 8; i++) {
+        a[i / 8] = 0x80 >> (i % 8);
+
+        CPPUNIT_ASSERT(ops->any_and(a.data(), b.data(), length));
+        CPPUNIT_ASSERT(!ops->any_andnot(a.data(), b.data(), length));
+
+        b[i / 8] = 0;
+        CPPUNIT_ASSERT(!ops->any_and(a.data(), b.data(), length));
+        CPPUNIT_ASSERT(ops->any_andnot(a.data(), b.data(), length));
+
+        b[i / 8] = 0xff;
+        a[i / 8] = 0;
+      }
+    }
+  }
+}
+
+void
+TestBitfieldOps::test_find_next_and() {
+  std::mt19937 rng(2);
+
+  for (auto engine : all_engines) {
+    if (!bitfield_ops::is_engine_supported(engine))
+      continue;
+
+    auto ops = bitfield_ops::get(engine);
+
+    for (auto length : test_lengths) {
+      uint32_t bits = length * 8;
+
+      for (unsigned int density : { 0u, 2u, 40u, 256u }) {
+        auto a = random_data(rng, length, density);
+        auto b = random_data(rng, length, 160);
+
+        // Empty ranges, unaligned ends and 'last' inside a byte.
+        for (uint32_t first = 0; first <= bits; first += 1 + rng() % 13) {
+          for (uint32_t last = first; last <= bits; last += 1 + rng() % 29) {
+            CPPUNIT_ASSERT(ops->find_next_and(a.data(), b.data(), first, last) == reference_find(a, b, first, last));
+          }
+
+          CPPUNIT_ASSERT(ops->find_next_and(a.data(), b.data(), first, bits) == reference_find(a, b, first, bits));
+        }
+      }
+    }
+  }
+}
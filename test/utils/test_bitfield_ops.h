@@ -0,0 +1,19 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "utils/bitfield_ops.h"
+
+class TestBitfieldOps : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(TestBitfieldOps);
+  CPPUNIT_TEST(test_counts);
+  CPPUNIT_TEST(test_any);
+  CPPUNIT_TEST(test_find_next_and);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp() override {}
+  void tearDown() override {}
+
+  void test_counts();
+  void test_any();
+  void test_find_next_and();
+};
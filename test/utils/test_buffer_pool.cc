@@ -0,0 +1,92 @@
+#include "config.h"
+
+#include "test_buffer_pool.h"
+
+#include <vector>
+
+#include "net/protocol_buffer.h"
+#include "torrent/exceptions.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestBufferPool);
+
+using torrent::BufferPool;
+
+void
+TestBufferPool::test_size_class() {
+  CPPUNIT_ASSERT(BufferPool::size_class(0) == 0);
+  CPPUNIT_ASSERT(BufferPool::size_class(BufferPool::min_size + BufferPool::header_size) == 0);
+  CPPUNIT_ASSERT(BufferPool::size_class(BufferPool::min_size + BufferPool::header_size + 1) == 1);
+
+  CPPUNIT_ASSERT(BufferPool::size_class(sizeof(torrent::ProtocolBuffer<16384>)) == 5);
+  CPPUNIT_ASSERT(BufferPool::size_class(1 << 15) == BufferPool::class_count - 1);
+
+  CPPUNIT_ASSERT_THROW(BufferPool::size_class(BufferPool::max_size + BufferPool::header_size + 1), torrent::internal_error);
+}
+
+void
+TestBufferPool::test_reuse() {
+  BufferPool pool;
+
+  char* first = pool.allocate(100);
+  pool.release(first, 100);
+
+  CPPUNIT_ASSERT(pool.cached_size() == 1);
+  CPPUNIT_ASSERT(pool.cached_bytes() == BufferPool::class_size(0));
+
+  // Same class is reused, other classes are not.
+  char* larger = pool.allocate(4000);
+  CPPUNIT_ASSERT(larger != first);
+  CPPUNIT_ASSERT(pool.cached_size() == 1);
+
+  char* second = pool.allocate(400);
+  CPPUNIT_ASSERT(second == first);
+  CPPUNIT_ASSERT(pool.cached_size() == 0);
+
+  pool.release(second, 400);
+  pool.release(larger, 4000);
+  pool.release(nullptr, 4000);
+
+  CPPUNIT_ASSERT(pool.cached_size() == 2);
+
+  pool.clear();
+  CPPUNIT_ASSERT(pool.cached_size() == 0);
+  CPPUNIT_ASSERT(pool.cached_bytes() == 0);
+}
+
+void
+TestBufferPool::test_max_cached() {
+  BufferPool pool;
+  std::vector<char*> buffers;
+
+  size_t size = BufferPool::max_size;
+  size_t max_count = BufferPool::max_cached_bytes / BufferPool::class_size(BufferPool::size_class(size));
+
+  for (size_t i = 0; i < max_count + 4; i++)
+    buffers.push_back(pool.allocate(size));
+
+  for (auto buffer : buffers)
+    pool.release(buffer, size);
+
+  CPPUNIT_ASSERT(pool.cached_size() == max_count);
+  CPPUNIT_ASSERT(pool.cached_bytes() <= BufferPool::max_cached_bytes);
+}
+
+void
+TestBufferPool::test_pooled_ptr() {
+  BufferPool::thread_pool()->clear();
+
+  auto buffer = torrent::make_pooled<torrent::ProtocolBuffer<16384>>();
+  buffer->reset();
+  buffer->write_32(1);
+
+  CPPUNIT_ASSERT(buffer->remaining() == 4);
+
+  void* address = buffer.get();
+  buffer = nullptr;
+
+  CPPUNIT_ASSERT(BufferPool::thread_pool()->cached_size() == 1);
+
+  buffer = torrent::make_pooled<torrent::ProtocolBuffer<16384>>();
+  CPPUNIT_ASSERT(buffer.get() == address);
+  CPPUNIT_ASSERT(BufferPool::thread_pool()->cached_size() == 0);
+}
@@ -0,0 +1,21 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "utils/buffer_pool.h"
+
+class TestBufferPool : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(TestBufferPool);
+  CPPUNIT_TEST(test_size_class);
+  CPPUNIT_TEST(test_reuse);
+  CPPUNIT_TEST(test_max_cached);
+  CPPUNIT_TEST(test_pooled_ptr);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp() override {}
+  void tearDown() override {}
+
+  void test_size_class();
+  void test_reuse();
+  void test_max_cached();
+  void test_pooled_ptr();
+};
@@ -0,0 +1,125 @@
+#include "config.h"
+
+#include "test_diffie_hellman_pool.h"
+
+#include <thread>
+
+#include "protocol/handshake_encryption.h"
+#include "utils/diffie_hellman_pool.h"
+
+CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(test_diffie_hellman_pool, "utils");
+
+using torrent::DiffieHellmanPool;
+using torrent::HandshakeEncryption;
+
+namespace {
+
+std::unique_ptr<DiffieHellmanPool>
+create_pool() {
+  return std::make_unique<DiffieHellmanPool>(HandshakeEncryption::dh_prime, HandshakeEncryption::dh_prime_length,
+                                             HandshakeEncryption::dh_generator, HandshakeEncryption::dh_generator_length);
+}
+
+// Processes the main thread's callbacks until 'done' returns true or
+// a few seconds have passed.
+template <typename Func>
+bool
+wait_for(TestMainThread* thread, Func done) {
+  for (int i = 0; i < 5000; i++) {
+    thread->test_process_events_without_cached_time();
+
+    if (done())
+      return true;
+
+    std::this_thread::sleep_for(1ms);
+  }
+
+  return false;
+}
+
+}
+
+void
+test_diffie_hellman_pool::test_take_key() {
+  auto pool = create_pool();
+
+  CPPUNIT_ASSERT(pool->size() == 0);
+
+  auto key = pool->take_key();
+
+  CPPUNIT_ASSERT(key != nullptr && key->is_valid());
+  CPPUNIT_ASSERT(wait_for(m_main_thread.get(), [&] { return pool->size() == DiffieHellmanPool::max_keys; }));
+
+  auto pooled_key = pool->take_key();
+
+  CPPUNIT_ASSERT(pooled_key != nullptr && pooled_key->is_valid());
+  CPPUNIT_ASSERT(wait_for(m_main_thread.get(), [&] { return pool->size() == DiffieHellmanPool::max_keys; }));
+}
+
+void
+test_diffie_hellman_pool::test_compute_secret() {
+  auto pool = create_pool();
+  auto local_key = pool->take_key();
+  auto remote_key = pool->take_key();
+
+  unsigned char local_pubkey[96];
+  unsigned char remote_pubkey[96];
+
+  local_key->store_pub_key(local_pubkey, 96);
+  remote_key->store_pub_key(remote_pubkey, 96);
+
+  CPPUNIT_ASSERT(remote_key->compute_secret(local_pubkey, 96));
+
+  int target;
+  DiffieHellmanPool::key_type result;
+
+  pool->compute_secret(m_main_thread.get(), &target, std::move(local_key), remote_pubkey, 96, [&](auto key) {
+      result = std::move(key);
+    });
+
+  CPPUNIT_ASSERT(wait_for(m_main_thread.get(), [&] { return result != nullptr; }));
+  CPPUNIT_ASSERT(result->has_secret());
+  CPPUNIT_ASSERT(result->secret_str() == remote_key->secret_str());
+}
+
+void
+test_diffie_hellman_pool::test_invalid_pubkey() {
+  auto pool = create_pool();
+
+  unsigned char zero_pubkey[96] = {};
+
+  int target;
+  DiffieHellmanPool::key_type result;
+
+  pool->compute_secret(m_main_thread.get(), &target, pool->take_key(), zero_pubkey, 96, [&](auto key) {
+      result = std::move(key);
+    });
+
+  CPPUNIT_ASSERT(wait_for(m_main_thread.get(), [&] { return result != nullptr; }));
+  CPPUNIT_ASSERT(!result->has_secret());
+}
+
+void
+test_diffie_hellman_pool::test_cancel() {
+  auto pool = create_pool();
+  auto remote_key = pool->take_key();
+
+  unsigned char remote_pubkey[96];
+  remote_key->store_pub_key(remote_pubkey, 96);
+
+  int targets[2];
+  bool cancelled_called = false;
+  DiffieHellmanPool::key_type result;
+
+  pool->compute_secret(m_main_thread.get(), &targets[0], pool->take_key(), remote_pubkey, 96, [&](auto) {
+      cancelled_called = true;
+    });
+  pool->compute_secret(m_main_thread.get(), &targets[1], pool->take_key(), remote_pubkey, 96, [&](auto key) {
+      result = std::move(key);
+    });
+
+  pool->cancel(m_main_thread.get(), &targets[0]);
+
+  CPPUNIT_ASSERT(wait_for(m_main_thread.get(), [&] { return result != nullptr; }));
+  CPPUNIT_ASSERT(!cancelled_called);
+}
@@ -0,0 +1,18 @@
+#include "helpers/test_main_thread.h"
+
+class test_diffie_hellman_pool : public TestFixtureWithMainThread {
+  CPPUNIT_TEST_SUITE(test_diffie_hellman_pool);
+
+  CPPUNIT_TEST(test_take_key);
+  CPPUNIT_TEST(test_compute_secret);
+  CPPUNIT_TEST(test_invalid_pubkey);
+  CPPUNIT_TEST(test_cancel);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_take_key();
+  void test_compute_secret();
+  void test_invalid_pubkey();
+  void test_cancel();
+};